@@ -8,6 +8,16 @@ AUTO_LOAD = ["mipi_dsi_cam"]
 CONF_CAMERA_ID = "camera_id"
 CONF_CANVAS_ID = "canvas_id"
 CONF_UPDATE_INTERVAL = "update_interval"
+CONF_SKIP_UNCHANGED = "skip_unchanged"
+CONF_DIRTY_RECTANGLES = "dirty_rectangles"
+CONF_TILE_SIZE = "tile_size"
+CONF_FULL_REDRAW_THRESHOLD = "full_redraw_threshold"
+CONF_SCALER = "scaler"
+CONF_SCALE_FILTER = "scale_filter"
+CONF_ROTATION = "rotation"
+CONF_MIRROR_X = "mirror_x"
+CONF_MIRROR_Y = "mirror_y"
+CONF_CPU_BUDGET = "cpu_budget"
 
 lvgl_camera_display_ns = cg.esphome_ns.namespace("lvgl_camera_display")
 LVGLCameraDisplay = lvgl_camera_display_ns.class_("LVGLCameraDisplay", cg.Component)
@@ -16,11 +26,47 @@ LVGLCameraDisplay = lvgl_camera_display_ns.class_("LVGLCameraDisplay", cg.Compon
 mipi_dsi_cam_ns = cg.esphome_ns.namespace("mipi_dsi_cam")
 MipiDsiCam = mipi_dsi_cam_ns.class_("MipiDsiCam")
 
+ScalerMode = lvgl_camera_display_ns.enum("ScalerMode")
+SCALER_MODES = {
+    "NONE": ScalerMode.SCALER_NONE,
+    "AUTO": ScalerMode.SCALER_AUTO,
+    "HARDWARE": ScalerMode.SCALER_HARDWARE,
+    "SOFTWARE": ScalerMode.SCALER_SOFTWARE,
+}
+ScaleFilter = mipi_dsi_cam_ns.enum("ScaleFilter")
+SCALE_FILTERS = {
+    "BILINEAR": ScaleFilter.SCALE_FILTER_BILINEAR,
+    "AREA": ScaleFilter.SCALE_FILTER_AREA,
+}
+FrameRotation = mipi_dsi_cam_ns.enum("FrameRotation")
+ROTATIONS = {
+    0: FrameRotation.ROTATION_0,
+    90: FrameRotation.ROTATION_90,
+    180: FrameRotation.ROTATION_180,
+    270: FrameRotation.ROTATION_270,
+}
+
 CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(): cv.declare_id(LVGLCameraDisplay),
     cv.Required(CONF_CAMERA_ID): cv.use_id(MipiDsiCam),
     cv.Required(CONF_CANVAS_ID): cv.string,
-    cv.Optional(CONF_UPDATE_INTERVAL, default="33ms"): cv.positive_time_period_milliseconds,
+    # Cadence d'affichage : au plus une frame par update_interval (0 = pas de
+    # plafond), et une frame sur N de la caméra si le rendu dépasse le budget
+    cv.Optional(CONF_UPDATE_INTERVAL, default="0ms"): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_CPU_BUDGET, default="50%"): cv.percentage,
+    # Scène statique : le canvas n'est ni reconverti ni invalidé
+    cv.Optional(CONF_SKIP_UNCHANGED, default=True): cv.boolean,
+    # Invalidation limitée aux tuiles changées, tout le canvas au-delà du seuil
+    cv.Optional(CONF_DIRTY_RECTANGLES, default=True): cv.boolean,
+    cv.Optional(CONF_TILE_SIZE, default=32): cv.int_range(min=8, max=256),
+    cv.Optional(CONF_FULL_REDRAW_THRESHOLD, default="50%"): cv.percentage,
+    # Image ramenée à la taille du canvas : PPA (P4) ou logiciel, NONE = zero-copy
+    cv.Optional(CONF_SCALER, default="AUTO"): cv.enum(SCALER_MODES, upper=True),
+    cv.Optional(CONF_SCALE_FILTER, default="BILINEAR"): cv.enum(SCALE_FILTERS, upper=True),
+    # Écran en portrait / retourné : rotation horaire puis miroir de l'image
+    cv.Optional(CONF_ROTATION, default=0): cv.enum(ROTATIONS, int=True),
+    cv.Optional(CONF_MIRROR_X, default=False): cv.boolean,
+    cv.Optional(CONF_MIRROR_Y, default=False): cv.boolean,
 }).extend(cv.COMPONENT_SCHEMA)
 
 
@@ -35,3 +81,13 @@ async def to_code(config):
     # Définir l'intervalle de mise à jour
     update_interval_ms = config[CONF_UPDATE_INTERVAL].total_milliseconds
     cg.add(var.set_update_interval(int(update_interval_ms)))
+    cg.add(var.set_cpu_budget(config[CONF_CPU_BUDGET]))
+    cg.add(var.set_skip_unchanged(config[CONF_SKIP_UNCHANGED]))
+    cg.add(var.set_dirty_rectangles(config[CONF_DIRTY_RECTANGLES]))
+    cg.add(var.set_tile_size(config[CONF_TILE_SIZE]))
+    cg.add(var.set_full_redraw_threshold(config[CONF_FULL_REDRAW_THRESHOLD]))
+    cg.add(var.set_scaler_mode(config[CONF_SCALER]))
+    cg.add(var.set_scale_filter(config[CONF_SCALE_FILTER]))
+    cg.add(var.set_rotation(config[CONF_ROTATION]))
+    cg.add(var.set_mirror_x(config[CONF_MIRROR_X]))
+    cg.add(var.set_mirror_y(config[CONF_MIRROR_Y]))
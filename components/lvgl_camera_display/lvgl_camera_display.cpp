@@ -1,12 +1,33 @@
 #include "lvgl_camera_display.h"
 #include "esphome/core/log.h"
 #include "esphome/core/application.h"
+#include <new>
+
+#ifdef USE_ESP32
+#include "esp_heap_caps.h"
+#endif
 
 namespace esphome {
 namespace lvgl_camera_display {
 
 static const char *const TAG = "lvgl_camera_display";
 
+// Tampon RGB565 en PSRAM agrandi au besoin (l'ancien contenu est perdu)
+static bool reserve_pixels(uint16_t *&buffer, size_t &capacity, size_t pixels) {
+  if (pixels <= capacity) {
+    return true;
+  }
+#ifdef USE_ESP32
+  heap_caps_free(buffer);
+  buffer = (uint16_t *) heap_caps_malloc(pixels * 2, MALLOC_CAP_SPIRAM);
+#else
+  delete[] buffer;
+  buffer = new (std::nothrow) uint16_t[pixels];
+#endif
+  capacity = buffer != nullptr ? pixels : 0;
+  return buffer != nullptr;
+}
+
 void LVGLCameraDisplay::setup() {
   ESP_LOGCONFIG(TAG, "🎥 LVGL Camera Display (Low Latency Mode)");
 
@@ -16,8 +37,27 @@ void LVGLCameraDisplay::setup() {
     return;
   }
 
-  // 🔧 Pas besoin de update_interval en mode event-driven
-  ESP_LOGI(TAG, "✅ Display initialized (event-driven mode)");
+  if (this->scaler_mode_ == SCALER_AUTO || this->scaler_mode_ == SCALER_HARDWARE) {
+#ifdef USE_ESP32_VARIANT_ESP32P4
+    this->ppa_scaler_ = new mipi_dsi_cam::PpaScaler();
+    if (this->ppa_scaler_->init()) {
+      this->scaler_ = this->ppa_scaler_;
+    } else {
+      delete this->ppa_scaler_;
+      this->ppa_scaler_ = nullptr;
+      ESP_LOGW(TAG, "⚠️ PPA unavailable, software scaler");
+    }
+#else
+    if (this->scaler_mode_ == SCALER_HARDWARE) {
+      ESP_LOGW(TAG, "⚠️ No hardware scaler on this target, software scaler");
+    }
+#endif
+  }
+  if (this->scaler_ == nullptr && this->scaler_mode_ != SCALER_NONE) {
+    this->scaler_ = &this->software_scaler_;
+  }
+
+  ESP_LOGI(TAG, "✅ Display initialized (event-driven mode, paced)");
 }
 
 void LVGLCameraDisplay::loop() {
@@ -26,51 +66,139 @@ void LVGLCameraDisplay::loop() {
     return;
   }
   
-  // 🔧 Vérifier si nouvelle frame disponible (non-bloquant, atomique)
-  //if (!this->camera_->has_new_frame()) {
-    //return;  // Pas de nouvelle frame, ne rien faire
-  //}
+  // 🆕 Prendre une référence sur la dernière frame du pool (non-bloquant)
+  mipi_dsi_cam::FrameHandle frame = this->camera_->acquire_frame();
+  if (!frame.valid()) {
+    return;
+  }
+  
+  // Déjà affichée (ou déjà écartée) : rendre la référence et ne rien faire
+  if (frame.info.sequence == this->frame_.info.sequence || frame.info.sequence == this->skipped_sequence_) {
+    this->camera_->release_frame(frame);
+    return;
+  }
+  
+  mipi_dsi_cam::FrameMetrics &metrics = this->camera_->get_metrics();
+  // Cadence d'affichage : une frame sur N, régulièrement espacées
+  if (!this->pacer_.should_display(frame.info.sequence, frame.info.timestamp_us)) {
+    this->skipped_sequence_ = frame.info.sequence;
+    this->camera_->release_frame(frame);
+    metrics.increment(mipi_dsi_cam::COUNTER_DISPLAY_PACED);
+    return;
+  }
+  // Scène statique : le canvas garde l'ancienne frame, ni conversion ni invalidate
+  if (this->skip_unchanged_ && this->is_unchanged_(frame)) {
+    this->skipped_sequence_ = frame.info.sequence;
+    this->camera_->release_frame(frame);
+    metrics.increment(mipi_dsi_cam::COUNTER_DISPLAY_SKIPPED);
+    return;
+  }
+  
+  metrics.record(mipi_dsi_cam::STAGE_ACQUIRE, mipi_dsi_cam::MipiDsiCam::get_frame_age_us(frame.info));
   
-  // 🆕 Capturer la frame (swap de buffer atomique)
-  if (this->camera_->capture_frame()) {
-    this->update_canvas_();
-    this->frame_count_++;
-
-    // Logger FPS réel toutes les 100 frames
-    if (this->frame_count_ % 100 == 0) {
-      uint32_t now_time = millis();
-
-      if (this->last_fps_time_ > 0) {
-        float elapsed = (now_time - this->last_fps_time_) / 1000.0f;
-        float fps = 100.0f / elapsed;
-        ESP_LOGI(TAG, "🎞️ Display FPS: %.2f | %u frames total", fps, this->frame_count_);
-      }
-      this->last_fps_time_ = now_time;
+  int64_t start = mipi_dsi_cam::capture_time_us();
+  if (this->update_canvas_(frame)) {
+    // FPS et latence glass-to-display : log périodique de la caméra
+    metrics.record(mipi_dsi_cam::STAGE_LVGL_INVALIDATE, mipi_dsi_cam::MipiDsiCam::get_frame_age_us(frame.info));
+    metrics.increment(mipi_dsi_cam::COUNTER_FRAMES_DISPLAYED);
+    // Rendu + flush tout de suite plutôt qu'au prochain timer LVGL : le coût
+    // réel de la frame est mesuré, et elle arrive à l'écran sans attendre
+    int64_t render_start = mipi_dsi_cam::capture_time_us();
+    lv_refr_now(this->display_);
+    int64_t end = mipi_dsi_cam::capture_time_us();
+    metrics.record(mipi_dsi_cam::STAGE_LVGL_RENDER, end - render_start);
+    this->pacer_.record_cost(end - start);
+    if (this->pacer_.get_decimation() != this->logged_decimation_) {
+      this->logged_decimation_ = this->pacer_.get_decimation();
+      ESP_LOGD(TAG, "⏱️ Pacing: 1/%u of the camera frames (%.1f ms per frame, budget %.0f%%)",
+               this->logged_decimation_, this->pacer_.get_cost_us() / 1000.0f,
+               this->pacer_.get_cpu_budget() * 100.0f);
     }
+    if (this->skip_unchanged_) {
+      this->displayed_signature_ = this->camera_->get_frame_signature(frame);
+    }
+  } else {
+    this->displayed_signature_ = mipi_dsi_cam::FrameSignature{};
   }
+  
+  // Le canvas pointe maintenant sur la nouvelle frame : l'ancienne peut
+  // retourner au pool (le DMA ne touche jamais une frame encore tenue)
+  this->camera_->release_frame(this->frame_);
+  this->frame_ = frame;
 }
 
 void LVGLCameraDisplay::dump_config() {
   ESP_LOGCONFIG(TAG, "LVGL Camera Display:");
   ESP_LOGCONFIG(TAG, "  Mode: Event-driven (zero-copy)");
   ESP_LOGCONFIG(TAG, "  Canvas: %s", this->canvas_obj_ ? "YES" : "NO");
+  ESP_LOGCONFIG(TAG, "  Skip unchanged frames: %s", this->skip_unchanged_ ? "YES" : "NO");
+  if (this->update_interval_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Pacing: CPU budget %.0f%%, at most one frame per %ums",
+                  this->pacer_.get_cpu_budget() * 100.0f, this->update_interval_);
+  } else {
+    ESP_LOGCONFIG(TAG, "  Pacing: CPU budget %.0f%%", this->pacer_.get_cpu_budget() * 100.0f);
+  }
+  if (this->scaler_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Scaler: %s (%s) to %ux%u", this->scaler_->get_name(),
+                  this->scaler_ == &this->software_scaler_
+                      ? mipi_dsi_cam::scale_filter_name(this->software_scaler_.get_filter())
+                      : "hardware",
+                  this->target_width_, this->target_height_);
+  } else {
+    ESP_LOGCONFIG(TAG, "  Scaler: NO (camera resolution)");
+  }
+  if (!this->transform_.is_identity()) {
+    ESP_LOGCONFIG(TAG, "  Rotation: %s%s%s", mipi_dsi_cam::rotation_name(this->transform_.rotation),
+                  this->transform_.mirror_x ? ", mirror X" : "", this->transform_.mirror_y ? ", mirror Y" : "");
+  }
+  if (this->dirty_rectangles_) {
+    ESP_LOGCONFIG(TAG, "  Dirty rectangles: %upx tiles, full redraw past %.0f%%", this->tiles_.get_tile_size(),
+                  this->tiles_.get_full_threshold() * 100.0f);
+  } else {
+    ESP_LOGCONFIG(TAG, "  Dirty rectangles: NO (whole canvas)");
+  }
 }
 
-void LVGLCameraDisplay::update_canvas_() {
+bool LVGLCameraDisplay::is_unchanged_(const mipi_dsi_cam::FrameHandle &frame) {
+  if (!this->frame_.valid() || !this->displayed_signature_.valid()) {
+    return false;
+  }
+  // Zoom déplacé : même scène, autre image
+  mipi_dsi_cam::FrameView view = this->camera_->get_zoom_view(frame);
+  if ((size_t) (view.data - frame.data) != this->displayed_offset_ || view.width != this->displayed_width_ ||
+      view.height != this->displayed_height_) {
+    return false;
+  }
+  return !this->camera_->has_content_changed(frame, this->displayed_signature_);
+}
+
+bool LVGLCameraDisplay::update_canvas_(const mipi_dsi_cam::FrameHandle &frame) {
   if (this->camera_ == nullptr || this->canvas_obj_ == nullptr) {
     if (!this->canvas_warning_shown_) {
       ESP_LOGW(TAG, "❌ Canvas null");
       this->canvas_warning_shown_ = true;
     }
-    return;
+    return false;
   }
 
-  uint8_t* img_data = this->camera_->get_image_data();
-  uint16_t width = this->camera_->get_image_width();
-  uint16_t height = this->camera_->get_image_height();
+  // Fenêtre de zoom de la caméra (image entière sans zoom) : vue dans la frame
+  mipi_dsi_cam::FrameView view = this->camera_->get_zoom_view(frame);
+  this->displayed_offset_ = view.data - frame.data;
+  this->displayed_width_ = view.width;
+  this->displayed_height_ = view.height;
+  if (view.valid() && view.format != mipi_dsi_cam::PIXEL_FORMAT_RGB565) {
+    view = this->convert_view_(view);
+  }
+  if (view.valid()) {
+    view = this->render_view_(view);
+  }
+  uint8_t* img_data = view.data;
+  // Taille de la vue : elle change avec le mode du capteur et le zoom
+  uint16_t width = view.width;
+  uint16_t height = view.height;
 
   if (img_data == nullptr) {
-    return;
+    return false;
   }
 
   if (this->first_update_) {
@@ -81,17 +209,182 @@ void LVGLCameraDisplay::update_canvas_() {
   }
 
   // 🔧 CRITIQUE: Ne PAS appeler lv_canvas_set_buffer à chaque frame si le buffer ne change pas
-  // Le buffer est maintenant stable (triple buffering), donc on peut juste invalider
+  // Le buffer affiché reste référencé dans le pool tant qu'il est à l'écran
+  // LVGL n'a pas de stride : l'image fait la largeur d'une ligne de la frame
+  // et l'objet est réduit à la largeur de la vue, LVGL ne dessine (et ne lit)
+  // que cette partie. Aucune copie du crop.
+  uint16_t row_pixels = view.stride / 2;
+  bool geometry_changed = this->last_width_ != width || this->last_height_ != height ||
+                          this->last_row_pixels_ != row_pixels;
   
-  // 🆕 Première fois ou si le buffer a changé: set_buffer
-  if (this->last_buffer_ptr_ != img_data) {
-    // Verrouillage LVGL pour thread-safety
-    lv_canvas_set_buffer(this->canvas_obj_, img_data, width, height, LV_IMG_CF_TRUE_COLOR);
+  // 🆕 Première fois ou si le mode capteur, ou le zoom, a changé: set_buffer (invalide tout le canvas)
+  if (geometry_changed) {
+    lv_canvas_set_buffer(this->canvas_obj_, img_data, row_pixels, height, LV_IMG_CF_TRUE_COLOR);
+    lv_obj_set_size(this->canvas_obj_, width, height);
+    this->last_buffer_ptr_ = img_data;
+    this->last_width_ = width;
+    this->last_height_ = height;
+    this->last_row_pixels_ = row_pixels;
+    this->tiles_.reset();
+  } else if (this->last_buffer_ptr_ != img_data) {
+    // Nouvelle frame, même géométrie : seul le pointeur de l'image change,
+    // l'invalidation reste limitée aux zones qui ont bougé
+    lv_img_dsc_t *dsc = lv_canvas_get_img(this->canvas_obj_);
+    dsc->data = img_data;
+    lv_img_cache_invalidate_src(dsc);
     this->last_buffer_ptr_ = img_data;
   }
   
-  // 🔧 Invalider seulement la zone nécessaire (plus rapide que tout l'écran)
-  lv_obj_invalidate(this->canvas_obj_);
+  mipi_dsi_cam::TileChanges changes;
+  if (this->dirty_rectangles_) {
+    this->tiles_.compare(view, this->camera_->get_change_threshold(), changes);
+  } else {
+    changes.full = true;
+  }
+  this->invalidate_(changes);
+  return true;
+}
+
+mipi_dsi_cam::FrameView LVGLCameraDisplay::render_view_(const mipi_dsi_cam::FrameView &view) {
+  const mipi_dsi_cam::FrameTransform &transform = this->transform_;
+  uint16_t turned_width = transform.swaps_axes() ? view.height : view.width;
+  uint16_t turned_height = transform.swaps_axes() ? view.width : view.height;
+  uint16_t k = 16;
+  if (this->scaler_ != nullptr) {
+    k = mipi_dsi_cam::fit_scale_sixteenths(turned_width, turned_height, this->target_width_, this->target_height_);
+    // Taille du canvas inconnue : taille de la caméra
+    if (k == 0)
+      k = 16;
+  }
+  // Déjà à la taille du canvas et dans le bon sens : zero-copy
+  if (k == 16 && transform.is_identity()) {
+    return view;
+  }
+  uint16_t width = (uint32_t) turned_width * k / 16;
+  uint16_t height = (uint32_t) turned_height * k / 16;
+  size_t pixels = (size_t) width * height;
+  if (pixels > this->display_capacity_ && !this->allocate_display_buffers_(pixels)) {
+    return {};
+  }
+
+  // Tampon que le canvas n'affiche pas
+  this->display_index_ ^= 1;
+  mipi_dsi_cam::FrameView out = mipi_dsi_cam::FrameView::packed(
+      (uint8_t *) this->display_buffers_[this->display_index_], width, height, mipi_dsi_cam::PIXEL_FORMAT_RGB565);
+  // Rotation seule : le PPA la fait aussi bien (sans le CPU), sinon par blocs
+  bool ok = k == 16 && (this->scaler_ == nullptr || !this->scaler_->supports_transform())
+                ? this->rotate_(view, out)
+                : this->scale_(view, out, transform);
+  return ok ? out : mipi_dsi_cam::FrameView{};
+}
+
+bool LVGLCameraDisplay::scale_(const mipi_dsi_cam::FrameView &src, const mipi_dsi_cam::FrameView &dst,
+                               const mipi_dsi_cam::FrameTransform &transform) {
+  if (!transform.is_identity() && !this->scaler_->supports_transform()) {
+    return this->scale_rotate_(src, dst);
+  }
+  int64_t start = mipi_dsi_cam::capture_time_us();
+  if (!this->scaler_->scale_transformed(src, dst, transform)) {
+    if (this->scaler_ == &this->software_scaler_) {
+      return false;
+    }
+    ESP_LOGW(TAG, "⚠️ %s scaler failed, falling back to software", this->scaler_->get_name());
+    this->scaler_ = &this->software_scaler_;
+    return this->scale_(src, dst, transform);
+  }
+  this->camera_->get_metrics().record(mipi_dsi_cam::STAGE_SCALE, mipi_dsi_cam::capture_time_us() - start);
+  return true;
+}
+
+bool LVGLCameraDisplay::scale_rotate_(const mipi_dsi_cam::FrameView &src, const mipi_dsi_cam::FrameView &dst) {
+  // Deux passes par un tampon intermédiaire, la rotation sur la plus petite
+  // des deux images (après réduction, avant agrandissement)
+  bool shrink = (size_t) dst.width * dst.height < (size_t) src.width * src.height;
+  size_t pixels = shrink ? (size_t) dst.width * dst.height : (size_t) src.width * src.height;
+  if (!reserve_pixels(this->transform_buffer_, this->transform_capacity_, pixels)) {
+    ESP_LOGE(TAG, "❌ Rotation buffer alloc failed (%u pixels)", (unsigned) pixels);
+    return false;
+  }
+  uint8_t *buffer = (uint8_t *) this->transform_buffer_;
+  if (shrink) {
+    bool swap = this->transform_.swaps_axes();
+    mipi_dsi_cam::FrameView scaled = mipi_dsi_cam::FrameView::packed(
+        buffer, swap ? dst.height : dst.width, swap ? dst.width : dst.height, mipi_dsi_cam::PIXEL_FORMAT_RGB565);
+    return this->scale_(src, scaled, {}) && this->rotate_(scaled, dst);
+  }
+  mipi_dsi_cam::FrameView turned = mipi_dsi_cam::transformed_view(src, this->transform_, buffer);
+  return this->rotate_(src, turned) && this->scale_(turned, dst, {});
+}
+
+bool LVGLCameraDisplay::rotate_(const mipi_dsi_cam::FrameView &src, const mipi_dsi_cam::FrameView &dst) {
+  int64_t start = mipi_dsi_cam::capture_time_us();
+  bool ok = mipi_dsi_cam::transform_frame(src, dst, this->transform_);
+  this->camera_->get_metrics().record(mipi_dsi_cam::STAGE_ROTATE, mipi_dsi_cam::capture_time_us() - start);
+  return ok;
+}
+
+bool LVGLCameraDisplay::allocate_display_buffers_(size_t pixels) {
+  // Alignés sur la ligne de cache : le PPA écrit directement dedans
+  size_t bytes = (pixels * 2 + 63) & ~(size_t) 63;
+  for (uint16_t *&buffer : this->display_buffers_) {
+#ifdef USE_ESP32
+    heap_caps_free(buffer);
+    buffer = (uint16_t *) heap_caps_aligned_alloc(64, bytes, MALLOC_CAP_SPIRAM);
+#else
+    delete[] buffer;
+    buffer = new (std::nothrow) uint16_t[bytes / 2];
+#endif
+  }
+  if (this->display_buffers_[0] == nullptr || this->display_buffers_[1] == nullptr) {
+    ESP_LOGE(TAG, "❌ Display buffers alloc failed (2x %u bytes)", (unsigned) bytes);
+    this->display_capacity_ = 0;
+    return false;
+  }
+  this->display_capacity_ = pixels;
+  // Le canvas pointait peut-être sur un ancien tampon
+  this->last_width_ = 0;
+  ESP_LOGI(TAG, "🖼️ Display buffers: 2x %u bytes (%u pixels)", (unsigned) bytes, (unsigned) pixels);
+  return true;
+}
+
+void LVGLCameraDisplay::invalidate_(const mipi_dsi_cam::TileChanges &changes) {
+  if (changes.full) {
+    lv_obj_invalidate(this->canvas_obj_);
+    return;
+  }
+  if (changes.rect_count == 0) {
+    return;
+  }
+  // Zones en pixels de l'image, LVGL les veut en coordonnées écran
+  lv_area_t coords;
+  lv_obj_get_coords(this->canvas_obj_, &coords);
+  for (uint8_t i = 0; i < changes.rect_count; i++) {
+    const mipi_dsi_cam::FrameRoi &rect = changes.rects[i];
+    lv_area_t area;
+    area.x1 = coords.x1 + rect.x;
+    area.y1 = coords.y1 + rect.y;
+    area.x2 = area.x1 + rect.width - 1;
+    area.y2 = area.y1 + rect.height - 1;
+    lv_obj_invalidate_area(this->canvas_obj_, &area);
+  }
+  this->camera_->get_metrics().increment(mipi_dsi_cam::COUNTER_DISPLAY_PARTIAL);
+}
+
+mipi_dsi_cam::FrameView LVGLCameraDisplay::convert_view_(const mipi_dsi_cam::FrameView &view) {
+  size_t pixels = (size_t) view.width * view.height;
+  if (pixels > this->convert_capacity_) {
+    if (!reserve_pixels(this->convert_buffer_, this->convert_capacity_, pixels)) {
+      ESP_LOGE(TAG, "❌ RGB565 buffer alloc failed (%ux%u)", view.width, view.height);
+      return {};
+    }
+    ESP_LOGI(TAG, "🎨 Camera in %s: converted to RGB565 for the canvas", mipi_dsi_cam::pixel_format_name(view.format));
+  }
+  // Le canvas lit ce buffer au prochain rendu LVGL, dans cette même tâche
+  int64_t start = mipi_dsi_cam::capture_time_us();
+  mipi_dsi_cam::convert_to_rgb565(view, this->convert_buffer_, this->camera_->get_demosaic_method());
+  this->camera_->get_metrics().record(mipi_dsi_cam::STAGE_CONVERT, mipi_dsi_cam::capture_time_us() - start);
+  return mipi_dsi_cam::FrameView::packed((uint8_t *) this->convert_buffer_, view.width, view.height,
+                                         mipi_dsi_cam::PIXEL_FORMAT_RGB565);
 }
 
 void LVGLCameraDisplay::configure_canvas(lv_obj_t *canvas) { 
@@ -99,9 +392,14 @@ void LVGLCameraDisplay::configure_canvas(lv_obj_t *canvas) {
   ESP_LOGI(TAG, "🎨 Canvas configured: %p", canvas);
 
   if (canvas != nullptr) {
+    // Taille voulue par la mise en page : la cible du scaler
+    lv_obj_update_layout(canvas);
     lv_coord_t w = lv_obj_get_width(canvas);
     lv_coord_t h = lv_obj_get_height(canvas);
     ESP_LOGI(TAG, "   Canvas size: %dx%d", w, h);
+    this->target_width_ = w > 0 ? w : 0;
+    this->target_height_ = h > 0 ? h : 0;
+    this->display_ = lv_obj_get_disp(canvas);
     
     // 🆕 Désactiver le cache de transformation si disponible pour réduire la latence
     lv_obj_clear_flag(canvas, LV_OBJ_FLAG_SCROLLABLE);
@@ -2,11 +2,25 @@
 
 #include "esphome/core/component.h"
 #include "esphome/components/lvgl/lvgl_esphome.h"
+#include "../mipi_dsi_cam/frame_scaler.h"
+#include "../mipi_dsi_cam/frame_pacer.h"
+#include "../mipi_dsi_cam/frame_signature.h"
+#include "../mipi_dsi_cam/frame_transform.h"
 #include "../mipi_dsi_cam/mipi_dsi_cam.h"
+#include "../mipi_dsi_cam/ppa_scaler.h"
+#include "../mipi_dsi_cam/pixel_convert.h"
 
 namespace esphome {
 namespace lvgl_camera_display {
 
+// Mise à l'échelle vers la taille du canvas
+enum ScalerMode : uint8_t {
+  SCALER_NONE = 0,  // buffer caméra tel quel (zero-copy), LVGL découpe
+  SCALER_AUTO,      // PPA si disponible, sinon logiciel
+  SCALER_HARDWARE,
+  SCALER_SOFTWARE,
+};
+
 class LVGLCameraDisplay : public Component {
  public:
   void setup() override;
@@ -15,10 +29,32 @@ class LVGLCameraDisplay : public Component {
 
   void set_camera(mipi_dsi_cam::MipiDsiCam *camera) { this->camera_ = camera; }
   void set_canvas_id(const std::string &canvas_id) { this->canvas_id_ = canvas_id; }
-  void set_update_interval(uint32_t interval_ms) { 
-    // Ignoré en mode event-driven
-    this->update_interval_ = interval_ms; 
+  // Intervalle minimal entre deux frames affichées (plafond de cadence),
+  // 0 = seul le budget CPU limite
+  void set_update_interval(uint32_t interval_ms) {
+    this->update_interval_ = interval_ms;
+    this->pacer_.set_min_interval_us(interval_ms * 1000);
   }
+  // Part du temps CPU laissée au widget caméra (conversion, scaler, rendu et
+  // flush LVGL) : au-delà, une frame sur N de la caméra, N entier
+  void set_cpu_budget(float budget) { this->pacer_.set_cpu_budget(budget); }
+
+  // Scène inchangée (MipiDsiCam::has_content_changed) : pas de nouveau rendu
+  void set_skip_unchanged(bool skip) { this->skip_unchanged_ = skip; }
+  // Seules les tuiles changées sont invalidées (lv_obj_invalidate_area),
+  // tout le canvas au-delà de `full_threshold` de la surface
+  void set_dirty_rectangles(bool enabled) { this->dirty_rectangles_ = enabled; }
+  void set_tile_size(uint16_t tile_size) { this->tiles_.set_tile_size(tile_size); }
+  void set_full_redraw_threshold(float coverage) { this->tiles_.set_full_threshold(coverage); }
+  // Image mise à la taille du canvas (ratio conservé, pas de 1/16) dans une
+  // paire de tampons d'affichage : coût par frame fixé par la taille d'écran
+  void set_scaler_mode(ScalerMode mode) { this->scaler_mode_ = mode; }
+  void set_scale_filter(mipi_dsi_cam::ScaleFilter filter) { this->software_scaler_.set_filter(filter); }
+  // Écran monté en portrait / retourné : rotation horaire puis miroir, dans
+  // la passe du PPA ou par blocs (frame_transform.h)
+  void set_rotation(mipi_dsi_cam::FrameRotation rotation) { this->transform_.rotation = rotation; }
+  void set_mirror_x(bool mirror) { this->transform_.mirror_x = mirror; }
+  void set_mirror_y(bool mirror) { this->transform_.mirror_y = mirror; }
 
   void configure_canvas(lv_obj_t *canvas);
 
@@ -29,19 +65,70 @@ class LVGLCameraDisplay : public Component {
   lv_obj_t *canvas_obj_{nullptr};
   std::string canvas_id_{};
 
-  uint32_t update_interval_{33};  // Non utilisé en mode event-driven
-  uint32_t last_update_{0};       // Non utilisé en mode event-driven
+  uint32_t update_interval_{0};
+  mipi_dsi_cam::FramePacer pacer_;
+  uint8_t logged_decimation_{1};
+  lv_disp_t *display_{nullptr};  // rafraîchi (et chronométré) à chaque frame
 
-  uint32_t frame_count_{0};
   bool first_update_{true};
   bool canvas_warning_shown_{false};
 
-  uint32_t last_fps_time_{0};
-  
   // Suivi du pointeur de buffer pour éviter les appels inutiles
   uint8_t* last_buffer_ptr_{nullptr};
+  uint16_t last_width_{0};
+  uint16_t last_height_{0};
+
+  // Frame actuellement affichée (référence tenue dans le pool de la caméra)
+  mipi_dsi_cam::FrameHandle frame_{};
+
+  // Contenu affiché : signature et zone (zoom) de la frame à l'écran
+  bool skip_unchanged_{true};
+  mipi_dsi_cam::FrameSignature displayed_signature_{};
+  size_t displayed_offset_{0};
+  uint16_t displayed_width_{0};
+  uint16_t displayed_height_{0};
+  uint32_t skipped_sequence_{0};  // dernière frame écartée, pas revérifiée
+
+  bool dirty_rectangles_{true};
+  mipi_dsi_cam::TileChangeTracker tiles_;
+  uint16_t last_row_pixels_{0};
+
+  ScalerMode scaler_mode_{SCALER_AUTO};
+  mipi_dsi_cam::SoftwareScaler software_scaler_;
+#ifdef USE_ESP32_VARIANT_ESP32P4
+  mipi_dsi_cam::PpaScaler *ppa_scaler_{nullptr};
+#endif
+  mipi_dsi_cam::FrameScaler *scaler_{nullptr};  // nullptr : pas de mise à l'échelle
+  // Taille du canvas lue à configure_canvas(), 0 = inconnue
+  uint16_t target_width_{0};
+  uint16_t target_height_{0};
+  // Le canvas lit l'un pendant que le scaler écrit l'autre
+  uint16_t *display_buffers_[2]{};
+  size_t display_capacity_{0};  // pixels par tampon
+  uint8_t display_index_{0};
+
+  mipi_dsi_cam::FrameTransform transform_{};
+  // Étape intermédiaire rotation + mise à l'échelle logicielle
+  uint16_t *transform_buffer_{nullptr};
+  size_t transform_capacity_{0};
+
+  // Caméra en YUV422 / RAW8 : le canvas veut du RGB565, converti ici
+  uint16_t *convert_buffer_{nullptr};
+  size_t convert_capacity_{0};
 
-  void update_canvas_();
+  // Même contenu et même zone que la frame à l'écran
+  bool is_unchanged_(const mipi_dsi_cam::FrameHandle &frame);
+  // false : rien d'affiché (canvas absent, conversion impossible)
+  bool update_canvas_(const mipi_dsi_cam::FrameHandle &frame);
+  mipi_dsi_cam::FrameView convert_view_(const mipi_dsi_cam::FrameView &view);
+  // Rotation et mise à la taille du canvas, dans le tampon d'affichage libre
+  mipi_dsi_cam::FrameView render_view_(const mipi_dsi_cam::FrameView &view);
+  bool scale_(const mipi_dsi_cam::FrameView &src, const mipi_dsi_cam::FrameView &dst,
+              const mipi_dsi_cam::FrameTransform &transform);
+  bool scale_rotate_(const mipi_dsi_cam::FrameView &src, const mipi_dsi_cam::FrameView &dst);
+  bool rotate_(const mipi_dsi_cam::FrameView &src, const mipi_dsi_cam::FrameView &dst);
+  bool allocate_display_buffers_(size_t pixels);
+  void invalidate_(const mipi_dsi_cam::TileChanges &changes);
 };
 
 }  // namespace lvgl_camera_display
@@ -87,6 +87,13 @@ DEPENDENCIES = ["mipi_dsi_cam", "network"]
 CODEOWNERS = ["@youkorr"]
 
 CONF_CAMERA_ID = "camera_id"
+CONF_SKIP_UNCHANGED = "skip_unchanged"
+CONF_ROTATION = "rotation"
+CONF_MIRROR_X = "mirror_x"
+CONF_MIRROR_Y = "mirror_y"
+CONF_MAX_STREAM_FPS = "max_stream_fps"
+CONF_MAX_STREAMS = "max_streams"
+CONF_MAX_JPEG_PROFILES = "max_jpeg_profiles"
 
 mipi_camera_web_server_ns = cg.esphome_ns.namespace("mipi_camera_web_server")
 MipiCameraWebServer = mipi_camera_web_server_ns.class_(
@@ -95,12 +102,32 @@ MipiCameraWebServer = mipi_camera_web_server_ns.class_(
 
 mipi_dsi_cam_ns = cg.esphome_ns.namespace("mipi_dsi_cam")
 MipiDsiCam = mipi_dsi_cam_ns.class_("MipiDsiCam")
+FrameRotation = mipi_dsi_cam_ns.enum("FrameRotation")
+ROTATIONS = {
+    0: FrameRotation.ROTATION_0,
+    90: FrameRotation.ROTATION_90,
+    180: FrameRotation.ROTATION_180,
+    270: FrameRotation.ROTATION_270,
+}
 
 CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(): cv.declare_id(MipiCameraWebServer),
         cv.Required(CONF_CAMERA_ID): cv.use_id(MipiDsiCam),
         cv.Optional(CONF_PORT, default=81): cv.port,
+        # Scène statique : pas de nouvel encodage, JPEG précédent servi
+        cv.Optional(CONF_SKIP_UNCHANGED, default=True): cv.boolean,
+        # /stream MJPEG : images/s max par client (0 = chaque frame) et nombre
+        # de clients simultanés (un socket chacun, httpd en a 7)
+        cv.Optional(CONF_MAX_STREAM_FPS, default=0): cv.int_range(min=0, max=60),
+        cv.Optional(CONF_MAX_STREAMS, default=3): cv.int_range(min=1, max=4),
+        # Profils JPEG (zone ?roi=N + qualité : /stream 80, /snapshot 90) avec
+        # leurs buffers en PSRAM, 4 x 150 Ko chacun
+        cv.Optional(CONF_MAX_JPEG_PROFILES, default=2): cv.int_range(min=1, max=5),
+        # Image tournée (horaire) puis retournée avant l'encodage JPEG
+        cv.Optional(CONF_ROTATION, default=0): cv.enum(ROTATIONS, int=True),
+        cv.Optional(CONF_MIRROR_X, default=False): cv.boolean,
+        cv.Optional(CONF_MIRROR_Y, default=False): cv.boolean,
     }
 ).extend(cv.COMPONENT_SCHEMA)
 
@@ -113,6 +140,13 @@ async def to_code(config):
     camera = await cg.get_variable(config[CONF_CAMERA_ID])
     cg.add(var.set_camera(camera))
     cg.add(var.set_port(config[CONF_PORT]))
+    cg.add(var.set_skip_unchanged(config[CONF_SKIP_UNCHANGED]))
+    cg.add(var.set_max_stream_fps(config[CONF_MAX_STREAM_FPS]))
+    cg.add(var.set_max_streams(config[CONF_MAX_STREAMS]))
+    cg.add(var.set_max_jpeg_profiles(config[CONF_MAX_JPEG_PROFILES]))
+    cg.add(var.set_rotation(config[CONF_ROTATION]))
+    cg.add(var.set_mirror_x(config[CONF_MIRROR_X]))
+    cg.add(var.set_mirror_y(config[CONF_MIRROR_Y]))
     
     # Librairies nécessaires
     cg.add_library("ESP Async WebServer", None)
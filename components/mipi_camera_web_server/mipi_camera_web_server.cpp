@@ -4,6 +4,8 @@
 
 #include "esphome/core/log.h"
 #include "esphome/core/application.h"
+#include <algorithm>
+#include <cstring>
 
 // Inclure l'encodeur JPEG ESP-IDF si disponible
 //#include "esp_jpeg_common.h"
@@ -14,6 +16,22 @@ namespace mipi_camera_web_server {
 
 static const char *const TAG = "mipi_camera_web_server";
 
+// Flux MJPEG : une partie par image, le navigateur remplace la précédente
+#define STREAM_BOUNDARY "mipi-camera-frame"
+static const char STREAM_CONTENT_TYPE[] = "multipart/x-mixed-replace;boundary=" STREAM_BOUNDARY;
+static const char STREAM_PART_HEADER[] = "\r\n--" STREAM_BOUNDARY "\r\n"
+                                         "Content-Type: image/jpeg\r\n"
+                                         "Content-Length: %u\r\n"
+                                         "X-Frame-Sequence: %u\r\n"
+                                         "X-Frame-Timestamp-Us: %lld\r\n\r\n";
+// Attente d'une nouvelle frame entre deux coups d'œil au pool
+static const uint32_t STREAM_POLL_MS = 5;
+// Scène statique : l'image est quand même renvoyée une fois par seconde,
+// un client parti ne se voit qu'à l'envoi
+static const int64_t STREAM_KEEPALIVE_US = 1000000;
+// Changement de mode : arrêt bref du flux caméra, les clients restent connectés
+static const int64_t STREAM_STOP_GRACE_US = 1000000;
+
 // Page HTML simple et efficace
 static const char INDEX_HTML[] = R"html(
 <!DOCTYPE html>
@@ -54,6 +72,8 @@ static const char INDEX_HTML[] = R"html(
     const img=document.getElementById('stream');
     function toggleStream(){
       streaming=!streaming;
+      // Flux MJPEG : vider src ferme la connexion
+      img.src=streaming?'/stream':'';
       img.style.display=streaming?'block':'none';
       document.getElementById('status').textContent=streaming?'Streaming...':'Paused';
     }
@@ -62,12 +82,6 @@ static const char INDEX_HTML[] = R"html(
       document.getElementById('bval').textContent=v;
       fetch('/control?brightness='+v);
     }
-    setInterval(()=>{
-      if(streaming){
-        const t=Date.now();
-        img.src='/stream?t='+t;
-      }
-    },100);
   </script>
 </body>
 </html>
@@ -90,14 +104,11 @@ void MipiCameraWebServer::setup() {
     return;
   }
 
-  // Allouer buffer JPEG en PSRAM
-  this->jpeg_buffer_ = (uint8_t *)heap_caps_malloc(
-    this->jpeg_buffer_size_, 
-    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT
-  );
-
-  if (this->jpeg_buffer_ == nullptr) {
-    ESP_LOGE(TAG, "Failed to allocate JPEG buffer");
+  // Une tâche d'encodage pour tous les étages (un seul encodeur matériel) ;
+  // les buffers JPEG sont alloués par étage, au premier client du profil
+  if (xTaskCreate(MipiCameraWebServer::encoder_task_, "cam_jpeg", 4096, this, 5, &this->encoder_task_handle_) !=
+      pdPASS) {
+    ESP_LOGE(TAG, "Failed to create JPEG encoder task");
     this->mark_failed();
     return;
   }
@@ -155,6 +166,14 @@ void MipiCameraWebServer::setup() {
   };
   httpd_register_uri_handler(this->server_, &control_uri);
 
+  httpd_uri_t metrics_uri = {
+    .uri = "/metrics",
+    .method = HTTP_GET,
+    .handler = MipiCameraWebServer::metrics_handler_,
+    .user_ctx = this
+  };
+  httpd_register_uri_handler(this->server_, &metrics_uri);
+
   ESP_LOGI(TAG, "Web server started on port %d", this->port_);
 }
 
@@ -165,6 +184,22 @@ void MipiCameraWebServer::loop() {
 void MipiCameraWebServer::dump_config() {
   ESP_LOGCONFIG(TAG, "MIPI Camera Web Server:");
   ESP_LOGCONFIG(TAG, "  Port: %d", this->port_);
+  ESP_LOGCONFIG(TAG, "  Metrics: /metrics (Prometheus)");
+  ESP_LOGCONFIG(TAG, "  Skip unchanged frames: %s", this->skip_unchanged_ ? "YES (JPEG reuse)" : "NO");
+  if (this->max_stream_fps_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Stream: MJPEG, %u client(s) max, %u fps max per client", this->max_streams_,
+                  this->max_stream_fps_);
+  } else {
+    ESP_LOGCONFIG(TAG, "  Stream: MJPEG, %u client(s) max, every new frame", this->max_streams_);
+  }
+  ESP_LOGCONFIG(TAG, "  JPEG: encoded once per profile, %u buffers of %u KB shared by its clients", JPEG_SLOTS,
+                (unsigned) (this->jpeg_buffer_size_ / 1024));
+  ESP_LOGCONFIG(TAG, "  JPEG profiles: %u max (%u KB of buffers)", this->max_jpeg_profiles_,
+                (unsigned) (this->max_jpeg_profiles_ * JPEG_SLOTS * this->jpeg_buffer_size_ / 1024));
+  if (!this->transform_.is_identity()) {
+    ESP_LOGCONFIG(TAG, "  Rotation: %s%s%s", mipi_dsi_cam::rotation_name(this->transform_.rotation),
+                  this->transform_.mirror_x ? ", mirror X" : "", this->transform_.mirror_y ? ", mirror Y" : "");
+  }
   if (this->camera_) {
     ESP_LOGCONFIG(TAG, "  Resolution: %ux%u",
                   this->camera_->get_image_width(),
@@ -185,47 +220,128 @@ esp_err_t MipiCameraWebServer::stream_handler_(httpd_req_t *req) {
     httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Camera not streaming");
     return ESP_FAIL;
   }
-
-  if (!server->camera_->capture_frame()) {
-    httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "No frame");
+  if (server->active_streams_.fetch_add(1) >= server->max_streams_) {
+    server->active_streams_--;
+    httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Too many streams");
     return ESP_FAIL;
   }
-
-  uint8_t *rgb565 = server->camera_->get_image_data();
-  uint16_t w = server->camera_->get_image_width();
-  uint16_t h = server->camera_->get_image_height();
-
-  if (!rgb565) {
-    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Invalid data");
+  JpegStage *stage = server->acquire_stage_(server->request_roi_(req), 80);
+  if (stage == nullptr) {
+    server->active_streams_--;
+    httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Too many streams");
     return ESP_FAIL;
   }
 
-  if (xSemaphoreTake(server->jpeg_mutex_, pdMS_TO_TICKS(500)) != pdTRUE) {
-    httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Busy");
+  // Réponse longue : détachée du serveur (une seule tâche httpd), une tâche
+  // par client la remplit
+  StreamClient *client = new StreamClient{server, nullptr, stage, server->request_interval_us_(req)};
+  if (httpd_req_async_handler_begin(req, &client->req) != ESP_OK) {
+    delete client;
+    server->release_stage_(stage);
+    server->active_streams_--;
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Stream setup failed");
     return ESP_FAIL;
   }
-
-  uint8_t *jpeg_data = nullptr;
-  size_t jpeg_size = 0;
-  bool ok = server->encode_jpeg_(rgb565, w, h, &jpeg_data, &jpeg_size, 80);
-
-  if (!ok || jpeg_size == 0) {
-    xSemaphoreGive(server->jpeg_mutex_);
-    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Encoding failed");
+  if (xTaskCreate(MipiCameraWebServer::stream_task_, "cam_stream", 4096, client, 5, nullptr) != pdPASS) {
+    ESP_LOGW(TAG, "Stream task creation failed");
+    httpd_resp_send_err(client->req, HTTPD_503_SERVICE_UNAVAILABLE, "Busy");
+    httpd_req_async_handler_complete(client->req);
+    delete client;
+    server->release_stage_(stage);
+    server->active_streams_--;
     return ESP_FAIL;
   }
+  return ESP_OK;
+}
 
-  // Envoyer l'image JPEG
-  httpd_resp_set_type(req, "image/jpeg");
+void MipiCameraWebServer::stream_task_(void *arg) {
+  StreamClient *client = (StreamClient *)arg;
+  MipiCameraWebServer *server = client->server;
+  ESP_LOGD(TAG, "Stream client connected (%u active)", server->active_streams_.load());
+  server->stream_loop_(*client);
+  httpd_req_async_handler_complete(client->req);
+  server->release_stage_(client->stage);
+  delete client;
+  server->active_streams_--;
+  ESP_LOGD(TAG, "Stream client gone (%u active)", server->active_streams_.load());
+  vTaskDelete(nullptr);
+}
+
+void MipiCameraWebServer::stream_loop_(const StreamClient &client) {
+  httpd_req_t *req = client.req;
+  JpegStage *stage = client.stage;
+  mipi_dsi_cam::FrameMetrics &metrics = this->camera_->get_metrics();
+  httpd_resp_set_type(req, STREAM_CONTENT_TYPE);
   httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
   httpd_resp_set_hdr(req, "Pragma", "no-cache");
-  httpd_resp_set_hdr(req, "Expires", "0");
-  
-  esp_err_t ret = httpd_resp_send(req, (const char *)jpeg_data, jpeg_size);
-  
-  xSemaphoreGive(server->jpeg_mutex_);
-  
-  return ret;
+
+  uint32_t last_jpeg = 0;
+  int64_t last_sent_us = 0;
+  int64_t stopped_since_us = 0;
+  for (;;) {
+    int64_t now = mipi_dsi_cam::capture_time_us();
+    if (!this->camera_->is_streaming()) {
+      // set_mode() arrête puis relance le flux : on attend la reprise
+      if (stopped_since_us == 0) {
+        stopped_since_us = now;
+      } else if (now - stopped_since_us > STREAM_STOP_GRACE_US) {
+        break;
+      }
+      vTaskDelay(pdMS_TO_TICKS(STREAM_POLL_MS));
+      continue;
+    }
+    stopped_since_us = 0;
+
+    // Plafond du client : pas d'image avant l'échéance
+    int64_t wait_us = last_sent_us + client.interval_us - now;
+    if (last_sent_us != 0 && wait_us > 0) {
+      vTaskDelay(std::max<TickType_t>(1, pdMS_TO_TICKS(wait_us / 1000)));
+      continue;
+    }
+
+    // Scène statique : le même JPEG repart une fois par seconde, un client
+    // parti ne se voit qu'à l'envoi
+    int8_t slot = stage->pool.acquire();
+    if (slot < 0 || (stage->pool.sequence(slot) == last_jpeg && now - last_sent_us < STREAM_KEEPALIVE_US)) {
+      stage->pool.release(slot);
+      this->want_jpeg_(stage);
+      vTaskDelay(pdMS_TO_TICKS(STREAM_POLL_MS));
+      continue;
+    }
+
+    // Envoi depuis le buffer partagé, sans verrou : la référence suffit
+    const mipi_dsi_cam::FrameInfo info = stage->pool.info(slot);
+    if (stage->sends[slot].fetch_add(1, std::memory_order_relaxed) != 0) {
+      metrics.increment(mipi_dsi_cam::COUNTER_JPEG_REUSED);
+    }
+    esp_err_t ret = this->send_stream_part_(req, info, stage->source_sequence[slot], stage->pool.data(slot),
+                                            info.received_size);
+    last_jpeg = stage->pool.sequence(slot);
+    last_sent_us = now;
+    stage->pool.release(slot);
+    if (ret != ESP_OK) {
+      // Client parti (ou trop lent pour le délai d'envoi de httpd)
+      return;
+    }
+    this->want_jpeg_(stage);
+  }
+  // Caméra arrêtée : fin propre de la réponse chunked
+  httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+void MipiCameraWebServer::encoder_task_(void *arg) {
+  MipiCameraWebServer *server = (MipiCameraWebServer *)arg;
+  for (;;) {
+    // Tant qu'un client attend, on guette la prochaine frame ; sinon on
+    // dort jusqu'à ce qu'il y en ait un
+    bool waiting = false;
+    for (JpegStage &stage : server->stages_) {
+      if (stage.users.load() != 0 && stage.wanted.load()) {
+        waiting = !server->encode_stage_(&stage) || waiting;
+      }
+    }
+    ulTaskNotifyTake(pdTRUE, waiting ? pdMS_TO_TICKS(STREAM_POLL_MS) : portMAX_DELAY);
+  }
 }
 
 esp_err_t MipiCameraWebServer::snapshot_handler_(httpd_req_t *req) {
@@ -236,42 +352,63 @@ esp_err_t MipiCameraWebServer::snapshot_handler_(httpd_req_t *req) {
     return ESP_FAIL;
   }
 
-  if (!server->camera_->capture_frame()) {
+  // Au moins aussi récente que la dernière frame à l'arrivée de la requête
+  mipi_dsi_cam::FrameHandle frame = server->camera_->acquire_frame();
+  if (!frame.valid()) {
     httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "No frame");
     return ESP_FAIL;
   }
-
-  uint8_t *rgb565 = server->camera_->get_image_data();
-  uint16_t w = server->camera_->get_image_width();
-  uint16_t h = server->camera_->get_image_height();
-
-  if (!rgb565) {
-    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Invalid data");
+  const uint32_t wanted = frame.info.sequence;
+  server->camera_->release_frame(frame);
+  JpegStage *stage = server->acquire_stage_(server->request_roi_(req), 90);
+  if (stage == nullptr) {
+    httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Busy");
     return ESP_FAIL;
   }
 
-  if (xSemaphoreTake(server->jpeg_mutex_, pdMS_TO_TICKS(1000)) != pdTRUE) {
+  // Snapshots simultanés : un seul encodage, partagé. Entre deux essais, la
+  // tâche httpd dort jusqu'au prochain JPEG publié de l'étage (ou la fin du
+  // délai), notifiée par stage_updated_()
+  mipi_dsi_cam::FrameMetrics &metrics = server->camera_->get_metrics();
+  int8_t slot = -1;
+  const int64_t deadline = mipi_dsi_cam::capture_time_us() + 1000000;
+  stage->waiter.store(xTaskGetCurrentTaskHandle());
+  for (;;) {
+    // current_sequence lu avant acquire() : le JPEG obtenu est au moins celui
+    // qui la représentait
+    uint32_t current = stage->current_sequence.load(std::memory_order_acquire);
+    slot = stage->pool.acquire();
+    if (slot >= 0 && (int32_t) (current - wanted) >= 0) {
+      break;
+    }
+    stage->pool.release(slot);
+    slot = -1;
+    const int64_t remaining_us = deadline - mipi_dsi_cam::capture_time_us();
+    if (remaining_us <= 0) {
+      break;
+    }
+    server->want_jpeg_(stage);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(remaining_us / 1000 + 1));
+  }
+  stage->waiter.store(nullptr);
+  if (slot < 0) {
+    server->release_stage_(stage);
+    metrics.increment(mipi_dsi_cam::COUNTER_ENCODER_BUSY);
     httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Busy");
     return ESP_FAIL;
   }
-
-  uint8_t *jpeg_data = nullptr;
-  size_t jpeg_size = 0;
-  bool ok = server->encode_jpeg_(rgb565, w, h, &jpeg_data, &jpeg_size, 90);
-
-  if (!ok || jpeg_size == 0) {
-    xSemaphoreGive(server->jpeg_mutex_);
-    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Encoding failed");
-    return ESP_FAIL;
+  if (stage->sends[slot].fetch_add(1, std::memory_order_relaxed) != 0) {
+    metrics.increment(mipi_dsi_cam::COUNTER_JPEG_REUSED);
   }
 
   // Envoyer l'image avec header de téléchargement
   httpd_resp_set_type(req, "image/jpeg");
   httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=snapshot.jpg");
   
-  esp_err_t ret = httpd_resp_send(req, (const char *)jpeg_data, jpeg_size);
-  
-  xSemaphoreGive(server->jpeg_mutex_);
+  const mipi_dsi_cam::FrameInfo info = stage->pool.info(slot);
+  esp_err_t ret = server->send_jpeg_(req, info, stage->pool.data(slot), info.received_size);
+  stage->pool.release(slot);
+  server->release_stage_(stage);
   
   return ret;
 }
@@ -302,23 +439,268 @@ esp_err_t MipiCameraWebServer::control_handler_(httpd_req_t *req) {
   return ESP_FAIL;
 }
 
-bool MipiCameraWebServer::encode_jpeg_(const uint8_t *rgb565, size_t w, size_t h,
-                                       uint8_t **jpeg_out, size_t *jpeg_size, int quality) {
-  // Allouer RGB888 temporaire en PSRAM
-  size_t rgb888_size = w * h * 3;
-  uint8_t *rgb888 = (uint8_t *)heap_caps_malloc(rgb888_size, MALLOC_CAP_SPIRAM);
-  if (!rgb888) {
-    ESP_LOGE(TAG, "RGB888 alloc failed");
-    return false;
+esp_err_t MipiCameraWebServer::metrics_handler_(httpd_req_t *req) {
+  MipiCameraWebServer *server = (MipiCameraWebServer *)req->user_ctx;
+
+  std::string body;
+  body.reserve(10 * 1024);
+  server->camera_->write_metrics(body);
+
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+  return httpd_resp_send(req, body.c_str(), body.size());
+}
+
+esp_err_t MipiCameraWebServer::send_jpeg_(httpd_req_t *req, const mipi_dsi_cam::FrameInfo &info,
+                                          const uint8_t *jpeg, size_t size) {
+  int64_t start = mipi_dsi_cam::capture_time_us();
+  esp_err_t ret = httpd_resp_send(req, (const char *)jpeg, size);
+  if (ret != ESP_OK) {
+    this->camera_->get_metrics().increment(mipi_dsi_cam::COUNTER_SEND_FAILURES);
+    return ret;
+  }
+  this->record_sent_(info, start);
+  return ret;
+}
+
+esp_err_t MipiCameraWebServer::send_stream_part_(httpd_req_t *req, const mipi_dsi_cam::FrameInfo &info,
+                                                 uint32_t sequence, const uint8_t *jpeg, size_t size) {
+  char header[192];
+  int length = snprintf(header, sizeof(header), STREAM_PART_HEADER, (unsigned) size, (unsigned) sequence,
+                        (long long) info.timestamp_us);
+  int64_t start = mipi_dsi_cam::capture_time_us();
+  esp_err_t ret = httpd_resp_send_chunk(req, header, length);
+  if (ret == ESP_OK) {
+    ret = httpd_resp_send_chunk(req, (const char *)jpeg, size);
+  }
+  if (ret != ESP_OK) {
+    // Le plus souvent un client qui a fermé le flux
+    this->camera_->get_metrics().increment(mipi_dsi_cam::COUNTER_SEND_FAILURES);
+    return ret;
+  }
+  this->record_sent_(info, start);
+  return ret;
+}
+
+void MipiCameraWebServer::record_sent_(const mipi_dsi_cam::FrameInfo &info, int64_t start) {
+  mipi_dsi_cam::FrameMetrics &metrics = this->camera_->get_metrics();
+  // Dernier octet remis à la pile TCP : la latence vue par le client, à l'ack près
+  metrics.record(mipi_dsi_cam::STAGE_HTTP_SEND, mipi_dsi_cam::capture_time_us() - start);
+  metrics.record(mipi_dsi_cam::STAGE_GLASS_TO_CLIENT, mipi_dsi_cam::MipiDsiCam::get_frame_age_us(info));
+}
+
+MipiCameraWebServer::JpegStage *MipiCameraWebServer::acquire_stage_(int roi, int quality) {
+  xSemaphoreTake(this->jpeg_mutex_, portMAX_DELAY);
+  JpegStage *found = nullptr;
+  for (JpegStage &stage : this->stages_) {
+    if (stage.quality == quality && stage.roi == roi) {
+      found = &stage;
+      break;
+    }
+  }
+  if (found == nullptr) {
+    // Étage neuf tant que moins de max_jpeg_profiles_ ont des buffers (les
+    // profils sans client gardent leur dernier JPEG), sinon les buffers d'un
+    // profil sans client : plus référencés, l'encodeur est arrêté (jpeg_mutex_)
+    uint8_t buffered = 0;
+    JpegStage *fresh = nullptr;
+    for (JpegStage &stage : this->stages_) {
+      const bool has_buffers = stage.buffers[0] != nullptr;
+      buffered += has_buffers;
+      if (stage.users.load() != 0) {
+        continue;
+      }
+      if (!has_buffers && fresh == nullptr) {
+        fresh = &stage;
+      } else if (has_buffers && found == nullptr) {
+        found = &stage;
+      }
+    }
+    if (fresh != nullptr && buffered < this->max_jpeg_profiles_) {
+      found = fresh;
+    }
+    if (found != nullptr) {
+      for (uint8_t i = 0; i < JPEG_SLOTS && found != nullptr; i++) {
+        if (found->buffers[i] == nullptr) {
+          found->buffers[i] = (uint8_t *)heap_caps_malloc(this->jpeg_buffer_size_, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (found->buffers[i] == nullptr) {
+          ESP_LOGE(TAG, "Failed to allocate JPEG buffer");
+          // Tout ou rien : buffers[0] dit si l'étage compte dans le plafond
+          for (uint8_t j = 0; j < i; j++) {
+            heap_caps_free(found->buffers[j]);
+            found->buffers[j] = nullptr;
+          }
+          found = nullptr;
+        }
+      }
+    }
+    if (found != nullptr) {
+      found->pool.init(found->buffers, JPEG_SLOTS, this->jpeg_buffer_size_);
+      found->roi = roi;
+      found->quality = quality;
+      found->current_sequence.store(0);
+      found->checked_sequence = 0;
+      found->wanted.store(false);
+    }
+  }
+  if (found != nullptr) {
+    found->users++;
   }
+  xSemaphoreGive(this->jpeg_mutex_);
+  return found;
+}
 
-  // Convertir RGB565 -> RGB888
-  this->rgb565_to_rgb888_(rgb565, rgb888, w * h);
+void MipiCameraWebServer::want_jpeg_(JpegStage *stage) {
+  if (!stage->wanted.exchange(true)) {
+    xTaskNotifyGive(this->encoder_task_handle_);
+  }
+}
+
+bool MipiCameraWebServer::encode_stage_(JpegStage *stage) {
+  // Tenu tout du long : acquire_stage_() ne reprend pas l'étage en cours de route
+  xSemaphoreTake(this->jpeg_mutex_, portMAX_DELAY);
+  bool ok = false;
+  // Référence sur la dernière frame : le DMA ne l'écrase pas pendant l'encodage
+  mipi_dsi_cam::FrameHandle frame = this->camera_->acquire_frame();
+  mipi_dsi_cam::FrameMetrics &metrics = this->camera_->get_metrics();
+  if (stage->users.load() == 0 || !frame.valid() || frame.info.sequence == stage->checked_sequence) {
+    // Rien de neuf
+  } else if (this->skip_unchanged_ && stage->current_sequence.load() != 0 &&
+             !this->camera_->has_content_changed(frame, stage->signature)) {
+    // Scène inchangée : le JPEG publié vaut pour cette frame aussi
+    this->stage_updated_(stage, frame.info.sequence);
+    metrics.increment(mipi_dsi_cam::COUNTER_NOT_MODIFIED);
+  } else {
+    mipi_dsi_cam::FrameInfo info = frame.info;
+    metrics.record(mipi_dsi_cam::STAGE_ACQUIRE, mipi_dsi_cam::MipiDsiCam::get_frame_age_us(info));
+    // Tous les buffers encore en cours d'envoi : frame sautée
+    int8_t slot = stage->pool.begin_write();
+    if (slot < 0) {
+      metrics.increment(mipi_dsi_cam::COUNTER_ENCODER_BUSY);
+    } else {
+      // Crop / zoom : simple vue dans la frame, la copie se fait à la conversion
+      size_t jpeg_size = 0;
+      ok = this->encode_jpeg_(this->roi_view_(frame, stage->roi), stage->pool.data(slot), &jpeg_size,
+                              stage->quality);
+      if (ok) {
+        if (this->skip_unchanged_) {
+          stage->signature = this->camera_->get_frame_signature(frame);
+        }
+        stage->source_sequence[slot] = info.sequence;
+        stage->sends[slot].store(0, std::memory_order_relaxed);
+        info.received_size = jpeg_size;
+        stage->pool.commit_write(slot, info);
+        stage->pool.publish_pending();
+        stage->wanted.store(false);
+        this->stage_updated_(stage, info.sequence);
+      } else {
+        stage->pool.cancel_write(slot);
+      }
+    }
+  }
+  if (frame.valid()) {
+    stage->checked_sequence = frame.info.sequence;
+  }
+  this->camera_->release_frame(frame);
+  xSemaphoreGive(this->jpeg_mutex_);
+  return ok;
+}
+
+void MipiCameraWebServer::stage_updated_(JpegStage *stage, uint32_t sequence) {
+  stage->current_sequence.store(sequence, std::memory_order_release);
+  TaskHandle_t waiter = stage->waiter.load();
+  if (waiter != nullptr) {
+    xTaskNotifyGive(waiter);
+  }
+}
+
+int MipiCameraWebServer::request_roi_(httpd_req_t *req) const {
+  char query[64];
+  char param[8];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "roi", param, sizeof(param)) == ESP_OK) {
+    int id = atoi(param);
+    if (id >= 0 && id < mipi_dsi_cam::MipiDsiCam::MAX_ROIS) {
+      return id;
+    }
+  }
+  return -1;
+}
+
+mipi_dsi_cam::FrameView MipiCameraWebServer::roi_view_(const mipi_dsi_cam::FrameHandle &frame, int roi) const {
+  // ROI effacée depuis la requête : retour à la fenêtre de zoom
+  if (roi >= 0 && this->camera_->has_roi(roi)) {
+    return this->camera_->get_roi_view(frame, roi);
+  }
+  return this->camera_->get_zoom_view(frame);
+}
+
+uint32_t MipiCameraWebServer::request_interval_us_(httpd_req_t *req) const {
+  uint32_t fps = this->max_stream_fps_;
+  char query[64];
+  char param[8];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "fps", param, sizeof(param)) == ESP_OK) {
+    int requested = atoi(param);
+    // Le client peut baisser le plafond, pas le dépasser
+    if (requested > 0 && (fps == 0 || (uint32_t) requested < fps)) {
+      fps = requested;
+    }
+  }
+  return fps != 0 ? 1000000 / fps : 0;
+}
+
+bool MipiCameraWebServer::encode_jpeg_(const mipi_dsi_cam::FrameView &source, uint8_t *jpeg, size_t *jpeg_size,
+                                       int quality) {
+  mipi_dsi_cam::FrameMetrics &metrics = this->camera_->get_metrics();
+  mipi_dsi_cam::FrameView view = source;
+  // Rotation / miroir : copie tournée dans le format de la frame (contiguë,
+  // le YUV422 part ensuite tel quel à l'encodeur)
+  uint8_t *turned = nullptr;
+  if (!this->transform_.is_identity()) {
+    turned = (uint8_t *)heap_caps_malloc(source.row_bytes() * source.height, MALLOC_CAP_SPIRAM);
+    if (!turned) {
+      ESP_LOGE(TAG, "Rotation buffer alloc failed");
+      metrics.increment(mipi_dsi_cam::COUNTER_ENCODE_FAILURES);
+      return false;
+    }
+    int64_t rotate_start = mipi_dsi_cam::capture_time_us();
+    view = mipi_dsi_cam::transformed_view(source, this->transform_, turned);
+    mipi_dsi_cam::transform_frame(source, view, this->transform_);
+    metrics.record(mipi_dsi_cam::STAGE_ROTATE, mipi_dsi_cam::capture_time_us() - rotate_start);
+  }
+
+  size_t w = view.width;
+  size_t h = view.height;
+  // YUV422 : l'encodeur le prend tel quel (aucune conversion si la vue est
+  // contiguë). RGB565 / RAW8 : conversion RGB888 ligne par ligne (stride).
+  const bool yuv = view.format == mipi_dsi_cam::PIXEL_FORMAT_YUV422;
+  const uint8_t *input = view.data;
+  uint8_t *converted = nullptr;
+  size_t input_size = w * h * 2;
+  if (!yuv || !view.is_packed()) {
+    input_size = w * h * (yuv ? 2 : 3);
+    converted = (uint8_t *)heap_caps_malloc(input_size, MALLOC_CAP_SPIRAM);
+    if (!converted) {
+      ESP_LOGE(TAG, "JPEG input alloc failed");
+      heap_caps_free(turned);
+      metrics.increment(mipi_dsi_cam::COUNTER_ENCODE_FAILURES);
+      return false;
+    }
+    int64_t convert_start = mipi_dsi_cam::capture_time_us();
+    if (yuv) {
+      mipi_dsi_cam::convert_to_yuv422(view, converted);
+    } else {
+      mipi_dsi_cam::convert_to_rgb888(view, converted, this->camera_->get_demosaic_method());
+    }
+    metrics.record(mipi_dsi_cam::STAGE_CONVERT, mipi_dsi_cam::capture_time_us() - convert_start);
+    input = converted;
+  }
 
   // Configuration de l'encodeur JPEG ESP-IDF
   jpeg_encode_config_t encode_config = {
-    .src_type = JPEG_ENCODE_IN_FORMAT_RGB888,
-    .sub_sample = JPEG_DOWN_SAMPLING_YUV420,
+    .src_type = yuv ? JPEG_ENCODE_IN_FORMAT_YUV422 : JPEG_ENCODE_IN_FORMAT_RGB888,
+    .sub_sample = yuv ? JPEG_DOWN_SAMPLING_YUV422 : JPEG_DOWN_SAMPLING_YUV420,
     .image_quality = quality,
     .width = (int)w,
     .height = (int)h,
@@ -334,64 +716,46 @@ bool MipiCameraWebServer::encode_jpeg_(const uint8_t *rgb565, size_t w, size_t h
   esp_err_t ret = jpeg_new_encoder_engine(&engine_cfg, &encoder_handle);
   if (ret != ESP_OK || encoder_handle == nullptr) {
     ESP_LOGE(TAG, "Failed to create JPEG encoder: 0x%x", ret);
-    heap_caps_free(rgb888);
+    heap_caps_free(converted);
+    heap_caps_free(turned);
+    metrics.increment(mipi_dsi_cam::COUNTER_ENCODE_FAILURES);
     return false;
   }
 
-  // Préparer la structure pour l'encodage
-  jpeg_encode_picture_t encode_pic = {
-    .width = (int)w,
-    .height = (int)h,
-    .format = JPEG_ENCODE_IN_FORMAT_RGB888,
-    .color_space = JPEG_ENC_COLOR_SPACE_RGB,
-  };
-
   uint32_t out_size = 0;
   
   // Encoder l'image
+  int64_t encode_start = mipi_dsi_cam::capture_time_us();
   ret = jpeg_encoder_process(
     encoder_handle,
     &encode_config,
-    rgb888,
-    rgb888_size,
-    this->jpeg_buffer_,
+    input,
+    input_size,
+    jpeg,
     this->jpeg_buffer_size_,
     &out_size
   );
 
   // Libérer les ressources
   jpeg_del_encoder_engine(encoder_handle);
-  heap_caps_free(rgb888);
+  heap_caps_free(converted);
+  heap_caps_free(turned);
 
   if (ret != ESP_OK || out_size == 0) {
     ESP_LOGE(TAG, "JPEG encoding failed: 0x%x, size: %u", ret, out_size);
+    metrics.increment(mipi_dsi_cam::COUNTER_ENCODE_FAILURES);
     return false;
   }
+  metrics.record(mipi_dsi_cam::STAGE_JPEG_ENCODE, mipi_dsi_cam::capture_time_us() - encode_start);
 
   *jpeg_size = out_size;
-  *jpeg_out = this->jpeg_buffer_;
 
   ESP_LOGV(TAG, "JPEG encoded: %ux%u -> %u bytes (quality: %d)", w, h, out_size, quality);
   
   return true;
 }
 
-void MipiCameraWebServer::rgb565_to_rgb888_(const uint8_t *rgb565, uint8_t *rgb888, size_t pixels) {
-  for (size_t i = 0; i < pixels; i++) {
-    // Lire pixel RGB565 (little-endian)
-    uint16_t px = (rgb565[i * 2 + 1] << 8) | rgb565[i * 2];
-    
-    // Extraire les composantes RGB565
-    uint8_t r5 = (px >> 11) & 0x1F;
-    uint8_t g6 = (px >> 5) & 0x3F;
-    uint8_t b5 = px & 0x1F;
-    
-    // Convertir en RGB888 avec expansion
-    rgb888[i * 3 + 0] = (r5 << 3) | (r5 >> 2);  // R
-    rgb888[i * 3 + 1] = (g6 << 2) | (g6 >> 4);  // G
-    rgb888[i * 3 + 2] = (b5 << 3) | (b5 >> 2);  // B
-  }
-}
-
 }  // namespace mipi_camera_web_server
 }  // namespace esphome
+
+#endif  // USE_ESP32_VARIANT_ESP32P4
@@ -2,9 +2,12 @@
 
 #include "esphome/core/component.h"
 #include "esphome/components/mipi_dsi_cam/mipi_dsi_cam.h"
+#include "esphome/components/mipi_dsi_cam/frame_transform.h"
+#include "esphome/components/mipi_dsi_cam/pixel_convert.h"
 
 #ifdef USE_ESP32_VARIANT_ESP32P4
 #include <esp_http_server.h>
+#include <atomic>
 #endif
 
 namespace esphome {
@@ -19,29 +22,113 @@ class MipiCameraWebServer : public Component {
 
   void set_camera(mipi_dsi_cam::MipiDsiCam *camera) { this->camera_ = camera; }
   void set_port(uint16_t port) { this->port_ = port; }
+  // Scène inchangée (MipiDsiCam::has_content_changed) : pas de nouvel
+  // encodage, le JPEG précédent reste servi
+  void set_skip_unchanged(bool skip) { this->skip_unchanged_ = skip; }
+  // /stream en MJPEG (multipart/x-mixed-replace) : images/s max par client,
+  // ?fps=N le baisse, 0 = chaque nouvelle frame
+  void set_max_stream_fps(uint8_t fps) { this->max_stream_fps_ = fps; }
+  // Clients /stream simultanés : une tâche et un socket chacun
+  void set_max_streams(uint8_t count) { this->max_streams_ = count; }
+  // Profils JPEG (zone + qualité) avec leurs buffers en même temps : au-delà,
+  // un nouveau profil reprend les buffers d'un profil sans client, sinon 503
+  void set_max_jpeg_profiles(uint8_t count) { this->max_jpeg_profiles_ = count; }
+  // Image tournée / retournée avant l'encodage JPEG (frame_transform.h)
+  void set_rotation(mipi_dsi_cam::FrameRotation rotation) { this->transform_.rotation = rotation; }
+  void set_mirror_x(bool mirror) { this->transform_.mirror_x = mirror; }
+  void set_mirror_y(bool mirror) { this->transform_.mirror_y = mirror; }
 
  protected:
   mipi_dsi_cam::MipiDsiCam *camera_{nullptr};
   uint16_t port_{80};
+  bool skip_unchanged_{true};
+  uint8_t max_stream_fps_{0};
+  uint8_t max_streams_{3};
+  uint8_t max_jpeg_profiles_{2};
+  mipi_dsi_cam::FrameTransform transform_{};
 
 #ifdef USE_ESP32_VARIANT_ESP32P4
   httpd_handle_t server_{nullptr};
   
-  // Buffer pour JPEG
-  uint8_t *jpeg_buffer_{nullptr};
+  // Capacité de chaque buffer JPEG
   size_t jpeg_buffer_size_{150 * 1024};
+  // Table des étages et encodeur matériel (pas les envois)
   SemaphoreHandle_t jpeg_mutex_{nullptr};
+  TaskHandle_t encoder_task_handle_{nullptr};
+
+  // Étage d'encodage d'un profil (zone + qualité) : chaque nouvelle frame
+  // demandée est encodée une fois dans un FramePool de JPEG, et tous les
+  // clients du profil envoient le dernier JPEG par référence, sans verrou.
+  // Le pool ne réécrit jamais un buffer encore référencé par un envoi.
+  static constexpr uint8_t JPEG_SLOTS = 4;
+  static constexpr uint8_t JPEG_STAGES = mipi_dsi_cam::MipiDsiCam::MAX_ROIS + 1;
+  struct JpegStage {
+    int roi{-1};       // ?roi=N, -1 = fenêtre de zoom
+    int quality{0};    // 0 = étage jamais utilisé
+    uint8_t *buffers[JPEG_SLOTS]{};
+    mipi_dsi_cam::FramePool pool;  // FrameInfo::received_size = taille du JPEG
+    // Frame source de chaque slot, stable tant que le slot est référencé
+    uint32_t source_sequence[JPEG_SLOTS]{};
+    std::atomic<uint16_t> sends[JPEG_SLOTS]{};
+    // Dernière frame traitée : le dernier JPEG publié la représente encore
+    // (encodée, ou inchangée depuis)
+    std::atomic<uint32_t> current_sequence{0};
+    // Réservé à la tâche d'encodage
+    uint32_t checked_sequence{0};
+    mipi_dsi_cam::FrameSignature signature;
+    std::atomic<uint8_t> users{0};     // clients /stream et snapshots en cours
+    std::atomic<bool> wanted{false};   // un client attend une image plus récente
+    // Snapshot en attente (tâche httpd), notifié à chaque JPEG publié
+    std::atomic<TaskHandle_t> waiter{nullptr};
+  };
+  JpegStage stages_[JPEG_STAGES];
+  
+  // Un client /stream : la requête est détachée de httpd (handler
+  // asynchrone) pour que le serveur continue de répondre aux autres
+  struct StreamClient {
+    MipiCameraWebServer *server;
+    httpd_req_t *req;      // rendue par httpd_req_async_handler_complete()
+    JpegStage *stage;      // rendu par release_stage_()
+    uint32_t interval_us;  // plafond d'images/s du client, 0 = aucun
+  };
+  std::atomic<uint8_t> active_streams_{0};
   
   // Handlers HTTP
   static esp_err_t index_handler_(httpd_req_t *req);
   static esp_err_t stream_handler_(httpd_req_t *req);
   static esp_err_t snapshot_handler_(httpd_req_t *req);
   static esp_err_t control_handler_(httpd_req_t *req);
+  // Latences par étape et compteurs du pipeline, format texte Prometheus
+  static esp_err_t metrics_handler_(httpd_req_t *req);
   
-  bool encode_jpeg_(const uint8_t *rgb565_data, size_t width, size_t height, 
-                    uint8_t **jpeg_out, size_t *jpeg_size, int quality = 12);
+  static void stream_task_(void *arg);
+  static void encoder_task_(void *arg);
+  // Envoie chaque nouveau JPEG de l'étage jusqu'à ce que le client parte
+  void stream_loop_(const StreamClient &client);
   
-  static void rgb565_to_rgb888_(const uint8_t *rgb565, uint8_t *rgb888, size_t pixels);
+  // Étage du profil, créé ou repris à un étage sans client ; nullptr si
+  // tous servent déjà d'autres profils ou si max_jpeg_profiles_ étages ont
+  // déjà des buffers et qu'aucun n'est libre
+  JpegStage *acquire_stage_(int roi, int quality);
+  void release_stage_(JpegStage *stage) { stage->users--; }
+  // Réveille la tâche d'encodage : un client attend un JPEG plus récent
+  void want_jpeg_(JpegStage *stage);
+  // Encode la dernière frame pour l'étage si elle est nouvelle (tâche d'encodage)
+  bool encode_stage_(JpegStage *stage);
+  // current_sequence à jour : réveille le snapshot qui attend l'étage
+  void stage_updated_(JpegStage *stage, uint32_t sequence);
+  // Zone de la frame demandée (?roi=N), sinon la fenêtre de zoom de la caméra
+  int request_roi_(httpd_req_t *req) const;
+  mipi_dsi_cam::FrameView roi_view_(const mipi_dsi_cam::FrameHandle &frame, int roi) const;
+  uint32_t request_interval_us_(httpd_req_t *req) const;
+  // Vue dans n'importe quel pixel_format (conversion pixel_convert.h si besoin)
+  bool encode_jpeg_(const mipi_dsi_cam::FrameView &source, uint8_t *jpeg, size_t *jpeg_size, int quality = 12);
+  // httpd_resp_send() chronométré : envoi et latence glass-to-client de la frame
+  esp_err_t send_jpeg_(httpd_req_t *req, const mipi_dsi_cam::FrameInfo &info, const uint8_t *jpeg, size_t size);
+  // Même chose pour une partie du flux multipart (en-tête de partie + JPEG)
+  esp_err_t send_stream_part_(httpd_req_t *req, const mipi_dsi_cam::FrameInfo &info, uint32_t sequence,
+                              const uint8_t *jpeg, size_t size);
+  void record_sent_(const mipi_dsi_cam::FrameInfo &info, int64_t start);
 #endif
 };
 
@@ -1,20 +1,35 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import i2c
+from esphome import automation
+from esphome.components import i2c, time
 from esphome.const import (
     CONF_ID,
+    CONF_TRIGGER_ID,
     CONF_NAME,
     CONF_FREQUENCY,
     CONF_ADDRESS,
+    CONF_WIDTH,
+    CONF_HEIGHT,
+    CONF_TIME_ID,
 )
+from esphome.core import CORE
 from esphome import pins
 
+from .sensor_codegen import generate_driver_factory
+
 CODEOWNERS = ["@youkorr"]
-DEPENDENCIES = ["i2c", "esp32"]
+DOMAIN = "mipi_dsi_cam"
 MULTI_CONF = True
 
 mipi_dsi_cam_ns = cg.esphome_ns.namespace("mipi_dsi_cam")
 MipiDsiCam = mipi_dsi_cam_ns.class_("MipiDsiCam", cg.Component, i2c.I2CDevice)
+CaptureBackend = mipi_dsi_cam_ns.class_("CaptureBackend")
+VirtualCsiBackend = mipi_dsi_cam_ns.class_("VirtualCsiBackend", CaptureBackend)
+FrameRoi = mipi_dsi_cam_ns.struct("FrameRoi")
+MotionConfig = mipi_dsi_cam_ns.struct("MotionConfig")
+MotionResult = mipi_dsi_cam_ns.struct("MotionResult")
+MotionStartTrigger = mipi_dsi_cam_ns.class_("MotionStartTrigger", automation.Trigger.template(MotionResult))
+MotionEndTrigger = mipi_dsi_cam_ns.class_("MotionEndTrigger", automation.Trigger.template(MotionResult))
 
 CONF_EXTERNAL_CLOCK_PIN = "external_clock_pin"
 CONF_RESET_PIN = "reset_pin"
@@ -23,8 +38,61 @@ CONF_LANE = "lane"
 CONF_ADDRESS_SENSOR = "address_sensor"
 CONF_RESOLUTION = "resolution"
 CONF_PIXEL_FORMAT = "pixel_format"
+CONF_DEMOSAIC = "demosaic"
 CONF_FRAMERATE = "framerate"
 CONF_JPEG_QUALITY = "jpeg_quality"
+CONF_FRAME_BUFFERS = "frame_buffers"
+CONF_AE_METERING = "ae_metering"
+CONF_AE_EXPOSURE_MIN = "ae_exposure_min"
+CONF_AE_EXPOSURE_MAX = "ae_exposure_max"
+CONF_AE_MAX_GAIN_INDEX = "ae_max_gain_index"
+CONF_AWB_MODE = "awb_mode"
+CONF_STATS_ZONES = "stats_zones"
+CONF_STATS_BUDGET = "stats_budget"
+CONF_CHANGE_THRESHOLD = "change_threshold"
+CONF_VIRTUAL_CAMERA = "virtual_camera"
+CONF_PATTERN = "pattern"
+CONF_REPLAY_FILE = "replay_file"
+CONF_REPLAY_FORMAT = "replay_format"
+CONF_TONE = "tone"
+CONF_GAMMA = "gamma"
+CONF_CONTRAST = "contrast"
+CONF_BRIGHTNESS = "brightness"
+CONF_SATURATION = "saturation"
+CONF_DIGITAL_ZOOM = "digital_zoom"
+CONF_FACTOR = "factor"
+CONF_CENTER_X = "center_x"
+CONF_CENTER_Y = "center_y"
+CONF_ROIS = "rois"
+CONF_X = "x"
+CONF_Y = "y"
+CONF_MOTION = "motion"
+CONF_PLANE_WIDTH = "plane_width"
+CONF_PLANE_HEIGHT = "plane_height"
+CONF_CELL_SIZE = "cell_size"
+CONF_SENSITIVITY = "sensitivity"
+CONF_MIN_AREA = "min_area"
+CONF_LEARNING_RATE = "learning_rate"
+CONF_BUDGET = "budget"
+CONF_MASKS = "masks"
+CONF_ON_MOTION_START = "on_motion_start"
+CONF_ON_MOTION_END = "on_motion_end"
+CONF_OSD = "osd"
+CONF_LABEL = "label"
+CONF_TIMESTAMP = "timestamp"
+CONF_STATS = "stats"
+CONF_MOTION_BOXES = "motion_boxes"
+CONF_POSITION = "position"
+CONF_SCALE = "scale"
+CONF_BACKGROUND_OPACITY = "background_opacity"
+CONF_COLOR = "color"
+
+# MipiDsiCam::MAX_ROIS
+MAX_ROIS = 4
+# MotionDetector::MAX_MASKS / MAX_PLANE_WIDTH / MAX_PLANE_HEIGHT
+MAX_MOTION_MASKS = 8
+MAX_MOTION_PLANE_WIDTH = 160
+MAX_MOTION_PLANE_HEIGHT = 120
 
 PixelFormat = mipi_dsi_cam_ns.enum("PixelFormat")
 PIXEL_FORMAT_RGB565 = PixelFormat.PIXEL_FORMAT_RGB565
@@ -37,6 +105,63 @@ PIXEL_FORMATS = {
     "RAW8": PIXEL_FORMAT_RAW8,
 }
 
+DemosaicMethod = mipi_dsi_cam_ns.enum("DemosaicMethod")
+DEMOSAIC_METHODS = {
+    "NEAREST": DemosaicMethod.DEMOSAIC_NEAREST,
+    "BILINEAR": DemosaicMethod.DEMOSAIC_BILINEAR,
+    "EDGE_AWARE": DemosaicMethod.DEMOSAIC_EDGE_AWARE,
+}
+
+MeteringMode = mipi_dsi_cam_ns.enum("MeteringMode")
+METERING_MODES = {
+    "AVERAGE": MeteringMode.METERING_AVERAGE,
+    "CENTER_WEIGHTED": MeteringMode.METERING_CENTER_WEIGHTED,
+    "SPOT": MeteringMode.METERING_SPOT,
+}
+
+AwbMode = mipi_dsi_cam_ns.enum("AwbMode")
+AWB_MODES = {
+    "OFF": AwbMode.AWB_OFF,
+    "GRAY_WORLD": AwbMode.AWB_GRAY_WORLD,
+    "WHITE_PATCH": AwbMode.AWB_WHITE_PATCH,
+}
+# Capteurs dont l'AWB matériel de l'ISP est désactivé : AWB logicielle par défaut
+SOFTWARE_AWB_SENSORS = ["ov5647", "sc202cs"]
+
+OsdConfig = mipi_dsi_cam_ns.struct("OsdConfig")
+OsdPosition = mipi_dsi_cam_ns.enum("OsdPosition")
+OSD_POSITIONS = {
+    "TOP_LEFT": OsdPosition.OSD_TOP_LEFT,
+    "TOP_RIGHT": OsdPosition.OSD_TOP_RIGHT,
+    "BOTTOM_LEFT": OsdPosition.OSD_BOTTOM_LEFT,
+    "BOTTOM_RIGHT": OsdPosition.OSD_BOTTOM_RIGHT,
+}
+
+VirtualPattern = mipi_dsi_cam_ns.enum("VirtualPattern")
+VIRTUAL_PATTERNS = {
+    "COLOR_BARS": VirtualPattern.VIRTUAL_PATTERN_COLOR_BARS,
+    "GRADIENT": VirtualPattern.VIRTUAL_PATTERN_GRADIENT,
+    "NOISE": VirtualPattern.VIRTUAL_PATTERN_NOISE,
+}
+
+VirtualReplayFormat = mipi_dsi_cam_ns.enum("VirtualReplayFormat")
+VIRTUAL_REPLAY_FORMATS = {
+    "RGB565": VirtualReplayFormat.VIRTUAL_REPLAY_RGB565,
+    "RAW8": VirtualReplayFormat.VIRTUAL_REPLAY_RAW8,
+}
+
+# Capteur sans matériel (host) : utilisé avec le backend CSI virtuel
+MOCK_SENSOR = "mock"
+MOCK_SENSOR_INFO = {
+    'width': 1280,
+    'height': 720,
+    'lane_count': 2,
+    'bayer_pattern': 0,
+    'lane_bitrate_mbps': 800,
+    'i2c_address': 0x36,
+    'fps': 30,
+}
+
 # Résolutions disponibles
 RESOLUTIONS = {
     "720P": (1280, 720),
@@ -131,6 +256,8 @@ def load_sensors():
 load_sensors()
 
 def validate_sensor(value):
+    if value == MOCK_SENSOR:
+        return value
     if value not in AVAILABLE_SENSORS:
         available = ', '.join(AVAILABLE_SENSORS.keys())
         raise cv.Invalid(
@@ -182,7 +309,88 @@ def validate_external_clock_pin(value):
     # On le passe à travers le validateur de pin
     return pins.internal_gpio_output_pin_schema(value)
 
-CONFIG_SCHEMA = cv.Schema(
+VIRTUAL_CAMERA_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(VirtualCsiBackend),
+        # 0 = framerate du capteur
+        cv.Optional(CONF_FRAMERATE, default=0): cv.int_range(min=0, max=240),
+        cv.Optional(CONF_PATTERN, default="COLOR_BARS"): cv.enum(VIRTUAL_PATTERNS, upper=True),
+        cv.Optional(CONF_REPLAY_FILE): cv.string,
+        cv.Optional(CONF_REPLAY_FORMAT, default="RGB565"): cv.enum(VIRTUAL_REPLAY_FORMATS, upper=True),
+    }
+)
+
+TONE_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_GAMMA, default=1.0): cv.float_range(min=0.2, max=5.0),
+        cv.Optional(CONF_CONTRAST, default=1.0): cv.float_range(min=0.0, max=4.0),
+        cv.Optional(CONF_BRIGHTNESS, default=0): cv.int_range(min=-100, max=100),
+        cv.Optional(CONF_SATURATION, default=1.0): cv.float_range(min=0.0, max=4.0),
+    }
+)
+
+DIGITAL_ZOOM_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_FACTOR): cv.float_range(min=1.0, max=16.0),
+        cv.Optional(CONF_CENTER_X, default=0.5): cv.percentage,
+        cv.Optional(CONF_CENTER_Y, default=0.5): cv.percentage,
+    }
+)
+
+ROI_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_X, default=0): cv.uint16_t,
+        cv.Optional(CONF_Y, default=0): cv.uint16_t,
+        cv.Required(CONF_WIDTH): cv.int_range(min=2, max=65535),
+        cv.Required(CONF_HEIGHT): cv.int_range(min=2, max=65535),
+    }
+)
+
+MOTION_SCHEMA = cv.Schema(
+    {
+        # Plan luma réduit (boîtes moyennées) et taille des cellules en pixels du plan
+        cv.Optional(CONF_PLANE_WIDTH, default=80): cv.int_range(min=16, max=MAX_MOTION_PLANE_WIDTH),
+        cv.Optional(CONF_PLANE_HEIGHT, default=60): cv.int_range(min=12, max=MAX_MOTION_PLANE_HEIGHT),
+        cv.Optional(CONF_CELL_SIZE, default=4): cv.int_range(min=1, max=16),
+        cv.Optional(CONF_SENSITIVITY, default="50%"): cv.percentage,
+        # Surface minimale d'une région, en part de la frame
+        cv.Optional(CONF_MIN_AREA, default="1%"): cv.percentage,
+        cv.Optional(CONF_LEARNING_RATE, default="5%"): cv.percentage,
+        cv.Optional(CONF_BUDGET, default="1ms"): cv.All(
+            cv.positive_time_period_microseconds, cv.Range(min=cv.TimePeriod(microseconds=100))
+        ),
+        # Zones ignorées, en pixels de la frame
+        cv.Optional(CONF_MASKS): cv.All(cv.ensure_list(ROI_SCHEMA), cv.Length(max=MAX_MOTION_MASKS)),
+        cv.Optional(CONF_ON_MOTION_START): automation.validate_automation(
+            {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(MotionStartTrigger)}
+        ),
+        cv.Optional(CONF_ON_MOTION_END): automation.validate_automation(
+            {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(MotionEndTrigger)}
+        ),
+    }
+)
+
+OSD_SCHEMA = cv.Schema(
+    {
+        # Première ligne, par défaut le nom de la caméra
+        cv.Optional(CONF_LABEL): cv.string,
+        # Heure de l'horloge si time_id, sinon temps depuis le boot
+        cv.Optional(CONF_TIMESTAMP, default=True): cv.boolean,
+        cv.Optional(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
+        # fps, exposition / gain, état du mouvement
+        cv.Optional(CONF_STATS, default=False): cv.boolean,
+        # Contour des régions en mouvement (nécessite motion:)
+        cv.Optional(CONF_MOTION_BOXES, default=True): cv.boolean,
+        cv.Optional(CONF_POSITION, default="TOP_LEFT"): cv.enum(OSD_POSITIONS, upper=True, space="_"),
+        # Pixels de frame par pixel de police, 0 = hauteur de frame / 240
+        cv.Optional(CONF_SCALE, default=0): cv.int_range(min=0, max=16),
+        cv.Optional(CONF_BACKGROUND_OPACITY, default="50%"): cv.percentage,
+        # Texte et boîtes, 0xRRGGBB
+        cv.Optional(CONF_COLOR, default=0xFFFFFF): cv.int_range(min=0, max=0xFFFFFF),
+    }
+)
+
+BASE_SCHEMA = cv.Schema(
     {
         cv.GenerateID(): cv.declare_id(MipiDsiCam),
         cv.Optional(CONF_NAME, default="MIPI Camera"): cv.string,
@@ -194,16 +402,79 @@ CONFIG_SCHEMA = cv.Schema(
         cv.Optional(CONF_ADDRESS_SENSOR): cv.i2c_address,
         cv.Optional(CONF_RESOLUTION): validate_resolution,
         cv.Optional(CONF_PIXEL_FORMAT, default="RGB565"): cv.enum(PIXEL_FORMATS, upper=True),
+        # Debayer logiciel quand pixel_format: RAW8 (affichage / JPEG)
+        cv.Optional(CONF_DEMOSAIC, default="BILINEAR"): cv.enum(DEMOSAIC_METHODS, upper=True, space="_"),
         cv.Optional(CONF_FRAMERATE): cv.int_range(min=1, max=60),
         cv.Optional(CONF_JPEG_QUALITY, default=10): cv.int_range(min=1, max=63),
+        # Profondeur du pool de frames (DMA + consommateurs LVGL / web)
+        cv.Optional(CONF_FRAME_BUFFERS, default=4): cv.int_range(min=3, max=6),
+        # Auto exposure : mesure et limites (par défaut celles du capteur)
+        cv.Optional(CONF_AE_METERING, default="CENTER_WEIGHTED"): cv.enum(METERING_MODES, upper=True, space="_"),
+        cv.Optional(CONF_AE_EXPOSURE_MIN): cv.int_range(min=1, max=0xFFFFF),
+        cv.Optional(CONF_AE_EXPOSURE_MAX): cv.int_range(min=1, max=0xFFFFF),
+        cv.Optional(CONF_AE_MAX_GAIN_INDEX): cv.int_range(min=0, max=255),
+        # AWB logicielle (par défaut GRAY_WORLD pour les capteurs sans AWB matériel)
+        cv.Optional(CONF_AWB_MODE): cv.enum(AWB_MODES, upper=True, space="_"),
+        # Courbe tonale logicielle, fusionnée avec l'AWB dans une seule LUT RGB565
+        cv.Optional(CONF_TONE): TONE_SCHEMA,
+        # Grille de zones des statistiques luma (N x N) et budget CPU par frame
+        cv.Optional(CONF_STATS_ZONES, default=8): cv.int_range(min=1, max=16),
+        cv.Optional(CONF_STATS_BUDGET, default="300us"): cv.All(
+            cv.positive_time_period_microseconds, cv.Range(min=cv.TimePeriod(microseconds=50))
+        ),
+        # Écart de luma (par bloc) sous lequel une frame est "inchangée" : le
+        # serveur web renvoie le JPEG précédent, LVGL ne redessine pas
+        cv.Optional(CONF_CHANGE_THRESHOLD, default=4): cv.int_range(min=0, max=255),
+        # Zoom numérique et ROIs : vues sans copie dans la frame (LVGL, web, lambdas)
+        cv.Optional(CONF_DIGITAL_ZOOM): DIGITAL_ZOOM_SCHEMA,
+        cv.Optional(CONF_ROIS): cv.All(cv.ensure_list(ROI_SCHEMA), cv.Length(max=MAX_ROIS)),
+        # Détection de mouvement (binary_sensor, on_motion_start / on_motion_end)
+        cv.Optional(CONF_MOTION): MOTION_SCHEMA,
+        # Incrustation dans les frames publiées (LVGL et flux HTTP)
+        cv.Optional(CONF_OSD): OSD_SCHEMA,
+        # Host uniquement : remplace le contrôleur CSI par un CSI virtuel
+        cv.Optional(CONF_VIRTUAL_CAMERA): VIRTUAL_CAMERA_SCHEMA,
     }
-).extend(cv.COMPONENT_SCHEMA).extend(i2c.i2c_device_schema(0x36))
+).extend(cv.COMPONENT_SCHEMA)
+
+I2C_SCHEMA = BASE_SCHEMA.extend(i2c.i2c_device_schema(0x36))
+
+
+def validate_config(config):
+    if CORE.is_host:
+        config = BASE_SCHEMA(config)
+        if config[CONF_SENSOR] != MOCK_SENSOR:
+            raise cv.Invalid(f"Sur host seul le capteur '{MOCK_SENSOR}' est disponible")
+        return config
+
+    if not CORE.is_esp32:
+        raise cv.Invalid("mipi_dsi_cam nécessite un ESP32-P4 (ou host pour le CSI virtuel)")
+    config = I2C_SCHEMA(config)
+    if config[CONF_SENSOR] == MOCK_SENSOR:
+        raise cv.Invalid(f"Le capteur '{MOCK_SENSOR}' n'est disponible que sur host")
+    if CONF_VIRTUAL_CAMERA in config:
+        raise cv.Invalid(f"'{CONF_VIRTUAL_CAMERA}' n'est disponible que sur host")
+    return config
+
+
+CONFIG_SCHEMA = validate_config
+
+
+def roi_initializer(roi):
+    return cg.StructInitializer(
+        FrameRoi,
+        ("x", roi[CONF_X]),
+        ("y", roi[CONF_Y]),
+        ("width", roi[CONF_WIDTH]),
+        ("height", roi[CONF_HEIGHT]),
+    )
 
 
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
-    await i2c.register_i2c_device(var, config)
+    if not CORE.is_host:
+        await i2c.register_i2c_device(var, config)
     
     cg.add(var.set_name(config[CONF_NAME]))
     
@@ -232,7 +503,10 @@ async def to_code(config):
     
     # Récupérer les infos du capteur
     sensor_name = config[CONF_SENSOR]
-    sensor_info = AVAILABLE_SENSORS[sensor_name]['info']
+    if sensor_name == MOCK_SENSOR:
+        sensor_info = MOCK_SENSOR_INFO
+    else:
+        sensor_info = AVAILABLE_SENSORS[sensor_name]['info']
     
     # Utiliser la résolution spécifiée ou la résolution native du capteur
     if CONF_RESOLUTION in config:
@@ -256,45 +530,99 @@ async def to_code(config):
     cg.add(var.set_lane_bitrate(sensor_info['lane_bitrate_mbps']))
     
     cg.add(var.set_pixel_format(config[CONF_PIXEL_FORMAT]))
+    cg.add(var.set_demosaic_method(config[CONF_DEMOSAIC]))
     cg.add(var.set_jpeg_quality(config[CONF_JPEG_QUALITY]))
     cg.add(var.set_framerate(framerate))
-    
+    cg.add(var.set_frame_buffer_count(config[CONF_FRAME_BUFFERS]))
+    cg.add(var.set_ae_metering_mode(config[CONF_AE_METERING]))
+    if CONF_AE_EXPOSURE_MIN in config or CONF_AE_EXPOSURE_MAX in config:
+        cg.add(var.set_ae_exposure_limits(config.get(CONF_AE_EXPOSURE_MIN, 0), config.get(CONF_AE_EXPOSURE_MAX, 0)))
+    if CONF_AE_MAX_GAIN_INDEX in config:
+        cg.add(var.set_ae_max_gain_index(config[CONF_AE_MAX_GAIN_INDEX]))
+    if CONF_AWB_MODE in config:
+        cg.add(var.set_awb_mode(config[CONF_AWB_MODE]))
+    elif sensor_name in SOFTWARE_AWB_SENSORS and config[CONF_PIXEL_FORMAT] == "RGB565":
+        cg.add(var.set_awb_mode(AWB_MODES["GRAY_WORLD"]))
+    if CONF_TONE in config:
+        tone_config = config[CONF_TONE]
+        cg.add(var.set_tone_gamma(tone_config[CONF_GAMMA]))
+        cg.add(var.set_tone_contrast(tone_config[CONF_CONTRAST]))
+        cg.add(var.set_tone_brightness(tone_config[CONF_BRIGHTNESS]))
+        cg.add(var.set_tone_saturation(tone_config[CONF_SATURATION]))
+    cg.add(var.set_stats_zones(config[CONF_STATS_ZONES], config[CONF_STATS_ZONES]))
+    cg.add(var.set_stats_budget_us(config[CONF_STATS_BUDGET].total_microseconds))
+    cg.add(var.set_change_threshold(config[CONF_CHANGE_THRESHOLD]))
+    if CONF_DIGITAL_ZOOM in config:
+        zoom_config = config[CONF_DIGITAL_ZOOM]
+        cg.add(var.set_digital_zoom(zoom_config[CONF_FACTOR], zoom_config[CONF_CENTER_X], zoom_config[CONF_CENTER_Y]))
+    for index, roi in enumerate(config.get(CONF_ROIS, [])):
+        cg.add(var.set_roi(index, roi_initializer(roi)))
+    if CONF_MOTION in config:
+        motion_config = config[CONF_MOTION]
+        cg.add(var.set_motion_config(cg.StructInitializer(
+            MotionConfig,
+            ("plane_width", motion_config[CONF_PLANE_WIDTH]),
+            ("plane_height", motion_config[CONF_PLANE_HEIGHT]),
+            ("cell_size", motion_config[CONF_CELL_SIZE]),
+            ("sensitivity", motion_config[CONF_SENSITIVITY]),
+            ("min_area", motion_config[CONF_MIN_AREA]),
+            ("learning_rate", motion_config[CONF_LEARNING_RATE]),
+        )))
+        cg.add(var.set_motion_budget_us(motion_config[CONF_BUDGET].total_microseconds))
+        for mask in motion_config.get(CONF_MASKS, []):
+            cg.add(var.add_motion_mask(roi_initializer(mask)))
+        for conf in motion_config.get(CONF_ON_MOTION_START, []):
+            trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+            await automation.build_automation(trigger, [(MotionResult, "motion")], conf)
+        for conf in motion_config.get(CONF_ON_MOTION_END, []):
+            trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+            await automation.build_automation(trigger, [(MotionResult, "motion")], conf)
+    
+    if CONF_OSD in config:
+        osd_config = config[CONF_OSD]
+        cg.add(var.set_osd_config(cg.StructInitializer(
+            OsdConfig,
+            ("position", osd_config[CONF_POSITION]),
+            ("scale", osd_config[CONF_SCALE]),
+            ("background_opacity", int(round(osd_config[CONF_BACKGROUND_OPACITY] * 100))),
+            ("color", osd_config[CONF_COLOR]),
+        )))
+        if CONF_LABEL in osd_config:
+            cg.add(var.set_osd_label(osd_config[CONF_LABEL]))
+        cg.add(var.set_osd_timestamp(osd_config[CONF_TIMESTAMP]))
+        if CONF_TIME_ID in osd_config:
+            clock = await cg.get_variable(osd_config[CONF_TIME_ID])
+            cg.add(var.set_osd_time(clock))
+        cg.add(var.set_osd_stats(osd_config[CONF_STATS]))
+        cg.add(var.set_osd_motion_boxes(osd_config[CONF_MOTION_BOXES]))
     if CONF_RESET_PIN in config:
         reset_pin = await cg.gpio_pin_expression(config[CONF_RESET_PIN])
         cg.add(var.set_reset_pin(reset_pin))
     
+    if CONF_VIRTUAL_CAMERA in config:
+        virtual_config = config[CONF_VIRTUAL_CAMERA]
+        backend = cg.new_Pvariable(virtual_config[CONF_ID])
+        cg.add(backend.set_fps(virtual_config[CONF_FRAMERATE]))
+        cg.add(backend.set_pattern(virtual_config[CONF_PATTERN]))
+        if CONF_REPLAY_FILE in virtual_config:
+            cg.add(backend.set_replay_file(virtual_config[CONF_REPLAY_FILE], virtual_config[CONF_REPLAY_FORMAT]))
+        cg.add(var.set_capture_backend(backend))
+    
     import os
     
+    # Seuls les capteurs configurés sont générés : avec MULTI_CONF, chaque
+    # instance réécrit le fichier avec l'union des capteurs vus jusqu'ici
+    selected_sensors = CORE.data.setdefault(DOMAIN, {}).setdefault("sensors", [])
+    if sensor_name != MOCK_SENSOR and sensor_name not in selected_sensors:
+        selected_sensors.append(sensor_name)
+    
     all_drivers_code = ""
     
-    for sensor_id, sensor_data in AVAILABLE_SENSORS.items():
-        driver_code_func = sensor_data['driver']
+    for sensor_id in selected_sensors:
+        driver_code_func = AVAILABLE_SENSORS[sensor_id]['driver']
         all_drivers_code += driver_code_func() + "\n\n"
     
-    factory_code = f'''
-namespace esphome {{
-namespace mipi_dsi_cam {{
-
-inline ISensorDriver* create_sensor_driver(const std::string& sensor_type, i2c::I2CDevice* i2c) {{
-'''
-    
-    for sensor_id in AVAILABLE_SENSORS.keys():
-        sensor_upper = sensor_id.upper()
-        factory_code += f'''
-    if (sensor_type == "{sensor_id}") {{
-        return new {sensor_upper}Adapter(i2c);
-    }}
-'''
-    
-    factory_code += f'''
-    
-    ESP_LOGE("mipi_dsi_cam", "Unknown sensor type: %s", sensor_type.c_str());
-    return nullptr;
-}}
-
-}}
-}}
-'''
+    factory_code = generate_driver_factory(selected_sensors)
     
     complete_code = all_drivers_code + factory_code
     
@@ -307,9 +635,10 @@ inline ISensorDriver* create_sensor_driver(const std::string& sensor_type, i2c::
         f.write(complete_code)
         f.write("\n#endif\n")
     
-    cg.add_build_flag("-DBOARD_HAS_PSRAM")
-    cg.add_build_flag("-DCONFIG_CAMERA_CORE0=1")
-    cg.add_build_flag("-DUSE_ESP32_VARIANT_ESP32P4")
+    if CORE.is_esp32:
+        cg.add_build_flag("-DBOARD_HAS_PSRAM")
+        cg.add_build_flag("-DCONFIG_CAMERA_CORE0=1")
+        cg.add_build_flag("-DUSE_ESP32_VARIANT_ESP32P4")
     
     # Message de log pour la configuration
     has_ext_clock = CONF_EXTERNAL_CLOCK_PIN in config and config[CONF_EXTERNAL_CLOCK_PIN] != NO_CLOCK
@@ -323,5 +652,6 @@ inline ISensorDriver* create_sensor_driver(const std::string& sensor_type, i2c::
         ESP_LOGI("compile", "  Address: 0x{sensor_address:02X}");
         ESP_LOGI("compile", "  Format: {config[CONF_PIXEL_FORMAT]}");
         ESP_LOGI("compile", "  FPS: {framerate}");
+        ESP_LOGI("compile", "  Frame buffers: {config[CONF_FRAME_BUFFERS]}");
         ESP_LOGI("compile", "  External Clock: {ext_clock_msg}");
     '''))
@@ -0,0 +1,138 @@
+#include "auto_exposure.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Hystérésis autour de la cible (EV) : plus de correction sous ENTER, reprise
+// seulement au-delà de LEAVE ; le bruit près de la cible ne fait pas osciller l'AE
+static const float ENTER_BAND_EV = 0.08f;
+static const float LEAVE_BAND_EV = 0.20f;
+// Une frame noire ou saturée dit mal à quelle distance on est
+static const float MAX_STEP_EV = 3.0f;
+static const float SATURATED_STEP_EV = 2.0f;
+
+void AutoExposure::set_limits(uint32_t exposure_min, uint32_t exposure_max, const std::vector<uint32_t> &gain_values) {
+  this->exposure_min_ = exposure_min;
+  this->exposure_max_ = exposure_max > exposure_min ? exposure_max : exposure_min;
+  if (!gain_values.empty())
+    this->gain_values_ = gain_values;
+}
+
+uint32_t AutoExposure::get_gain_index_max() const {
+  uint32_t last = this->gain_values_.size() - 1;
+  return this->gain_index_max_ < last ? this->gain_index_max_ : last;
+}
+
+uint32_t AutoExposure::gain_value_(uint32_t index) const {
+  uint32_t max = this->get_gain_index_max();
+  return this->gain_values_[index < max ? index : max];
+}
+
+uint32_t AutoExposure::gain_index_for_(float gain) const {
+  // Entrée la plus proche en rapport (table croissante)
+  uint32_t max = this->get_gain_index_max();
+  uint32_t index = 0;
+  while (index < max && this->gain_values_[index] < gain)
+    index++;
+  if (index > 0 && gain * gain < (float) this->gain_values_[index] * this->gain_values_[index - 1])
+    index--;
+  return index;
+}
+
+void AutoExposure::reset(uint32_t exposure, uint32_t gain_index) {
+  this->exposure_ = exposure;
+  this->gain_index_ = gain_index;
+  this->prev_error_ev_ = 0.0f;
+  this->last_error_ev_ = 0.0f;
+  this->settle_ = 0;
+  this->converged_ = false;
+}
+
+uint8_t AutoExposure::metered_luma(const FrameStats &stats) const {
+  const int cols = stats.zone_cols;
+  const int rows = stats.zone_rows;
+  if (this->metering_mode_ == METERING_AVERAGE || cols == 0 || rows == 0)
+    return stats.mean_luma;
+
+  // Distance au centre en demi-zones : |2c + 1 - cols|
+  uint32_t sum = 0;
+  uint32_t weights = 0;
+  for (int r = 0; r < rows; r++) {
+    int dy = std::abs(2 * r + 1 - rows);
+    for (int c = 0; c < cols; c++) {
+      int dx = std::abs(2 * c + 1 - cols);
+      uint32_t w;
+      if (this->metering_mode_ == METERING_SPOT) {
+        // ~25 % central de chaque axe
+        w = (dx * 4 <= cols && dy * 4 <= rows) ? 1 : 0;
+      } else {
+        // Pyramide décroissante du centre vers les bords
+        w = (uint32_t) (cols + 1 - dx) * (rows + 1 - dy);
+      }
+      sum += w * stats.zone(c, r);
+      weights += w;
+    }
+  }
+  return weights != 0 ? sum / weights : stats.mean_luma;
+}
+
+bool AutoExposure::update(const FrameStats &stats, uint32_t *exposure, uint32_t *gain_index) {
+  if (this->settle_ > 0) {
+    this->settle_--;
+    return false;
+  }
+
+  uint8_t metered = this->metered_luma(stats);
+  float error = log2f((float) this->target_ / (float) (metered > 0 ? metered : 1));
+  // Saturée : l'erreur réelle dépasse ce que dit la luminance écrêtée
+  if (metered >= FrameStats::CLIP_LEVEL)
+    error = -SATURATED_STEP_EV;
+  this->last_error_ev_ = error;
+
+  if (std::fabs(error) < (this->converged_ ? LEAVE_BAND_EV : ENTER_BAND_EV)) {
+    this->converged_ = true;
+    this->prev_error_ev_ = 0.0f;
+    return false;
+  }
+  this->converged_ = false;
+
+  if (error > MAX_STEP_EV)
+    error = MAX_STEP_EV;
+  if (error < -MAX_STEP_EV)
+    error = -MAX_STEP_EV;
+  float step = this->ki_ * error + this->kp_ * (error - this->prev_error_ev_);
+  this->prev_error_ev_ = error;
+
+  // Produit en « unités d'exposition à gain x1 »
+  float product = (float) this->exposure_ * this->gain_value_(this->gain_index_) / 1000.0f * exp2f(step);
+
+  uint32_t new_gain_index = 0;
+  float ideal_exposure = product * 1000.0f / this->gain_value_(0);
+  if (ideal_exposure > this->exposure_max_) {
+    new_gain_index = this->gain_index_for_(product * 1000.0f / this->exposure_max_);
+  }
+  float new_exposure = product * 1000.0f / this->gain_value_(new_gain_index);
+  if (new_exposure < this->exposure_min_)
+    new_exposure = this->exposure_min_;
+  if (new_exposure > this->exposure_max_)
+    new_exposure = this->exposure_max_;
+
+  uint32_t exp_value = (uint32_t) (new_exposure + 0.5f);
+  if (exp_value == this->exposure_ && new_gain_index == this->gain_index_) {
+    // Butée (min/max) atteinte
+    return false;
+  }
+
+  this->exposure_ = exp_value;
+  this->gain_index_ = new_gain_index;
+  this->settle_ = this->settle_frames_;
+  *exposure = exp_value;
+  *gain_index = new_gain_index;
+  return true;
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
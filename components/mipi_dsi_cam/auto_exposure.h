@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_stats.h"
+
+// Réglée hors ligne : tests/auto_exposure_replay_test.cpp rejoue des traces de
+// luminance en boucle fermée pour vérifier gains PI et hystérésis.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+enum MeteringMode {
+  METERING_AVERAGE = 0,
+  METERING_CENTER_WEIGHTED = 1,
+  METERING_SPOT = 2,
+};
+
+// AE dans le domaine logarithmique : l'erreur se mesure en EV
+// (log2(cible / mesure)) et le produit exposition x gain bouge d'autant de
+// diaphragmes d'un coup ; un passage sombre -> clair se règle en quelques
+// frames au lieu de quelques secondes.
+//
+//   log2(P[k]) = log2(P[k-1]) + ki * e[k] + kp * (e[k] - e[k-1])
+//
+// Le produit est ensuite réparti : exposition d'abord (jusqu'à exposure_max),
+// le reste en gain analogique pris dans la table du capteur.
+class AutoExposure {
+ public:
+  // Gains x1000, croissants, un par index de gain du capteur.
+  void set_limits(uint32_t exposure_min, uint32_t exposure_max, const std::vector<uint32_t> &gain_values);
+  void set_gain_index_max(uint32_t index) { this->gain_index_max_ = index; }
+  void set_metering_mode(MeteringMode mode) { this->metering_mode_ = mode; }
+  void set_target(uint8_t target) { this->target_ = target; }
+  void set_coefficients(float kp, float ki) {
+    this->kp_ = kp;
+    this->ki_ = ki;
+  }
+  // Frames ignorées après un changement, le temps que le capteur l'applique
+  void set_settle_frames(uint8_t frames) { this->settle_frames_ = frames; }
+
+  // Point de départ (réglages actuels du capteur) ; remet le régulateur à zéro.
+  void reset(uint32_t exposure, uint32_t gain_index);
+
+  // Stats d'une frame. true avec les nouveaux réglages quand le capteur doit
+  // être mis à jour.
+  bool update(const FrameStats &stats, uint32_t *exposure, uint32_t *gain_index);
+
+  uint8_t metered_luma(const FrameStats &stats) const;
+
+  MeteringMode get_metering_mode() const { return this->metering_mode_; }
+  uint32_t get_exposure_min() const { return this->exposure_min_; }
+  uint32_t get_exposure_max() const { return this->exposure_max_; }
+  uint32_t get_gain_index_max() const;
+  float get_last_error_ev() const { return this->last_error_ev_; }
+  bool is_converged() const { return this->converged_; }
+
+ protected:
+  uint32_t gain_value_(uint32_t index) const;
+  uint32_t gain_index_for_(float gain) const;
+
+  uint32_t exposure_min_{0x10};
+  uint32_t exposure_max_{0xF00};
+  std::vector<uint32_t> gain_values_{1000};
+  uint32_t gain_index_max_{UINT32_MAX};
+
+  MeteringMode metering_mode_{METERING_CENTER_WEIGHTED};
+  uint8_t target_{128};
+  float kp_{0.1f};
+  float ki_{1.0f};
+  uint8_t settle_frames_{2};
+
+  uint32_t exposure_{0};
+  uint32_t gain_index_{0};
+  float prev_error_ev_{0.0f};
+  float last_error_ev_{0.0f};
+  uint8_t settle_{0};
+  bool converged_{false};
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
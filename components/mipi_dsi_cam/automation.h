@@ -0,0 +1,31 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "mipi_dsi_cam.h"
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// on_motion_start / on_motion_end : `motion` porte les boîtes (MotionResult)
+class MotionStartTrigger : public Trigger<MotionResult> {
+ public:
+  explicit MotionStartTrigger(MipiDsiCam *parent) {
+    parent->add_on_motion_callback([this](const MotionResult &result) {
+      if (result.motion)
+        this->trigger(result);
+    });
+  }
+};
+
+class MotionEndTrigger : public Trigger<MotionResult> {
+ public:
+  explicit MotionEndTrigger(MipiDsiCam *parent) {
+    parent->add_on_motion_callback([this](const MotionResult &result) {
+      if (!result.motion)
+        this->trigger(result);
+    });
+  }
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,24 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import binary_sensor
+from esphome.const import DEVICE_CLASS_MOTION
+
+from . import MipiDsiCam
+
+DEPENDENCIES = ["mipi_dsi_cam"]
+
+CONF_CAMERA_ID = "camera_id"
+
+# Actif tant que la détection de mouvement voit une région (réglages : bloc
+# `motion:` de la caméra, sinon valeurs par défaut)
+CONFIG_SCHEMA = binary_sensor.binary_sensor_schema(device_class=DEVICE_CLASS_MOTION).extend(
+    {
+        cv.GenerateID(CONF_CAMERA_ID): cv.use_id(MipiDsiCam),
+    }
+)
+
+
+async def to_code(config):
+    var = await binary_sensor.new_binary_sensor(config)
+    camera = await cg.get_variable(config[CONF_CAMERA_ID])
+    cg.add(camera.set_motion_binary_sensor(var))
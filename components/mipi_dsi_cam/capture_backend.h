@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "esphome/core/hal.h"
+#include "frame_view.h"
+
+#ifdef USE_ESP32
+#include "esp_err.h"
+#include "esp_timer.h"
+#else
+#include <chrono>
+
+// Build host : les drivers capteur n'ont besoin que du vocabulaire esp_err_t
+// et des macros de délai FreeRTOS, ramenés sur la HAL d'ESPHome.
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+#define ESP_ERR_TIMEOUT 0x107
+inline const char *esp_err_to_name(esp_err_t err) { return err == ESP_OK ? "ESP_OK" : "ESP_FAIL"; }
+#ifndef pdMS_TO_TICKS
+#define pdMS_TO_TICKS(ms) (ms)
+#define vTaskDelay(ticks) esphome::delay(ticks)
+#endif
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#endif
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Horloge de capture monotone en µs (esp_timer sur la carte, steady_clock sur host).
+inline int64_t capture_time_us() {
+#ifdef USE_ESP32
+  return esp_timer_get_time();
+#else
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+struct CaptureConfig {
+  uint16_t width{0};
+  uint16_t height{0};
+  uint8_t lane_count{1};
+  uint16_t lane_bitrate_mbps{800};
+  uint8_t bayer_pattern{0};
+  PixelFormat format{PIXEL_FORMAT_RGB565};  // format des frames livrées
+  uint8_t fps{30};
+  const char *sensor_type{""};
+};
+
+// Source des frames de MipiDsiCam : contrôleur CSI + ISP sur l'ESP32-P4, ou
+// CSI virtuel alimenté par un thread sur host.
+//
+// Le backend rappelle depuis son contexte de capture (ISR sur la carte, thread
+// de capture sur host) avec le même contrat que le driver CSI :
+//   on_new_frame  -> buffer de destination de la frame suivante, nullptr pour la jeter
+//   on_frame_done -> buffer rempli de `received_size` octets (0 = avortée)
+class CaptureBackend {
+ public:
+  struct Callbacks {
+    uint8_t *(*on_new_frame)(void *arg){nullptr};
+    void (*on_frame_done)(void *arg, uint8_t *buffer, size_t received_size){nullptr};
+    void *arg{nullptr};
+  };
+
+  virtual ~CaptureBackend() = default;
+
+  virtual const char *get_name() const = 0;
+  virtual bool init(const CaptureConfig &config, const Callbacks &callbacks) = 0;
+  // Buffers où le backend peut écrire (capables de DMA sur la carte).
+  virtual uint8_t *allocate_frame_buffer(size_t size) = 0;
+  virtual bool start() = 0;
+  virtual void stop() = 0;
+  // Nouvelle géométrie / cadence (changement de mode capteur), à l'arrêt. Les
+  // buffers d'allocate_frame_buffer() restent valides.
+  virtual bool reconfigure(const CaptureConfig &config) = 0;
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
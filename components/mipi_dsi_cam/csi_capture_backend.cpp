@@ -0,0 +1,276 @@
+#include "csi_capture_backend.h"
+
+#ifdef USE_ESP32_VARIANT_ESP32P4
+
+#include "esphome/core/log.h"
+#include "esp_heap_caps.h"
+#include <cstring>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+static const char *const TAG = "mipi_dsi_cam.csi";
+
+// Sortie CSI/ISP selon pixel_format : l'ISP démosaïque pour RGB565 / YUV422,
+// RAW8 laisse passer la mosaïque Bayer telle quelle.
+static cam_ctlr_color_t csi_output_color(PixelFormat format) {
+  switch (format) {
+    case PIXEL_FORMAT_YUV422:
+      return CAM_CTLR_COLOR_YUV422;
+    case PIXEL_FORMAT_RAW8:
+      return CAM_CTLR_COLOR_RAW8;
+    default:
+      return CAM_CTLR_COLOR_RGB565;
+  }
+}
+
+static isp_color_t isp_output_color(PixelFormat format) {
+  switch (format) {
+    case PIXEL_FORMAT_YUV422:
+      return ISP_COLOR_YUV422;
+    case PIXEL_FORMAT_RAW8:
+      return ISP_COLOR_RAW8;
+    default:
+      return ISP_COLOR_RGB565;
+  }
+}
+
+bool CsiCaptureBackend::init(const CaptureConfig &config, const Callbacks &callbacks) {
+  this->config_ = config;
+  this->callbacks_ = callbacks;
+  this->frame_size_ = (size_t) config.width * config.height * bytes_per_pixel(config.format);
+
+  if (!this->init_ldo_()) {
+    ESP_LOGE(TAG, "LDO init failed");
+    return false;
+  }
+
+  if (!this->init_csi_()) {
+    ESP_LOGE(TAG, "CSI init failed");
+    return false;
+  }
+
+  if (!this->init_isp_()) {
+    ESP_LOGE(TAG, "ISP init failed");
+    return false;
+  }
+
+  return true;
+}
+
+bool CsiCaptureBackend::init_ldo_() {
+  ESP_LOGI(TAG, "Init LDO MIPI");
+
+  esp_ldo_channel_config_t ldo_config = {
+    .chan_id = 3,
+    .voltage_mv = 2500,
+  };
+
+  esp_err_t ret = esp_ldo_acquire_channel(&ldo_config, &this->ldo_handle_);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "LDO failed: %d", ret);
+    return false;
+  }
+
+  ESP_LOGI(TAG, "LDO OK (2.5V)");
+  return true;
+}
+
+bool CsiCaptureBackend::init_csi_() {
+  ESP_LOGI(TAG, "Init MIPI-CSI");
+
+  esp_cam_ctlr_csi_config_t csi_config = {};
+  csi_config.ctlr_id = 0;
+  csi_config.clk_src = MIPI_CSI_PHY_CLK_SRC_DEFAULT;
+  csi_config.h_res = this->config_.width;
+  csi_config.v_res = this->config_.height;
+  csi_config.lane_bit_rate_mbps = this->config_.lane_bitrate_mbps;
+  csi_config.input_data_color_type = CAM_CTLR_COLOR_RAW8;
+  csi_config.output_data_color_type = csi_output_color(this->config_.format);
+  csi_config.data_lane_num = this->config_.lane_count;
+  csi_config.byte_swap_en = false;
+  csi_config.queue_items = 10;
+
+  esp_err_t ret = esp_cam_new_csi_ctlr(&csi_config, &this->csi_handle_);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "CSI failed: %d", ret);
+    return false;
+  }
+
+  esp_cam_ctlr_evt_cbs_t callbacks = {
+    .on_get_new_trans = CsiCaptureBackend::on_csi_new_frame_,
+    .on_trans_finished = CsiCaptureBackend::on_csi_frame_done_,
+  };
+
+  ret = esp_cam_ctlr_register_event_callbacks(this->csi_handle_, &callbacks, this);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Callbacks failed: %d", ret);
+    return false;
+  }
+
+  ret = esp_cam_ctlr_enable(this->csi_handle_);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Enable CSI failed: %d", ret);
+    return false;
+  }
+
+  ESP_LOGI(TAG, "CSI OK (RAW8 -> %s)", pixel_format_name(this->config_.format));
+  return true;
+}
+
+bool CsiCaptureBackend::init_isp_() {
+  ESP_LOGI(TAG, "Init ISP");
+
+  uint32_t isp_clock_hz = 120000000;
+
+  esp_isp_processor_cfg_t isp_config = {};
+  isp_config.clk_src = ISP_CLK_SRC_DEFAULT;
+  isp_config.input_data_source = ISP_INPUT_DATA_SOURCE_CSI;
+  isp_config.input_data_color_type = ISP_COLOR_RAW8;
+  isp_config.output_data_color_type = isp_output_color(this->config_.format);
+  // YUV : BT.601 pleine échelle, comme pixel_convert.h et le JPEG
+  isp_config.yuv_range = ISP_COLOR_RANGE_FULL;
+  isp_config.yuv_std = ISP_YUV_CONV_STD_BT601;
+  isp_config.h_res = this->config_.width;
+  isp_config.v_res = this->config_.height;
+  isp_config.has_line_start_packet = false;
+  isp_config.has_line_end_packet = false;
+  isp_config.clk_hz = isp_clock_hz;
+  isp_config.bayer_order = (color_raw_element_order_t)this->config_.bayer_pattern;
+
+  esp_err_t ret = esp_isp_new_processor(&isp_config, &this->isp_handle_);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "ISP creation failed: 0x%x", ret);
+    return false;
+  }
+
+  ret = esp_isp_enable(this->isp_handle_);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "ISP enable failed: 0x%x", ret);
+    esp_isp_del_processor(this->isp_handle_);
+    this->isp_handle_ = nullptr;
+    return false;
+  }
+
+  // Configure AWB si supporté par le capteur
+  this->configure_white_balance_();
+
+  ESP_LOGI(TAG, "ISP OK");
+  return true;
+}
+
+void CsiCaptureBackend::deinit_csi_() {
+  if (this->csi_handle_ == nullptr) return;
+  esp_cam_ctlr_disable(this->csi_handle_);
+  esp_cam_ctlr_del(this->csi_handle_);
+  this->csi_handle_ = nullptr;
+}
+
+void CsiCaptureBackend::deinit_isp_() {
+  if (this->isp_handle_ == nullptr) return;
+  if (this->awb_ctlr_ != nullptr) {
+    esp_isp_awb_controller_disable(this->awb_ctlr_);
+    esp_isp_del_awb_controller(this->awb_ctlr_);
+    this->awb_ctlr_ = nullptr;
+  }
+  esp_isp_disable(this->isp_handle_);
+  esp_isp_del_processor(this->isp_handle_);
+  this->isp_handle_ = nullptr;
+}
+
+bool CsiCaptureBackend::reconfigure(const CaptureConfig &config) {
+  // LDO conservé : seuls le contrôleur CSI et l'ISP dépendent du mode
+  this->deinit_isp_();
+  this->deinit_csi_();
+
+  this->config_ = config;
+  this->frame_size_ = (size_t) config.width * config.height * bytes_per_pixel(config.format);
+
+  if (!this->init_csi_()) {
+    ESP_LOGE(TAG, "CSI re-init failed");
+    return false;
+  }
+
+  if (!this->init_isp_()) {
+    ESP_LOGE(TAG, "ISP re-init failed");
+    return false;
+  }
+
+  return true;
+}
+
+void CsiCaptureBackend::configure_white_balance_() {
+  if (!this->isp_handle_) return;
+
+  // OV5647 et SC202CS ont des problèmes avec AWB matériel sur ESP32-P4
+  if (strcmp(this->config_.sensor_type, "ov5647") == 0 || strcmp(this->config_.sensor_type, "sc202cs") == 0) {
+    ESP_LOGI(TAG, "%s détecté - AWB matériel désactivé (correction logicielle uniquement)",
+             this->config_.sensor_type);
+    return;
+  }
+
+  // Tentative de configuration AWB pour les autres capteurs
+  esp_isp_awb_config_t awb_config = {};
+  awb_config.sample_point = ISP_AWB_SAMPLE_POINT_AFTER_CCM;
+
+  // Configuration de la window (noms corrects pour ESP32-P4)
+  awb_config.window.top_left.x = this->config_.width / 4;
+  awb_config.window.top_left.y = this->config_.height / 4;
+  awb_config.window.btm_right.x = (this->config_.width * 3) / 4;
+  awb_config.window.btm_right.y = (this->config_.height * 3) / 4;
+
+  esp_err_t ret = esp_isp_new_awb_controller(this->isp_handle_, &awb_config, &this->awb_ctlr_);
+
+  if (ret == ESP_OK && this->awb_ctlr_ != nullptr) {
+    esp_isp_awb_controller_enable(this->awb_ctlr_);
+    ESP_LOGI(TAG, "✅ AWB matériel activé (auto-correction couleurs)");
+  } else {
+    ESP_LOGW(TAG, "AWB matériel non disponible (0x%x), utilisation ISP par défaut", ret);
+  }
+}
+
+uint8_t *CsiCaptureBackend::allocate_frame_buffer(size_t size) {
+  return (uint8_t*)heap_caps_aligned_alloc(64, size, MALLOC_CAP_SPIRAM);
+}
+
+bool CsiCaptureBackend::start() {
+  esp_err_t ret = esp_cam_ctlr_start(this->csi_handle_);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "CSI start failed: %d", ret);
+    return false;
+  }
+  return true;
+}
+
+void CsiCaptureBackend::stop() {
+  esp_cam_ctlr_stop(this->csi_handle_);
+}
+
+bool IRAM_ATTR CsiCaptureBackend::on_csi_new_frame_(
+  esp_cam_ctlr_handle_t handle,
+  esp_cam_ctlr_trans_t *trans,
+  void *user_data
+) {
+  CsiCaptureBackend *backend = (CsiCaptureBackend*)user_data;
+  uint8_t *buffer = backend->callbacks_.on_new_frame(backend->callbacks_.arg);
+
+  // nullptr : le driver CSI bascule sur son backup buffer et la frame est perdue
+  trans->buffer = buffer;
+  trans->buflen = buffer != nullptr ? backend->frame_size_ : 0;
+  return false;
+}
+
+bool IRAM_ATTR CsiCaptureBackend::on_csi_frame_done_(
+  esp_cam_ctlr_handle_t handle,
+  esp_cam_ctlr_trans_t *trans,
+  void *user_data
+) {
+  CsiCaptureBackend *backend = (CsiCaptureBackend*)user_data;
+  backend->callbacks_.on_frame_done(backend->callbacks_.arg, (uint8_t*)trans->buffer, trans->received_size);
+  return false;
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
+
+#endif  // USE_ESP32_VARIANT_ESP32P4
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "capture_backend.h"
+
+#ifdef USE_ESP32_VARIANT_ESP32P4
+extern "C" {
+  #include "esp_cam_ctlr.h"
+  #include "esp_cam_ctlr_csi.h"
+  #include "driver/isp.h"
+  #include "esp_ldo_regulator.h"
+}
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Contrôleur MIPI-CSI + ISP (RAW8 -> RGB565) de l'ESP32-P4.
+class CsiCaptureBackend : public CaptureBackend {
+ public:
+  const char *get_name() const override { return "MIPI-CSI + ISP"; }
+  bool init(const CaptureConfig &config, const Callbacks &callbacks) override;
+  uint8_t *allocate_frame_buffer(size_t size) override;
+  bool start() override;
+  void stop() override;
+  bool reconfigure(const CaptureConfig &config) override;
+
+ protected:
+  bool init_ldo_();
+  bool init_csi_();
+  bool init_isp_();
+  void deinit_csi_();
+  void deinit_isp_();
+  void configure_white_balance_();
+
+  static bool IRAM_ATTR on_csi_new_frame_(
+    esp_cam_ctlr_handle_t handle,
+    esp_cam_ctlr_trans_t *trans,
+    void *user_data
+  );
+
+  static bool IRAM_ATTR on_csi_frame_done_(
+    esp_cam_ctlr_handle_t handle,
+    esp_cam_ctlr_trans_t *trans,
+    void *user_data
+  );
+
+  CaptureConfig config_{};
+  Callbacks callbacks_{};
+  size_t frame_size_{0};
+
+  esp_cam_ctlr_handle_t csi_handle_{nullptr};
+  isp_proc_handle_t isp_handle_{nullptr};
+  esp_ldo_channel_handle_t ldo_handle_{nullptr};
+  isp_awb_ctlr_t awb_ctlr_{nullptr};
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
+
+#endif  // USE_ESP32_VARIANT_ESP32P4
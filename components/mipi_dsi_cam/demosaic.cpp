@@ -0,0 +1,294 @@
+#include "demosaic.h"
+#include "pixel_convert.h"
+
+#include <cstdlib>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Pixels de sortie par paquet de colonnes (pair : une paire YUV422 ne chevauche jamais deux paquets)
+static const uint16_t CHUNK = 128;
+// Lignes / colonnes lues autour d'un pixel : 1 en bilinéaire, 3 en edge-aware
+// (son vert chez les voisins regarde 2 plus loin)
+static const uint8_t MAX_RADIUS = 3;
+
+static inline int reflect(int i, int n) {
+  if (i < 0)
+    return -i;
+  if (i >= n)
+    return 2 * n - 2 - i;
+  return i;
+}
+
+// Couleur de chaque site du quad de Bayer 2x2
+enum SiteColor : uint8_t { SITE_RED, SITE_GREEN, SITE_BLUE };
+
+struct BayerLayout {
+  SiteColor sites[4];
+  // Site vert dont les voisins horizontaux sont rouges (ligne 0 ou 1 du quad)
+  bool red_row[2];
+
+  explicit BayerLayout(uint8_t pattern) {
+    const uint8_t r_site = bayer_red_site(pattern);
+    const uint8_t b_site = bayer_blue_site(pattern);
+    for (uint8_t s = 0; s < 4; s++) {
+      this->sites[s] = s == r_site ? SITE_RED : (s == b_site ? SITE_BLUE : SITE_GREEN);
+    }
+    this->red_row[r_site >> 1] = true;
+    this->red_row[(r_site >> 1) ^ 1] = false;
+  }
+  SiteColor at(int x, int y) const { return this->sites[(y & 1) * 2 + (x & 1)]; }
+};
+
+// Lignes y-radius..y+radius des colonnes [x0 - radius, x0 + n + radius) :
+// directement dans la frame à l'intérieur, via une copie en miroir aux bords
+struct Band {
+  const uint8_t *rows[2 * MAX_RADIUS + 1];
+  uint8_t pad[2 * MAX_RADIUS + 1][CHUNK + 2 * MAX_RADIUS];
+
+  void load(const FrameView &raw, int y, int x0, int n, int radius) {
+    const int begin = x0 - radius;
+    const int end = x0 + n + radius;
+    const bool inside = begin >= 0 && end <= raw.width;
+    for (int r = -radius; r <= radius; r++) {
+      const uint8_t *row = raw.row(reflect(y + r, raw.height));
+      if (inside) {
+        this->rows[r + radius] = row + begin;
+        continue;
+      }
+      uint8_t *dst = this->pad[r + radius];
+      for (int x = begin; x < end; x++) {
+        dst[x - begin] = row[reflect(x, raw.width)];
+      }
+      this->rows[r + radius] = dst;
+    }
+  }
+  // Ligne dy (-radius..radius), colonne i du paquet
+  const uint8_t *row(int dy, int radius) const { return this->rows[dy + radius] + radius; }
+};
+
+static inline uint8_t avg2(int a, int b) { return (a + b + 1) >> 1; }
+static inline uint8_t avg4(int a, int b, int c, int d) { return (a + b + c + d + 2) >> 2; }
+
+static void bilinear_chunk(const Band &band, const BayerLayout &layout, int x0, int y, int n, uint8_t *r,
+                           uint8_t *g, uint8_t *b) {
+  const uint8_t *up = band.row(-1, 1);
+  const uint8_t *mid = band.row(0, 1);
+  const uint8_t *down = band.row(1, 1);
+  const bool red_row = layout.red_row[y & 1];
+  for (int i = 0; i < n; i++) {
+    const int c = mid[i];
+    switch (layout.at(x0 + i, y)) {
+      case SITE_RED:
+        r[i] = c;
+        g[i] = avg4(up[i], down[i], mid[i - 1], mid[i + 1]);
+        b[i] = avg4(up[i - 1], up[i + 1], down[i - 1], down[i + 1]);
+        break;
+      case SITE_BLUE:
+        b[i] = c;
+        g[i] = avg4(up[i], down[i], mid[i - 1], mid[i + 1]);
+        r[i] = avg4(up[i - 1], up[i + 1], down[i - 1], down[i + 1]);
+        break;
+      default: {
+        const uint8_t horizontal = avg2(mid[i - 1], mid[i + 1]);
+        const uint8_t vertical = avg2(up[i], down[i]);
+        g[i] = c;
+        r[i] = red_row ? horizontal : vertical;
+        b[i] = red_row ? vertical : horizontal;
+        break;
+      }
+    }
+  }
+}
+
+// Vert à la colonne i de la ligne dy de la bande : interpolé dans la direction
+// du plus faible gradient (Hamilton-Adams), corrigé par la courbure de la
+// couleur propre du site
+static inline int edge_green(const Band &band, const BayerLayout &layout, int x, int y, int dy, int i) {
+  const uint8_t *p = band.row(dy, MAX_RADIUS);
+  if (layout.at(x, y + dy) == SITE_GREEN)
+    return p[i];
+  const uint8_t *u1 = band.row(dy - 1, MAX_RADIUS);
+  const uint8_t *u2 = band.row(dy - 2, MAX_RADIUS);
+  const uint8_t *d1 = band.row(dy + 1, MAX_RADIUS);
+  const uint8_t *d2 = band.row(dy + 2, MAX_RADIUS);
+  const int c2 = 2 * p[i];
+  const int lap_h = c2 - p[i - 2] - p[i + 2];
+  const int lap_v = c2 - u2[i] - d2[i];
+  const int grad_h = abs(p[i - 1] - p[i + 1]) + abs(lap_h);
+  const int grad_v = abs(u1[i] - d1[i]) + abs(lap_v);
+  const int green_h = 2 * (p[i - 1] + p[i + 1]) + lap_h;  // x4
+  const int green_v = 2 * (u1[i] + d1[i]) + lap_v;        // x4
+  int green;
+  if (grad_h < grad_v) {
+    green = green_h;
+  } else if (grad_v < grad_h) {
+    green = green_v;
+  } else {
+    green = (green_h + green_v + 1) >> 1;
+  }
+  return clamp_u8((green + 2) >> 2);
+}
+
+// Vert de la ligne y + dy sur le paquet, plus une colonne de chaque côté
+static void edge_green_row(const Band &band, const BayerLayout &layout, int x0, int y, int dy, int n, int16_t *out) {
+  for (int i = -1; i <= n; i++) {
+    out[i + 1] = edge_green(band, layout, x0 + i, y, dy, i);
+  }
+}
+
+// g_rows : vert des lignes y-1, y, y+1 (edge_green_row)
+static void edge_aware_chunk(const Band &band, const BayerLayout &layout, const int16_t *const g_rows[3], int x0,
+                             int y, int n, uint8_t *r, uint8_t *g, uint8_t *b) {
+  const int16_t *g_up = g_rows[0] + 1;
+  const int16_t *g_mid = g_rows[1] + 1;
+  const int16_t *g_down = g_rows[2] + 1;
+  const uint8_t *up = band.row(-1, MAX_RADIUS);
+  const uint8_t *mid = band.row(0, MAX_RADIUS);
+  const uint8_t *down = band.row(1, MAX_RADIUS);
+  const bool red_row = layout.red_row[y & 1];
+
+  for (int i = 0; i < n; i++) {
+    const int gc = g_mid[i];
+    // R - G / B - G varient lentement : on interpole la différence
+    const int diag = (up[i - 1] - g_up[i - 1] + up[i + 1] - g_up[i + 1] + down[i - 1] - g_down[i - 1] +
+                      down[i + 1] - g_down[i + 1]) /
+                     4;
+    const int horizontal = (mid[i - 1] - g_mid[i - 1] + mid[i + 1] - g_mid[i + 1]) / 2;
+    const int vertical = (up[i] - g_up[i] + down[i] - g_down[i]) / 2;
+    g[i] = gc;
+    switch (layout.at(x0 + i, y)) {
+      case SITE_RED:
+        r[i] = mid[i];
+        b[i] = clamp_u8(gc + diag);
+        break;
+      case SITE_BLUE:
+        b[i] = mid[i];
+        r[i] = clamp_u8(gc + diag);
+        break;
+      default:
+        r[i] = clamp_u8(gc + (red_row ? horizontal : vertical));
+        b[i] = clamp_u8(gc + (red_row ? vertical : horizontal));
+        break;
+    }
+  }
+}
+
+static void nearest_chunk(const FrameView &raw, const BayerLayout &layout, int x0, int y, int n, bool binned,
+                          uint8_t *r, uint8_t *g, uint8_t *b) {
+  // Quad 2x2 de la paire de lignes (binning : un pixel de sortie par quad)
+  int qy = binned ? 2 * y : (y & ~1);
+  if (qy + 1 >= raw.height)
+    qy = raw.height - 2;
+  const uint8_t *top = raw.row(qy);
+  const uint8_t *bottom = raw.row(qy + 1);
+  for (int i = 0; i < n; i++) {
+    int qx = binned ? 2 * (x0 + i) : ((x0 + i) & ~1);
+    if (qx + 1 >= raw.width)
+      qx = raw.width - 2;
+    const uint8_t quad[4] = {top[qx], top[qx + 1], bottom[qx], bottom[qx + 1]};
+    int green = 0;
+    for (uint8_t s = 0; s < 4; s++) {
+      switch (layout.sites[s]) {
+        case SITE_RED:
+          r[i] = quad[s];
+          break;
+        case SITE_BLUE:
+          b[i] = quad[s];
+          break;
+        default:
+          green += quad[s];
+          break;
+      }
+    }
+    g[i] = (green + 1) >> 1;
+  }
+}
+
+static void emit_chunk(DemosaicOutput format, const uint8_t *r, const uint8_t *g, const uint8_t *b, int n,
+                       uint8_t *dst) {
+  switch (format) {
+    case DEMOSAIC_OUTPUT_RGB888:
+      for (int i = 0; i < n; i++) {
+        dst[i * 3 + 0] = r[i];
+        dst[i * 3 + 1] = g[i];
+        dst[i * 3 + 2] = b[i];
+      }
+      break;
+    case DEMOSAIC_OUTPUT_YUV422:
+      for (int i = 0; i + 1 < n; i += 2) {
+        const uint8_t ra = avg2(r[i], r[i + 1]), ga = avg2(g[i], g[i + 1]), ba = avg2(b[i], b[i + 1]);
+        dst[i * 2 + 0] = rgb_to_y(r[i], g[i], b[i]);
+        dst[i * 2 + 1] = rgb_to_u(ra, ga, ba);
+        dst[i * 2 + 2] = rgb_to_y(r[i + 1], g[i + 1], b[i + 1]);
+        dst[i * 2 + 3] = rgb_to_v(ra, ga, ba);
+      }
+      break;
+    default: {
+      uint16_t *px = (uint16_t *) dst;
+      for (int i = 0; i < n; i++) {
+        px[i] = pack_rgb565(r[i], g[i], b[i]);
+      }
+      break;
+    }
+  }
+}
+
+void demosaic_rows(const FrameView &raw, DemosaicMethod method, bool binned, DemosaicOutput format,
+                   uint16_t row_begin, uint16_t row_end, uint8_t *out, uint32_t out_stride) {
+  if (!raw.valid() || raw.format != PIXEL_FORMAT_RAW8 || raw.width < 2 || raw.height < 2) {
+    return;
+  }
+  // Trop petit pour le voisinage : le quad suffit
+  if (raw.width <= 2 * MAX_RADIUS || raw.height <= 2 * MAX_RADIUS)
+    method = DEMOSAIC_NEAREST;
+
+  const BayerLayout layout(raw.bayer_pattern);
+  const uint16_t width = demosaic_output_width(raw, binned);
+  const uint8_t bpp = demosaic_output_bpp(format);
+  const int radius = method == DEMOSAIC_EDGE_AWARE ? MAX_RADIUS : 1;
+  uint8_t r[CHUNK], g[CHUNK], b[CHUNK];
+  Band band;
+
+  if (method == DEMOSAIC_EDGE_AWARE && !binned) {
+    // Colonne de chunks d'abord : le vert de chaque ligne sert à trois lignes
+    // de sortie, il est calculé une fois et roulé.
+    int16_t green[3][CHUNK + 2];
+    for (uint16_t x0 = 0; x0 < width; x0 += CHUNK) {
+      const int n = width - x0 < CHUNK ? width - x0 : CHUNK;
+      int16_t *rows[3] = {green[0], green[1], green[2]};
+      for (uint16_t y = row_begin; y < row_end; y++) {
+        band.load(raw, y, x0, n, radius);
+        if (y == row_begin) {
+          edge_green_row(band, layout, x0, y, -1, n, rows[0]);
+          edge_green_row(band, layout, x0, y, 0, n, rows[1]);
+        }
+        edge_green_row(band, layout, x0, y, 1, n, rows[2]);
+        edge_aware_chunk(band, layout, rows, x0, y, n, r, g, b);
+        emit_chunk(format, r, g, b, n, out + (size_t) y * out_stride + (size_t) x0 * bpp);
+        int16_t *oldest = rows[0];
+        rows[0] = rows[1];
+        rows[1] = rows[2];
+        rows[2] = oldest;
+      }
+    }
+    return;
+  }
+
+  for (uint16_t y = row_begin; y < row_end; y++) {
+    uint8_t *dst = out + (size_t) y * out_stride;
+    for (uint16_t x0 = 0; x0 < width; x0 += CHUNK) {
+      const int n = width - x0 < CHUNK ? width - x0 : CHUNK;
+      if (binned || method == DEMOSAIC_NEAREST) {
+        nearest_chunk(raw, layout, x0, y, n, binned, r, g, b);
+      } else {
+        band.load(raw, y, x0, n, radius);
+        bilinear_chunk(band, layout, x0, y, n, r, g, b);
+      }
+      emit_chunk(format, r, g, b, n, dst + (size_t) x0 * bpp);
+    }
+  }
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
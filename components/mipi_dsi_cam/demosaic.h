@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_view.h"
+
+// Dématriçage logiciel des frames RAW8, vérifié sur host par
+// tests/demosaic_golden_test.cpp.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+enum DemosaicMethod {
+  DEMOSAIC_NEAREST = 0,     // couleur du quad 2x2, le moins cher
+  DEMOSAIC_BILINEAR = 1,    // moyenne des voisins de chaque canal
+  DEMOSAIC_EDGE_AWARE = 2,  // vert interpolé le long des contours, R/B par différence de couleur
+};
+
+enum DemosaicOutput {
+  DEMOSAIC_OUTPUT_RGB565 = 0,
+  DEMOSAIC_OUTPUT_RGB888 = 1,
+  DEMOSAIC_OUTPUT_YUV422 = 2,  // Y0 U Y1 V, BT.601 pleine échelle
+};
+
+inline uint8_t demosaic_output_bpp(DemosaicOutput format) { return format == DEMOSAIC_OUTPUT_RGB888 ? 3 : 2; }
+
+// Dématriçage d'une vue RAW8 (les quatre ordres, voir FrameView::bayer_pattern)
+// quand l'ISP ne le fait pas : capture RAW8 pour économiser la bande passante,
+// ou ISP occupé par un autre flux.
+//
+// Par bandes : demosaic_rows() ne produit que les lignes [row_begin, row_end),
+// une frame peut se répartir sur les deux cœurs ou s'entrelacer avec le
+// consommateur. Les bords sont en miroir, ce qui garde la phase Bayer. Les
+// lignes sont parcourues par paquets de colonnes : quelques centaines d'octets
+// de pile, des boucles internes sans branchement.
+//
+// `binned` fusionne un binning 2x2 : sortie demi-taille, un pixel par quad
+// (la méthode n'importe plus).
+void demosaic_rows(const FrameView &raw, DemosaicMethod method, bool binned, DemosaicOutput format,
+                   uint16_t row_begin, uint16_t row_end, uint8_t *out, uint32_t out_stride);
+
+inline uint16_t demosaic_output_width(const FrameView &raw, bool binned) { return binned ? raw.width / 2 : raw.width; }
+inline uint16_t demosaic_output_height(const FrameView &raw, bool binned) {
+  return binned ? raw.height / 2 : raw.height;
+}
+
+// Toute la vue, en image compacte.
+inline void demosaic(const FrameView &raw, DemosaicMethod method, bool binned, DemosaicOutput format, uint8_t *out) {
+  demosaic_rows(raw, method, binned, format, 0, demosaic_output_height(raw, binned), out,
+                (uint32_t) demosaic_output_width(raw, binned) * demosaic_output_bpp(format));
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,113 @@
+#include "frame_metrics.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+constexpr uint32_t LatencyHistogram::BUCKET_BOUNDS_US[];
+
+static const char *const STAGE_NAMES[STAGE_COUNT] = {
+    "csi_frame_interval", "acquire", "convert", "jpeg_encode", "http_send", "glass_to_client", "lvgl_invalidate",
+    "motion", "signature", "scale", "rotate", "lvgl_render", "osd",
+};
+
+struct CounterDesc {
+  const char *name;
+  const char *help;
+};
+
+static const CounterDesc COUNTERS[COUNTER_COUNT] = {
+    {"frames_captured", "Frames completed by the capture controller"},
+    {"frames_dropped", "Frames lost because no pool slot was free"},
+    {"frames_displayed", "Frames pushed to the LVGL canvas"},
+    {"encode_failures", "JPEG encodings that failed"},
+    {"send_failures", "HTTP image sends that failed"},
+    {"encoder_busy", "Frames not encoded or snapshots refused, no JPEG buffer available in time"},
+    {"jpeg_reused", "HTTP images sent from a JPEG already encoded for another client"},
+    {"not_modified", "Frames not re-encoded for the web clients, content unchanged"},
+    {"display_skipped", "Frames not redrawn on the LVGL canvas, content unchanged"},
+    {"display_partial", "Canvas updates limited to the changed tiles"},
+    {"display_paced", "Frames not shown to keep the display within its CPU budget"},
+};
+
+const char *metric_stage_name(MetricStage stage) { return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "unknown"; }
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+  Snapshot snap;
+  for (uint8_t i = 0; i < BUCKET_COUNT; i++) {
+    snap.buckets[i] = this->buckets_[i].load(std::memory_order_relaxed);
+    snap.count += snap.buckets[i];
+  }
+  snap.sum_us = this->sum_us_.load(std::memory_order_relaxed);
+  return snap;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Snapshot::since(const Snapshot &earlier) const {
+  Snapshot delta;
+  for (uint8_t i = 0; i < BUCKET_COUNT; i++) {
+    delta.buckets[i] = this->buckets[i] - earlier.buckets[i];
+    delta.count += delta.buckets[i];
+  }
+  delta.sum_us = this->sum_us - earlier.sum_us;
+  return delta;
+}
+
+uint32_t LatencyHistogram::Snapshot::percentile_us(float q) const {
+  if (this->count == 0)
+    return 0;
+  const float rank = q * this->count;
+  uint32_t below = 0;
+  for (uint8_t i = 0; i < BUCKET_COUNT; i++) {
+    if (below + this->buckets[i] >= rank && this->buckets[i] != 0) {
+      const uint32_t lower = i == 0 ? 0 : BUCKET_BOUNDS_US[i - 1];
+      // Au-delà de la dernière borne : on ne sait pas, on la rend
+      if (i == BUCKET_COUNT - 1)
+        return lower;
+      const float fraction = (rank - below) / this->buckets[i];
+      return lower + (uint32_t) (fraction * (BUCKET_BOUNDS_US[i] - lower));
+    }
+    below += this->buckets[i];
+  }
+  return BUCKET_BOUNDS_US[BUCKET_COUNT - 2];
+}
+
+void FrameMetrics::write_prometheus(std::string &out) const {
+  char line[320];
+  out += "# HELP mipi_camera_stage_latency_seconds Latency of each frame pipeline stage\n"
+         "# TYPE mipi_camera_stage_latency_seconds histogram\n";
+  for (uint8_t s = 0; s < STAGE_COUNT; s++) {
+    const char *stage = STAGE_NAMES[s];
+    const LatencyHistogram::Snapshot snap = this->histograms_[s].snapshot();
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < LatencyHistogram::BUCKET_COUNT; i++) {
+      cumulative += snap.buckets[i];
+      if (i < LatencyHistogram::BUCKET_COUNT - 1) {
+        snprintf(line, sizeof(line), "mipi_camera_stage_latency_seconds_bucket{stage=\"%s\",le=\"%g\"} %" PRIu32 "\n",
+                 stage, LatencyHistogram::BUCKET_BOUNDS_US[i] / 1e6, cumulative);
+      } else {
+        snprintf(line, sizeof(line), "mipi_camera_stage_latency_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %" PRIu32 "\n",
+                 stage, cumulative);
+      }
+      out += line;
+    }
+    snprintf(line, sizeof(line),
+             "mipi_camera_stage_latency_seconds_sum{stage=\"%s\"} %.6f\n"
+             "mipi_camera_stage_latency_seconds_count{stage=\"%s\"} %" PRIu32 "\n",
+             stage, snap.sum_us / 1e6, stage, snap.count);
+    out += line;
+  }
+
+  for (uint8_t c = 0; c < COUNTER_COUNT; c++) {
+    snprintf(line, sizeof(line),
+             "# HELP mipi_camera_%s_total %s\n"
+             "# TYPE mipi_camera_%s_total counter\n"
+             "mipi_camera_%s_total %" PRIu32 "\n",
+             COUNTERS[c].name, COUNTERS[c].help, COUNTERS[c].name, COUNTERS[c].name, this->counter((MetricCounter) c));
+    out += line;
+  }
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Télémétrie du pipeline, exposée en Prometheus sur /metrics par le serveur web.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Étapes chronométrées du pipeline. Les latences mesurées depuis
+// l'interruption de fin de frame (FrameInfo::timestamp_us) sont « glass-to-X ».
+enum MetricStage : uint8_t {
+  STAGE_CSI_FRAME_INTERVAL = 0,  // entre deux interruptions de fin de frame
+  STAGE_ACQUIRE,                 // fin de frame -> prise par un consommateur
+  STAGE_CONVERT,                 // conversion de format / dématriçage
+  STAGE_JPEG_ENCODE,
+  STAGE_HTTP_SEND,               // httpd_resp_send() d'une image
+  STAGE_GLASS_TO_CLIENT,         // fin de frame -> envoi HTTP terminé
+  STAGE_LVGL_INVALIDATE,         // fin de frame -> canvas invalidé
+  STAGE_MOTION,                  // passe de détection de mouvement
+  STAGE_SIGNATURE,               // signature du contenu d'une frame
+  STAGE_SCALE,                   // mise à l'échelle du canvas
+  STAGE_ROTATE,                  // rotation / miroir (frame_transform.h)
+  STAGE_LVGL_RENDER,             // rendu LVGL + flush d'une frame caméra
+  STAGE_OSD,                     // incrustation OSD (osd_overlay.h)
+  STAGE_COUNT,
+};
+
+enum MetricCounter : uint8_t {
+  COUNTER_FRAMES_CAPTURED = 0,
+  COUNTER_FRAMES_DROPPED,  // recopié du pool de frames
+  COUNTER_FRAMES_DISPLAYED,
+  COUNTER_ENCODE_FAILURES,
+  COUNTER_SEND_FAILURES,
+  COUNTER_ENCODER_BUSY,  // frame non encodée (buffers JPEG tous en envoi) ou snapshot expiré
+  COUNTER_JPEG_REUSED,   // JPEG envoyé depuis un buffer déjà envoyé à un autre client
+  COUNTER_NOT_MODIFIED,  // contenu inchangé : pas réencodé, les clients gardent le JPEG précédent
+  COUNTER_DISPLAY_SKIPPED,  // contenu inchangé : canvas non redessiné
+  COUNTER_DISPLAY_PARTIAL,  // seules les tuiles changées invalidées
+  COUNTER_DISPLAY_PACED,    // non affichée pour tenir la cadence (FramePacer)
+  COUNTER_COUNT,
+};
+
+const char *metric_stage_name(MetricStage stage);
+
+// Histogramme de latences à seaux fixes (façon Prometheus, µs). record() n'est
+// que quelques additions atomiques relâchées : sûr depuis l'ISR et toute tâche.
+class LatencyHistogram {
+ public:
+  static constexpr uint8_t BUCKET_COUNT = 12;
+  // Bornes hautes, le dernier seau est +Inf
+  static constexpr uint32_t BUCKET_BOUNDS_US[BUCKET_COUNT - 1] = {
+      500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000,
+  };
+
+  inline void record(uint32_t us);
+
+  // Copie assez cohérente pour un rapport (count = somme des seaux)
+  struct Snapshot {
+    uint32_t buckets[BUCKET_COUNT]{};
+    uint32_t count{0};
+    uint64_t sum_us{0};
+
+    // Estimé depuis les seaux (linéaire dans un seau), 0 si vide
+    uint32_t percentile_us(float q) const;
+    // Mesures enregistrées après `earlier` (copie plus ancienne du même histogramme)
+    Snapshot since(const Snapshot &earlier) const;
+  };
+  Snapshot snapshot() const;
+
+ protected:
+  std::atomic<uint32_t> buckets_[BUCKET_COUNT]{};
+  std::atomic<uint64_t> sum_us_{0};
+};
+
+// Partagée par la caméra et ses consommateurs (MipiDsiCam::get_metrics()).
+class FrameMetrics {
+ public:
+  void record(MetricStage stage, uint32_t us) { this->histograms_[stage].record(us); }
+  void increment(MetricCounter counter) { this->counters_[counter].fetch_add(1, std::memory_order_relaxed); }
+  void set(MetricCounter counter, uint32_t value) { this->counters_[counter].store(value, std::memory_order_relaxed); }
+
+  LatencyHistogram::Snapshot histogram(MetricStage stage) const { return this->histograms_[stage].snapshot(); }
+  uint32_t counter(MetricCounter counter) const { return this->counters_[counter].load(std::memory_order_relaxed); }
+
+  // Format texte d'exposition Prometheus, ajouté à `out`
+  void write_prometheus(std::string &out) const;
+
+ protected:
+  LatencyHistogram histograms_[STAGE_COUNT];
+  std::atomic<uint32_t> counters_[COUNTER_COUNT]{};
+};
+
+void LatencyHistogram::record(uint32_t us) {
+  uint8_t bucket = 0;
+  while (bucket < BUCKET_COUNT - 1 && us > BUCKET_BOUNDS_US[bucket])
+    bucket++;
+  this->buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  this->sum_us_.fetch_add(us, std::memory_order_relaxed);
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,68 @@
+#include "frame_pacer.h"
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Lissage exponentiel 1/8 : réagit en quelques frames sans suivre chaque pic
+static uint32_t smooth(uint32_t average, uint32_t sample) {
+  return average == 0 ? sample : (uint32_t) (((uint64_t) average * 7 + sample) / 8);
+}
+
+bool FramePacer::should_display(uint32_t sequence, int64_t timestamp_us) {
+  if (this->has_last_ && sequence != this->last_sequence_) {
+    uint32_t steps = sequence - this->last_sequence_;
+    int64_t elapsed = timestamp_us - this->last_timestamp_us_;
+    // Trous d'une seconde et plus (pause, changement de mode) : pas une cadence
+    if (steps < 0x80000000u && elapsed > 0 && elapsed < 1000000) {
+      this->source_interval_us_ = smooth(this->source_interval_us_, (uint32_t) (elapsed / steps));
+    }
+  }
+  this->last_sequence_ = sequence;
+  this->last_timestamp_us_ = timestamp_us;
+  this->has_last_ = true;
+
+  // Compté en frames de la caméra : la cadence tient même si cette tâche
+  // voit les frames en retard
+  if (this->has_shown_ && sequence - this->shown_sequence_ < this->decimation_) {
+    return false;
+  }
+  this->shown_sequence_ = sequence;
+  this->has_shown_ = true;
+  return true;
+}
+
+void FramePacer::record_cost(uint32_t cost_us) {
+  this->cost_us_ = smooth(this->cost_us_, cost_us);
+  uint32_t source = this->source_interval_us_;
+  if (source == 0) {
+    return;
+  }
+  float required = this->cost_us_ / this->budget_;
+  if (required < this->min_interval_us_)
+    required = this->min_interval_us_;
+  // 10% de tolérance : un plafond à 60 fps ne divise pas par deux un capteur
+  // à 60 fps qui tique un peu vite
+  float frames = required / source - 0.1f;
+  uint32_t needed = frames <= 1.0f ? 1 : (uint32_t) frames + (frames > (uint32_t) frames ? 1 : 0);
+  if (needed > MAX_DECIMATION)
+    needed = MAX_DECIMATION;
+  if (needed > this->decimation_) {
+    // Surcharge : on réduit tout de suite
+    this->decimation_ = needed;
+  } else {
+    // Remonter seulement avec 15% de marge, sinon ça oscille
+    while (this->decimation_ > needed && required <= (this->decimation_ - 1) * source * 0.85f)
+      this->decimation_--;
+  }
+}
+
+void FramePacer::reset() {
+  this->source_interval_us_ = 0;
+  this->has_last_ = false;
+  this->has_shown_ = false;
+  this->cost_us_ = 0;
+  this->decimation_ = 1;
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
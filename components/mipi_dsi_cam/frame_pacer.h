@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+// Cadence d'affichage du widget LVGL, indépendante de la cadence capteur.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Affiche une frame caméra sur N, N entier pour que les frames affichées
+// restent régulièrement espacées (pas de saccade), et choisi pour que le coût
+// mesuré d'une frame affichée (conversion, mise à l'échelle, rendu LVGL et
+// flush) reste dans une part du temps CPU.
+class FramePacer {
+ public:
+  static constexpr uint8_t MAX_DECIMATION = 16;
+
+  // Intervalle minimal entre deux frames affichées (plafond de cadence), 0 = aucun
+  void set_min_interval_us(uint32_t interval_us) { this->min_interval_us_ = interval_us; }
+  // Part du temps que le widget caméra peut prendre, 0..1
+  void set_cpu_budget(float budget) { this->budget_ = budget > 0.01f ? budget : 0.01f; }
+  float get_cpu_budget() const { return this->budget_; }
+
+  // Nouvelle frame caméra (séquence, FrameInfo::timestamp_us). true : l'afficher.
+  // La décision est définitive : une frame refusée n'est pas reproposée.
+  bool should_display(uint32_t sequence, int64_t timestamp_us);
+  // Coût de la frame qui vient d'être affichée, fixe la décimation des suivantes
+  void record_cost(uint32_t cost_us);
+  void reset();
+
+  uint8_t get_decimation() const { return this->decimation_; }
+  uint32_t get_source_interval_us() const { return this->source_interval_us_; }
+  uint32_t get_cost_us() const { return this->cost_us_; }
+
+ protected:
+  uint32_t min_interval_us_{0};
+  float budget_{0.5f};
+
+  // Cadence caméra : intervalle lissé entre deux numéros de séquence
+  uint32_t source_interval_us_{0};
+  uint32_t last_sequence_{0};
+  int64_t last_timestamp_us_{0};
+  bool has_last_{false};
+
+  uint32_t shown_sequence_{0};
+  bool has_shown_{false};
+  uint32_t cost_us_{0};  // coût lissé d'une frame affichée
+  uint8_t decimation_{1};
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,122 @@
+#include "frame_pool.h"
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+bool FramePool::init(uint8_t *const *buffers, uint8_t count, size_t size) {
+  if (count < MIN_SLOTS || count > MAX_SLOTS)
+    return false;
+
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (buffers[i] == nullptr)
+      return false;
+    this->slots_[i].data = buffers[i];
+    this->slots_[i].refs.store(0, std::memory_order_relaxed);
+    this->slots_[i].sequence.store(0, std::memory_order_relaxed);
+    this->slots_[i].info = FrameInfo{};
+    mask |= 1u << i;
+  }
+  this->count_ = count;
+  this->buffer_size_ = size;
+
+  this->free_mask_.store(mask, std::memory_order_relaxed);
+  this->filled_mask_.store(0, std::memory_order_relaxed);
+  this->writing_mask_.store(0, std::memory_order_relaxed);
+  this->latest_.store(-1, std::memory_order_relaxed);
+  this->next_sequence_ = 1;
+  this->published_sequence_.store(0, std::memory_order_relaxed);
+  this->dropped_.store(0, std::memory_order_release);
+  return true;
+}
+
+void FramePool::abort_writes() {
+  uint8_t mask = this->writing_mask_.exchange(0, std::memory_order_acq_rel);
+  this->free_mask_.fetch_or(mask, std::memory_order_release);
+}
+
+void FramePool::flush() {
+  uint8_t mask = this->filled_mask_.exchange(0, std::memory_order_acq_rel);
+  this->free_mask_.fetch_or(mask, std::memory_order_release);
+  int8_t slot = this->latest_.exchange(-1, std::memory_order_acq_rel);
+  if (slot >= 0)
+    this->unref_(slot);
+}
+
+int8_t FramePool::acquire() {
+  if (this->auto_publish_.load(std::memory_order_relaxed))
+    this->publish_pending();
+
+  for (;;) {
+    int8_t slot = this->latest_.load(std::memory_order_acquire);
+    if (slot < 0)
+      return -1;
+
+    // Ne référencer qu'un slot encore référencé : à zéro, il peut déjà être
+    // revenu aux libres ou sous DMA
+    uint16_t refs = this->slots_[slot].refs.load(std::memory_order_relaxed);
+    while (refs != 0) {
+      if (this->slots_[slot].refs.compare_exchange_weak(refs, refs + 1, std::memory_order_acq_rel))
+        return slot;
+    }
+  }
+}
+
+void FramePool::release(int8_t slot) {
+  if (slot < 0 || slot >= this->count_)
+    return;
+  this->unref_(slot);
+}
+
+void FramePool::publish_pending() {
+  int8_t slot = this->take_pending();
+  if (slot >= 0)
+    this->publish_(slot);
+}
+
+int8_t FramePool::take_pending() {
+  uint8_t mask = this->filled_mask_.exchange(0, std::memory_order_acq_rel);
+  if (mask == 0)
+    return -1;
+
+  int8_t newest = -1;
+  for (uint8_t i = 0; i < this->count_; i++) {
+    if (!(mask & (1u << i)))
+      continue;
+    if (newest < 0 || (int32_t) (this->sequence(i) - this->sequence(newest)) > 0)
+      newest = i;
+  }
+  // Frames dépassées avant toute lecture : recyclées directement
+  this->free_mask_.fetch_or(mask & ~(1u << newest), std::memory_order_release);
+  return newest;
+}
+
+void FramePool::publish_(int8_t slot) {
+  this->slots_[slot].refs.store(1, std::memory_order_release);
+  uint32_t seq = this->sequence(slot);
+
+  // Deux consommateurs peuvent publier en même temps et l'ISR reprendre
+  // `latest` entre-temps : la séquence publiée ne recule jamais
+  uint32_t newest = this->published_sequence_.load(std::memory_order_relaxed);
+  do {
+    if ((int32_t) (seq - newest) <= 0) {
+      this->unref_(slot);
+      return;
+    }
+  } while (!this->published_sequence_.compare_exchange_weak(newest, seq, std::memory_order_relaxed));
+
+  int8_t old = this->latest_.load(std::memory_order_acquire);
+  for (;;) {
+    if (old >= 0 && (int32_t) (this->sequence(old) - seq) > 0) {
+      this->unref_(slot);
+      return;
+    }
+    if (this->latest_.compare_exchange_weak(old, slot, std::memory_order_acq_rel))
+      break;
+  }
+  if (old >= 0)
+    this->unref_(old);
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_view.h"
+
+// Rien que des buffers et des atomiques : tests/frame_pool_stress_test.cpp
+// le fait tourner sur host avec des std::thread.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Métadonnées posées par l'ISR de capture sur chaque frame remise au pool.
+struct FrameInfo {
+  uint32_t sequence{0};        // croissant, 0 = pas de frame
+  int64_t timestamp_us{0};     // instant de capture (interruption de fin de frame)
+  size_t received_size{0};     // octets écrits par le DMA
+  uint16_t width{0};           // géométrie du mode capteur de la capture
+  uint16_t height{0};
+  PixelFormat format{PIXEL_FORMAT_RGB565};
+  uint16_t exposure{0};        // exposition capteur en vigueur
+  uint8_t gain_index{0};       // index de gain capteur en vigueur
+  uint32_t dropped_frames{0};  // pertes cumulées à la capture de cette frame
+};
+
+// Pool de N slots partagé entre le DMA CSI (producteur, contexte ISR) et les
+// consommateurs (LVGL, serveur web, ...).
+//
+// Chaque slot est à un seul endroit à la fois :
+//   libres     -> confiés au DMA par begin_write()
+//   DMA        -> commit_write() les passe aux remplis, cancel_write() aux libres
+//   remplis    -> publish_pending() fait du plus récent `latest`
+//   latest     -> tient une référence ; acquire() en ajoute une par consommateur
+// Libres et remplis sont des masques atomiques, ordonnés par séquence : rien
+// ne bloque, et un consommateur interrompu ne fait jamais perdre de slot à
+// l'ISR. Un slot ne redevient libre qu'à zéro référence : le DMA n'écrit
+// jamais dans un buffer encore tenu. Sans slot disponible, la plus ancienne
+// frame non lue est recyclée (ou la frame entrante jetée) et la perte comptée.
+class FramePool {
+ public:
+  static constexpr uint8_t MIN_SLOTS = 3;
+  static constexpr uint8_t MAX_SLOTS = 6;
+
+  // Les buffers restent à l'appelant, `size` est leur capacité : une frame
+  // peut en utiliser moins (FrameInfo::received_size). Pas thread-safe.
+  bool init(uint8_t *const *buffers, uint8_t count, size_t size);
+
+  // --- Producteur (appelable en ISR, ne bloque jamais) ---
+  inline int8_t begin_write();
+  // Séquence et pertes de `info` sont renseignées par le pool.
+  inline void commit_write(int8_t slot, const FrameInfo &info);
+  inline void cancel_write(int8_t slot);
+  inline int8_t slot_for(const void *buffer) const;
+  // Rend aux libres les slots encore au DMA (contrôleur arrêté).
+  void abort_writes();
+  // Recycle les frames remplies et retire la frame publiée (contrôleur
+  // arrêté, changement de mode). Un consommateur qui tient une frame la garde
+  // jusqu'à son release.
+  void flush();
+
+  // --- Consommateurs (toute tâche) ---
+  // Dernière frame publiée, une référence prise ; -1 si aucune.
+  int8_t acquire();
+  void release(int8_t slot);
+  // Publie la plus récente frame remplie comme `latest`, recycle les autres.
+  void publish_pending();
+
+  // --- Étage de traitement (une seule tâche) ---
+  // Sans auto-publication, acquire() ne publie plus : le propriétaire prend la
+  // frame remplie la plus récente avec take_pending() (exclusive : ni le DMA
+  // ni les consommateurs n'y ont accès), la traite en place puis la publish().
+  void set_auto_publish(bool auto_publish) { this->auto_publish_.store(auto_publish, std::memory_order_relaxed); }
+  int8_t take_pending();
+  void publish(int8_t slot) { this->publish_(slot); }
+
+  uint8_t *data(int8_t slot) const { return this->slots_[slot].data; }
+  uint32_t sequence(int8_t slot) const { return this->slots_[slot].sequence.load(std::memory_order_acquire); }
+  // Stable seulement tant que le slot est référencé (entre acquire et release).
+  const FrameInfo &info(int8_t slot) const { return this->slots_[slot].info; }
+  size_t buffer_size() const { return this->buffer_size_; }
+  uint8_t slot_count() const { return this->count_; }
+  uint32_t get_dropped_frames() const { return this->dropped_.load(std::memory_order_relaxed); }
+
+ protected:
+  struct Slot {
+    uint8_t *data{nullptr};
+    std::atomic<uint16_t> refs{0};
+    std::atomic<uint32_t> sequence{0};
+    FrameInfo info;
+  };
+
+  void publish_(int8_t slot);
+  inline void unref_(int8_t slot);
+  inline int8_t take_free_();
+  inline int8_t take_oldest_filled_();
+
+  Slot slots_[MAX_SLOTS];
+  uint8_t count_{0};
+  size_t buffer_size_{0};
+
+  std::atomic<uint8_t> free_mask_{0};
+  std::atomic<uint8_t> filled_mask_{0};
+  std::atomic<uint8_t> writing_mask_{0};
+  std::atomic<int8_t> latest_{-1};
+  std::atomic<bool> auto_publish_{true};
+
+  uint32_t next_sequence_{1};  // producteur uniquement
+  std::atomic<uint32_t> published_sequence_{0};
+  std::atomic<uint32_t> dropped_{0};
+};
+
+int8_t FramePool::take_free_() {
+  uint8_t mask = this->free_mask_.load(std::memory_order_acquire);
+  while (mask != 0) {
+    int8_t slot = __builtin_ctz(mask);
+    if (this->free_mask_.compare_exchange_weak(mask, mask & ~(1u << slot), std::memory_order_acq_rel))
+      return slot;
+  }
+  return -1;
+}
+
+int8_t FramePool::take_oldest_filled_() {
+  uint8_t mask = this->filled_mask_.load(std::memory_order_acquire);
+  while (mask != 0) {
+    int8_t oldest = -1;
+    uint32_t oldest_seq = 0;
+    for (uint8_t i = 0; i < this->count_; i++) {
+      if (!(mask & (1u << i)))
+        continue;
+      uint32_t seq = this->sequence(i);
+      if (oldest < 0 || (int32_t) (seq - oldest_seq) < 0) {
+        oldest = i;
+        oldest_seq = seq;
+      }
+    }
+    if (this->filled_mask_.compare_exchange_weak(mask, mask & ~(1u << oldest), std::memory_order_acq_rel))
+      return oldest;
+  }
+  return -1;
+}
+
+int8_t FramePool::begin_write() {
+  int8_t slot = this->take_free_();
+  if (slot < 0) {
+    // Plus de slot libre : recycler la plus ancienne frame non lue, ou la
+    // frame publiée si aucun consommateur ne la tient
+    slot = this->take_oldest_filled_();
+    if (slot < 0) {
+      slot = this->latest_.exchange(-1, std::memory_order_acq_rel);
+      if (slot >= 0 && this->slots_[slot].refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        slot = -1;
+    }
+    // Le contenu du slot (ou la frame entrante) est perdu
+    this->dropped_.fetch_add(1, std::memory_order_relaxed);
+    if (slot < 0)
+      return -1;
+  }
+  this->writing_mask_.fetch_or(1u << slot, std::memory_order_relaxed);
+  return slot;
+}
+
+void FramePool::commit_write(int8_t slot, const FrameInfo &info) {
+  this->writing_mask_.fetch_and(~(1u << slot), std::memory_order_relaxed);
+  uint32_t seq = this->next_sequence_++;
+  Slot &s = this->slots_[slot];
+  s.info = info;
+  s.info.sequence = seq;
+  s.info.dropped_frames = this->dropped_.load(std::memory_order_relaxed);
+  s.sequence.store(seq, std::memory_order_release);
+  this->filled_mask_.fetch_or(1u << slot, std::memory_order_release);
+}
+
+void FramePool::cancel_write(int8_t slot) {
+  this->writing_mask_.fetch_and(~(1u << slot), std::memory_order_relaxed);
+  this->free_mask_.fetch_or(1u << slot, std::memory_order_release);
+}
+
+int8_t FramePool::slot_for(const void *buffer) const {
+  for (uint8_t i = 0; i < this->count_; i++) {
+    if (this->slots_[i].data == buffer)
+      return i;
+  }
+  return -1;
+}
+
+void FramePool::unref_(int8_t slot) {
+  if (this->slots_[slot].refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    this->free_mask_.fetch_or(1u << slot, std::memory_order_release);
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
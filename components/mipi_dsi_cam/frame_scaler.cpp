@@ -0,0 +1,142 @@
+#include "frame_scaler.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// RGB565 étalé sur 32 bits (G en haut, R et B en bas, avec des trous) : les
+// trois canaux sont pondérés en une multiplication, sans débordement pour des
+// poids jusqu'à 32 ou des sommes de 16 pixels
+static constexpr uint32_t SPREAD_MASK = 0x07E0F81F;
+static inline uint32_t spread565(uint16_t px) { return (px | ((uint32_t) px << 16)) & SPREAD_MASK; }
+static inline uint16_t pack565(uint32_t v) { return (uint16_t) (v | (v >> 16)); }
+// a + (b - a) * w / 32, w dans 0..32
+static inline uint32_t lerp565(uint32_t a, uint32_t b, uint32_t w) {
+  return ((a * (32 - w) + b * w) >> 5) & SPREAD_MASK;
+}
+
+const char *scale_filter_name(ScaleFilter filter) {
+  return filter == SCALE_FILTER_AREA ? "area average" : "bilinear";
+}
+
+uint16_t fit_scale_sixteenths(uint16_t src_w, uint16_t src_h, uint16_t max_w, uint16_t max_h) {
+  if (src_w == 0 || src_h == 0)
+    return 0;
+  uint32_t kw = (uint32_t) max_w * 16 / src_w;
+  uint32_t kh = (uint32_t) max_h * 16 / src_h;
+  return (uint16_t) std::min(kw, kh);
+}
+
+void SoftwareScaler::layout_axis_(Axis &axis, uint16_t src, uint16_t dst, ScaleFilter filter) {
+  if (filter == SCALE_FILTER_BILINEAR) {
+    axis.first.resize(dst);
+    axis.second.resize(dst);
+    axis.weight.resize(dst);
+    for (uint16_t i = 0; i < dst; i++) {
+      // Centres alignés : centre du pixel de sortie ramené dans la source, en 16.16
+      int64_t pos = (((int64_t) 2 * i + 1) * src << 16) / (2 * dst) - 32768;
+      if (pos < 0)
+        pos = 0;
+      uint16_t p0 = (uint16_t) std::min<int64_t>(pos >> 16, src - 1);
+      axis.first[i] = p0;
+      axis.second[i] = p0 + 1 < src ? p0 + 1 : p0;
+      axis.weight[i] = (uint8_t) (((pos & 0xFFFF) + 1024) >> 11);
+    }
+    return;
+  }
+  // Boîte [i * src / dst, (i + 1) * src / dst), au plus MAX_AREA_SAMPLES échantillons centrés
+  axis.first.resize((size_t) dst * MAX_AREA_SAMPLES);
+  axis.second.clear();
+  axis.weight.resize(dst);
+  for (uint16_t i = 0; i < dst; i++) {
+    uint32_t start = (uint32_t) i * src / dst;
+    uint32_t end = std::max<uint32_t>((uint32_t) (i + 1) * src / dst, start + 1);
+    uint32_t length = std::min<uint32_t>(end, src) - start;
+    uint8_t count = (uint8_t) std::min<uint32_t>(length, MAX_AREA_SAMPLES);
+    axis.weight[i] = count;
+    for (uint8_t s = 0; s < count; s++) {
+      axis.first[(size_t) i * MAX_AREA_SAMPLES + s] = (uint16_t) (start + ((2u * s + 1) * length) / (2u * count));
+    }
+  }
+}
+
+bool SoftwareScaler::scale(const FrameView &src, const FrameView &dst) {
+  if (!src.valid() || !dst.valid() || src.format != PIXEL_FORMAT_RGB565 || dst.format != PIXEL_FORMAT_RGB565) {
+    return false;
+  }
+  if (src.width != this->src_w_ || src.height != this->src_h_ || dst.width != this->dst_w_ ||
+      dst.height != this->dst_h_ || this->filter_ != this->layout_filter_) {
+    layout_axis_(this->x_, src.width, dst.width, this->filter_);
+    layout_axis_(this->y_, src.height, dst.height, this->filter_);
+    this->src_w_ = src.width;
+    this->src_h_ = src.height;
+    this->dst_w_ = dst.width;
+    this->dst_h_ = dst.height;
+    this->layout_filter_ = this->filter_;
+  }
+  if (this->filter_ == SCALE_FILTER_AREA) {
+    this->scale_area_(src, dst);
+  } else {
+    this->scale_bilinear_(src, dst);
+  }
+  return true;
+}
+
+void SoftwareScaler::scale_bilinear_(const FrameView &src, const FrameView &dst) const {
+  const uint16_t *x0 = this->x_.first.data();
+  const uint16_t *x1 = this->x_.second.data();
+  const uint8_t *wx = this->x_.weight.data();
+  for (uint16_t y = 0; y < dst.height; y++) {
+    const uint16_t *top = (const uint16_t *) src.row(this->y_.first[y]);
+    const uint16_t *bottom = (const uint16_t *) src.row(this->y_.second[y]);
+    const uint32_t wy = this->y_.weight[y];
+    uint16_t *out = (uint16_t *) dst.row(y);
+    if (wy == 0) {
+      // Ligne source exacte : interpolation horizontale seule
+      for (uint16_t x = 0; x < dst.width; x++) {
+        out[x] = pack565(lerp565(spread565(top[x0[x]]), spread565(top[x1[x]]), wx[x]));
+      }
+      continue;
+    }
+    for (uint16_t x = 0; x < dst.width; x++) {
+      uint32_t upper = lerp565(spread565(top[x0[x]]), spread565(top[x1[x]]), wx[x]);
+      uint32_t lower = lerp565(spread565(bottom[x0[x]]), spread565(bottom[x1[x]]), wx[x]);
+      out[x] = pack565(lerp565(upper, lower, wy));
+    }
+  }
+}
+
+void SoftwareScaler::scale_area_(const FrameView &src, const FrameView &dst) const {
+  // 1/n en 16.16 pour n = 1..16 échantillons
+  uint32_t reciprocal[MAX_AREA_SAMPLES * MAX_AREA_SAMPLES + 1];
+  for (uint32_t n = 1; n <= MAX_AREA_SAMPLES * MAX_AREA_SAMPLES; n++) {
+    reciprocal[n] = (65536 + n / 2) / n;
+  }
+  const uint16_t *rows[MAX_AREA_SAMPLES];
+  for (uint16_t y = 0; y < dst.height; y++) {
+    const uint8_t ny = this->y_.weight[y];
+    for (uint8_t s = 0; s < ny; s++) {
+      rows[s] = (const uint16_t *) src.row(this->y_.first[(size_t) y * MAX_AREA_SAMPLES + s]);
+    }
+    uint16_t *out = (uint16_t *) dst.row(y);
+    for (uint16_t x = 0; x < dst.width; x++) {
+      const uint8_t nx = this->x_.weight[x];
+      const uint16_t *xs = &this->x_.first[(size_t) x * MAX_AREA_SAMPLES];
+      uint32_t sum = 0;
+      for (uint8_t sy = 0; sy < ny; sy++) {
+        for (uint8_t sx = 0; sx < nx; sx++) {
+          sum += spread565(rows[sy][xs[sx]]);
+        }
+      }
+      const uint32_t inv = reciprocal[nx * ny];
+      uint32_t b = ((sum & 0x3FF) * inv + 32768) >> 16;
+      uint32_t r = (((sum >> 11) & 0x3FF) * inv + 32768) >> 16;
+      uint32_t g = (((sum >> 21) & 0x7FF) * inv + 32768) >> 16;
+      out[x] = (uint16_t) ((r << 11) | (g << 5) | b);
+    }
+  }
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
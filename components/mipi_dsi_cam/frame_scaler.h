@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_transform.h"
+#include "frame_view.h"
+
+// Redimensionnement RGB565 pour l'affichage et les flux ; le backend matériel
+// est dans ppa_scaler.h (ESP32-P4 uniquement).
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+enum ScaleFilter : uint8_t {
+  SCALE_FILTER_BILINEAR = 0,
+  SCALE_FILTER_AREA,  // moyenne sur boîte, pour réduire (plus proche voisin en agrandissement)
+};
+
+const char *scale_filter_name(ScaleFilter filter);
+
+// Facteurs d'échelle multiples de 1/16 (le pas du PPA) : tous les backends
+// sortent exactement la même taille. Plus grand k tel que src * k / 16 tienne
+// dans max_w x max_h en gardant le ratio, 0 si rien ne tient.
+uint16_t fit_scale_sixteenths(uint16_t src_w, uint16_t src_h, uint16_t max_w, uint16_t max_h);
+
+// Rééchantillonne une vue RGB565 dans une autre (ratio quelconque, strides
+// libres des deux côtés). dst est entièrement écrite.
+class FrameScaler {
+ public:
+  virtual ~FrameScaler() = default;
+  virtual const char *get_name() const = 0;
+  virtual bool scale(const FrameView &src, const FrameView &dst) = 0;
+  // Rotation / miroir dans la même passe (dst a la taille transformée).
+  // Sans support, seule l'identité passe : tourner avec transform_frame().
+  virtual bool supports_transform() const { return false; }
+  virtual bool scale_transformed(const FrameView &src, const FrameView &dst, const FrameTransform &transform) {
+    return transform.is_identity() && this->scale(src, dst);
+  }
+};
+
+// Virgule fixe, portable. Les tables de coordonnées sont gardées d'une frame
+// à l'autre pour une même géométrie : un flux stable ne paie que la boucle
+// pixels.
+class SoftwareScaler : public FrameScaler {
+ public:
+  static constexpr uint8_t MAX_AREA_SAMPLES = 4;  // par axe et par pixel de sortie
+
+  explicit SoftwareScaler(ScaleFilter filter = SCALE_FILTER_BILINEAR) : filter_(filter) {}
+  const char *get_name() const override { return "software"; }
+  void set_filter(ScaleFilter filter) { this->filter_ = filter; }
+  ScaleFilter get_filter() const { return this->filter_; }
+  bool scale(const FrameView &src, const FrameView &dst) override;
+
+ protected:
+  // Positions source de chaque colonne / ligne de sortie pour le filtre courant
+  struct Axis {
+    std::vector<uint16_t> first;   // bilinéaire : échantillon gauche / haut ; area : positions
+    std::vector<uint16_t> second;  // bilinéaire : échantillon droit / bas
+    std::vector<uint8_t> weight;   // bilinéaire : 0-32 vers `second` ; area : nb d'échantillons
+  };
+  static void layout_axis_(Axis &axis, uint16_t src, uint16_t dst, ScaleFilter filter);
+  void scale_bilinear_(const FrameView &src, const FrameView &dst) const;
+  void scale_area_(const FrameView &src, const FrameView &dst) const;
+
+  ScaleFilter filter_;
+  // Géométrie pour laquelle les tables ont été construites
+  uint16_t src_w_{0};
+  uint16_t src_h_{0};
+  uint16_t dst_w_{0};
+  uint16_t dst_h_{0};
+  ScaleFilter layout_filter_{SCALE_FILTER_BILINEAR};
+  Axis x_;
+  Axis y_;
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
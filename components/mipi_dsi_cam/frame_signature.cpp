@@ -0,0 +1,275 @@
+#include "frame_signature.h"
+#include "pixel_convert.h"
+
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Luma des échantillons `xs` de la ligne y, ajoutée à sums[i / per_sum]
+static void accumulate_row_luma(const FrameView &view, uint16_t y, const uint16_t *xs, uint16_t count,
+                                uint8_t per_sum, uint16_t *sums) {
+  if (view.format == PIXEL_FORMAT_RGB565) {
+    const uint16_t *row = (const uint16_t *) view.row(y);
+    for (uint16_t i = 0; i < count; i++) {
+      uint16_t px = row[xs[i]];
+      sums[i / per_sum] += luma565(px >> 11, (px >> 5) & 0x3F, px & 0x1F);
+    }
+  } else if (view.format == PIXEL_FORMAT_YUV422) {
+    // Y0 U Y1 V : le Y du pixel x est l'octet 2x
+    const uint8_t *row = view.row(y);
+    for (uint16_t i = 0; i < count; i++) {
+      sums[i / per_sum] += row[2 * xs[i]];
+    }
+  } else {
+    // Moyenne du quad (xs pairs) : les quatre couleurs pèsent pareil, sans démosaïquage
+    y &= ~1;
+    const uint8_t *row0 = view.row(y);
+    const uint8_t *row1 = y + 1 < view.height ? view.row(y + 1) : row0;
+    for (uint16_t i = 0; i < count; i++) {
+      uint16_t x = xs[i];
+      uint16_t x1 = x + 1 < view.width ? x + 1 : x;
+      sums[i / per_sum] += (row0[x] + row0[x1] + row1[x] + row1[x1] + 2) >> 2;
+    }
+  }
+}
+
+// Échantillon i (sur count) au centre de sous-intervalles réguliers de [start, start + length)
+static inline uint16_t sample_position(uint16_t start, uint16_t length, uint16_t i, uint16_t count) {
+  return start + (uint16_t) (((2u * i + 1) * length) / (2u * count));
+}
+
+uint8_t FrameSignature::distance(const FrameSignature &other) const {
+  if (!this->valid() || !other.valid() || this->width != other.width || this->height != other.height ||
+      this->format != other.format) {
+    return 255;
+  }
+  int largest = 0;
+  for (size_t i = 0; i < COLS * ROWS; i++) {
+    int delta = abs((int) this->blocks[i] - (int) other.blocks[i]);
+    if (delta > largest)
+      largest = delta;
+  }
+  return (uint8_t) largest;
+}
+
+void compute_frame_signature(const FrameView &view, uint32_t sequence, FrameSignature &out) {
+  constexpr uint8_t COLS = FrameSignature::COLS;
+  constexpr uint8_t SAMPLES = FrameSignature::SAMPLES;
+  constexpr uint16_t SAMPLE_COLS = COLS * SAMPLES;
+  constexpr uint16_t SAMPLE_ROWS = FrameSignature::ROWS * SAMPLES;
+
+  out.sequence = view.valid() ? sequence : 0;
+  out.width = view.width;
+  out.height = view.height;
+  out.format = view.format;
+  if (!out.valid())
+    return;
+
+  // Toute la largeur est couverte ; RAW8 : coin haut-gauche d'un quad Bayer entier
+  const uint16_t align = view.format == PIXEL_FORMAT_RAW8 ? ~1 : 0xFFFF;
+  uint16_t sample_x[SAMPLE_COLS];
+  for (uint16_t i = 0; i < SAMPLE_COLS; i++) {
+    sample_x[i] = sample_position(0, view.width, i, SAMPLE_COLS) & align;
+  }
+
+  for (uint8_t by = 0; by < FrameSignature::ROWS; by++) {
+    uint16_t sums[COLS]{};
+    for (uint8_t s = 0; s < SAMPLES; s++) {
+      accumulate_row_luma(view, sample_position(0, view.height, by * SAMPLES + s, SAMPLE_ROWS), sample_x,
+                          SAMPLE_COLS, SAMPLES, sums);
+    }
+    for (uint8_t bx = 0; bx < COLS; bx++) {
+      out.blocks[by * COLS + bx] = (uint8_t) ((sums[bx] + SAMPLES * SAMPLES / 2) / (SAMPLES * SAMPLES));
+    }
+  }
+}
+
+void TileChangeTracker::set_tile_size(uint16_t tile_size) {
+  this->tile_size_ = tile_size < MIN_TILE_SIZE ? MIN_TILE_SIZE : tile_size;
+  // Géométrie refaite (et image entière) à la prochaine comparaison
+  this->width_ = 0;
+  this->height_ = 0;
+}
+
+void TileChangeTracker::layout_(const FrameView &view) {
+  this->width_ = view.width;
+  this->height_ = view.height;
+  this->format_ = view.format;
+  this->tile_cols_ = (view.width + this->tile_size_ - 1) / this->tile_size_;
+  this->tile_rows_ = (view.height + this->tile_size_ - 1) / this->tile_size_;
+  const size_t tiles = (size_t) this->tile_cols_ * this->tile_rows_;
+  this->current_.assign(tiles, 0);
+  this->displayed_.assign(tiles, 0);
+  this->changed_.assign(tiles, 0);
+
+  // La dernière tuile d'une ligne / colonne peut être plus petite
+  const uint16_t align = view.format == PIXEL_FORMAT_RAW8 ? ~1 : 0xFFFF;
+  this->sample_x_.resize((size_t) this->tile_cols_ * SAMPLES);
+  for (uint16_t tx = 0; tx < this->tile_cols_; tx++) {
+    uint16_t x0 = tx * this->tile_size_;
+    uint16_t w = std::min<uint16_t>(this->tile_size_, view.width - x0);
+    for (uint8_t s = 0; s < SAMPLES; s++) {
+      this->sample_x_[tx * SAMPLES + s] = sample_position(x0, w, s, SAMPLES) & align;
+    }
+  }
+}
+
+void TileChangeTracker::compare(const FrameView &view, uint8_t threshold, TileChanges &out) {
+  out = TileChanges{};
+  if (!view.valid()) {
+    return;
+  }
+  const bool relayout = view.width != this->width_ || view.height != this->height_ || view.format != this->format_;
+  if (relayout) {
+    this->layout_(view);
+  }
+
+  std::vector<uint16_t> &sums = this->sums_;
+  sums.assign(this->tile_cols_, 0);
+  for (uint16_t ty = 0; ty < this->tile_rows_; ty++) {
+    uint16_t y0 = ty * this->tile_size_;
+    uint16_t h = std::min<uint16_t>(this->tile_size_, view.height - y0);
+    std::fill(sums.begin(), sums.end(), 0);
+    for (uint8_t s = 0; s < SAMPLES; s++) {
+      accumulate_row_luma(view, sample_position(y0, h, s, SAMPLES), this->sample_x_.data(),
+                          this->sample_x_.size(), SAMPLES, sums.data());
+    }
+    uint8_t *row = &this->current_[(size_t) ty * this->tile_cols_];
+    for (uint16_t tx = 0; tx < this->tile_cols_; tx++) {
+      row[tx] = (uint8_t) ((sums[tx] + SAMPLES * SAMPLES / 2) / (SAMPLES * SAMPLES));
+    }
+  }
+  out.tile_count = this->current_.size();
+
+  // Première image, autre géométrie : tout est à redessiner
+  if (relayout || !this->has_displayed_) {
+    out.full = true;
+    out.changed_tiles = out.tile_count;
+    out.coverage = 1.0f;
+    this->commit_all_();
+    return;
+  }
+
+  for (size_t i = 0; i < this->current_.size(); i++) {
+    this->changed_[i] = abs((int) this->current_[i] - (int) this->displayed_[i]) > threshold;
+    out.changed_tiles += this->changed_[i];
+  }
+  if (out.changed_tiles == 0) {
+    return;
+  }
+  this->build_rects_(out);
+
+  uint32_t area = 0;
+  for (uint8_t i = 0; i < out.rect_count; i++) {
+    area += (uint32_t) out.rects[i].width * out.rects[i].height;
+  }
+  out.coverage = (float) area / ((uint32_t) view.width * view.height);
+  if (out.coverage > this->full_threshold_) {
+    out.full = true;
+    out.rect_count = 0;
+    this->commit_all_();
+    return;
+  }
+  // Seules les tuiles redessinées prennent le nouveau contenu : une dérive
+  // lente des autres finit par dépasser le seuil
+  for (uint8_t i = 0; i < out.rect_count; i++) {
+    const FrameRoi &rect = out.rects[i];
+    for (uint16_t ty = rect.y / this->tile_size_; ty * this->tile_size_ < rect.y + rect.height; ty++) {
+      size_t first = (size_t) ty * this->tile_cols_ + rect.x / this->tile_size_;
+      size_t count = (rect.width + this->tile_size_ - 1) / this->tile_size_;
+      memcpy(&this->displayed_[first], &this->current_[first], count);
+    }
+  }
+}
+
+void TileChangeTracker::commit_all_() {
+  this->displayed_ = this->current_;
+  this->has_displayed_ = true;
+}
+
+void TileChangeTracker::build_rects_(TileChanges &out) const {
+  // Suites horizontales de tuiles changées, prolongées vers le bas quand la
+  // ligne suivante a exactement la même suite
+  struct Span {
+    uint16_t x0, x1, y0, y1;  // tuiles, bornes incluses
+    uint32_t area() const { return (uint32_t) (this->x1 - this->x0 + 1) * (this->y1 - this->y0 + 1); }
+  };
+  constexpr uint8_t MAX_SPANS = 4 * TileChanges::MAX_RECTS;
+  Span spans[MAX_SPANS];
+  uint8_t count = 0;
+  bool overflow = false;
+  Span bounds{this->tile_cols_, 0, this->tile_rows_, 0};
+
+  for (uint16_t ty = 0; ty < this->tile_rows_; ty++) {
+    const uint8_t *row = &this->changed_[(size_t) ty * this->tile_cols_];
+    for (uint16_t tx = 0; tx < this->tile_cols_;) {
+      if (!row[tx]) {
+        tx++;
+        continue;
+      }
+      uint16_t start = tx;
+      while (tx < this->tile_cols_ && row[tx])
+        tx++;
+      uint16_t end = tx - 1;
+      bounds = {std::min(bounds.x0, start), std::max(bounds.x1, end), std::min(bounds.y0, ty), ty};
+      if (overflow)
+        continue;
+      bool merged = false;
+      for (uint8_t i = 0; i < count && !merged; i++) {
+        if (spans[i].y1 + 1 == ty && spans[i].x0 == start && spans[i].x1 == end) {
+          spans[i].y1 = ty;
+          merged = true;
+        }
+      }
+      if (merged)
+        continue;
+      if (count == MAX_SPANS) {
+        overflow = true;
+        continue;
+      }
+      spans[count++] = {start, end, ty, ty};
+    }
+  }
+
+  if (overflow) {
+    // Changements épars partout : leur enveloppe
+    spans[0] = bounds;
+    count = 1;
+  }
+  // Fusion des deux zones qui ajoutent le moins de surface, jusqu'à MAX_RECTS
+  while (count > TileChanges::MAX_RECTS) {
+    uint8_t best_a = 0, best_b = 1;
+    uint32_t best_cost = UINT32_MAX;
+    for (uint8_t a = 0; a < count; a++) {
+      for (uint8_t b = a + 1; b < count; b++) {
+        Span joined{std::min(spans[a].x0, spans[b].x0), std::max(spans[a].x1, spans[b].x1),
+                    std::min(spans[a].y0, spans[b].y0), std::max(spans[a].y1, spans[b].y1)};
+        uint32_t cost = joined.area() - std::min(joined.area(), spans[a].area() + spans[b].area());
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_a = a;
+          best_b = b;
+        }
+      }
+    }
+    Span &a = spans[best_a];
+    const Span &b = spans[best_b];
+    a = {std::min(a.x0, b.x0), std::max(a.x1, b.x1), std::min(a.y0, b.y0), std::max(a.y1, b.y1)};
+    spans[best_b] = spans[--count];
+  }
+
+  out.rect_count = count;
+  for (uint8_t i = 0; i < count; i++) {
+    uint16_t x = spans[i].x0 * this->tile_size_;
+    uint16_t y = spans[i].y0 * this->tile_size_;
+    uint16_t x_end = std::min<uint32_t>((uint32_t) (spans[i].x1 + 1) * this->tile_size_, this->width_);
+    uint16_t y_end = std::min<uint32_t>((uint32_t) (spans[i].y1 + 1) * this->tile_size_, this->height_);
+    out.rects[i] = {x, y, (uint16_t) (x_end - x), (uint16_t) (y_end - y)};
+  }
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
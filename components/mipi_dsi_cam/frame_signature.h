@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_view.h"
+
+// Repérer les frames inchangées (pas de réencodage ni de redessin) et les
+// tuiles changées d'une image déjà affichée.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Empreinte du contenu d'une frame : luminance moyenne d'une grille de
+// COLS x ROWS blocs, chacun moyenné sur SAMPLES x SAMPLES échantillons épars.
+// Deux frames d'une scène statique ne diffèrent que du bruit capteur : on les
+// compare avec une tolérance (distance) plutôt qu'avec un hash.
+struct FrameSignature {
+  static constexpr uint8_t COLS = 16;
+  static constexpr uint8_t ROWS = 12;
+  static constexpr uint8_t SAMPLES = 8;  // par côté de bloc
+
+  uint32_t sequence{0};  // frame d'origine, 0 = aucune
+  uint16_t width{0};
+  uint16_t height{0};
+  PixelFormat format{PIXEL_FORMAT_RGB565};
+  uint8_t blocks[COLS * ROWS]{};
+
+  bool valid() const { return this->sequence != 0; }
+  // Plus grand écart entre blocs en niveaux de luminance ; 255 si l'une est
+  // vide ou si les géométries diffèrent
+  uint8_t distance(const FrameSignature &other) const;
+  bool differs(const FrameSignature &other, uint8_t threshold) const { return this->distance(other) > threshold; }
+};
+
+// COLS * ROWS * SAMPLES^2 lectures de pixels, quelle que soit la taille
+void compute_frame_signature(const FrameView &view, uint32_t sequence, FrameSignature &out);
+
+// Zones d'une image changées depuis son dernier dessin (TileChangeTracker)
+struct TileChanges {
+  static constexpr uint8_t MAX_RECTS = 8;
+
+  bool full{false};  // tout redessiner (première image, autre géométrie, couverture)
+  uint8_t rect_count{0};
+  FrameRoi rects[MAX_RECTS]{};  // pixels de la vue, alignés sur les tuiles
+  uint32_t changed_tiles{0};
+  uint32_t tile_count{0};
+  float coverage{0.0f};  // part de la vue couverte par les rectangles
+};
+
+// Rectangles à redessiner pour un affichage qui ne redessine que ce qui a
+// changé : la vue est découpée en tuiles carrées, résumées chacune par la
+// luminance moyenne de SAMPLES x SAMPLES échantillons et comparées aux tuiles
+// du dernier dessin. Les tuiles changées sont fusionnées en MAX_RECTS
+// rectangles au plus (leur enveloppe au-delà) ; au-delà de `full_threshold`
+// de couverture, c'est l'image entière.
+class TileChangeTracker {
+ public:
+  static constexpr uint8_t SAMPLES = 4;  // par côté de tuile
+  static constexpr uint16_t MIN_TILE_SIZE = 8;
+
+  void set_tile_size(uint16_t tile_size);
+  uint16_t get_tile_size() const { return this->tile_size_; }
+  void set_full_threshold(float coverage) { this->full_threshold_ = coverage; }
+  float get_full_threshold() const { return this->full_threshold_; }
+
+  // L'appelant redessine ce que donne `out` : ces tuiles deviennent la
+  // référence du prochain appel. Une tuile a changé quand sa moyenne a bougé
+  // de plus de `threshold` niveaux.
+  void compare(const FrameView &view, uint8_t threshold, TileChanges &out);
+  // Le prochain compare() demande de tout redessiner
+  void reset() { this->has_displayed_ = false; }
+
+ protected:
+  void layout_(const FrameView &view);
+  void build_rects_(TileChanges &out) const;
+  void commit_all_();
+
+  uint16_t tile_size_{32};
+  float full_threshold_{0.5f};
+
+  uint16_t width_{0};
+  uint16_t height_{0};
+  PixelFormat format_{PIXEL_FORMAT_RGB565};
+  uint16_t tile_cols_{0};
+  uint16_t tile_rows_{0};
+  bool has_displayed_{false};
+  std::vector<uint16_t> sample_x_;
+  std::vector<uint16_t> sums_;
+  std::vector<uint8_t> current_;
+  std::vector<uint8_t> displayed_;  // tuiles telles que dessinées
+  std::vector<uint8_t> changed_;
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,174 @@
+#include "frame_stats.h"
+#include "pixel_convert.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Point de départ avant toute mesure d'adapt() : ~16k échantillons par frame
+static const uint32_t INITIAL_SAMPLES = 16384;
+
+static uint8_t min_step_for(uint16_t width) {
+  return (width + FrameStatsEngine::MAX_ROW_SAMPLES - 1) / FrameStatsEngine::MAX_ROW_SAMPLES;
+}
+
+void FrameStatsEngine::configure(uint16_t width, uint16_t height, uint8_t zone_cols, uint8_t zone_rows) {
+  this->width_ = width;
+  this->height_ = height;
+  this->zone_cols_ = zone_cols < 1 ? 1 : (zone_cols > FrameStats::MAX_ZONES ? FrameStats::MAX_ZONES : zone_cols);
+  this->zone_rows_ = zone_rows < 1 ? 1 : (zone_rows > FrameStats::MAX_ZONES ? FrameStats::MAX_ZONES : zone_rows);
+
+  uint32_t pixels = (uint32_t) width * height;
+  uint8_t step = 1;
+  while (step < MAX_STEP && pixels / ((uint32_t) step * step) > INITIAL_SAMPLES)
+    step++;
+  if (step < min_step_for(width))
+    step = min_step_for(width);
+  this->step_ = step;
+  this->layout_();
+}
+
+void FrameStatsEngine::layout_() {
+  // La colonne i échantillonnée tombe dans la zone (i * step * cols / width) :
+  // on garde le début de chaque zone, la boucle interne ne divise jamais
+  uint32_t span = (uint32_t) this->zone_cols_ * this->step_;
+  for (uint8_t zc = 0; zc <= this->zone_cols_; zc++) {
+    this->zone_x_start_[zc] = ((uint32_t) zc * this->width_ + span - 1) / span;
+  }
+}
+
+void FrameStatsEngine::adapt(uint32_t elapsed_us) {
+  uint8_t step = this->step_;
+  if (elapsed_us > this->budget_us_ && step < MAX_STEP) {
+    step++;
+  } else if (elapsed_us < this->budget_us_ / 2 && step > min_step_for(this->width_)) {
+    step--;
+  }
+  if (step != this->step_) {
+    this->step_ = step;
+    this->layout_();
+  }
+}
+
+bool FrameStatsEngine::compute(const FrameView &view, uint32_t sequence, FrameStats &out) {
+  // Layout faite pour une autre taille : ne rien lire hors de la vue
+  const uint16_t h = view.width == this->width_ && view.height == this->height_ ? this->height_ : 0;
+  const uint8_t step = this->step_;
+  const uint8_t cols = this->zone_cols_;
+  const uint8_t rows = this->zone_rows_;
+  const uint16_t row_samples = this->zone_x_start_[cols];
+
+  if (h == 0)
+    return false;
+
+  uint32_t *histogram = this->histogram_;
+  uint32_t *zone_sum = this->zone_sum_;
+  uint32_t *zone_count = this->zone_count_;
+  uint8_t *luma_row = this->luma_row_;
+  // YUV422 / RAW8 : échantillons d'abord ramenés en RGB565, par paquets
+  uint16_t *sample_chunk = this->sample_chunk_;
+  memset(histogram, 0, sizeof(this->histogram_));
+  memset(zone_sum, 0, sizeof(uint32_t) * cols * rows);
+  memset(zone_count, 0, sizeof(uint32_t) * cols * rows);
+  const bool rgb565 = view.format == PIXEL_FORMAT_RGB565;
+  uint32_t sum_r = 0, sum_g = 0, sum_b = 0;
+  uint32_t bright_r = 0, bright_g = 0, bright_b = 0, bright_n = 0;
+  uint32_t samples = 0;
+
+  for (uint32_t y = 0; y < h; y += step) {
+    const uint16_t *row = (const uint16_t *) view.row(y);
+
+    // 1) luminance + sommes par canal, sans branchement
+    uint32_t row_r = 0, row_g = 0, row_b = 0;
+    uint32_t row_br = 0, row_bg = 0, row_bb = 0, row_bn = 0;
+    for (uint16_t first = 0; first < row_samples; first += SAMPLE_CHUNK) {
+      const uint16_t count = row_samples - first < SAMPLE_CHUNK ? row_samples - first : SAMPLE_CHUNK;
+      const uint16_t *src = row + (uint32_t) first * step;
+      uint8_t pitch = step;
+      if (!rgb565) {
+        sample_row_rgb565(view, y, step, first, count, sample_chunk);
+        src = sample_chunk;
+        pitch = 1;
+      }
+      for (uint16_t i = 0; i < count; i++) {
+        uint32_t p = src[i * pitch];
+        uint32_t r = p >> 11;
+        uint32_t g = (p >> 5) & 0x3F;
+        uint32_t b = p & 0x1F;
+        uint32_t luma = luma565(r, g, b);
+        uint32_t bright = (luma >= FrameStats::BRIGHT_LEVEL) & (luma < FrameStats::CLIP_LEVEL);
+        row_r += r;
+        row_g += g;
+        row_b += b;
+        row_br += r * bright;
+        row_bg += g * bright;
+        row_bb += b * bright;
+        row_bn += bright;
+        luma_row[first + i] = luma;
+      }
+    }
+    sum_r += row_r;
+    sum_g += row_g;
+    sum_b += row_b;
+    bright_r += row_br;
+    bright_g += row_bg;
+    bright_b += row_bb;
+    bright_n += row_bn;
+
+    // 2) histogramme + zones
+    uint32_t *zsum = &zone_sum[(y * rows / h) * cols];
+    uint32_t *zcount = &zone_count[(y * rows / h) * cols];
+    for (uint8_t zc = 0; zc < cols; zc++) {
+      uint32_t acc = 0;
+      for (uint16_t i = this->zone_x_start_[zc]; i < this->zone_x_start_[zc + 1]; i++) {
+        acc += luma_row[i];
+        histogram[luma_row[i]]++;
+      }
+      zsum[zc] += acc;
+      zcount[zc] += this->zone_x_start_[zc + 1] - this->zone_x_start_[zc];
+    }
+    samples += row_samples;
+  }
+
+  if (samples == 0)
+    return false;
+  out.sequence = sequence;
+  out.sample_count = samples;
+  out.sample_step = step;
+  out.zone_cols = cols;
+  out.zone_rows = rows;
+
+  uint64_t luma_total = 0;
+  uint32_t clipped = 0, crushed = 0;
+  for (uint16_t v = 0; v < 256; v++) {
+    out.histogram[v] = histogram[v];
+    luma_total += (uint64_t) v * histogram[v];
+    if (v >= FrameStats::CLIP_LEVEL)
+      clipped += histogram[v];
+    if (v <= FrameStats::CRUSH_LEVEL)
+      crushed += histogram[v];
+  }
+  out.mean_luma = luma_total / samples;
+  out.clipped_percent = clipped * 100.0f / samples;
+  out.crushed_percent = crushed * 100.0f / samples;
+  out.mean_r = (uint64_t) sum_r * 255 / (31u * samples);
+  out.mean_g = (uint64_t) sum_g * 255 / (63u * samples);
+  out.mean_b = (uint64_t) sum_b * 255 / (31u * samples);
+  out.bright_count = bright_n;
+  if (bright_n != 0) {
+    out.bright_r = (uint64_t) bright_r * 255 / (31u * bright_n);
+    out.bright_g = (uint64_t) bright_g * 255 / (63u * bright_n);
+    out.bright_b = (uint64_t) bright_b * 255 / (31u * bright_n);
+  } else {
+    out.bright_r = out.bright_g = out.bright_b = 0;
+  }
+
+  for (uint16_t z = 0; z < (uint16_t) cols * rows; z++) {
+    out.zone_mean[z] = zone_count[z] != 0 ? zone_sum[z] / zone_count[z] : 0;
+  }
+  return true;
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
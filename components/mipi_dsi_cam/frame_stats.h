@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_view.h"
+
+// Stats partagées par AE, AWB, OSD et automations : une seule passe par frame.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Statistiques de luminance d'une frame (MipiDsiCam::get_frame_stats()).
+struct FrameStats {
+  static constexpr uint8_t MAX_ZONES = 16;  // par axe
+  static constexpr uint8_t CLIP_LEVEL = 250;
+  static constexpr uint8_t CRUSH_LEVEL = 5;
+  static constexpr uint8_t BRIGHT_LEVEL = 200;
+
+  uint32_t sequence{0};  // frame d'origine, 0 = pas encore
+  uint32_t sample_count{0};
+  uint32_t histogram[256]{};
+
+  uint8_t mean_luma{0};
+  // Moyennes par canal, échelle 0-255
+  uint8_t mean_r{0};
+  uint8_t mean_g{0};
+  uint8_t mean_b{0};
+  // Moyennes par canal des échantillons clairs non saturés (BRIGHT_LEVEL <= luma < CLIP_LEVEL)
+  uint32_t bright_count{0};
+  uint8_t bright_r{0};
+  uint8_t bright_g{0};
+  uint8_t bright_b{0};
+  float clipped_percent{0.0f};  // luma >= CLIP_LEVEL
+  float crushed_percent{0.0f};  // luma <= CRUSH_LEVEL
+
+  // Grille ligne par ligne : zone_cols x zone_rows entrées valides dans zone_mean
+  uint8_t zone_cols{0};
+  uint8_t zone_rows{0};
+  uint8_t zone_mean[MAX_ZONES * MAX_ZONES]{};
+
+  uint8_t sample_step{1};  // pas d'échantillonnage sur les deux axes
+  uint32_t compute_us{0};
+
+  uint8_t zone(uint8_t col, uint8_t row) const { return this->zone_mean[row * this->zone_cols + col]; }
+};
+
+// Une seule passe sous-échantillonnée : histogramme, moyennes par zone et par
+// canal, saturation. Entiers uniquement ; la boucle interne parcourt une ligne
+// d'une zone à pas fixe, que le compilateur peut dérouler. Le pas s'adapte
+// pour tenir un budget CPU par frame.
+class FrameStatsEngine {
+ public:
+  static constexpr uint8_t MAX_STEP = 32;
+  // Échantillons par ligne du buffer de luminance
+  static constexpr uint16_t MAX_ROW_SAMPLES = 2048;
+  // Échantillons non RGB565 convertis par paquet
+  static constexpr uint16_t SAMPLE_CHUNK = 128;
+
+  void configure(uint16_t width, uint16_t height, uint8_t zone_cols, uint8_t zone_rows);
+  void set_budget_us(uint32_t budget_us) { this->budget_us_ = budget_us; }
+  uint32_t get_budget_us() const { return this->budget_us_; }
+
+  // Vue de la taille de configure() ; le stride permet une découpe (ROI)
+  // sans copie. YUV422 / RAW8 convertis à la volée (pixel_convert.h).
+  // false, `out` inchangé : rien d'échantillonné (vue d'une autre taille).
+  bool compute(const FrameView &view, uint32_t sequence, FrameStats &out);
+  // Durée mesurée du dernier compute(), pour ajuster le pas.
+  void adapt(uint32_t elapsed_us);
+
+  uint8_t get_step() const { return this->step_; }
+  uint16_t get_width() const { return this->width_; }
+  uint16_t get_height() const { return this->height_; }
+
+ protected:
+  void layout_();
+
+  uint16_t width_{0};
+  uint16_t height_{0};
+  uint8_t zone_cols_{8};
+  uint8_t zone_rows_{8};
+  uint8_t step_{8};
+  uint32_t budget_us_{300};
+
+  // Premier échantillon de chaque colonne de zones (+ sentinelle de fin)
+  uint16_t zone_x_start_[FrameStats::MAX_ZONES + 1]{};
+
+  // Buffers de travail de compute(), ~5 Ko : hors de la pile de la tâche loop
+  uint32_t histogram_[256];
+  uint32_t zone_sum_[FrameStats::MAX_ZONES * FrameStats::MAX_ZONES];
+  uint32_t zone_count_[FrameStats::MAX_ZONES * FrameStats::MAX_ZONES];
+  uint8_t luma_row_[MAX_ROW_SAMPLES];
+  uint16_t sample_chunk_[SAMPLE_CHUNK];
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
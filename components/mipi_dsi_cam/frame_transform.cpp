@@ -0,0 +1,253 @@
+#include "frame_transform.h"
+#include "pixel_convert.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+const char *rotation_name(FrameRotation rotation) {
+  switch (rotation) {
+    case ROTATION_90:
+      return "90°";
+    case ROTATION_180:
+      return "180°";
+    case ROTATION_270:
+      return "270°";
+    default:
+      return "0°";
+  }
+}
+
+// Coordonnées source du pixel de sortie (x, y), affines :
+// sx = x0 + x * xdx + y * xdy, sy = y0 + x * ydx + y * ydy
+struct Walk {
+  int32_t x0, xdx, xdy;
+  int32_t y0, ydx, ydy;
+};
+
+static void output_size(const FrameView &src, const FrameTransform &transform, uint16_t &width, uint16_t &height) {
+  width = transform.swaps_axes() ? src.height : src.width;
+  height = transform.swaps_axes() ? src.width : src.height;
+  if (src.format == PIXEL_FORMAT_YUV422) {
+    width &= ~1;
+  }
+}
+
+static Walk make_walk(const FrameView &src, uint16_t width, uint16_t height, const FrameTransform &transform) {
+  auto source = [&](int32_t x, int32_t y, int32_t &sx, int32_t &sy) {
+    // Miroir défait d'abord (appliqué en dernier), puis la rotation
+    int32_t ux = transform.mirror_x ? width - 1 - x : x;
+    int32_t uy = transform.mirror_y ? height - 1 - y : y;
+    switch (transform.rotation) {
+      case ROTATION_90:
+        sx = uy;
+        sy = src.height - 1 - ux;
+        break;
+      case ROTATION_180:
+        sx = src.width - 1 - ux;
+        sy = src.height - 1 - uy;
+        break;
+      case ROTATION_270:
+        sx = src.width - 1 - uy;
+        sy = ux;
+        break;
+      default:
+        sx = ux;
+        sy = uy;
+        break;
+    }
+  };
+  Walk walk;
+  int32_t sx, sy;
+  source(0, 0, walk.x0, walk.y0);
+  source(1, 0, sx, sy);
+  walk.xdx = sx - walk.x0;
+  walk.ydx = sy - walk.y0;
+  source(0, 1, sx, sy);
+  walk.xdy = sx - walk.x0;
+  walk.ydy = sy - walk.y0;
+  return walk;
+}
+
+FrameView transformed_view(const FrameView &src, const FrameTransform &transform, uint8_t *data) {
+  uint16_t width, height;
+  output_size(src, transform, width, height);
+  FrameView view = FrameView::packed(data, width, height, src.format);
+  if (src.format == PIXEL_FORMAT_RAW8) {
+    // Le site bleu de la mosaïque suit les pixels
+    Walk walk = make_walk(src, width, height, transform);
+    uint8_t blue = bayer_blue_site(src.bayer_pattern);
+    for (uint8_t site = 0; site < 4; site++) {
+      int32_t x = site & 1, y = site >> 1;
+      int32_t sx = walk.x0 + x * walk.xdx + y * walk.xdy;
+      int32_t sy = walk.y0 + x * walk.ydx + y * walk.ydy;
+      if ((sx & 1) == (blue & 1) && (sy & 1) == (blue >> 1)) {
+        view.bayer_pattern = site;
+      }
+    }
+  }
+  return view;
+}
+
+// Ligne de sortie y, colonnes tx..tx+count-1 : une colonne source descendue
+template<typename T>
+static void transform_span(const uint8_t *base, ptrdiff_t step_x, ptrdiff_t step_y, const FrameView &dst,
+                           uint16_t y, uint16_t tx, uint16_t count) {
+  const uint8_t *s = base + y * step_y + tx * step_x;
+  T *d = (T *) dst.row(y) + tx;
+  for (uint16_t x = 0; x < count; x++) {
+    d[x] = *(const T *) s;
+    s += step_x;
+  }
+}
+
+// Quart de tour RGB565, 2x2 pixels par itération : les pixels source des
+// lignes de sortie y et y + 1 sont voisins (step_y = ±2 octets), un mot de
+// 32 bits les lit ensemble et chaque ligne de sortie reçoit un mot. Moitié
+// moins d'accès mémoire que pixel par pixel.
+template<bool FORWARD>
+static void transpose_pair_565(const uint8_t *base, ptrdiff_t step_x, ptrdiff_t step_y, const FrameView &dst,
+                               uint16_t y, uint16_t tx, uint16_t count) {
+  const uint8_t *s = base + y * step_y + tx * step_x - (FORWARD ? 0 : 2);
+  uint8_t *d0 = dst.row(y) + tx * 2;
+  uint8_t *d1 = dst.row(y + 1) + tx * 2;
+  for (uint16_t x = 0; x + 1 < count; x += 2) {
+    uint32_t a, b;
+    memcpy(&a, __builtin_assume_aligned(s, 4), 4);
+    memcpy(&b, __builtin_assume_aligned(s + step_x, 4), 4);
+    s += 2 * step_x;
+    if (!FORWARD) {
+      // Pixel de la ligne y en poids faible
+      a = (a >> 16) | (a << 16);
+      b = (b >> 16) | (b << 16);
+    }
+    uint32_t w0 = (a & 0xFFFF) | (b << 16);
+    uint32_t w1 = (a >> 16) | (b & 0xFFFF0000);
+    memcpy(__builtin_assume_aligned(d0, 4), &w0, 4);
+    memcpy(__builtin_assume_aligned(d1, 4), &w1, 4);
+    d0 += 4;
+    d1 += 4;
+  }
+  if (count & 1) {
+    transform_span<uint16_t>(base, step_x, step_y, dst, y, tx + count - 1, 1);
+    transform_span<uint16_t>(base, step_x, step_y, dst, y + 1, tx + count - 1, 1);
+  }
+}
+
+// RGB565 / RAW8 : la source est parcourue par pointeur, step_x et step_y
+// octets par pixel et par ligne de sortie (négatifs pour un miroir)
+template<typename T>
+static void transform_pixels(const uint8_t *base, ptrdiff_t step_x, ptrdiff_t step_y, const FrameView &dst,
+                             bool tiled) {
+  if (!tiled) {
+    // Lignes source lues dans un sens ou dans l'autre : déjà séquentiel
+    for (uint16_t y = 0; y < dst.height; y++) {
+      const T *__restrict s = (const T *) (base + y * step_y);
+      T *__restrict d = (T *) dst.row(y);
+      if (step_x > 0) {
+        memcpy(d, s, dst.row_bytes());
+      } else {
+        for (uint16_t x = 0; x < dst.width; x++)
+          d[x] = *(s - x);
+      }
+    }
+    return;
+  }
+  // Mots de 32 bits alignés des deux côtés : noyau 2x2 (RGB565 seulement)
+  bool pairs = sizeof(T) == 2 && step_x % 4 == 0 && dst.stride % 4 == 0 && (uintptr_t) dst.data % 4 == 0 &&
+               (uintptr_t) (base - (step_y < 0 ? 2 : 0)) % 4 == 0;
+  // Quart de tour : une ligne de sortie descend une colonne source. Par
+  // bloc, les TRANSFORM_TILE lignes source touchées restent en cache et la
+  // colonne suivante les relit au lieu de recharger une ligne par pixel.
+  for (uint16_t ty = 0; ty < dst.height; ty += TRANSFORM_TILE) {
+    uint16_t y_end = std::min<uint32_t>(ty + TRANSFORM_TILE, dst.height);
+    for (uint16_t tx = 0; tx < dst.width; tx += TRANSFORM_TILE) {
+      uint16_t count = std::min<uint32_t>(TRANSFORM_TILE, dst.width - tx);
+      uint16_t y = ty;
+      if (pairs) {
+        for (; y + 1 < y_end; y += 2) {
+          if (step_y > 0) {
+            transpose_pair_565<true>(base, step_x, step_y, dst, y, tx, count);
+          } else {
+            transpose_pair_565<false>(base, step_x, step_y, dst, y, tx, count);
+          }
+        }
+      }
+      for (; y < y_end; y++) {
+        transform_span<T>(base, step_x, step_y, dst, y, tx, count);
+      }
+    }
+  }
+}
+
+// YUV422 : Y0 U Y1 V. Chaque paire de sortie prend la luma de ses deux
+// pixels source et la moyenne de leurs chromas (la même s'ils viennent de la
+// même paire, sans quart de tour).
+static void transform_yuv422_pairs(const FrameView &src, const Walk &walk, uint16_t y, uint16_t x_begin,
+                                   uint16_t x_end, uint8_t *d) {
+  int32_t sx = walk.x0 + x_begin * walk.xdx + y * walk.xdy;
+  int32_t sy = walk.y0 + x_begin * walk.ydx + y * walk.ydy;
+  for (uint16_t x = x_begin; x < x_end; x += 2, d += 4) {
+    int32_t sx1 = sx + walk.xdx, sy1 = sy + walk.ydx;
+    const uint8_t *p0 = src.row(sy) + (sx & ~1) * 2;
+    const uint8_t *p1 = src.row(sy1) + (sx1 & ~1) * 2;
+    d[0] = p0[(sx & 1) * 2];
+    d[1] = (p0[1] + p1[1] + 1) >> 1;
+    d[2] = p1[(sx1 & 1) * 2];
+    d[3] = (p0[3] + p1[3] + 1) >> 1;
+    sx += 2 * walk.xdx;
+    sy += 2 * walk.ydx;
+  }
+}
+
+static void transform_yuv422(const FrameView &src, const FrameView &dst, const Walk &walk, bool tiled) {
+  if (!tiled) {
+    for (uint16_t y = 0; y < dst.height; y++) {
+      if (walk.xdx > 0) {
+        memcpy(dst.row(y), src.row(walk.y0 + y * walk.ydy), dst.row_bytes());
+      } else {
+        transform_yuv422_pairs(src, walk, y, 0, dst.width, dst.row(y));
+      }
+    }
+    return;
+  }
+  for (uint16_t ty = 0; ty < dst.height; ty += TRANSFORM_TILE) {
+    uint16_t y_end = std::min<uint32_t>(ty + TRANSFORM_TILE, dst.height);
+    for (uint16_t tx = 0; tx < dst.width; tx += TRANSFORM_TILE) {
+      uint16_t x_end = std::min<uint32_t>(tx + TRANSFORM_TILE, dst.width);
+      for (uint16_t y = ty; y < y_end; y++) {
+        transform_yuv422_pairs(src, walk, y, tx, x_end, dst.row(y) + tx * 2);
+      }
+    }
+  }
+}
+
+bool transform_frame(const FrameView &src, const FrameView &dst, const FrameTransform &transform) {
+  uint16_t width, height;
+  output_size(src, transform, width, height);
+  if (!src.valid() || !dst.valid() || dst.format != src.format || dst.width != width || dst.height != height) {
+    return false;
+  }
+  Walk walk = make_walk(src, width, height, transform);
+  bool tiled = transform.swaps_axes();
+  if (src.format == PIXEL_FORMAT_YUV422) {
+    transform_yuv422(src, dst, walk, tiled);
+    return true;
+  }
+  ptrdiff_t bpp = bytes_per_pixel(src.format);
+  ptrdiff_t stride = src.stride;
+  const uint8_t *base = src.data + walk.y0 * stride + walk.x0 * bpp;
+  ptrdiff_t step_x = walk.ydx * stride + walk.xdx * bpp;
+  ptrdiff_t step_y = walk.ydy * stride + walk.xdy * bpp;
+  if (bpp == 1) {
+    transform_pixels<uint8_t>(base, step_x, step_y, dst, tiled);
+  } else {
+    transform_pixels<uint16_t>(base, step_x, step_y, dst, tiled);
+  }
+  return true;
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_view.h"
+
+// Rotation / miroir logiciels pour un écran monté autrement que le capteur ;
+// le PPA (ppa_scaler.h) le fait dans la même passe qu'un redimensionnement.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+enum FrameRotation : uint8_t {
+  ROTATION_0 = 0,
+  ROTATION_90,  // sens horaire
+  ROTATION_180,
+  ROTATION_270,
+};
+
+const char *rotation_name(FrameRotation rotation);
+
+// Rotation (sens horaire) puis miroir de l'image tournée : couvre toutes les
+// façons de monter un écran par rapport au capteur.
+struct FrameTransform {
+  FrameRotation rotation{ROTATION_0};
+  bool mirror_x{false};  // gauche <-> droite
+  bool mirror_y{false};  // haut <-> bas
+
+  bool is_identity() const { return this->rotation == ROTATION_0 && !this->mirror_x && !this->mirror_y; }
+  // Quart de tour : largeur et hauteur échangées
+  bool swaps_axes() const { return this->rotation == ROTATION_90 || this->rotation == ROTATION_270; }
+};
+
+// Vue compacte sur `data` avec la taille, le format et l'ordre Bayer de `src`
+// transformée. Le YUV422 garde des paires Y0UY1V entières : après un quart de
+// tour, une hauteur source impaire perd sa première ligne.
+FrameView transformed_view(const FrameView &src, const FrameTransform &transform, uint8_t *data);
+
+// Écrit `src` transformée dans `dst` (issue de transformed_view(), ou toute
+// vue de cette taille et de ce format, avec ou sans stride). Les quarts de
+// tour avancent par blocs TRANSFORM_TILE x TRANSFORM_TILE : les lignes source
+// d'un bloc restent en cache pendant la lecture de ses colonnes, et la PSRAM
+// est parcourue en rafales des deux côtés plutôt qu'une ligne de cache par
+// pixel. La chroma YUV422 de deux pixels qui deviennent voisins est moyennée.
+static constexpr uint16_t TRANSFORM_TILE = 32;
+bool transform_frame(const FrameView &src, const FrameView &dst, const FrameTransform &transform);
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
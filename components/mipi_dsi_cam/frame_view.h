@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Vues sur les buffers du pool : ROI et zoom numérique sans copie.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+enum PixelFormat {
+  PIXEL_FORMAT_RGB565 = 0,
+  PIXEL_FORMAT_YUV422 = 1,
+  PIXEL_FORMAT_RAW8 = 2,
+};
+
+inline uint8_t bytes_per_pixel(PixelFormat format) { return format == PIXEL_FORMAT_RAW8 ? 1 : 2; }
+inline const char *pixel_format_name(PixelFormat format) {
+  return format == PIXEL_FORMAT_YUV422 ? "YUV422" : (format == PIXEL_FORMAT_RAW8 ? "RAW8" : "RGB565");
+}
+
+// Rectangle en pixels. Largeur ou hauteur nulle : toute la frame.
+struct FrameRoi {
+  uint16_t x{0};
+  uint16_t y{0};
+  uint16_t width{0};
+  uint16_t height{0};
+
+  bool is_full() const { return this->width == 0 || this->height == 0; }
+
+  // 64 bits : tient dans un std::atomic, lu sans verrou par les consommateurs
+  uint64_t pack() const {
+    return (uint64_t) this->x | (uint64_t) this->y << 16 | (uint64_t) this->width << 32 |
+           (uint64_t) this->height << 48;
+  }
+  static FrameRoi unpack(uint64_t packed) {
+    return {(uint16_t) packed, (uint16_t) (packed >> 16), (uint16_t) (packed >> 32), (uint16_t) (packed >> 48)};
+  }
+};
+
+// Fenêtre sur un buffer de frame : `stride` octets entre deux débuts de ligne,
+// une découpe n'est qu'un autre pointeur et d'autres dimensions dans le même
+// buffer. Valable tant que la frame est tenue (FrameHandle).
+struct FrameView {
+  uint8_t *data{nullptr};
+  uint16_t width{0};
+  uint16_t height{0};
+  uint32_t stride{0};
+  PixelFormat format{PIXEL_FORMAT_RGB565};
+  uint8_t bayer_pattern{0};  // RAW8 : ordre de la mosaïque à l'origine de la vue
+
+  static FrameView packed(uint8_t *data, uint16_t width, uint16_t height, PixelFormat format,
+                          uint8_t bayer_pattern = 0) {
+    return {data, width, height, (uint32_t) width * bytes_per_pixel(format), format, bayer_pattern};
+  }
+
+  bool valid() const { return this->data != nullptr && this->width != 0 && this->height != 0; }
+  // Lignes contiguës : la vue se passe comme un seul buffer
+  bool is_packed() const { return this->stride == (uint32_t) this->width * bytes_per_pixel(this->format); }
+  size_t row_bytes() const { return (size_t) this->width * bytes_per_pixel(this->format); }
+  uint8_t *row(uint16_t y) const { return this->data + (size_t) y * this->stride; }
+
+  // Sous-fenêtre ramenée dans la vue. YUV422 garde des paires Y0UY1V entières
+  // (x et largeur pairs), RAW8 la phase Bayer (x et y pairs).
+  FrameView crop(const FrameRoi &roi) const {
+    if (roi.is_full() || !this->valid()) {
+      return *this;
+    }
+    uint16_t x = roi.x < this->width ? roi.x : this->width - 1;
+    uint16_t y = roi.y < this->height ? roi.y : this->height - 1;
+    uint16_t w = roi.width < this->width - x ? roi.width : this->width - x;
+    uint16_t h = roi.height < this->height - y ? roi.height : this->height - y;
+    if (this->format == PIXEL_FORMAT_YUV422) {
+      x &= ~1;
+      w = (w + 1) & ~1;
+      if (w > this->width - x)
+        w = (this->width - x) & ~1;
+    } else if (this->format == PIXEL_FORMAT_RAW8) {
+      w += x & 1;
+      h += y & 1;
+      x &= ~1;
+      y &= ~1;
+    }
+    FrameView view = *this;
+    view.data = this->row(y) + (size_t) x * bytes_per_pixel(this->format);
+    view.width = w;
+    view.height = h;
+    return view;
+  }
+};
+
+// Zoom numérique : fenêtre de 1/factor de la frame centrée sur (center_x,
+// center_y) (0..1), gardée dans la frame.
+inline FrameRoi zoom_window(uint16_t width, uint16_t height, float factor, float center_x, float center_y) {
+  if (factor <= 1.0f) {
+    return {};
+  }
+  uint16_t w = width / factor;
+  uint16_t h = height / factor;
+  w = w < 2 ? 2 : w & ~1;
+  h = h < 2 ? 2 : h & ~1;
+  float x = center_x * width - w / 2.0f;
+  float y = center_y * height - h / 2.0f;
+  x = x < 0 ? 0 : (x > width - w ? width - w : x);
+  y = y < 0 ? 0 : (y > height - h ? height - h : y);
+  return {(uint16_t) ((uint16_t) x & ~1), (uint16_t) y, w, h};
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -2,41 +2,41 @@
 #include "esphome/core/log.h"
 #include "esphome/core/application.h"
 
-#include "mipi_dsi_cam_drivers_generated.h"
+#include "mock_sensor_driver.h"
+#include "csi_capture_backend.h"
+#include "virtual_csi_backend.h"
 
-#ifdef USE_ESP32_VARIANT_ESP32P4
+#include <cstdio>
+#include <cstring>
+#include <new>
 
+#ifdef USE_ESP32
+#include "sensor_registers.h"
+#include "mipi_dsi_cam_drivers_generated.h"
 #include "driver/ledc.h"
+#include "esp_heap_caps.h"
+#endif
 
 namespace esphome {
 namespace mipi_dsi_cam {
 
 static const char *const TAG = "mipi_dsi_cam";
 
+// Durée depuis `since`, qui avance au maintenant (phases successives)
+static uint32_t elapsed_us(int64_t &since) {
+  int64_t now = capture_time_us();
+  uint32_t elapsed = now - since;
+  since = now;
+  return elapsed;
+}
+
 void MipiDsiCam::setup() {
   ESP_LOGI(TAG, "Init MIPI Camera");
   ESP_LOGI(TAG, "  Sensor type: %s", this->sensor_type_.c_str());
+  this->boot_start_us_ = capture_time_us();
+  int64_t phase = this->boot_start_us_;
   
-  if (this->reset_pin_ != nullptr) {
-    this->reset_pin_->setup();
-    this->reset_pin_->digital_write(false);
-    delay(10);
-    this->reset_pin_->digital_write(true);
-    delay(20);
-  }
-  
-  if (!this->create_sensor_driver_()) {
-    ESP_LOGE(TAG, "Driver creation failed");
-    this->mark_failed();
-    return;
-  }
-  
-  if (!this->init_sensor_()) {
-    ESP_LOGE(TAG, "Sensor init failed");
-    this->mark_failed();
-    return;
-  }
-  
+  // XCLK d'abord : sans horloge le capteur ne répond pas sur I2C
   if (this->has_external_clock()) {
     if (!this->init_external_clock_()) {
       ESP_LOGE(TAG, "External clock init failed");
@@ -46,39 +46,72 @@ void MipiDsiCam::setup() {
   } else {
     ESP_LOGI(TAG, "No external clock configured - sensor must use internal clock");
   }
+  this->boot_timing_.clock_us = elapsed_us(phase);
   
-  if (!this->init_ldo_()) {
-    ESP_LOGE(TAG, "LDO init failed");
+  if (!this->create_sensor_driver_()) {
+    ESP_LOGE(TAG, "Driver creation failed");
     this->mark_failed();
     return;
   }
   
-  if (!this->init_csi_()) {
-    ESP_LOGE(TAG, "CSI init failed");
+  if (!this->power_up_sensor_()) {
+    ESP_LOGE(TAG, "Sensor not detected");
     this->mark_failed();
     return;
   }
+  this->boot_timing_.power_up_us = elapsed_us(phase);
   
-  if (!this->init_isp_()) {
-    ESP_LOGE(TAG, "ISP init failed");
-    this->mark_failed();
-    return;
-  }
+  // Tables d'init (I2C) en tâche de fond pendant que LDO/CSI/ISP et buffers se préparent
+  this->start_sensor_init_();
+  
+  this->configure_auto_exposure_();
   
-  if (!this->allocate_buffer_()) {
+  bool ok = this->init_backend_();
+  this->boot_timing_.backend_us = elapsed_us(phase);
+  if (!ok) {
+    ESP_LOGE(TAG, "Capture backend init failed");
+  } else if (!(ok = this->allocate_buffer_())) {
     ESP_LOGE(TAG, "Buffer alloc failed");
+  } else {
+    this->stats_engine_.configure(this->width_, this->height_, this->stats_zone_cols_, this->stats_zone_rows_);
+    if (this->pixel_format_ != PIXEL_FORMAT_RGB565 &&
+        (this->white_balance_.is_active() || !this->tone_params_.is_identity())) {
+      ESP_LOGW(TAG, "Software AWB / tone need RGB565 frames, ignored in %s", pixel_format_name(this->pixel_format_));
+    }
+    if (this->is_tone_mapping_() && !(ok = this->init_tone_mapper_())) {
+      ESP_LOGE(TAG, "Tone mapper init failed");
+    }
+  }
+  this->boot_timing_.buffers_us = elapsed_us(phase);
+  
+  // La tâche d'init utilise `this` : toujours l'attendre, même en cas d'échec
+  bool sensor_ok = this->finish_sensor_init_();
+  this->boot_timing_.sensor_wait_us = elapsed_us(phase);
+  if (!sensor_ok) {
+    ESP_LOGE(TAG, "Sensor init failed");
+    ok = false;
+  }
+  if (!ok) {
     this->mark_failed();
     return;
   }
   
+  this->boot_timing_.setup_us = capture_time_us() - this->boot_start_us_;
   this->initialized_ = true;
-  ESP_LOGI(TAG, "Camera ready (%ux%u) with Auto Exposure", this->width_, this->height_);
+  ESP_LOGI(TAG, "Camera ready (%ux%u) with Auto Exposure in %.1f ms", this->width_, this->height_,
+           this->boot_timing_.setup_us / 1000.0f);
 }
 
 bool MipiDsiCam::create_sensor_driver_() {
   ESP_LOGI(TAG, "Creating driver for: %s", this->sensor_type_.c_str());
   
-  this->sensor_driver_ = create_sensor_driver(this->sensor_type_, this);
+  if (this->sensor_type_ == "mock") {
+    this->sensor_driver_ = new MockSensorDriver(this->width_, this->height_, this->framerate_);
+  } else {
+#ifdef USE_ESP32
+    this->sensor_driver_ = create_sensor_driver(this->sensor_type_, this);
+#endif
+  }
   
   if (this->sensor_driver_ == nullptr) {
     ESP_LOGE(TAG, "Unknown or unavailable sensor: %s", this->sensor_type_.c_str());
@@ -89,24 +122,28 @@ bool MipiDsiCam::create_sensor_driver_() {
   return true;
 }
 
-bool MipiDsiCam::init_sensor_() {
-  if (!this->sensor_driver_) {
-    ESP_LOGE(TAG, "No sensor driver");
-    return false;
+bool MipiDsiCam::power_up_sensor_() {
+  if (this->reset_pin_ != nullptr) {
+    this->reset_pin_->setup();
+    this->reset_pin_->digital_write(false);
+    // Impulsion de reset : 1 ms couvre les capteurs supportés
+    delay(1);
+    this->reset_pin_->digital_write(true);
   }
   
-  ESP_LOGI(TAG, "Init sensor: %s", this->sensor_driver_->get_name());
-  
-  this->width_ = this->sensor_driver_->get_width();
-  this->height_ = this->sensor_driver_->get_height();
-  this->lane_count_ = this->sensor_driver_->get_lane_count();
-  this->bayer_pattern_ = this->sensor_driver_->get_bayer_pattern();
-  this->lane_bitrate_mbps_ = this->sensor_driver_->get_lane_bitrate_mbps();
-  
-  ESP_LOGI(TAG, "  Resolution: %ux%u", this->width_, this->height_);
-  ESP_LOGI(TAG, "  Lanes: %u", this->lane_count_);
-  ESP_LOGI(TAG, "  Bayer: %u", this->bayer_pattern_);
-  ESP_LOGI(TAG, "  Bitrate: %u Mbps", this->lane_bitrate_mbps_);
+  // Le capteur répond dès que son SCCB est prêt : sondé, le délai déclaré n'est qu'une borne
+  uint16_t waited_ms = 0;
+#ifdef USE_ESP32
+  uint16_t power_up_ms = this->sensor_driver_->get_power_up_ms();
+  while (power_up_ms != 0 && this->write(nullptr, 0) != i2c::ERROR_OK) {
+    if (waited_ms >= power_up_ms) {
+      ESP_LOGE(TAG, "No I2C answer after %u ms", waited_ms);
+      return false;
+    }
+    delay(1);
+    waited_ms++;
+  }
+#endif
   
   uint16_t pid = 0;
   esp_err_t ret = this->sensor_driver_->read_id(&pid);
@@ -121,23 +158,83 @@ bool MipiDsiCam::init_sensor_() {
     return false;
   }
   
-  ESP_LOGI(TAG, "Sensor ID: 0x%04X", pid);
+  ESP_LOGI(TAG, "Sensor ID: 0x%04X (answered after %u ms)", pid, waited_ms);
+  
+  this->read_sensor_mode_();
   
-  ret = this->sensor_driver_->init();
+  ESP_LOGI(TAG, "  Resolution: %ux%u", this->width_, this->height_);
+  ESP_LOGI(TAG, "  Lanes: %u", this->lane_count_);
+  ESP_LOGI(TAG, "  Bayer: %u", this->bayer_pattern_);
+  ESP_LOGI(TAG, "  Bitrate: %u Mbps", this->lane_bitrate_mbps_);
+  return true;
+}
+
+bool MipiDsiCam::init_sensor_() {
+  ESP_LOGI(TAG, "Init sensor: %s", this->sensor_driver_->get_name());
+  
+  int64_t start = capture_time_us();
+  esp_err_t ret = this->sensor_driver_->init();
+  this->boot_timing_.sensor_init_us = elapsed_us(start);
   if (ret != ESP_OK) {
     ESP_LOGE(TAG, "Sensor init failed: %d", ret);
     return false;
   }
   
+  // Pas d'attente de stabilisation : le capteur reste en standby jusqu'à
+  // start_stream(), sa première frame dit quand il est prêt
   ESP_LOGI(TAG, "Sensor initialized");
-  
-  delay(200);
-  ESP_LOGI(TAG, "Sensor stabilized");
-  
   return true;
 }
 
+void MipiDsiCam::start_sensor_init_() {
+#ifdef USE_ESP32
+  this->sensor_init_done_ = xSemaphoreCreateBinary();
+  if (this->sensor_init_done_ != nullptr &&
+      xTaskCreate(MipiDsiCam::sensor_init_task_, "cam_init", 4096, this, uxTaskPriorityGet(nullptr), nullptr) == pdPASS) {
+    return;
+  }
+  ESP_LOGW(TAG, "Sensor init task failed, initializing sequentially");
+  if (this->sensor_init_done_ != nullptr) {
+    vSemaphoreDelete(this->sensor_init_done_);
+    this->sensor_init_done_ = nullptr;
+  }
+#endif
+  this->sensor_init_ok_ = this->init_sensor_();
+}
+
+bool MipiDsiCam::finish_sensor_init_() {
+#ifdef USE_ESP32
+  if (this->sensor_init_done_ != nullptr) {
+    xSemaphoreTake(this->sensor_init_done_, portMAX_DELAY);
+    vSemaphoreDelete(this->sensor_init_done_);
+    this->sensor_init_done_ = nullptr;
+  }
+#endif
+  return this->sensor_init_ok_;
+}
+
+#ifdef USE_ESP32
+void MipiDsiCam::sensor_init_task_(void *arg) {
+  MipiDsiCam *cam = (MipiDsiCam*)arg;
+  cam->sensor_init_ok_ = cam->init_sensor_();
+  xSemaphoreGive(cam->sensor_init_done_);
+  vTaskDelete(nullptr);
+}
+#endif
+
+void MipiDsiCam::read_sensor_mode_() {
+  this->width_ = this->sensor_driver_->get_width();
+  this->height_ = this->sensor_driver_->get_height();
+  this->lane_count_ = this->sensor_driver_->get_lane_count();
+  this->bayer_pattern_ = this->sensor_driver_->get_bayer_pattern();
+  this->lane_bitrate_mbps_ = this->sensor_driver_->get_lane_bitrate_mbps();
+}
+
 bool MipiDsiCam::init_external_clock_() {
+#ifndef USE_ESP32
+  ESP_LOGW(TAG, "External clock ignored on this platform");
+  return true;
+#else
   ESP_LOGI(TAG, "Init external clock on GPIO%d @ %u Hz", 
            this->external_clock_pin_, this->external_clock_frequency_);
   
@@ -171,183 +268,139 @@ bool MipiDsiCam::init_external_clock_() {
   
   ESP_LOGI(TAG, "External clock initialized");
   return true;
+#endif
 }
 
-bool MipiDsiCam::init_ldo_() {
-  ESP_LOGI(TAG, "Init LDO MIPI");
-  
-  esp_ldo_channel_config_t ldo_config = {
-    .chan_id = 3,
-    .voltage_mv = 2500,
-  };
-  
-  esp_err_t ret = esp_ldo_acquire_channel(&ldo_config, &this->ldo_handle_);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "LDO failed: %d", ret);
+bool MipiDsiCam::init_backend_() {
+  if (this->backend_ == nullptr) {
+#if defined(USE_ESP32_VARIANT_ESP32P4)
+    this->backend_ = new CsiCaptureBackend();
+#elif defined(USE_HOST)
+    this->backend_ = new VirtualCsiBackend();
+#else
+    ESP_LOGE(TAG, "No capture backend for this platform");
     return false;
+#endif
   }
   
-  ESP_LOGI(TAG, "LDO OK (2.5V)");
-  return true;
+  ESP_LOGI(TAG, "Capture backend: %s", this->backend_->get_name());
+  
+  CaptureBackend::Callbacks callbacks;
+  callbacks.on_new_frame = MipiDsiCam::on_new_frame_;
+  callbacks.on_frame_done = MipiDsiCam::on_frame_done_;
+  callbacks.arg = this;
+  
+  return this->backend_->init(this->make_capture_config_(), callbacks);
 }
 
-bool MipiDsiCam::init_csi_() {
-  ESP_LOGI(TAG, "Init MIPI-CSI");
-  
-  esp_cam_ctlr_csi_config_t csi_config = {};
-  csi_config.ctlr_id = 0;
-  csi_config.clk_src = MIPI_CSI_PHY_CLK_SRC_DEFAULT;
-  csi_config.h_res = this->width_;
-  csi_config.v_res = this->height_;
-  csi_config.lane_bit_rate_mbps = this->lane_bitrate_mbps_;
-  csi_config.input_data_color_type = CAM_CTLR_COLOR_RAW8;
-  csi_config.output_data_color_type = CAM_CTLR_COLOR_RGB565;
-  csi_config.data_lane_num = this->lane_count_;
-  csi_config.byte_swap_en = false;
-  csi_config.queue_items = 10;
+CaptureConfig MipiDsiCam::make_capture_config_() const {
+  CaptureConfig config;
+  config.width = this->width_;
+  config.height = this->height_;
+  config.lane_count = this->lane_count_;
+  config.lane_bitrate_mbps = this->lane_bitrate_mbps_;
+  config.bayer_pattern = this->bayer_pattern_;
+  config.format = this->pixel_format_;
+  config.fps = this->framerate_;
+  config.sensor_type = this->sensor_type_.c_str();
+  return config;
+}
+
+bool MipiDsiCam::allocate_buffer_() {
+  const uint8_t bpp = bytes_per_pixel(this->pixel_format_);
+  this->frame_buffer_size_ = (size_t) this->width_ * this->height_ * bpp;
+  
+  // Buffers taillés pour le plus grand mode : un changement de mode ne réalloue rien
+  this->frame_buffer_capacity_ = this->frame_buffer_size_;
+  for (uint8_t i = 0; i < this->sensor_driver_->get_mode_count(); i++) {
+    SensorMode mode = this->sensor_driver_->get_mode(i);
+    size_t size = (size_t) mode.width * mode.height * bpp;
+    if (size > this->frame_buffer_capacity_) {
+      this->frame_buffer_capacity_ = size;
+    }
+  }
   
-  esp_err_t ret = esp_cam_new_csi_ctlr(&csi_config, &this->csi_handle_);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "CSI failed: %d", ret);
+  if (this->frame_buffer_count_ < FramePool::MIN_SLOTS || this->frame_buffer_count_ > FramePool::MAX_SLOTS) {
+    ESP_LOGE(TAG, "Invalid frame buffer count: %u (%u-%u)", this->frame_buffer_count_,
+             FramePool::MIN_SLOTS, FramePool::MAX_SLOTS);
     return false;
   }
   
-  esp_cam_ctlr_evt_cbs_t callbacks = {
-    .on_get_new_trans = MipiDsiCam::on_csi_new_frame_,
-    .on_trans_finished = MipiDsiCam::on_csi_frame_done_,
-  };
-  
-  ret = esp_cam_ctlr_register_event_callbacks(this->csi_handle_, &callbacks, this);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Callbacks failed: %d", ret);
-    return false;
+  for (uint8_t i = 0; i < this->frame_buffer_count_; i++) {
+    this->frame_buffers_[i] = this->backend_->allocate_frame_buffer(this->frame_buffer_capacity_);
+    
+    if (!this->frame_buffers_[i]) {
+      ESP_LOGE(TAG, "Buffer alloc failed (%u/%u)", i + 1, this->frame_buffer_count_);
+      return false;
+    }
   }
   
-  ret = esp_cam_ctlr_enable(this->csi_handle_);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Enable CSI failed: %d", ret);
+  if (!this->frame_pool_.init(this->frame_buffers_, this->frame_buffer_count_, this->frame_buffer_capacity_)) {
+    ESP_LOGE(TAG, "Frame pool init failed");
     return false;
   }
   
-  ESP_LOGI(TAG, "CSI OK");
+  ESP_LOGI(TAG, "Buffers: %ux%u bytes", this->frame_buffer_count_, (unsigned) this->frame_buffer_capacity_);
   return true;
 }
 
-bool MipiDsiCam::init_isp_() {
-  ESP_LOGI(TAG, "Init ISP");
-  
-  uint32_t isp_clock_hz = 120000000;
-  
-  esp_isp_processor_cfg_t isp_config = {};
-  isp_config.clk_src = ISP_CLK_SRC_DEFAULT;
-  isp_config.input_data_source = ISP_INPUT_DATA_SOURCE_CSI;
-  isp_config.input_data_color_type = ISP_COLOR_RAW8;
-  isp_config.output_data_color_type = ISP_COLOR_RGB565;
-  isp_config.h_res = this->width_;
-  isp_config.v_res = this->height_;
-  isp_config.has_line_start_packet = false;
-  isp_config.has_line_end_packet = false;
-  isp_config.clk_hz = isp_clock_hz;
-  isp_config.bayer_order = (color_raw_element_order_t)this->bayer_pattern_;
-  
-  esp_err_t ret = esp_isp_new_processor(&isp_config, &this->isp_handle_);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "ISP creation failed: 0x%x", ret);
-    return false;
-  }
-  
-  ret = esp_isp_enable(this->isp_handle_);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "ISP enable failed: 0x%x", ret);
-    esp_isp_del_processor(this->isp_handle_);
-    this->isp_handle_ = nullptr;
-    return false;
-  }
+uint8_t *IRAM_ATTR MipiDsiCam::on_new_frame_(void *arg) {
+  MipiDsiCam *cam = (MipiDsiCam*)arg;
+  int8_t slot = cam->frame_pool_.begin_write();
   
-  // Configure AWB si supporté par le capteur
-  this->configure_white_balance_();
-  
-  ESP_LOGI(TAG, "ISP OK");
-  return true;
+  // Tous les slots sont tenus par des consommateurs : la frame est perdue (comptée)
+  return slot >= 0 ? cam->frame_pool_.data(slot) : nullptr;
 }
 
-void MipiDsiCam::configure_white_balance_() {
-  if (!this->isp_handle_) return;
+void IRAM_ATTR MipiDsiCam::on_frame_done_(void *arg, uint8_t *buffer, size_t received_size) {
+  MipiDsiCam *cam = (MipiDsiCam*)arg;
+  int8_t slot = cam->frame_pool_.slot_for(buffer);
   
-  // OV5647 et SC202CS ont des problèmes avec AWB matériel sur ESP32-P4
-  if (this->sensor_type_ == "ov5647" || this->sensor_type_ == "sc202cs") {
-    ESP_LOGI(TAG, "%s détecté - AWB matériel désactivé (correction logicielle uniquement)", 
-             this->sensor_type_.c_str());
+  if (slot < 0) {
     return;
   }
   
-  // Tentative de configuration AWB pour les autres capteurs
-  esp_isp_awb_config_t awb_config = {};
-  awb_config.sample_point = ISP_AWB_SAMPLE_POINT_AFTER_CCM;
-  
-  // Configuration de la window (noms corrects pour ESP32-P4)
-  awb_config.window.top_left.x = this->width_ / 4;
-  awb_config.window.top_left.y = this->height_ / 4;
-  awb_config.window.btm_right.x = (this->width_ * 3) / 4;
-  awb_config.window.btm_right.y = (this->height_ * 3) / 4;
-  
-  esp_err_t ret = esp_isp_new_awb_controller(this->isp_handle_, &awb_config, &this->awb_ctlr_);
-  
-  if (ret == ESP_OK && this->awb_ctlr_ != nullptr) {
-    esp_isp_awb_controller_enable(this->awb_ctlr_);
-    ESP_LOGI(TAG, "✅ AWB matériel activé (auto-correction couleurs)");
-  } else {
-    ESP_LOGW(TAG, "AWB matériel non disponible (0x%x), utilisation ISP par défaut", ret);
+  if (received_size == 0) {
+    cam->frame_pool_.cancel_write(slot);
+    return;
   }
-}
-
-bool MipiDsiCam::allocate_buffer_() {
-  this->frame_buffer_size_ = this->width_ * this->height_ * 2;
-  
-  this->frame_buffers_[0] = (uint8_t*)heap_caps_aligned_alloc(
-    64, this->frame_buffer_size_, MALLOC_CAP_SPIRAM
-  );
-  
-  this->frame_buffers_[1] = (uint8_t*)heap_caps_aligned_alloc(
-    64, this->frame_buffer_size_, MALLOC_CAP_SPIRAM
-  );
   
-  if (!this->frame_buffers_[0] || !this->frame_buffers_[1]) {
-    ESP_LOGE(TAG, "Buffer alloc failed");
-    return false;
+  FrameInfo info;
+  info.timestamp_us = capture_time_us();
+  info.received_size = received_size;
+  info.width = cam->width_;
+  info.height = cam->height_;
+  info.format = cam->pixel_format_;
+  
+  // Réglages réellement en vigueur pour cette frame (délai d'application du capteur)
+  uint32_t frame = cam->frames_done_.fetch_add(1, std::memory_order_relaxed) + 1;
+  uint32_t from = cam->inflight_from_frame_.load(std::memory_order_acquire);
+  if (frame >= from) {
+    uint32_t controls = cam->inflight_controls_.load(std::memory_order_relaxed);
+    // Relu : un commit concurrent sera pris à la frame suivante
+    if (cam->inflight_from_frame_.load(std::memory_order_acquire) == from) {
+      cam->effective_controls_ = controls;
+    }
   }
+  info.exposure = cam->effective_controls_ & 0xFFFF;
+  info.gain_index = cam->effective_controls_ >> 16;
+  cam->last_frame_done_us_.store((uint32_t) info.timestamp_us, std::memory_order_relaxed);
   
-  this->current_frame_buffer_ = this->frame_buffers_[0];
+  cam->frame_pool_.commit_write(slot, info);
   
-  ESP_LOGI(TAG, "Buffers: 2x%u bytes", this->frame_buffer_size_);
-  return true;
-}
-
-bool IRAM_ATTR MipiDsiCam::on_csi_new_frame_(
-  esp_cam_ctlr_handle_t handle,
-  esp_cam_ctlr_trans_t *trans,
-  void *user_data
-) {
-  MipiDsiCam *cam = (MipiDsiCam*)user_data;
-  trans->buffer = cam->frame_buffers_[cam->buffer_index_];
-  trans->buflen = cam->frame_buffer_size_;
-  return false;
+  uint32_t now = (uint32_t) info.timestamp_us;
+  if (cam->last_capture_us_ != 0) {
+    cam->metrics_.record(STAGE_CSI_FRAME_INTERVAL, now - cam->last_capture_us_);
+  }
+  cam->last_capture_us_ = now;
+  cam->metrics_.increment(COUNTER_FRAMES_CAPTURED);
 }
 
-bool IRAM_ATTR MipiDsiCam::on_csi_frame_done_(
-  esp_cam_ctlr_handle_t handle,
-  esp_cam_ctlr_trans_t *trans,
-  void *user_data
-) {
-  MipiDsiCam *cam = (MipiDsiCam*)user_data;
-  
-  if (trans->received_size > 0) {
-    cam->frame_ready_ = true;
-    cam->buffer_index_ = (cam->buffer_index_ + 1) % 2;
-    cam->total_frames_received_++;
+int64_t MipiDsiCam::get_frame_age_us(const FrameInfo &info) {
+  if (info.sequence == 0) {
+    return 0;
   }
-  
-  return false;
+  return capture_time_us() - info.timestamp_us;
 }
 
 bool MipiDsiCam::start_streaming() {
@@ -357,22 +410,26 @@ bool MipiDsiCam::start_streaming() {
   
   ESP_LOGI(TAG, "Start streaming");
   
-  this->total_frames_received_ = 0;
+  // Pas d'intervalle entre la dernière frame du flux précédent et la première
+  this->last_capture_us_ = 0;
   this->last_frame_log_time_ = millis();
+  this->stream_start_us_ = capture_time_us();
+  
+  // Contrôleur prêt avant le capteur : plus d'attente fixe, la première
+  // frame reçue signale que le capteur (PLL, MIPI) est prêt
+  if (!this->backend_->start()) {
+    ESP_LOGE(TAG, "Capture backend start failed");
+    return false;
+  }
   
   if (this->sensor_driver_) {
     esp_err_t ret = this->sensor_driver_->start_stream();
     if (ret != ESP_OK) {
       ESP_LOGE(TAG, "Sensor start failed: %d", ret);
+      this->backend_->stop();
+      this->frame_pool_.abort_writes();
       return false;
     }
-    delay(100);
-  }
-  
-  esp_err_t ret = esp_cam_ctlr_start(this->csi_handle_);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "CSI start failed: %d", ret);
-    return false;
   }
   
   this->streaming_ = true;
@@ -385,7 +442,8 @@ bool MipiDsiCam::stop_streaming() {
     return true;
   }
   
-  esp_cam_ctlr_stop(this->csi_handle_);
+  this->backend_->stop();
+  this->frame_pool_.abort_writes();
   
   if (this->sensor_driver_) {
     this->sensor_driver_->stop_stream();
@@ -396,123 +454,723 @@ bool MipiDsiCam::stop_streaming() {
   return true;
 }
 
-bool MipiDsiCam::capture_frame() {
-  if (!this->streaming_) {
+int MipiDsiCam::find_mode(const std::string &name) const {
+  for (uint8_t i = 0; i < this->get_mode_count(); i++) {
+    if (name == this->sensor_driver_->get_mode(i).name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool MipiDsiCam::set_mode(const std::string &name) {
+  int index = this->find_mode(name);
+  if (index < 0) {
+    ESP_LOGE(TAG, "Unknown sensor mode: %s", name.c_str());
+    return false;
+  }
+  return this->set_mode((uint8_t) index);
+}
+
+bool MipiDsiCam::set_mode(uint8_t index) {
+  if (!this->initialized_ || index >= this->get_mode_count()) {
+    ESP_LOGE(TAG, "Invalid sensor mode: %u", index);
+    return false;
+  }
+  if (index == this->get_current_mode()) {
+    return true;
+  }
+  
+  SensorMode mode = this->sensor_driver_->get_mode(index);
+  if ((size_t) mode.width * mode.height * bytes_per_pixel(this->pixel_format_) > this->frame_buffer_capacity_) {
+    ESP_LOGE(TAG, "Mode %s (%ux%u) does not fit the frame buffers", mode.name, mode.width, mode.height);
+    return false;
+  }
+  
+  int64_t start = capture_time_us();
+  bool was_streaming = this->streaming_;
+  this->stop_streaming();
+  // Frames de l'ancien mode : plus publiées. Celles encore tenues par un
+  // consommateur gardent leur taille (FrameInfo) jusqu'à leur release.
+  this->release_frame(this->current_frame_);
+  this->frame_pool_.flush();
+  int64_t stopped = capture_time_us();
+  
+  esp_err_t ret = this->sensor_driver_->set_mode(index);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Sensor mode %s failed: %d", mode.name, ret);
+    if (was_streaming) {
+      this->start_streaming();
+    }
+    return false;
+  }
+  this->read_sensor_mode_();
+  this->framerate_ = this->sensor_driver_->get_fps();
+  this->frame_buffer_size_ = (size_t) this->width_ * this->height_ * bytes_per_pixel(this->pixel_format_);
+  int64_t sensor_done = capture_time_us();
+  
+  if (!this->backend_->reconfigure(this->make_capture_config_())) {
+    // CSI/ISP détruits : plus de capture possible
+    ESP_LOGE(TAG, "Capture backend reconfigure failed");
+    this->initialized_ = false;
+    this->mark_failed();
+    return false;
+  }
+  int64_t backend_done = capture_time_us();
+  
+  this->stats_engine_.configure(this->width_, this->height_, this->stats_zone_cols_, this->stats_zone_rows_);
+  // Nouveau VTS : l'exposition courante peut dépasser la limite du mode
+  uint32_t exposure_max = this->ae_exposure_max_ != 0 ? this->ae_exposure_max_ : this->sensor_driver_->get_exposure_max();
+  if (this->current_exposure_ > exposure_max) {
+    this->current_exposure_ = exposure_max;
+    if (this->sensor_driver_->set_exposure_gain(this->current_exposure_, this->current_gain_index_) != ESP_OK) {
+      ESP_LOGW(TAG, "Failed to clamp exposure to the new mode limit 0x%04X", exposure_max);
+    }
+  }
+  this->controls_pending_ = false;
+  this->configure_auto_exposure_();
+  
+  if (was_streaming && !this->start_streaming()) {
     return false;
   }
+  int64_t done = capture_time_us();
+  this->mode_switch_us_ = done - start;
+  this->mode_switch_start_us_ = was_streaming ? start : 0;
+  
+  ESP_LOGI(TAG, "📐 Mode %s: %ux%u@%u, %u Mbps | switch %.1f ms (stop %.1f, sensor %.1f, CSI/ISP %.1f, restart %.1f)",
+           mode.name, this->width_, this->height_, this->framerate_, this->lane_bitrate_mbps_,
+           (done - start) / 1000.0f, (stopped - start) / 1000.0f, (sensor_done - stopped) / 1000.0f,
+           (backend_done - sensor_done) / 1000.0f, (done - backend_done) / 1000.0f);
+  return true;
+}
+
+FrameHandle MipiDsiCam::acquire_frame() {
+  FrameHandle frame;
+  if (!this->initialized_) {
+    return frame;
+  }
   
-  bool was_ready = this->frame_ready_;
-  if (was_ready) {
-    this->frame_ready_ = false;
-    uint8_t last_buffer = (this->buffer_index_ + 1) % 2;
-    this->current_frame_buffer_ = this->frame_buffers_[last_buffer];
+  int8_t slot = this->frame_pool_.acquire();
+  if (slot < 0) {
+    return frame;
   }
   
-  return was_ready;
+  frame.slot = slot;
+  frame.data = this->frame_pool_.data(slot);
+  frame.info = this->frame_pool_.info(slot);
+  frame.size = (size_t) frame.info.width * frame.info.height * bytes_per_pixel(frame.info.format);
+  return frame;
 }
 
-void MipiDsiCam::update_auto_exposure_() {
-  if (!this->auto_exposure_enabled_ || !this->sensor_driver_) {
+void MipiDsiCam::release_frame(FrameHandle &frame) {
+  if (!frame.valid()) {
     return;
   }
   
-  uint32_t now = millis();
-  if (now - this->last_ae_update_ < 100) {
-    return;
+  this->frame_pool_.release(frame.slot);
+  frame = FrameHandle{};
+}
+
+bool MipiDsiCam::capture_frame() {
+  if (!this->streaming_) {
+    return false;
+  }
+  
+  FrameHandle frame = this->acquire_frame();
+  if (!frame.valid() || frame.info.sequence == this->current_frame_.info.sequence) {
+    this->release_frame(frame);
+    return false;
   }
-  this->last_ae_update_ = now;
   
-  uint32_t avg_brightness = this->calculate_brightness_();
+  this->release_frame(this->current_frame_);
+  this->current_frame_ = frame;
+  return true;
+}
+
+bool MipiDsiCam::set_roi(uint8_t id, const FrameRoi &roi) {
+  if (id >= MAX_ROIS) {
+    return false;
+  }
+  this->rois_[id].store(roi.pack(), std::memory_order_relaxed);
+  return true;
+}
+
+FrameRoi MipiDsiCam::get_roi(uint8_t id) const {
+  if (id >= MAX_ROIS) {
+    return {};
+  }
+  return FrameRoi::unpack(this->rois_[id].load(std::memory_order_relaxed));
+}
+
+void MipiDsiCam::set_digital_zoom(float factor, float center_x, float center_y) {
+  FrameRoi window = zoom_window(ZOOM_SCALE, ZOOM_SCALE, factor, center_x, center_y);
+  this->zoom_.store(window.pack(), std::memory_order_relaxed);
+  ESP_LOGD(TAG, "🔍 Zoom x%.2f centre (%.2f, %.2f)", factor, center_x, center_y);
+}
+
+float MipiDsiCam::get_digital_zoom() const {
+  FrameRoi window = FrameRoi::unpack(this->zoom_.load(std::memory_order_relaxed));
+  return window.is_full() ? 1.0f : (float) ZOOM_SCALE / window.width;
+}
+
+FrameView MipiDsiCam::get_frame_view(const FrameHandle &frame) const {
+  if (!frame.valid()) {
+    return {};
+  }
+  return FrameView::packed(frame.data, frame.info.width, frame.info.height, frame.info.format, this->bayer_pattern_);
+}
+
+FrameSignature MipiDsiCam::get_frame_signature(const FrameHandle &frame) {
+  FrameSignature signature;
+  if (!frame.valid()) {
+    return signature;
+  }
+  SignatureSlot &cached = this->signatures_[frame.slot];
+  if (cached.sequence.load(std::memory_order_acquire) == frame.info.sequence) {
+    return cached.signature;
+  }
+  
+  int64_t start = capture_time_us();
+  compute_frame_signature(this->get_frame_view(frame), frame.info.sequence, signature);
+  this->metrics_.record(STAGE_SIGNATURE, capture_time_us() - start);
+  
+  // Un seul écrivain ; le perdant (autre tâche sur la même frame) garde sa copie
+  bool expected = false;
+  if (cached.busy.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+    if (cached.sequence.load(std::memory_order_relaxed) != frame.info.sequence) {
+      cached.signature = signature;
+      cached.sequence.store(frame.info.sequence, std::memory_order_release);
+    }
+    cached.busy.store(false, std::memory_order_release);
+  }
+  return signature;
+}
+
+FrameView MipiDsiCam::get_zoom_view(const FrameHandle &frame) const {
+  FrameView view = this->get_frame_view(frame);
+  FrameRoi window = FrameRoi::unpack(this->zoom_.load(std::memory_order_relaxed));
+  if (window.is_full()) {
+    return view;
+  }
+  // Fraction de frame -> pixels de la frame (la taille suit le mode courant)
+  FrameRoi roi{(uint16_t) ((uint32_t) window.x * view.width / ZOOM_SCALE),
+               (uint16_t) ((uint32_t) window.y * view.height / ZOOM_SCALE),
+               (uint16_t) ((uint32_t) window.width * view.width / ZOOM_SCALE),
+               (uint16_t) ((uint32_t) window.height * view.height / ZOOM_SCALE)};
+  return view.crop(roi);
+}
+
+FrameView MipiDsiCam::get_roi_view(const FrameHandle &frame, uint8_t id) const {
+  return this->get_frame_view(frame).crop(this->get_roi(id));
+}
+
+bool MipiDsiCam::init_tone_mapper_() {
+  if (this->tone_lut_ != nullptr) {
+    return true;
+  }
   
-  int32_t brightness_error = (int32_t)this->ae_target_brightness_ - (int32_t)avg_brightness;
+  size_t lut_bytes = ToneMapper::LUT_SIZE * sizeof(uint16_t);
+#ifdef USE_ESP32
+  // Accès aléatoires : la LUT (128 Ko) a sa place en SRAM interne, PSRAM en secours
+  this->tone_lut_ = (uint16_t *) heap_caps_malloc(lut_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (this->tone_lut_ == nullptr) {
+    ESP_LOGW(TAG, "Tone LUT: no internal RAM, using PSRAM");
+    this->tone_lut_ = (uint16_t *) heap_caps_malloc(lut_bytes, MALLOC_CAP_SPIRAM);
+  }
+#else
+  this->tone_lut_ = new (std::nothrow) uint16_t[ToneMapper::LUT_SIZE];
+#endif
+  if (this->tone_lut_ == nullptr) {
+    ESP_LOGE(TAG, "Tone LUT alloc failed (%u bytes)", (unsigned) lut_bytes);
+    return false;
+  }
+  this->tone_mapper_.set_lut_buffer(this->tone_lut_);
+  
+#ifdef MIPI_DSI_CAM_SPLIT_PROCESSING
+  this->tone_done_ = xSemaphoreCreateBinary();
+  if (this->tone_done_ == nullptr ||
+      xTaskCreatePinnedToCore(MipiDsiCam::tone_worker_task_, "cam_tone", 3072, this, 5, &this->tone_worker_,
+                              xPortGetCoreID() ^ 1) != pdPASS) {
+    ESP_LOGW(TAG, "Tone worker task failed, single-core processing");
+    this->tone_worker_ = nullptr;
+  }
+#endif
+  return true;
+}
+
+#ifdef MIPI_DSI_CAM_SPLIT_PROCESSING
+void MipiDsiCam::tone_worker_task_(void *arg) {
+  MipiDsiCam *cam = (MipiDsiCam*)arg;
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    cam->tone_mapper_.apply(cam->tone_frame_, cam->tone_split_, cam->tone_end_);
+    xSemaphoreGive(cam->tone_done_);
+  }
+}
+#endif
+
+void MipiDsiCam::update_processing_() {
+  // Les frames doivent être corrigées avant d'être visibles des consommateurs
+  bool processing = this->is_tone_mapping_();
+  if (processing && this->initialized_ && !this->init_tone_mapper_()) {
+    processing = false;
+  }
+  bool manual = processing || this->osd_enabled_;
+  this->frame_pool_.set_auto_publish(!manual);
+  // Les frames attendent loop() pour être publiées : boucle rapide plutôt
+  // qu'un passage toutes les 16 ms. Requester distinct : apply_controls_()
+  // arrête high_freq_ à chaque commit de l'AE.
+  if (manual) {
+    this->processing_high_freq_.start();
+  } else {
+    this->processing_high_freq_.stop();
+  }
+}
+
+bool MipiDsiCam::process_pending_frame_() {
+  int8_t slot = this->frame_pool_.take_pending();
+  if (slot < 0) {
+    return false;
+  }
   
-  if (abs(brightness_error) > 10) {
+  // Slot exclusif : ni le DMA ni les consommateurs n'y ont accès
+  uint8_t *data = this->frame_pool_.data(slot);
+  const FrameInfo &info = this->frame_pool_.info(slot);
+  FrameView view = FrameView::packed(data, info.width, info.height, info.format, this->bayer_pattern_);
+  // Stats et mouvement sur l'image du capteur, avant la LUT et l'incrustation :
+  // l'AE ne compense pas la luminosité logicielle, l'AWB mesure la vraie
+  // dominante, et l'horloge ou les boîtes dessinées ne se détectent pas
+  bool analysed = this->analyse_frame_(view, info);
+  
+  if (this->is_tone_mapping_() && this->tone_mapper_.has_lut()) {
+    ToneParams params = this->tone_params_;
+    if (this->white_balance_.is_active()) {
+      params.gain_r = this->white_balance_.get_red_gain();
+      params.gain_g = this->white_balance_.get_green_gain();
+      params.gain_b = this->white_balance_.get_blue_gain();
+    }
+    this->tone_mapper_.set_params(params);
     
-    if (brightness_error > 0) {
-      // Image trop sombre
-      if (this->current_exposure_ < 0xF00) {
-        this->current_exposure_ += 0x40;
-      } else if (this->current_gain_index_ < 120) {
-        this->current_gain_index_ += 2;
-      }
+    int64_t start = capture_time_us();
+    this->tone_mapper_.prepare();
+    size_t pixels = (size_t) info.width * info.height;
+#ifdef MIPI_DSI_CAM_SPLIT_PROCESSING
+    if (this->tone_worker_ != nullptr) {
+      // Seconde moitié sur l'autre cœur pendant qu'on traite la première
+      this->tone_frame_ = data;
+      this->tone_split_ = (pixels / 2) & ~(size_t) 15;
+      this->tone_end_ = pixels;
+      xTaskNotifyGive(this->tone_worker_);
+      this->tone_mapper_.apply(data, 0, this->tone_split_);
+      xSemaphoreTake(this->tone_done_, portMAX_DELAY);
     } else {
-      // Image trop lumineuse
-      if (this->current_exposure_ > 0x200) {
-        this->current_exposure_ -= 0x40;
-      } else if (this->current_gain_index_ > 0) {
-        this->current_gain_index_ -= 2;
+      this->tone_mapper_.apply(data, 0, pixels);
+    }
+#else
+    this->tone_mapper_.apply(data, 0, pixels);
+#endif
+    this->processing_us_ = capture_time_us() - start;
+  }
+  
+  // Signature mise en cache sur le slot avant l'incrustation : l'horloge et
+  // les stats dessinées ne font pas passer une scène statique pour changée
+  FrameHandle frame;
+  frame.slot = slot;
+  frame.data = data;
+  frame.info = info;
+  frame.size = view.row_bytes() * view.height;
+  this->get_frame_signature(frame);
+  
+  if (this->osd_enabled_) {
+    int64_t start = capture_time_us();
+    this->update_osd_(info);
+    this->osd_.draw(view);
+    this->metrics_.record(STAGE_OSD, capture_time_us() - start);
+  }
+  
+  this->frame_pool_.publish(slot);
+  return analysed;
+}
+
+void MipiDsiCam::update_osd_(const FrameInfo &info) {
+  // Ligne refaite seulement quand la seconde ou le libellé change : pas de
+  // std::string construite à chaque frame à côté de la capture
+  const std::string &label = this->osd_label_.empty() ? this->name_ : this->osd_label_;
+  uint32_t key = 0;
+  char clock[32] = "";
+  if (this->osd_timestamp_) {
+    key = info.timestamp_us / 1000000;
+    bool wall_clock = false;
+#ifdef USE_TIME
+    ESPTime now{};
+    if (this->osd_time_ != nullptr) {
+      now = this->osd_time_->now();
+      wall_clock = now.is_valid();
+    }
+    if (wall_clock) {
+      key = now.timestamp;
+      if (key != this->osd_clock_key_) {
+        now.strftime(clock, sizeof(clock), "%Y-%m-%d %H:%M:%S");
       }
     }
-    
-    this->sensor_driver_->set_exposure(this->current_exposure_);
-    this->sensor_driver_->set_gain(this->current_gain_index_);
-    
-    ESP_LOGV(TAG, "🔆 AE: brightness=%u target=%u → exp=0x%04X gain=%u",
-             avg_brightness, this->ae_target_brightness_,
-             this->current_exposure_, this->current_gain_index_);
+#endif
+    if (!wall_clock && key != this->osd_clock_key_) {
+      // Temps de capture de la frame depuis le boot
+      snprintf(clock, sizeof(clock), "UP %02u:%02u:%02u", (unsigned) (key / 3600), (unsigned) (key / 60 % 60),
+               (unsigned) (key % 60));
+    }
+  }
+  if (key != this->osd_clock_key_) {
+    this->osd_clock_key_ = key;
+    char line[96];
+    snprintf(line, sizeof(line), "%s%s%s", label.c_str(), label.empty() || clock[0] == '\0' ? "" : "  ", clock);
+    this->osd_.set_line(0, line);
+  }
+  
+  char stats[64] = "";
+  if (this->osd_stats_) {
+    // Une fois par seconde : le texte (et son sprite) ne change pas à chaque frame
+    uint32_t now = millis();
+    uint32_t captured = this->metrics_.counter(COUNTER_FRAMES_CAPTURED);
+    if (this->osd_fps_time_ == 0 || now - this->osd_fps_time_ >= 1000) {
+      if (this->osd_fps_time_ != 0) {
+        this->osd_fps_ = (captured - this->osd_fps_captured_) * 1000.0f / (now - this->osd_fps_time_);
+      }
+      this->osd_fps_time_ = now;
+      this->osd_fps_captured_ = captured;
+    }
+    snprintf(stats, sizeof(stats), "%.1f fps  exp 0x%04X  gain %u%s", this->osd_fps_, info.exposure, info.gain_index,
+             this->motion_enabled_ && this->motion_.motion ? "  MOTION" : "");
+  }
+  if (strcmp(stats, this->osd_stats_line_) != 0) {
+    memcpy(this->osd_stats_line_, stats, sizeof(stats));
+    this->osd_.set_line(1, stats);
+  }
+  this->osd_.set_line(2, this->osd_text_);
+  
+  if (this->osd_motion_boxes_ && this->motion_enabled_ && this->motion_.motion &&
+      this->motion_.sequence == info.sequence) {
+    this->osd_.set_boxes(this->motion_.boxes, this->motion_.box_count);
+  } else {
+    this->osd_.set_boxes(nullptr, 0);
+  }
+}
+
+void MipiDsiCam::set_osd_enabled(bool enabled) {
+  this->osd_enabled_ = enabled;
+  this->update_processing_();
+}
+
+bool MipiDsiCam::analyse_frame_(const FrameView &view, const FrameInfo &info) {
+  int64_t start = capture_time_us();
+  if (view.width != this->stats_engine_.get_width() || view.height != this->stats_engine_.get_height()) {
+    // Frame d'un autre mode encore dans le pool
+    this->stats_engine_.configure(view.width, view.height, this->stats_zone_cols_, this->stats_zone_rows_);
+  }
+  bool computed = this->stats_engine_.compute(view, info.sequence, this->stats_);
+  uint32_t elapsed = capture_time_us() - start;
+  
+  if (this->motion_enabled_) {
+    this->update_motion_(view, info.sequence);
+  }
+  if (!computed) {
+    // Rien d'échantillonné : les stats précédentes restent celles de leur frame
+    return false;
+  }
+  this->stats_info_ = info;
+  this->stats_.compute_us = elapsed;
+  this->stats_engine_.adapt(elapsed);
+  return true;
+}
+
+bool MipiDsiCam::update_stats_() {
+  FrameHandle frame = this->acquire_frame();
+  if (!frame.valid() || frame.info.sequence == this->stats_.sequence) {
+    // Frame corrigée ou incrustée : déjà analysée avant publication
+    this->release_frame(frame);
+    return false;
+  }
+  
+  // Signature calculée ici, une fois par frame : les consommateurs la trouvent prête
+  this->get_frame_signature(frame);
+  // Même frame, encore tenue : stats et mouvement n'acquièrent rien de plus
+  bool analysed = this->analyse_frame_(this->get_frame_view(frame), frame.info);
+  this->release_frame(frame);
+  return analysed;
+}
+
+void MipiDsiCam::update_motion_(const FrameView &view, uint32_t sequence) {
+  bool was_moving = this->motion_.motion;
+  int64_t start = capture_time_us();
+  this->motion_detector_.process(view, sequence, this->motion_);
+  uint32_t elapsed = capture_time_us() - start;
+  this->motion_.compute_us = elapsed;
+  this->motion_detector_.adapt(elapsed);
+  this->metrics_.record(STAGE_MOTION, elapsed);
+  
+  if (this->motion_.global_change) {
+    ESP_LOGD(TAG, "🏃 Global change (%.0f%% of the frame): motion background reset", this->motion_.changed_percent);
+  }
+  if (this->motion_.motion == was_moving) {
+    return;
+  }
+  if (this->motion_.motion) {
+    ESP_LOGD(TAG, "🏃 Motion: %u region(s), largest %ux%u at (%u, %u)", this->motion_.box_count,
+             this->motion_.boxes[0].width, this->motion_.boxes[0].height, this->motion_.boxes[0].x,
+             this->motion_.boxes[0].y);
+  } else {
+    ESP_LOGD(TAG, "🏃 Motion ended");
+  }
+#ifdef USE_BINARY_SENSOR
+  if (this->motion_binary_sensor_ != nullptr) {
+    this->motion_binary_sensor_->publish_state(this->motion_.motion);
   }
+#endif
+  this->motion_callback_.call(this->motion_);
 }
 
-uint32_t MipiDsiCam::calculate_brightness_() {
-  if (!this->current_frame_buffer_) {
-    return 128;
+void MipiDsiCam::set_motion_enabled(bool enabled) {
+  if (enabled && !this->motion_enabled_) {
+    // Le fond d'avant la pause ne vaut plus rien
+    this->motion_detector_.reset();
+  }
+  this->motion_enabled_ = enabled;
+  if (!enabled && this->motion_.motion) {
+    this->motion_ = MotionResult{};
+#ifdef USE_BINARY_SENSOR
+    if (this->motion_binary_sensor_ != nullptr) {
+      this->motion_binary_sensor_->publish_state(false);
+    }
+#endif
+    this->motion_callback_.call(this->motion_);
+  }
+}
+
+void MipiDsiCam::configure_auto_exposure_() {
+  std::vector<uint32_t> gains(this->sensor_driver_->get_gain_count());
+  for (size_t i = 0; i < gains.size(); i++) {
+    gains[i] = this->sensor_driver_->get_gain_value(i);
+  }
+  
+  uint32_t exposure_min = this->ae_exposure_min_ != 0 ? this->ae_exposure_min_ : this->sensor_driver_->get_exposure_min();
+  uint32_t exposure_max = this->ae_exposure_max_ != 0 ? this->ae_exposure_max_ : this->sensor_driver_->get_exposure_max();
+  
+  this->auto_exposure_.set_limits(exposure_min, exposure_max, gains);
+  this->auto_exposure_.set_target(this->ae_target_brightness_);
+  this->auto_exposure_.reset(this->current_exposure_, this->current_gain_index_);
+  // Plus de pause aveugle : l'AE ne reçoit que les frames exposées avec les derniers réglages
+  this->auto_exposure_.set_settle_frames(0);
+  
+  this->apply_delay_frames_ = this->sensor_driver_->get_apply_delay_frames();
+  // Approximation du blanking vertical : 1/8 de la période trame après la fin de frame
+  this->blanking_window_us_ = 1000000 / ((uint32_t) this->framerate_ * 8);
+  this->effective_controls_ = this->current_exposure_ | ((uint32_t) this->current_gain_index_ << 16);
+  this->inflight_controls_ = this->effective_controls_;
+  
+  ESP_LOGI(TAG, "AE controls: %s, apply delay %u frame(s)",
+           this->sensor_driver_->has_group_hold() ? "group hold" : "written in vblank", this->apply_delay_frames_);
+  ESP_LOGI(TAG, "AE limits: exp 0x%04X-0x%04X, gain x%.2f-x%.2f (index max %u)",
+           exposure_min, exposure_max, gains.empty() ? 1.0f : gains.front() / 1000.0f,
+           gains.empty() ? 1.0f : this->sensor_driver_->get_gain_value(this->auto_exposure_.get_gain_index_max()) / 1000.0f,
+           this->auto_exposure_.get_gain_index_max());
+}
+
+void MipiDsiCam::update_auto_exposure_() {
+  if (!this->auto_exposure_enabled_ || !this->sensor_driver_) {
+    return;
   }
   
-  uint32_t sum = 0;
-  uint32_t sample_count = 0;
+  // Frame exposée avec des réglages périmés : la mesure ferait sur-corriger l'AE
+  if (this->controls_pending_ || this->stats_info_.exposure != this->current_exposure_ ||
+      this->stats_info_.gain_index != this->current_gain_index_) {
+    this->ae_stale_frames_++;
+    return;
+  }
+  
+  uint32_t exposure;
+  uint32_t gain_index;
+  if (!this->auto_exposure_.update(this->stats_, &exposure, &gain_index)) {
+    return;
+  }
+  
+  // Stagé : exposition et gain partent ensemble au prochain commit
+  this->current_exposure_ = exposure;
+  this->current_gain_index_ = gain_index;
+  this->controls_pending_ = true;
+  this->commit_controls_();
   
-  uint32_t center_offset = (this->height_ / 2) * this->width_ * 2 + (this->width_ / 2) * 2;
+  ESP_LOGV(TAG, "🔆 AE: luma=%u target=%u (%+.2f EV) → exp=0x%04X gain=%u",
+           this->auto_exposure_.metered_luma(this->stats_), this->ae_target_brightness_,
+           this->auto_exposure_.get_last_error_ev(), this->current_exposure_, this->current_gain_index_);
+}
+
+void MipiDsiCam::commit_controls_() {
+  if (!this->controls_pending_) {
+    return;
+  }
   
-  for (int i = 0; i < 100; i++) {
-    uint32_t offset = center_offset + (i * 200);
-    if (offset + 1 < this->frame_buffer_size_) {
-      uint16_t pixel = (this->current_frame_buffer_[offset + 1] << 8) | 
-                       this->current_frame_buffer_[offset];
-      
-      uint8_t r = (pixel >> 11) & 0x1F;
-      uint8_t g = (pixel >> 5) & 0x3F;
-      uint8_t b = pixel & 0x1F;
-      
-      uint32_t brightness = (r * 8 * 299 + g * 4 * 587 + b * 8 * 114) / 1000;
-      
-      sum += brightness;
-      sample_count++;
+  bool in_blanking = false;
+  if (this->streaming_ && !this->sensor_driver_->has_group_hold()) {
+    uint32_t since_frame = (uint32_t) capture_time_us() - this->last_frame_done_us_.load(std::memory_order_relaxed);
+    in_blanking = since_frame < this->blanking_window_us_;
+    // Flux arrêté ou bloqué : plus de frontière de frame à attendre
+    bool stalled = since_frame > 2 * 8 * this->blanking_window_us_;
+    if (!in_blanking && !stalled) {
+      // Boucle rapide jusqu'à la prochaine fin de frame
+      this->high_freq_.start();
+      return;
     }
   }
+  this->apply_controls_(this->current_exposure_, this->current_gain_index_, in_blanking);
+}
+
+esp_err_t MipiDsiCam::apply_controls_(uint32_t exposure, uint32_t gain_index, bool in_blanking) {
+  this->controls_pending_ = false;
+  this->high_freq_.stop();
+  
+  esp_err_t ret = this->sensor_driver_->set_exposure_gain(exposure, gain_index);
+  if (ret != ESP_OK) {
+    // Écriture I2C ratée : revenir aux réglages réellement en vigueur, sinon
+    // toutes les frames paraissent périmées et l'AE ne repart plus
+    uint32_t controls = this->inflight_controls_.load(std::memory_order_relaxed);
+    this->current_exposure_ = controls & 0xFFFF;
+    this->current_gain_index_ = controls >> 16;
+    this->control_write_failures_++;
+    ESP_LOGW(TAG, "Sensor exp/gain write failed (%s, %u so far), keeping exp=0x%04X gain=%u",
+             esp_err_to_name(ret), this->control_write_failures_, this->current_exposure_, this->current_gain_index_);
+    return ret;
+  }
   
-  return sample_count > 0 ? (sum / sample_count) : 128;
+  // Commit dans le blanking : pris par la frame suivante, sinon par celle d'après
+  uint32_t from = this->frames_done_.load(std::memory_order_relaxed) + 1 + this->apply_delay_frames_ +
+                  (in_blanking || this->sensor_driver_->has_group_hold() ? 0 : 1);
+  this->inflight_from_frame_.store(UINT32_MAX, std::memory_order_relaxed);
+  this->inflight_controls_.store(exposure | (gain_index << 16), std::memory_order_relaxed);
+  this->inflight_from_frame_.store(from, std::memory_order_release);
+  return ESP_OK;
+}
+
+void MipiDsiCam::record_first_frame_() {
+  int64_t frame_us = this->stats_info_.timestamp_us;
+  this->boot_timing_.stream_to_frame_us = frame_us - this->stream_start_us_;
+  this->stream_start_us_ = 0;
+  
+  if (this->boot_timing_.boot_to_frame_us == 0) {
+    this->boot_timing_.boot_to_frame_us = frame_us - this->boot_start_us_;
+    ESP_LOGI(TAG, "⏱️ First frame %.1f ms after stream start, %.1f ms after boot",
+             this->boot_timing_.stream_to_frame_us / 1000.0f, this->boot_timing_.boot_to_frame_us / 1000.0f);
+  }
+  if (this->mode_switch_start_us_ != 0) {
+    ESP_LOGI(TAG, "📐 First frame of the new mode %.1f ms after the switch request",
+             (frame_us - this->mode_switch_start_us_) / 1000.0f);
+    this->mode_switch_start_us_ = 0;
+  }
 }
 
 void MipiDsiCam::loop() {
+  uint8_t brightness_level = this->requested_brightness_level_.exchange(NO_BRIGHTNESS_REQUEST, std::memory_order_relaxed);
+  if (brightness_level != NO_BRIGHTNESS_REQUEST) {
+    this->apply_brightness_level_(brightness_level);
+  }
+  
   if (this->streaming_) {
-    // Mise à jour Auto Exposure
-    this->update_auto_exposure_();
+    // Publier la dernière frame reçue (corrigée si WB/tone logicielles,
+    // incrustée si OSD) et recycler les plus anciennes
+    bool analysed = false;
+    bool processing = (this->is_tone_mapping_() && this->tone_mapper_.has_lut()) || this->osd_enabled_;
+    if (processing) {
+      analysed = this->process_pending_frame_();
+    } else {
+      this->frame_pool_.publish_pending();
+    }
     
-    static uint32_t ready_count = 0;
-    static uint32_t not_ready_count = 0;
+    // Juste après une fin de frame : le moment d'écrire exp/gain hors group hold
+    this->commit_controls_();
     
-    if (this->frame_ready_) {
-      ready_count++;
-    } else {
-      not_ready_count++;
+    // Une passe de statistiques par nouvelle frame, réutilisée par AE et AWB.
+    // Frames retouchées : analysées avant publication, jamais après
+    if (processing ? analysed : this->update_stats_()) {
+      if (this->stream_start_us_ != 0 && this->stats_info_.timestamp_us >= this->stream_start_us_) {
+        this->record_first_frame_();
+      }
+      this->update_auto_exposure_();
+      this->white_balance_.update(this->stats_);
     }
     
     uint32_t now = millis();
     if (now - this->last_frame_log_time_ >= 3000) {
-      float sensor_fps = this->total_frames_received_ / 3.0f;
-      float ready_rate = (float)ready_count / (float)(ready_count + not_ready_count) * 100.0f;
-      
-      ESP_LOGI(TAG, "📸 FPS: %.1f | frame_ready: %.1f%% | exp:0x%04X gain:%u", 
-               sensor_fps, ready_rate, this->current_exposure_, this->current_gain_index_);
-      
-      this->total_frames_received_ = 0;
+      this->log_pipeline_();
       this->last_frame_log_time_ = now;
-      ready_count = 0;
-      not_ready_count = 0;
     }
   }
 }
 
+void MipiDsiCam::log_pipeline_() {
+  float seconds = (millis() - this->last_frame_log_time_) / 1000.0f;
+  uint32_t captured = this->metrics_.counter(COUNTER_FRAMES_CAPTURED);
+  uint32_t displayed = this->metrics_.counter(COUNTER_FRAMES_DISPLAYED);
+  float sensor_fps = (captured - this->logged_captured_) / seconds;
+  
+  ESP_LOGI(TAG, "📸 FPS: %.1f | drops: %u | exp:0x%04X gain:%u | luma:%u clip:%.1f%% crush:%.1f%% (%uus, 1/%u)", 
+           sensor_fps, this->frame_pool_.get_dropped_frames(),
+           this->current_exposure_, this->current_gain_index_,
+           this->stats_.mean_luma, this->stats_.clipped_percent, this->stats_.crushed_percent,
+           this->stats_.compute_us, this->stats_.sample_step);
+  if (displayed != this->logged_displayed_) {
+    LatencyHistogram::Snapshot total = this->metrics_.histogram(STAGE_LVGL_INVALIDATE);
+    LatencyHistogram::Snapshot window = total.since(this->logged_display_);
+    ESP_LOGI(TAG, "🎞️ Display FPS: %.1f | glass-to-display p50 %.1f ms, p99 %.1f ms",
+             (displayed - this->logged_displayed_) / seconds, window.percentile_us(0.5f) / 1000.0f,
+             window.percentile_us(0.99f) / 1000.0f);
+    this->logged_display_ = total;
+  }
+  uint32_t display_paced = this->metrics_.counter(COUNTER_DISPLAY_PACED);
+  LatencyHistogram::Snapshot render_total = this->metrics_.histogram(STAGE_LVGL_RENDER);
+  LatencyHistogram::Snapshot render = render_total.since(this->logged_render_);
+  if (render.count != 0 || display_paced != this->logged_display_paced_) {
+    ESP_LOGD(TAG, "⏱️ Display pacing: %u frame(s) skipped | LVGL render p50 %.1f ms, p95 %.1f ms, p99 %.1f ms",
+             display_paced - this->logged_display_paced_, render.percentile_us(0.5f) / 1000.0f,
+             render.percentile_us(0.95f) / 1000.0f, render.percentile_us(0.99f) / 1000.0f);
+    this->logged_display_paced_ = display_paced;
+    this->logged_render_ = render_total;
+  }
+  LatencyHistogram::Snapshot client_total = this->metrics_.histogram(STAGE_GLASS_TO_CLIENT);
+  LatencyHistogram::Snapshot client = client_total.since(this->logged_client_);
+  if (client.count != 0) {
+    ESP_LOGD(TAG, "🌐 Glass-to-client p50 %.1f ms, p99 %.1f ms (%u images)", client.percentile_us(0.5f) / 1000.0f,
+             client.percentile_us(0.99f) / 1000.0f, client.count);
+    this->logged_client_ = client_total;
+  }
+  this->logged_captured_ = captured;
+  this->logged_displayed_ = displayed;
+  
+  uint32_t display_skipped = this->metrics_.counter(COUNTER_DISPLAY_SKIPPED);
+  uint32_t jpeg_reused = this->metrics_.counter(COUNTER_JPEG_REUSED) + this->metrics_.counter(COUNTER_NOT_MODIFIED);
+  if (display_skipped != this->logged_display_skipped_ || jpeg_reused != this->logged_jpeg_reused_) {
+    ESP_LOGD(TAG, "🪞 Unchanged content: %u redraw(s) skipped, %u JPEG(s) not re-encoded",
+             display_skipped - this->logged_display_skipped_, jpeg_reused - this->logged_jpeg_reused_);
+    this->logged_display_skipped_ = display_skipped;
+    this->logged_jpeg_reused_ = jpeg_reused;
+  }
+  
+  if (this->ae_stale_frames_ != 0) {
+    ESP_LOGD(TAG, "🔆 AE: %u stale frame(s) skipped (apply delay %u)", this->ae_stale_frames_,
+             this->apply_delay_frames_);
+    this->ae_stale_frames_ = 0;
+  }
+  if (this->is_tone_mapping_()) {
+    ESP_LOGI(TAG, "🎨 WB: R=%.2f G=%.2f B=%.2f | tone: γ%.2f c%.2f b%+d s%.2f (%uus/frame)",
+             this->white_balance_.get_red_gain(), this->white_balance_.get_green_gain(),
+             this->white_balance_.get_blue_gain(), this->tone_params_.gamma, this->tone_params_.contrast,
+             this->tone_params_.brightness, this->tone_params_.saturation, this->processing_us_);
+  }
+}
+
+void MipiDsiCam::write_metrics(std::string &out) {
+  this->metrics_.set(COUNTER_FRAMES_DROPPED, this->frame_pool_.get_dropped_frames());
+  this->metrics_.write_prometheus(out);
+}
+
 void MipiDsiCam::dump_config() {
   ESP_LOGCONFIG(TAG, "MIPI Camera:");
   if (this->sensor_driver_) {
@@ -522,9 +1180,25 @@ void MipiDsiCam::dump_config() {
     ESP_LOGCONFIG(TAG, "  Sensor: %s (driver not loaded)", this->sensor_type_.c_str());
   }
   ESP_LOGCONFIG(TAG, "  Resolution: %ux%u", this->width_, this->height_);
-  ESP_LOGCONFIG(TAG, "  Format: RGB565");
+  if (this->get_mode_count() > 1) {
+    for (uint8_t i = 0; i < this->get_mode_count(); i++) {
+      SensorMode mode = this->sensor_driver_->get_mode(i);
+      ESP_LOGCONFIG(TAG, "  Mode %u: %s %ux%u@%u, %u Mbps%s", i, mode.name, mode.width, mode.height, mode.fps,
+                    mode.lane_bitrate_mbps, i == this->get_current_mode() ? " (active)" : "");
+    }
+  }
+  ESP_LOGCONFIG(TAG, "  Format: %s (%u bytes/frame)", pixel_format_name(this->pixel_format_),
+                (unsigned) this->frame_buffer_size_);
+  if (this->pixel_format_ == PIXEL_FORMAT_RAW8) {
+    static const char *const DEMOSAIC_NAMES[] = {"nearest", "bilinear", "edge-aware"};
+    ESP_LOGCONFIG(TAG, "  Demosaic: %s (software)", DEMOSAIC_NAMES[this->demosaic_method_]);
+  }
   ESP_LOGCONFIG(TAG, "  Lanes: %u", this->lane_count_);
   ESP_LOGCONFIG(TAG, "  Bayer: %u", this->bayer_pattern_);
+  ESP_LOGCONFIG(TAG, "  Frame buffers: %u", this->frame_buffer_count_);
+  if (this->backend_) {
+    ESP_LOGCONFIG(TAG, "  Capture backend: %s", this->backend_->get_name());
+  }
   
   if (this->has_external_clock()) {
     ESP_LOGCONFIG(TAG, "  External Clock: GPIO%d @ %u Hz", 
@@ -535,48 +1209,132 @@ void MipiDsiCam::dump_config() {
   
   ESP_LOGCONFIG(TAG, "  Auto Exposure: %s", this->auto_exposure_enabled_ ? "ON" : "OFF");
   ESP_LOGCONFIG(TAG, "  AE Target: %u", this->ae_target_brightness_);
+  if (this->sensor_driver_) {
+    ESP_LOGCONFIG(TAG, "  AE Controls: %s, apply delay %u frame(s)",
+                  this->sensor_driver_->has_group_hold() ? "group hold" : "vblank write", this->apply_delay_frames_);
+  }
+  static const char *const AWB_NAMES[] = {"off", "gray-world", "white-patch", "manual"};
+  ESP_LOGCONFIG(TAG, "  Software AWB: %s", AWB_NAMES[this->white_balance_.get_mode()]);
+  ESP_LOGCONFIG(TAG, "  Tone: gamma %.2f, contrast %.2f, brightness %+d, saturation %.2f", this->tone_params_.gamma,
+                this->tone_params_.contrast, this->tone_params_.brightness, this->tone_params_.saturation);
+  static const char *const METERING_NAMES[] = {"average", "center-weighted", "spot"};
+  ESP_LOGCONFIG(TAG, "  AE Metering: %s", METERING_NAMES[this->auto_exposure_.get_metering_mode()]);
+  ESP_LOGCONFIG(TAG, "  Stats: %ux%u zones, budget %uus", this->stats_zone_cols_, this->stats_zone_rows_,
+                this->stats_engine_.get_budget_us());
+  ESP_LOGCONFIG(TAG, "  Change threshold: %u luma levels per block", this->change_threshold_);
+  if (this->motion_enabled_) {
+    const MotionConfig &motion = this->motion_detector_.get_config();
+    ESP_LOGCONFIG(TAG, "  Motion: %ux%u plane, %upx cells, sensitivity %.0f%%, min area %.1f%%, %u mask(s), budget %uus",
+                  motion.plane_width, motion.plane_height, motion.cell_size, motion.sensitivity * 100.0f,
+                  motion.min_area * 100.0f, this->motion_detector_.get_mask_count(),
+                  this->motion_detector_.get_budget_us());
+  }
+  if (this->osd_enabled_) {
+    static const char *const OSD_POSITIONS[] = {"top-left", "top-right", "bottom-left", "bottom-right"};
+    const OsdConfig &osd = this->osd_.get_config();
+    const char *clock = "uptime";
+#ifdef USE_TIME
+    if (this->osd_time_ != nullptr)
+      clock = "clock";
+#endif
+    ESP_LOGCONFIG(TAG, "  OSD: %s, scale %u%s, background %u%%, timestamp %s%s%s", OSD_POSITIONS[osd.position],
+                  osd.scale, osd.scale == 0 ? " (auto)" : "", osd.background_opacity,
+                  this->osd_timestamp_ ? clock : "off", this->osd_stats_ ? ", stats" : "",
+                  this->osd_motion_boxes_ && this->motion_enabled_ ? ", motion boxes" : "");
+  }
+  if (this->get_digital_zoom() > 1.0f) {
+    ESP_LOGCONFIG(TAG, "  Digital zoom: x%.2f", this->get_digital_zoom());
+  }
+  for (uint8_t i = 0; i < MAX_ROIS; i++) {
+    FrameRoi roi = this->get_roi(i);
+    if (!roi.is_full()) {
+      ESP_LOGCONFIG(TAG, "  ROI %u: %ux%u at (%u, %u)", i, roi.width, roi.height, roi.x, roi.y);
+    }
+  }
   ESP_LOGCONFIG(TAG, "  Streaming: %s", this->streaming_ ? "YES" : "NO");
+  const BootTiming &t = this->boot_timing_;
+  ESP_LOGCONFIG(TAG, "  Boot: %.1f ms (clock %.1f, power-up %.1f, CSI/ISP %.1f, buffers %.1f, sensor wait %.1f)",
+                t.setup_us / 1000.0f, t.clock_us / 1000.0f, t.power_up_us / 1000.0f, t.backend_us / 1000.0f,
+                t.buffers_us / 1000.0f, t.sensor_wait_us / 1000.0f);
+  ESP_LOGCONFIG(TAG, "  Sensor init: %.1f ms (in parallel with CSI/ISP and buffers)", t.sensor_init_us / 1000.0f);
+  if (t.boot_to_frame_us != 0) {
+    ESP_LOGCONFIG(TAG, "  First frame: %.1f ms after stream start, %.1f ms after boot", t.stream_to_frame_us / 1000.0f,
+                  t.boot_to_frame_us / 1000.0f);
+  } else {
+    ESP_LOGCONFIG(TAG, "  First frame: pending");
+  }
 }
 
 // Méthodes publiques pour contrôle
 void MipiDsiCam::set_auto_exposure(bool enabled) {
   this->auto_exposure_enabled_ = enabled;
+  this->auto_exposure_.reset(this->current_exposure_, this->current_gain_index_);
   ESP_LOGI(TAG, "Auto Exposure: %s", enabled ? "ENABLED" : "DISABLED");
 }
 
 void MipiDsiCam::set_ae_target_brightness(uint8_t target) {
   this->ae_target_brightness_ = target;
+  this->auto_exposure_.set_target(target);
   ESP_LOGI(TAG, "AE target brightness: %u", target);
 }
 
 void MipiDsiCam::set_manual_exposure(uint16_t exposure) {
-  this->current_exposure_ = exposure;
-  if (this->sensor_driver_) {
-    this->sensor_driver_->set_exposure(exposure);
-    ESP_LOGI(TAG, "Manual exposure: 0x%04X", exposure);
+  if (!this->sensor_driver_) {
+    // Pas encore de capteur : appliqué au démarrage
+    this->current_exposure_ = exposure;
+    return;
+  }
+  if (this->apply_controls_(exposure, this->current_gain_index_, false) != ESP_OK) {
+    return;
   }
+  this->current_exposure_ = exposure;
+  this->auto_exposure_.reset(this->current_exposure_, this->current_gain_index_);
+  ESP_LOGI(TAG, "Manual exposure: 0x%04X", exposure);
 }
 
 void MipiDsiCam::set_manual_gain(uint8_t gain_index) {
-  this->current_gain_index_ = gain_index;
-  if (this->sensor_driver_) {
-    this->sensor_driver_->set_gain(gain_index);
-    ESP_LOGI(TAG, "Manual gain: %u", gain_index);
+  if (!this->sensor_driver_) {
+    this->current_gain_index_ = gain_index;
+    return;
+  }
+  if (this->apply_controls_(this->current_exposure_, gain_index, false) != ESP_OK) {
+    return;
   }
+  this->current_gain_index_ = gain_index;
+  this->auto_exposure_.reset(this->current_exposure_, this->current_gain_index_);
+  ESP_LOGI(TAG, "Manual gain: %u", gain_index);
 }
 
 void MipiDsiCam::set_white_balance_gains(float red, float green, float blue) {
-  this->wb_red_gain_ = red;
-  this->wb_green_gain_ = green;
-  this->wb_blue_gain_ = blue;
-  
-  // Pour les capteurs supportant la balance des blancs au niveau registre
-  if (this->sensor_driver_ && (this->sensor_type_ == "sc202cs" || this->sensor_type_ == "sc2336")) {
-    // Appeler la méthode du driver si disponible
-    ESP_LOGI(TAG, "WB gains: R=%.2f G=%.2f B=%.2f (logiciel uniquement)", red, green, blue);
-  } else {
-    ESP_LOGI(TAG, "WB gains: R=%.2f G=%.2f B=%.2f", red, green, blue);
-  }
+  this->white_balance_.set_gains(red, green, blue);
+  this->update_processing_();
+  ESP_LOGI(TAG, "WB gains: R=%.2f G=%.2f B=%.2f (manuel)", this->white_balance_.get_red_gain(),
+           this->white_balance_.get_green_gain(), this->white_balance_.get_blue_gain());
+}
+
+void MipiDsiCam::set_awb_mode(AwbMode mode) {
+  this->white_balance_.set_mode(mode);
+  this->update_processing_();
+}
+
+void MipiDsiCam::set_tone_gamma(float gamma) {
+  this->tone_params_.gamma = gamma;
+  this->update_processing_();
+}
+
+void MipiDsiCam::set_tone_contrast(float contrast) {
+  this->tone_params_.contrast = contrast;
+  this->update_processing_();
+}
+
+void MipiDsiCam::set_tone_brightness(int8_t brightness) {
+  this->tone_params_.brightness = brightness < -100 ? -100 : (brightness > 100 ? 100 : brightness);
+  this->update_processing_();
+}
+
+void MipiDsiCam::set_tone_saturation(float saturation) {
+  this->tone_params_.saturation = saturation;
+  this->update_processing_();
 }
 
 void MipiDsiCam::adjust_exposure(uint16_t exposure_value) {
@@ -586,10 +1344,11 @@ void MipiDsiCam::adjust_exposure(uint16_t exposure_value) {
   }
   
   ESP_LOGI(TAG, "Adjusting exposure to: 0x%04X", exposure_value);
-  esp_err_t ret = this->sensor_driver_->set_exposure(exposure_value);
+  esp_err_t ret = this->apply_controls_(exposure_value, this->current_gain_index_, false);
   
   if (ret == ESP_OK) {
     this->current_exposure_ = exposure_value;
+    this->auto_exposure_.reset(this->current_exposure_, this->current_gain_index_);
     ESP_LOGI(TAG, "✅ Exposure adjusted successfully");
   } else {
     ESP_LOGE(TAG, "❌ Failed to adjust exposure");
@@ -603,10 +1362,11 @@ void MipiDsiCam::adjust_gain(uint8_t gain_index) {
   }
   
   ESP_LOGI(TAG, "Adjusting gain to index: %u", gain_index);
-  esp_err_t ret = this->sensor_driver_->set_gain(gain_index);
+  esp_err_t ret = this->apply_controls_(this->current_exposure_, gain_index, false);
   
   if (ret == ESP_OK) {
     this->current_gain_index_ = gain_index;
+    this->auto_exposure_.reset(this->current_exposure_, this->current_gain_index_);
     ESP_LOGI(TAG, "✅ Gain adjusted successfully");
   } else {
     ESP_LOGE(TAG, "❌ Failed to adjust gain");
@@ -614,7 +1374,18 @@ void MipiDsiCam::adjust_gain(uint8_t gain_index) {
 }
 
 void MipiDsiCam::set_brightness_level(uint8_t level) {
-  if (level > 10) level = 10;
+  // LUT, tâche tonale, publication et I2C appartiennent à la tâche loop
+  this->requested_brightness_level_.store(level > 10 ? 10 : level, std::memory_order_relaxed);
+}
+
+void MipiDsiCam::apply_brightness_level_(uint8_t level) {
+  if (this->auto_exposure_enabled_) {
+    // L'AE reprendrait la main sur exp/gain : décalage logiciel, 5 = neutre
+    int8_t brightness = ((int8_t) level - 5) * 10;
+    ESP_LOGI(TAG, "🔆 Setting brightness level %u: software offset %+d%%", level, brightness);
+    this->set_tone_brightness(brightness);
+    return;
+  }
   
   uint16_t exposure = 0x400 + (level * 0x0B0);
   uint8_t gain = level * 6;
@@ -629,5 +1400,3 @@ void MipiDsiCam::set_brightness_level(uint8_t level) {
 
 }  // namespace mipi_dsi_cam
 }  // namespace esphome
-
-#endif  // USE_ESP32_VARIANT_ESP32P4
@@ -2,25 +2,78 @@
 
 #include "esphome/core/component.h"
 #include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#ifdef USE_ESP32
 #include "esphome/components/i2c/i2c.h"
+#endif
+#include "auto_exposure.h"
+#include "capture_backend.h"
+#include "demosaic.h"
+#include "frame_metrics.h"
+#include "frame_pool.h"
+#include "frame_signature.h"
+#include "frame_stats.h"
+#include "frame_view.h"
+#include "motion_detector.h"
+#include "osd_overlay.h"
+#include "tone_mapper.h"
+#include "white_balance.h"
+#include <atomic>
 #include <string>
 
-#ifdef USE_ESP32_VARIANT_ESP32P4
-extern "C" {
-  #include "esp_cam_ctlr.h"
-  #include "esp_cam_ctlr_csi.h"
-  #include "driver/isp.h"
-  #include "esp_ldo_regulator.h"
-}
+#ifdef USE_BINARY_SENSOR
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#endif
+#ifdef USE_TIME
+#include "esphome/components/time/real_time_clock.h"
+#endif
+
+#ifdef USE_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#ifndef CONFIG_FREERTOS_UNICORE
+// La passe tonale est partagée entre les deux cœurs
+#define MIPI_DSI_CAM_SPLIT_PROCESSING
+#endif
 #endif
 
 namespace esphome {
 namespace mipi_dsi_cam {
 
-enum PixelFormat {
-  PIXEL_FORMAT_RGB565 = 0,
-  PIXEL_FORMAT_YUV422 = 1,
-  PIXEL_FORMAT_RAW8 = 2,
+// Référence sur une frame du pool, prise par MipiDsiCam::acquire_frame() et
+// rendue par release_frame() ; le DMA n'y écrit jamais entre-temps.
+struct FrameHandle {
+  int8_t slot{-1};
+  uint8_t *data{nullptr};
+  size_t size{0};
+  FrameInfo info{};
+
+  bool valid() const { return this->slot >= 0; }
+};
+
+// Durées du démarrage en µs (dump_config), les phases de setup() se suivent
+struct BootTiming {
+  uint32_t clock_us{0};
+  uint32_t power_up_us{0};     // reset -> capteur identifié sur I2C
+  uint32_t backend_us{0};      // LDO + CSI + ISP
+  uint32_t buffers_us{0};      // buffers, stats, LUT tonale
+  uint32_t sensor_wait_us{0};  // reste de l'init capteur après tout ça
+  uint32_t setup_us{0};
+  uint32_t sensor_init_us{0};  // tables d'init, en parallèle de backend/buffers
+  uint32_t stream_to_frame_us{0};
+  uint32_t boot_to_frame_us{0};
+};
+
+// Mode de capture du capteur (résolution / binning / fps), sélectionnable à chaud
+struct SensorMode {
+  const char *name;
+  uint16_t width;
+  uint16_t height;
+  uint8_t fps;
+  uint16_t lane_bitrate_mbps;
+  uint8_t bayer_pattern;
+  uint32_t exposure_max;
 };
 
 class ISensorDriver {
@@ -37,17 +90,51 @@ public:
   virtual uint16_t get_height() const = 0;
   virtual uint8_t get_fps() const = 0;
   
+  // Limites pour l'AE : gain (x1000) de chaque index, exposition en unités du capteur
+  virtual size_t get_gain_count() const = 0;
+  virtual uint32_t get_gain_value(uint32_t gain_index) const = 0;
+  virtual uint32_t get_exposure_min() const = 0;
+  virtual uint32_t get_exposure_max() const = 0;
+  // Frames encore exposées avec les anciens réglages après un commit exp/gain
+  virtual uint8_t get_apply_delay_frames() const = 0;
+  // Borne du réveil après reset (ms) : le capteur est sondé sur I2C jusque-là, 0 = pas de sondage
+  virtual uint16_t get_power_up_ms() const = 0;
+  // Group hold : set_exposure_gain() est appliqué atomiquement au début d'une frame
+  virtual bool has_group_hold() const { return false; }
+
+  // Table des modes ; le mode 0 est celui de init(). Les getters ci-dessus
+  // (taille, fps, bitrate, bayer, exposition max) suivent le mode courant.
+  virtual uint8_t get_mode_count() const { return 1; }
+  // Un seul mode : tout index y retombe, comme hors limites dans les drivers générés
+  virtual SensorMode get_mode(uint8_t /*index*/) const {
+    return {"default", this->get_width(), this->get_height(), this->get_fps(),
+            this->get_lane_bitrate_mbps(), this->get_bayer_pattern(), this->get_exposure_max()};
+  }
+  virtual uint8_t get_current_mode() const { return 0; }
+  // Flux arrêté uniquement
+  virtual esp_err_t set_mode(uint8_t index) { return index == 0 ? ESP_OK : ESP_ERR_NOT_SUPPORTED; }
+
   virtual esp_err_t init() = 0;
   virtual esp_err_t read_id(uint16_t* pid) = 0;
   virtual esp_err_t start_stream() = 0;
   virtual esp_err_t stop_stream() = 0;
   virtual esp_err_t set_gain(uint32_t gain_index) = 0;
   virtual esp_err_t set_exposure(uint32_t exposure) = 0;
+  // Sans group hold : deux écritures successives, l'appelant les place dans le blanking
+  virtual esp_err_t set_exposure_gain(uint32_t exposure, uint32_t gain_index) {
+    esp_err_t ret = this->set_exposure(exposure);
+    return ret != ESP_OK ? ret : this->set_gain(gain_index);
+  }
   virtual esp_err_t write_register(uint16_t reg, uint8_t value) = 0;
   virtual esp_err_t read_register(uint16_t reg, uint8_t* value) = 0;
 };
 
+#ifdef USE_ESP32
 class MipiDsiCam : public Component, public i2c::I2CDevice {
+#else
+// Host : le capteur mock n'a pas de bus, le composant i2c n'est pas compilé
+class MipiDsiCam : public Component {
+#endif
  public:
   void setup() override;
   void loop() override;
@@ -65,29 +152,161 @@ class MipiDsiCam : public Component, public i2c::I2CDevice {
   void set_lane_bitrate(uint16_t mbps) { this->lane_bitrate_mbps_ = mbps; }
   void set_resolution(uint16_t w, uint16_t h) { this->width_ = w; this->height_ = h; }
   void set_pixel_format(PixelFormat format) { this->pixel_format_ = format; }
+  // Debayer logiciel des frames RAW8 (consommateurs qui veulent de la couleur)
+  void set_demosaic_method(DemosaicMethod method) { this->demosaic_method_ = method; }
+  DemosaicMethod get_demosaic_method() const { return this->demosaic_method_; }
   void set_jpeg_quality(uint8_t quality) { this->jpeg_quality_ = quality; }
   void set_framerate(uint8_t fps) { this->framerate_ = fps; }
+  void set_frame_buffer_count(uint8_t count) { this->frame_buffer_count_ = count; }
+  // Source des frames ; par défaut CSI + ISP sur ESP32-P4, CSI virtuel sur host
+  void set_capture_backend(CaptureBackend *backend) { this->backend_ = backend; }
+  CaptureBackend *get_capture_backend() const { return this->backend_; }
+  void set_stats_zones(uint8_t cols, uint8_t rows) {
+    this->stats_zone_cols_ = cols;
+    this->stats_zone_rows_ = rows;
+  }
+  void set_stats_budget_us(uint32_t budget_us) { this->stats_engine_.set_budget_us(budget_us); }
+  // Détection de mouvement sur la frame des statistiques (plan luma réduit)
+  void set_motion_config(const MotionConfig &config) {
+    this->motion_detector_.set_config(config);
+    this->motion_enabled_ = true;
+  }
+  void set_motion_budget_us(uint32_t budget_us) { this->motion_detector_.set_budget_us(budget_us); }
+  void add_motion_mask(const FrameRoi &mask) { this->motion_detector_.add_mask(mask); }
+#ifdef USE_BINARY_SENSOR
+  void set_motion_binary_sensor(binary_sensor::BinarySensor *sensor) {
+    this->motion_binary_sensor_ = sensor;
+    this->motion_enabled_ = true;
+  }
+#endif
 
-  bool capture_frame();
   bool start_streaming();
   bool stop_streaming();
   bool is_streaming() const { return this->streaming_; }
-  
-  uint8_t* get_image_data() { return this->current_frame_buffer_; }
+
+  // Changement de mode capteur sans redémarrage : flux arrêté, CSI/ISP
+  // reconstruits, mêmes buffers (alloués pour le plus grand mode).
+  uint8_t get_mode_count() const { return this->sensor_driver_ ? this->sensor_driver_->get_mode_count() : 0; }
+  uint8_t get_current_mode() const { return this->sensor_driver_ ? this->sensor_driver_->get_current_mode() : 0; }
+  int find_mode(const std::string &name) const;
+  bool set_mode(uint8_t index);
+  bool set_mode(const std::string &name);
+  uint32_t get_last_mode_switch_us() const { return this->mode_switch_us_; }
+  const BootTiming &get_boot_timing() const { return this->boot_timing_; }
+
+  // Frame la plus récente, référencée jusqu'à release_frame(). Appelable de n'importe quelle tâche.
+  FrameHandle acquire_frame();
+  void release_frame(FrameHandle &frame);
+  uint32_t get_dropped_frames() const { return this->frame_pool_.get_dropped_frames(); }
+  // Temps écoulé depuis la sortie de la frame du capteur (latence glass-to-consumer).
+  static int64_t get_frame_age_us(const FrameInfo &info);
+  // Latences par étape et compteurs du pipeline : la caméra mesure la
+  // capture, les consommateurs (web, LVGL) y ajoutent leurs étapes.
+  FrameMetrics &get_metrics() { return this->metrics_; }
+  // Format texte Prometheus (route /metrics du serveur web)
+  void write_metrics(std::string &out);
+  // Signature du contenu d'une frame acquise (calculée une fois par frame,
+  // partagée entre consommateurs). Un consommateur garde celle de ce qu'il a
+  // produit et demande ensuite si la scène a changé depuis cette frame-là.
+  FrameSignature get_frame_signature(const FrameHandle &frame);
+  bool has_content_changed(const FrameHandle &frame, const FrameSignature &since) {
+    return this->get_frame_signature(frame).differs(since, this->change_threshold_);
+  }
+  // Écart max de luma d'un bloc (0-255) en dessous duquel le contenu est inchangé
+  void set_change_threshold(uint8_t threshold) { this->change_threshold_ = threshold; }
+  uint8_t get_change_threshold() const { return this->change_threshold_; }
+  // Statistiques luma de la dernière frame (une seule passe, partagée AE/AWB/lambdas)
+  const FrameStats &get_frame_stats() const { return this->stats_; }
+  // Dernier résultat de la détection de mouvement (boîtes en pixels de la frame)
+  bool is_motion_enabled() const { return this->motion_enabled_; }
+  void set_motion_enabled(bool enabled);
+  const MotionResult &get_motion() const { return this->motion_; }
+  MotionDetector &get_motion_detector() { return this->motion_detector_; }
+  // Appelé au début et à la fin d'un mouvement (result.motion)
+  void add_on_motion_callback(std::function<void(const MotionResult &)> &&callback) {
+    this->motion_callback_.add(std::move(callback));
+    this->motion_enabled_ = true;
+  }
+
+  // Incrustation (nom, heure, fps, boîtes de mouvement) dans les frames
+  // avant publication : LVGL et le flux HTTP la montrent, sans copie de frame
+  void set_osd_config(const OsdConfig &config) {
+    this->osd_.set_config(config);
+    this->set_osd_enabled(true);
+  }
+  void set_osd_enabled(bool enabled);
+  bool is_osd_enabled() const { return this->osd_enabled_; }
+  // Première ligne ; vide = nom de la caméra
+  void set_osd_label(const std::string &label) {
+    this->osd_label_ = label;
+    this->osd_clock_key_ = UINT32_MAX;
+  }
+  void set_osd_timestamp(bool enabled) {
+    this->osd_timestamp_ = enabled;
+    this->osd_clock_key_ = UINT32_MAX;
+  }
+  void set_osd_stats(bool enabled) { this->osd_stats_ = enabled; }
+  void set_osd_motion_boxes(bool enabled) { this->osd_motion_boxes_ = enabled; }
+  // Ligne libre sous les autres (lambdas), vide = masquée
+  void set_osd_text(const std::string &text) { this->osd_text_ = text; }
+#ifdef USE_TIME
+  // Heure murale ; sans horloge (ou pas encore synchronisée) : temps depuis le boot
+  void set_osd_time(time::RealTimeClock *clock) { this->osd_time_ = clock; }
+#endif
+
+  // Régions d'intérêt et zoom numérique : des vues dans le buffer de la frame
+  // (pointeur + stride), aucune copie avant l'encodage / la mise à l'échelle.
+  static constexpr uint8_t MAX_ROIS = 4;
+  // En pixels, rognée à la frame ; une taille nulle désactive la ROI
+  bool set_roi(uint8_t id, const FrameRoi &roi);
+  void clear_roi(uint8_t id) { this->set_roi(id, FrameRoi{}); }
+  FrameRoi get_roi(uint8_t id) const;
+  bool has_roi(uint8_t id) const { return !this->get_roi(id).is_full(); }
+  // factor <= 1 : image entière. Centre en fraction de la frame (0..1),
+  // suit donc les changements de mode.
+  void set_digital_zoom(float factor, float center_x = 0.5f, float center_y = 0.5f);
+  float get_digital_zoom() const;
+  // Vues sur une frame acquise, valides jusqu'à release_frame()
+  FrameView get_frame_view(const FrameHandle &frame) const;
+  FrameView get_zoom_view(const FrameHandle &frame) const;
+  FrameView get_roi_view(const FrameHandle &frame, uint8_t id) const;
+
+  // Aides mono-consommateur gardées pour les lambdas existantes : capture_frame()
+  // échange la frame tenue en interne contre une plus récente, get_image_data() y pointe.
+  bool capture_frame();
+  uint8_t* get_image_data() { return this->current_frame_.data; }
   size_t get_image_size() const { return this->frame_buffer_size_; }
   uint16_t get_image_width() const { return this->width_; }
   uint16_t get_image_height() const { return this->height_; }
+  PixelFormat get_pixel_format() const { return this->pixel_format_; }
+  uint8_t get_bayer_pattern() const { return this->bayer_pattern_; }
   
   bool has_external_clock() const { return this->external_clock_pin_ >= 0; }
 
   // Auto Exposure et White Balance
   void set_auto_exposure(bool enabled);
   void set_ae_target_brightness(uint8_t target);
+  void set_ae_metering_mode(MeteringMode mode) { this->auto_exposure_.set_metering_mode(mode); }
+  // 0 = limite du capteur
+  void set_ae_exposure_limits(uint32_t min, uint32_t max) {
+    this->ae_exposure_min_ = min;
+    this->ae_exposure_max_ = max;
+  }
+  void set_ae_max_gain_index(uint32_t index) { this->auto_exposure_.set_gain_index_max(index); }
   void set_manual_exposure(uint16_t exposure);
   void set_manual_gain(uint8_t gain_index);
   void set_white_balance_gains(float red, float green, float blue);
+  void set_awb_mode(AwbMode mode);
+  const WhiteBalance &get_white_balance() const { return this->white_balance_; }
+  // Courbe tonale logicielle (0 I2C), appliquée avec la WB en une seule passe LUT
+  void set_tone_gamma(float gamma);
+  void set_tone_contrast(float contrast);
+  void set_tone_brightness(int8_t brightness);
+  void set_tone_saturation(float saturation);
+  const ToneParams &get_tone_params() const { return this->tone_params_; }
   void adjust_exposure(uint16_t exposure_value);
   void adjust_gain(uint8_t gain_index);
+  // Appelable depuis une autre tâche (httpd) : appliqué par loop()
   void set_brightness_level(uint8_t level);
 
  protected:
@@ -105,64 +324,178 @@ class MipiDsiCam : public Component, public i2c::I2CDevice {
   
   std::string name_{"MIPI Camera"};
   PixelFormat pixel_format_{PIXEL_FORMAT_RGB565};
+  DemosaicMethod demosaic_method_{DEMOSAIC_BILINEAR};
   uint8_t jpeg_quality_{10};
   uint8_t framerate_{30};
 
   bool initialized_{false};
   bool streaming_{false};
-  bool frame_ready_{false};
+  uint32_t mode_switch_us_{0};
+  int64_t mode_switch_start_us_{0};  // jusqu'à la première frame du nouveau mode
+  BootTiming boot_timing_;
+  int64_t boot_start_us_{0};
+  int64_t stream_start_us_{0};  // jusqu'à la première frame
+  bool sensor_init_ok_{false};
+#ifdef USE_ESP32
+  SemaphoreHandle_t sensor_init_done_{nullptr};
+#endif
   
-  uint32_t total_frames_received_{0};
+  FrameMetrics metrics_;
+  uint32_t last_capture_us_{0};  // contexte de capture uniquement, 0 = pas encore de frame
   uint32_t last_frame_log_time_{0};
+  uint32_t logged_captured_{0};
+  uint32_t logged_displayed_{0};
+  uint32_t logged_display_skipped_{0};
+  uint32_t logged_jpeg_reused_{0};
+  uint32_t logged_display_paced_{0};
+  // Fenêtre du log périodique : percentiles des seules 3 dernières secondes
+  LatencyHistogram::Snapshot logged_display_;
+  LatencyHistogram::Snapshot logged_render_;
+  LatencyHistogram::Snapshot logged_client_;
   
-  uint8_t *frame_buffers_[2]{nullptr, nullptr};
-  uint8_t *current_frame_buffer_{nullptr};
-  size_t frame_buffer_size_{0};
-  uint8_t buffer_index_{0};
+  uint8_t frame_buffer_count_{4};
+  uint8_t *frame_buffers_[FramePool::MAX_SLOTS]{};
+  size_t frame_buffer_size_{0};      // frame du mode courant
+  size_t frame_buffer_capacity_{0};  // buffers alloués (plus grand mode)
+  FramePool frame_pool_;
+  FrameHandle current_frame_;
+  
+  FrameStatsEngine stats_engine_;
+  FrameStats stats_;
+  FrameInfo stats_info_;  // frame d'origine des stats
+  uint8_t stats_zone_cols_{8};
+  uint8_t stats_zone_rows_{8};
+
+  // Une signature par slot du pool, valable pour la frame `sequence` : tant
+  // qu'une frame est tenue son slot n'est pas réécrit, donc une signature
+  // publiée ne change plus
+  struct SignatureSlot {
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<bool> busy{false};
+    FrameSignature signature;
+  };
+  SignatureSlot signatures_[FramePool::MAX_SLOTS];
+  uint8_t change_threshold_{4};
+
+  bool motion_enabled_{false};
+  MotionDetector motion_detector_;
+  MotionResult motion_;
+  CallbackManager<void(const MotionResult &)> motion_callback_;
+#ifdef USE_BINARY_SENSOR
+  binary_sensor::BinarySensor *motion_binary_sensor_{nullptr};
+#endif
+
+  bool osd_enabled_{false};
+  OsdOverlay osd_;
+  std::string osd_label_;
+  std::string osd_text_;
+  bool osd_timestamp_{true};
+  bool osd_stats_{false};
+  bool osd_motion_boxes_{true};
+  float osd_fps_{0.0f};
+  uint32_t osd_fps_captured_{0};
+  uint32_t osd_fps_time_{0};
+  // Seconde affichée par la ligne d'horloge, UINT32_MAX = à reconstruire
+  uint32_t osd_clock_key_{UINT32_MAX};
+  char osd_stats_line_[64]{};
+#ifdef USE_TIME
+  time::RealTimeClock *osd_time_{nullptr};
+#endif
+
+  std::atomic<uint64_t> rois_[MAX_ROIS]{};
+  // Fenêtre de zoom en 1/ZOOM_SCALE de la frame (FrameRoi::pack)
+  static constexpr uint16_t ZOOM_SCALE = 10000;
+  std::atomic<uint64_t> zoom_{0};
   
   ISensorDriver *sensor_driver_{nullptr};
+  CaptureBackend *backend_{nullptr};
 
   // Auto Exposure
   bool auto_exposure_enabled_{false};
   uint16_t current_exposure_{0x9C0};
   uint8_t current_gain_index_{20};
   uint32_t ae_target_brightness_{128};
-  uint32_t last_ae_update_{0};
+  uint32_t ae_exposure_min_{0};
+  uint32_t ae_exposure_max_{0};
+  AutoExposure auto_exposure_;
+  uint32_t ae_stale_frames_{0};
+  uint32_t control_write_failures_{0};
   
-  // White Balance correction
-  float wb_red_gain_{1.3f};
-  float wb_green_gain_{0.9f};
-  float wb_blue_gain_{1.1f};
+  // Réglages exp/gain : stagés par l'AE, commités en une fois (group hold ou
+  // blanking vertical), en vigueur N frames plus tard (FrameInfo)
+  bool controls_pending_{false};
+  uint8_t apply_delay_frames_{2};
+  uint32_t blanking_window_us_{0};
+  HighFrequencyLoopRequester high_freq_;
+  std::atomic<uint32_t> frames_done_{0};
+  std::atomic<uint32_t> last_frame_done_us_{0};
+  std::atomic<uint32_t> inflight_controls_{0};  // exposure | gain_index << 16
+  std::atomic<uint32_t> inflight_from_frame_{0};
+  uint32_t effective_controls_{0};  // contexte de capture uniquement
   
-#ifdef USE_ESP32_VARIANT_ESP32P4
-  esp_cam_ctlr_handle_t csi_handle_{nullptr};
-  isp_proc_handle_t isp_handle_{nullptr};
-  esp_ldo_channel_handle_t ldo_handle_{nullptr};
-  isp_awb_ctlr_t awb_ctlr_{nullptr};
+  // White Balance + courbe tonale logicielles (appliquées avant publication des frames)
+  WhiteBalance white_balance_;
+  ToneParams tone_params_;
+  ToneMapper tone_mapper_;
+  uint16_t *tone_lut_{nullptr};
+  uint32_t processing_us_{0};
+  // Tenu tant que loop() publie les frames (LUT ou OSD actifs)
+  HighFrequencyLoopRequester processing_high_freq_;
+  // Niveau demandé par set_brightness_level(), NO_BRIGHTNESS_REQUEST sinon
+  static const uint8_t NO_BRIGHTNESS_REQUEST = 0xFF;
+  std::atomic<uint8_t> requested_brightness_level_{NO_BRIGHTNESS_REQUEST};
+#ifdef MIPI_DSI_CAM_SPLIT_PROCESSING
+  TaskHandle_t tone_worker_{nullptr};
+  SemaphoreHandle_t tone_done_{nullptr};
+  uint8_t *tone_frame_{nullptr};
+  size_t tone_split_{0};
+  size_t tone_end_{0};
+#endif
   
   bool create_sensor_driver_();
+  bool power_up_sensor_();
   bool init_sensor_();
+  void start_sensor_init_();
+  bool finish_sensor_init_();
+  void read_sensor_mode_();
+  CaptureConfig make_capture_config_() const;
+  void configure_auto_exposure_();
   bool init_external_clock_();
-  bool init_ldo_();
-  bool init_csi_();
-  bool init_isp_();
+  bool init_backend_();
   bool allocate_buffer_();
   
-  void configure_white_balance_();
+  // La LUT tonale / WB est RGB565 -> RGB565 : sans effet sur YUV422 / RAW8
+  bool is_tone_mapping_() const {
+    return this->pixel_format_ == PIXEL_FORMAT_RGB565 &&
+           (this->white_balance_.is_active() || !this->tone_params_.is_identity());
+  }
+  // Frames retouchées avant publication (LUT tonale, incrustation)
+  bool is_processing_() const { return this->is_tone_mapping_() || this->osd_enabled_; }
+  void update_processing_();
+  bool init_tone_mapper_();
+  // Frame en attente retouchée puis publiée ; true : nouvelles stats, prises
+  // avant la LUT et l'incrustation
+  bool process_pending_frame_();
+  // true : stats de cette frame calculées (le mouvement l'est dans tous les cas)
+  bool analyse_frame_(const FrameView &view, const FrameInfo &info);
+  void update_osd_(const FrameInfo &info);
+  bool update_stats_();
+  void update_motion_(const FrameView &view, uint32_t sequence);
+  void record_first_frame_();
+  void log_pipeline_();
   void update_auto_exposure_();
-  uint32_t calculate_brightness_();
+  void commit_controls_();
+  esp_err_t apply_controls_(uint32_t exposure, uint32_t gain_index, bool in_blanking);
+  void apply_brightness_level_(uint8_t level);
   
-  static bool IRAM_ATTR on_csi_new_frame_(
-    esp_cam_ctlr_handle_t handle,
-    esp_cam_ctlr_trans_t *trans,
-    void *user_data
-  );
-  
-  static bool IRAM_ATTR on_csi_frame_done_(
-    esp_cam_ctlr_handle_t handle,
-    esp_cam_ctlr_trans_t *trans,
-    void *user_data
-  );
+  // Appelés depuis le contexte de capture du backend (ISR / thread host)
+  static uint8_t *IRAM_ATTR on_new_frame_(void *arg);
+  static void IRAM_ATTR on_frame_done_(void *arg, uint8_t *buffer, size_t received_size);
+#ifdef USE_ESP32
+  static void sensor_init_task_(void *arg);
+#endif
+#ifdef MIPI_DSI_CAM_SPLIT_PROCESSING
+  static void tone_worker_task_(void *arg);
 #endif
 };
 
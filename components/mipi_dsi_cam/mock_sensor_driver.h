@@ -0,0 +1,111 @@
+#pragma once
+
+#include "mipi_dsi_cam.h"
+#include <map>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Capteur sans matériel derrière, associé au backend CSI virtuel. Les
+// écritures de registres finissent dans une map et exposition / gain sont
+// seulement mémorisés : l'AE et les contrôles tournent tels quels et restent
+// inspectables.
+//
+// Mode 0 : la taille configurée ; mode 1 : binning 2x2 à cadence double.
+class MockSensorDriver : public ISensorDriver {
+public:
+  static constexpr uint16_t PID = 0x0000;
+
+  MockSensorDriver(uint16_t width, uint16_t height, uint8_t fps)
+      : width_(width), height_(height), fps_(fps) {}
+
+  const char* get_name() const override { return "Mock"; }
+  uint16_t get_pid() const override { return PID; }
+  uint8_t get_i2c_address() const override { return 0x00; }
+  uint8_t get_lane_count() const override { return 2; }
+  uint8_t get_bayer_pattern() const override { return 0; }
+  uint16_t get_lane_bitrate_mbps() const override { return 800; }
+  uint16_t get_width() const override { return this->width_ >> this->mode_; }
+  uint16_t get_height() const override { return this->height_ >> this->mode_; }
+  uint8_t get_fps() const override { return this->fps_ << this->mode_; }
+
+  // x1 .. x16.75 par pas de 1/4
+  size_t get_gain_count() const override { return 64; }
+  uint32_t get_gain_value(uint32_t gain_index) const override { return 1000 + (gain_index < 64 ? gain_index : 63) * 250; }
+  uint32_t get_exposure_min() const override { return 0x10; }
+  uint32_t get_exposure_max() const override { return 0x3000; }
+  uint8_t get_apply_delay_frames() const override { return 1; }
+  // Pas de bus I2C derrière : rien à sonder
+  uint16_t get_power_up_ms() const override { return 0; }
+
+  uint8_t get_mode_count() const override { return 2; }
+  SensorMode get_mode(uint8_t index) const override {
+    uint8_t shift = index != 0 ? 1 : 0;
+    return {shift ? "binned" : "full", (uint16_t) (this->width_ >> shift), (uint16_t) (this->height_ >> shift),
+            (uint8_t) (this->fps_ << shift), this->get_lane_bitrate_mbps(), this->get_bayer_pattern(),
+            this->get_exposure_max()};
+  }
+  uint8_t get_current_mode() const override { return this->mode_; }
+  esp_err_t set_mode(uint8_t index) override {
+    if (index >= this->get_mode_count() || this->streaming_) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    this->mode_ = index;
+    return ESP_OK;
+  }
+
+  esp_err_t init() override {
+    this->mode_ = 0;
+    return ESP_OK;
+  }
+  esp_err_t read_id(uint16_t* pid) override {
+    *pid = PID;
+    return ESP_OK;
+  }
+  esp_err_t start_stream() override {
+    this->streaming_ = true;
+    return ESP_OK;
+  }
+  esp_err_t stop_stream() override {
+    this->streaming_ = false;
+    return ESP_OK;
+  }
+  esp_err_t set_gain(uint32_t gain_index) override {
+    this->gain_index_ = gain_index;
+    this->control_writes_++;
+    return ESP_OK;
+  }
+  esp_err_t set_exposure(uint32_t exposure) override {
+    this->exposure_ = exposure;
+    this->control_writes_++;
+    return ESP_OK;
+  }
+  esp_err_t write_register(uint16_t reg, uint8_t value) override {
+    this->registers_[reg] = value;
+    return ESP_OK;
+  }
+  esp_err_t read_register(uint16_t reg, uint8_t* value) override {
+    auto it = this->registers_.find(reg);
+    *value = it != this->registers_.end() ? it->second : 0;
+    return ESP_OK;
+  }
+
+  bool is_streaming() const { return this->streaming_; }
+  uint32_t get_exposure() const { return this->exposure_; }
+  uint32_t get_gain_index() const { return this->gain_index_; }
+  uint32_t get_control_writes() const { return this->control_writes_; }
+
+protected:
+  uint16_t width_;
+  uint16_t height_;
+  uint8_t fps_;
+  uint8_t mode_{0};
+  bool streaming_{false};
+  uint32_t exposure_{0};
+  uint32_t gain_index_{0};
+  uint32_t control_writes_{0};
+  std::map<uint16_t, uint8_t> registers_;
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
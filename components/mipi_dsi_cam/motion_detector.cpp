@@ -0,0 +1,331 @@
+#include "motion_detector.h"
+#include "pixel_convert.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+template<typename T> static inline T clamp_range(T value, T low, T high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+void MotionDetector::set_config(const MotionConfig &config) {
+  this->config_ = config;
+  this->config_.plane_width = clamp_range<uint16_t>(config.plane_width, 8, MAX_PLANE_WIDTH);
+  this->config_.plane_height = clamp_range<uint16_t>(config.plane_height, 8, MAX_PLANE_HEIGHT);
+  this->config_.cell_size = clamp_range<uint8_t>(config.cell_size, 1, 16);
+  this->config_.sensitivity = clamp_range(config.sensitivity, 0.0f, 1.0f);
+  this->config_.min_area = clamp_range(config.min_area, 0.0f, 1.0f);
+  this->config_.learning_rate = clamp_range(config.learning_rate, 0.0f, 1.0f);
+
+  // 0 % -> 64 niveaux de luma, 100 % -> 8 (sous ça, le bruit capteur suffit)
+  this->threshold_ = 8 + (uint8_t) ((1.0f - this->config_.sensitivity) * 56.0f);
+  this->rate_q8_ = clamp_range<uint16_t>((uint16_t) (this->config_.learning_rate * 256.0f + 0.5f), 1, 256);
+  // Géométrie refaite à la prochaine frame
+  this->width_ = 0;
+  this->height_ = 0;
+}
+
+bool MotionDetector::add_mask(const FrameRoi &mask) {
+  if (this->mask_count_ >= MAX_MASKS || mask.is_full())
+    return false;
+  this->masks_[this->mask_count_++] = mask;
+  if (this->width_ != 0)
+    this->update_mask_();
+  return true;
+}
+
+void MotionDetector::clear_masks() {
+  this->mask_count_ = 0;
+  if (this->width_ != 0)
+    this->update_mask_();
+}
+
+void MotionDetector::layout_(uint16_t width, uint16_t height) {
+  this->width_ = width;
+  this->height_ = height;
+  this->plane_w_ = this->config_.plane_width < width ? this->config_.plane_width : width;
+  this->plane_h_ = this->config_.plane_height < height ? this->config_.plane_height : height;
+  const uint8_t cs = this->config_.cell_size;
+  this->cell_cols_ = this->plane_w_ >= cs ? this->plane_w_ / cs : 1;
+  this->cell_rows_ = this->plane_h_ >= cs ? this->plane_h_ / cs : 1;
+
+  const size_t pixels = (size_t) this->plane_w_ * this->plane_h_;
+  const size_t cells = (size_t) this->cell_cols_ * this->cell_rows_;
+  this->plane_.assign(pixels, 0);
+  this->background_.assign(pixels, 0);
+  this->cell_score_.assign(cells, 0);
+  this->cell_changed_.assign(cells, 0);
+  this->cell_masked_.assign(cells, 0);
+  this->cell_label_.assign(cells, 0);
+  this->cell_stack_.assign(cells, 0);
+  this->sample_x_.clear();
+  this->has_background_ = false;
+  this->update_mask_();
+}
+
+void MotionDetector::update_mask_() {
+  const uint8_t cs = this->config_.cell_size;
+  for (uint8_t row = 0; row < this->cell_rows_; row++) {
+    // Centre de la cellule en pixels de la frame
+    uint32_t cy = ((uint32_t) row * cs * 2 + cs) * this->height_ / (2u * this->plane_h_);
+    for (uint8_t col = 0; col < this->cell_cols_; col++) {
+      uint32_t cx = ((uint32_t) col * cs * 2 + cs) * this->width_ / (2u * this->plane_w_);
+      uint8_t masked = 0;
+      for (uint8_t m = 0; m < this->mask_count_; m++) {
+        const FrameRoi &mask = this->masks_[m];
+        if (cx >= mask.x && cx < (uint32_t) mask.x + mask.width && cy >= mask.y && cy < (uint32_t) mask.y + mask.height)
+          masked = 1;
+      }
+      this->cell_masked_[row * this->cell_cols_ + col] = masked;
+    }
+  }
+}
+
+void MotionDetector::adapt(uint32_t elapsed_us) {
+  if (elapsed_us > this->budget_us_ && this->samples_ > 1) {
+    this->samples_--;
+  } else if (elapsed_us < this->budget_us_ / 2 && this->samples_ < MAX_SAMPLES) {
+    this->samples_++;
+  }
+}
+
+void MotionDetector::downsample_(const FrameView &view) {
+  const uint16_t pw = this->plane_w_;
+  const uint16_t ph = this->plane_h_;
+  // Échantillons par côté de boîte, bornés par la taille de la boîte
+  const uint16_t kx = clamp_range<uint16_t>(this->samples_, 1, view.width / pw);
+  const uint16_t ky = clamp_range<uint16_t>(this->samples_, 1, view.height / ph);
+  const uint16_t row_samples = pw * kx;
+  const uint32_t row_span = (uint32_t) ph * ky;
+  const uint16_t divisor = kx * ky;
+
+  // Colonnes échantillonnées, centrées dans leur part de boîte (refaites si
+  // le nombre d'échantillons change)
+  if (this->sample_x_.size() != row_samples) {
+    this->sample_x_.resize(row_samples);
+    for (uint32_t i = 0; i < row_samples; i++) {
+      this->sample_x_[i] = (i * 2 + 1) * view.width / (2u * row_samples);
+    }
+  }
+  const uint16_t *sample_x = this->sample_x_.data();
+
+  uint16_t acc[MAX_PLANE_WIDTH];
+  uint8_t *plane = this->plane_.data();
+
+  for (uint16_t py = 0; py < ph; py++) {
+    memset(acc, 0, pw * sizeof(uint16_t));
+    for (uint16_t j = 0; j < ky; j++) {
+      const uint32_t y = ((py * ky + j) * 2u + 1) * view.height / (2u * row_span);
+      const uint16_t *xs = sample_x;
+      switch (view.format) {
+        case PIXEL_FORMAT_YUV422: {
+          // Y0 U Y1 V : la luma du pixel x est l'octet 2x
+          const uint8_t *row = view.row(y);
+          for (uint16_t px = 0; px < pw; px++) {
+            uint32_t box = 0;
+            for (uint16_t s = 0; s < kx; s++) {
+              box += row[*xs++ * 2u];
+            }
+            acc[px] += box;
+          }
+          break;
+        }
+        case PIXEL_FORMAT_RAW8: {
+          // Quad 2x2 : (R + 2G + B) / 4, assez proche de la luma pour un écart au fond
+          const uint32_t qy = (y & ~1u) + 1 < view.height ? y & ~1u : view.height - 2;
+          const uint8_t *top = view.row(qy);
+          const uint8_t *bottom = view.row(qy + 1);
+          for (uint16_t px = 0; px < pw; px++) {
+            uint32_t box = 0;
+            for (uint16_t s = 0; s < kx; s++) {
+              uint32_t qx = *xs++ & ~1u;
+              if (qx + 1 >= view.width)
+                qx = view.width - 2;
+              box += (top[qx] + top[qx + 1] + bottom[qx] + bottom[qx + 1] + 2) >> 2;
+            }
+            acc[px] += box;
+          }
+          break;
+        }
+        default: {
+          const uint16_t *row = (const uint16_t *) view.row(y);
+          for (uint16_t px = 0; px < pw; px++) {
+            uint32_t box = 0;
+            for (uint16_t s = 0; s < kx; s++) {
+              uint32_t p = row[*xs++];
+              box += luma565(p >> 11, (p >> 5) & 0x3F, p & 0x1F);
+            }
+            acc[px] += box;
+          }
+          break;
+        }
+      }
+    }
+    uint8_t *dst = plane + (size_t) py * pw;
+    for (uint16_t px = 0; px < pw; px++) {
+      dst[px] = acc[px] / divisor;
+    }
+  }
+}
+
+void MotionDetector::process(const FrameView &view, uint32_t sequence, MotionResult &out) {
+  out = MotionResult{};
+  out.sequence = sequence;
+  if (!view.valid())
+    return;
+  if (view.width != this->width_ || view.height != this->height_)
+    this->layout_(view.width, view.height);
+
+  this->downsample_(view);
+
+  const uint16_t pw = this->plane_w_;
+  const uint16_t ph = this->plane_h_;
+  const uint8_t cs = this->config_.cell_size;
+  const uint8_t cols = this->cell_cols_;
+  const uint16_t cells = (uint16_t) cols * this->cell_rows_;
+  const uint8_t *plane = this->plane_.data();
+  uint16_t *background = this->background_.data();
+
+  if (!this->has_background_) {
+    for (size_t i = 0; i < this->plane_.size(); i++) {
+      background[i] = plane[i] << 8;
+    }
+    memset(this->cell_score_.data(), 0, cells);
+    this->has_background_ = true;
+    return;
+  }
+
+  // Différence au fond + mise à jour du fond, une seule passe
+  uint16_t *changed = this->cell_changed_.data();
+  memset(changed, 0, cells * sizeof(uint16_t));
+  const int32_t threshold = this->threshold_;
+  const int32_t rate = this->rate_q8_;
+  // Sous un objet, le fond apprend 4x moins vite
+  const int32_t foreground_rate = rate > 4 ? rate / 4 : 1;
+  for (uint16_t py = 0; py < ph; py++) {
+    const uint8_t *cur = plane + (size_t) py * pw;
+    uint16_t *bg = background + (size_t) py * pw;
+    const uint16_t cy = py / cs;
+    uint16_t *row_changed = cy < this->cell_rows_ ? changed + cy * cols : nullptr;
+    uint8_t cx = 0, in_cell = 0;
+    for (uint16_t px = 0; px < pw; px++) {
+      const int32_t value = (int32_t) cur[px] << 8;
+      const int32_t delta = value - bg[px];
+      const bool moved = abs(delta) > (threshold << 8);
+      bg[px] += (delta * (moved ? foreground_rate : rate)) >> 8;
+      if (moved && row_changed != nullptr && cx < cols)
+        row_changed[cx]++;
+      if (++in_cell == cs) {
+        in_cell = 0;
+        cx++;
+      }
+    }
+  }
+
+  // Scores des cellules
+  const uint16_t cell_pixels = (uint16_t) cs * cs;
+  uint16_t active = 0, unmasked = 0;
+  uint32_t changed_pixels = 0;
+  for (uint16_t c = 0; c < cells; c++) {
+    const uint8_t score = changed[c] * 100 / cell_pixels;
+    this->cell_score_[c] = score;
+    const bool counted = !this->cell_masked_[c];
+    const bool is_active = counted && score >= CELL_ACTIVE_PERCENT;
+    this->cell_label_[c] = is_active ? 1 : 0;
+    active += is_active;
+    unmasked += counted;
+    changed_pixels += counted ? changed[c] : 0;
+  }
+  out.active_cells = active;
+  out.changed_percent = unmasked != 0 ? changed_pixels * 100.0f / ((uint32_t) unmasked * cell_pixels) : 0.0f;
+
+  if (unmasked != 0 && (uint32_t) active * 100 > (uint32_t) unmasked * GLOBAL_CHANGE_PERCENT) {
+    // Pas un objet : le fond repart de cette frame
+    out.global_change = true;
+    for (size_t i = 0; i < this->plane_.size(); i++) {
+      background[i] = plane[i] << 8;
+    }
+    return;
+  }
+
+  out.box_count = this->find_regions_(out);
+  out.motion = out.box_count != 0;
+}
+
+uint8_t MotionDetector::find_regions_(MotionResult &out) {
+  struct Region {
+    uint16_t cells;
+    uint8_t x0, y0, x1, y1;
+  };
+  Region regions[MotionResult::MAX_BOXES];
+  uint8_t count = 0;
+
+  const uint8_t cols = this->cell_cols_;
+  const uint8_t rows = this->cell_rows_;
+  const uint16_t cells = (uint16_t) cols * rows;
+  uint16_t min_cells = (uint16_t) (this->config_.min_area * cells + 0.999f);
+  if (min_cells < 1)
+    min_cells = 1;
+  uint8_t *label = this->cell_label_.data();  // 1 = actif non visité, 2 = visité
+  uint16_t *stack = this->cell_stack_.data();
+
+  for (uint16_t seed = 0; seed < cells; seed++) {
+    if (label[seed] != 1)
+      continue;
+    // Croissance 4-connexe
+    Region region{0, (uint8_t) (seed % cols), (uint8_t) (seed / cols), (uint8_t) (seed % cols),
+                  (uint8_t) (seed / cols)};
+    uint16_t top = 0;
+    stack[top++] = seed;
+    label[seed] = 2;
+    while (top != 0) {
+      const uint16_t c = stack[--top];
+      const uint8_t x = c % cols, y = c / cols;
+      region.cells++;
+      region.x0 = x < region.x0 ? x : region.x0;
+      region.x1 = x > region.x1 ? x : region.x1;
+      region.y0 = y < region.y0 ? y : region.y0;
+      region.y1 = y > region.y1 ? y : region.y1;
+      const int32_t neighbours[4] = {x > 0 ? c - 1 : -1, x + 1 < cols ? c + 1 : -1, y > 0 ? c - cols : -1,
+                                     y + 1 < rows ? c + cols : -1};
+      for (int32_t n : neighbours) {
+        if (n >= 0 && label[n] == 1) {
+          label[n] = 2;
+          stack[top++] = n;
+        }
+      }
+    }
+    if (region.cells < min_cells)
+      continue;
+    // Garder les plus grandes, triées
+    uint8_t pos = count < MotionResult::MAX_BOXES ? count++ : MotionResult::MAX_BOXES;
+    if (pos == MotionResult::MAX_BOXES) {
+      if (region.cells <= regions[MotionResult::MAX_BOXES - 1].cells)
+        continue;
+      pos = MotionResult::MAX_BOXES - 1;
+    }
+    while (pos > 0 && regions[pos - 1].cells < region.cells) {
+      regions[pos] = regions[pos - 1];
+      pos--;
+    }
+    regions[pos] = region;
+  }
+
+  // Cellules -> pixels de la frame
+  const uint32_t cs = this->config_.cell_size;
+  for (uint8_t i = 0; i < count; i++) {
+    const Region &r = regions[i];
+    const uint32_t x0 = r.x0 * cs * this->width_ / this->plane_w_;
+    const uint32_t y0 = r.y0 * cs * this->height_ / this->plane_h_;
+    const uint32_t x1 = (r.x1 + 1u) * cs * this->width_ / this->plane_w_;
+    const uint32_t y1 = (r.y1 + 1u) * cs * this->height_ / this->plane_h_;
+    out.boxes[i] = FrameRoi{(uint16_t) x0, (uint16_t) y0, (uint16_t) (x1 - x0), (uint16_t) (y1 - y0)};
+  }
+  return count;
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_view.h"
+
+// Détection de mouvement embarquée, sur un plan de luminance réduit (~1 ms par frame).
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Résultat d'un MotionDetector::process() (MipiDsiCam::get_motion(),
+// on_motion_start / on_motion_end).
+struct MotionResult {
+  static constexpr uint8_t MAX_BOXES = 8;
+
+  uint32_t sequence{0};  // frame analysée, 0 = pas encore
+  bool motion{false};
+  // Presque toute la frame a changé d'un coup (pas d'exposition, lumière) :
+  // fond réinitialisé, pas signalé comme mouvement
+  bool global_change{false};
+  uint16_t active_cells{0};
+  float changed_percent{0.0f};  // pixels du plan changés, zone non masquée
+  // Plus grandes régions en mouvement d'abord, en pixels de la frame
+  uint8_t box_count{0};
+  FrameRoi boxes[MAX_BOXES]{};
+  uint32_t compute_us{0};
+};
+
+struct MotionConfig {
+  uint16_t plane_width{80};
+  uint16_t plane_height{60};
+  uint8_t cell_size{4};         // pixels du plan par côté de cellule
+  float sensitivity{0.5f};      // 0..1, plus haut = de plus petits écarts comptent
+  float min_area{0.01f};        // part de la frame qu'une région doit couvrir
+  float learning_rate{0.05f};   // mise à jour du fond par frame
+};
+
+// Détection sur un petit plan de luminance :
+//  1. réduction de la frame par boîtes (quelques échantillons par boîte, leur
+//     nombre suit un budget CPU comme FrameStatsEngine),
+//  2. fond en moyenne glissante (virgule fixe 8.8), appris plus lentement
+//     sous un objet pour qu'un objet lent ne soit pas absorbé d'un coup,
+//  3. score par cellule = part de ses pixels qui s'écartent du fond de plus
+//     que le seuil de sensibilité,
+//  4. cellules masquées ignorées, cellules actives regroupées en régions
+//     4-connexes, régions sous min_area écartées.
+class MotionDetector {
+ public:
+  static constexpr uint16_t MAX_PLANE_WIDTH = 160;
+  static constexpr uint16_t MAX_PLANE_HEIGHT = 120;
+  static constexpr uint8_t MAX_MASKS = 8;
+  static constexpr uint8_t MAX_SAMPLES = 8;  // par côté de boîte
+  // Part des pixels d'une cellule qui doivent changer pour l'activer
+  static constexpr uint8_t CELL_ACTIVE_PERCENT = 25;
+  // Part des cellules non masquées au-delà de laquelle le changement est global
+  static constexpr uint8_t GLOBAL_CHANGE_PERCENT = 60;
+
+  void set_config(const MotionConfig &config);
+  const MotionConfig &get_config() const { return this->config_; }
+  // En pixels de la frame ; les cellules dont le centre est masqué sont ignorées
+  bool add_mask(const FrameRoi &mask);
+  void clear_masks();
+  uint8_t get_mask_count() const { return this->mask_count_; }
+  void set_budget_us(uint32_t budget_us) { this->budget_us_ = budget_us; }
+  uint32_t get_budget_us() const { return this->budget_us_; }
+
+  // Toute taille et tout format ; une nouvelle taille réinitialise le fond.
+  void process(const FrameView &view, uint32_t sequence, MotionResult &out);
+  // Durée mesurée du dernier process() (échantillons par boîte)
+  void adapt(uint32_t elapsed_us);
+  // La prochaine frame devient le fond
+  void reset() { this->has_background_ = false; }
+
+  uint8_t get_samples() const { return this->samples_; }
+  uint16_t get_plane_width() const { return this->plane_w_; }
+  uint16_t get_plane_height() const { return this->plane_h_; }
+  const uint8_t *get_plane() const { return this->plane_.data(); }
+  uint8_t get_cell_cols() const { return this->cell_cols_; }
+  uint8_t get_cell_rows() const { return this->cell_rows_; }
+  // Score de la dernière frame, 0-100 (% des pixels de la cellule)
+  uint8_t cell_score(uint8_t col, uint8_t row) const { return this->cell_score_[row * this->cell_cols_ + col]; }
+
+ protected:
+  void layout_(uint16_t width, uint16_t height);
+  void update_mask_();
+  void downsample_(const FrameView &view);
+  uint8_t find_regions_(MotionResult &out);
+
+  MotionConfig config_{};
+  FrameRoi masks_[MAX_MASKS]{};
+  uint8_t mask_count_{0};
+  uint32_t budget_us_{1000};
+
+  // Géométrie de la dernière taille de frame
+  uint16_t width_{0};
+  uint16_t height_{0};
+  uint16_t plane_w_{0};
+  uint16_t plane_h_{0};
+  uint8_t samples_{4};
+  uint8_t cell_cols_{0};
+  uint8_t cell_rows_{0};
+  uint8_t threshold_{36};  // niveaux de luminance
+  uint16_t rate_q8_{13};   // learning_rate en 1/256
+
+  std::vector<uint16_t> sample_x_;  // colonne de frame de chaque échantillon d'une ligne du plan
+  bool has_background_{false};
+  std::vector<uint8_t> plane_;
+  std::vector<uint16_t> background_;  // 8.8
+  std::vector<uint8_t> cell_score_;
+  std::vector<uint16_t> cell_changed_;
+  std::vector<uint8_t> cell_masked_;
+  std::vector<uint8_t> cell_label_;   // travail de la croissance de régions
+  std::vector<uint16_t> cell_stack_;
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,342 @@
+#include "osd_overlay.h"
+#include "pixel_convert.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Police 5x7, ASCII 32..126 : une ligne par octet, bit 4 = colonne de gauche
+static const uint8_t FONT_5X7[95][7] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // espace
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04},  // !
+    {0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00},  // "
+    {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A},  // #
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04},  // $
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03},  // %
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D},  // &
+    {0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00},  // '
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02},  // (
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08},  // )
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00},  // *
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00},  // +
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08},  // ,
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00},  // -
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C},  // .
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00},  // /
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},  // 0
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},  // 1
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},  // 2
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},  // 3
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},  // 4
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},  // 5
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},  // 6
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},  // 7
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},  // 8
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},  // 9
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00},  // :
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08},  // ;
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02},  // <
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00},  // =
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08},  // >
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04},  // ?
+    {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E},  // @
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},  // A
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E},  // B
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},  // C
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C},  // D
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F},  // E
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},  // F
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F},  // G
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},  // H
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},  // I
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C},  // J
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},  // K
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F},  // L
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11},  // M
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},  // N
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},  // O
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10},  // P
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D},  // Q
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11},  // R
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E},  // S
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},  // T
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},  // U
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04},  // V
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A},  // W
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11},  // X
+    {0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04},  // Y
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F},  // Z
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E},  // [
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00},  // antislash
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E},  // ]
+    {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00},  // ^
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F},  // _
+    {0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00},  // `
+    {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F},  // a
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E},  // b
+    {0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E},  // c
+    {0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F},  // d
+    {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E},  // e
+    {0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08},  // f
+    {0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E},  // g
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11},  // h
+    {0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E},  // i
+    {0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C},  // j
+    {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12},  // k
+    {0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},  // l
+    {0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11},  // m
+    {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11},  // n
+    {0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E},  // o
+    {0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10},  // p
+    {0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01},  // q
+    {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10},  // r
+    {0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E},  // s
+    {0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06},  // t
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D},  // u
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04},  // v
+    {0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A},  // w
+    {0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11},  // x
+    {0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E},  // y
+    {0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F},  // z
+    {0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02},  // {
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},  // |
+    {0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08},  // }
+    {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00},  // ~
+};
+
+static constexpr uint8_t GLYPH_ADVANCE = 6;  // 5 colonnes + 1 d'espace
+static constexpr uint8_t GLYPH_HEIGHT = 7;
+
+// Lettres accentuées Latin-1 (U+00C0..U+00FF) -> lettre de base
+static const char LATIN1_BASE[] = "AAAAAAACEEEEIIIIDNOOOOOxOUUUUYPsaaaaaaaceeeeiiiidnooooo/ouuuuypy";
+
+// Un caractère UTF-8 de `text` à partir de `i`, ramené à la police
+static char next_glyph(const std::string &text, size_t &i) {
+  uint8_t c = text[i++];
+  if (c < 0x80) {
+    return c >= 32 && c < 127 ? (char) c : '?';
+  }
+  if (c == 0xC3 && i < text.size() && ((uint8_t) text[i] & 0xC0) == 0x80) {
+    return LATIN1_BASE[(uint8_t) text[i++] & 0x3F];
+  }
+  // Autre séquence : sauter ses octets de continuation
+  while (i < text.size() && ((uint8_t) text[i] & 0xC0) == 0x80)
+    i++;
+  return '?';
+}
+
+bool OsdSprite::set_text(const std::string &text, uint8_t scale) {
+  if (text == this->text_ && scale == this->scale_) {
+    return false;
+  }
+  this->text_ = text;
+  this->scale_ = scale;
+
+  std::string glyphs;
+  for (size_t i = 0; i < text.size();)
+    glyphs += next_glyph(text, i);
+  if (glyphs.empty()) {
+    this->width_ = this->height_ = 0;
+    this->mask_.clear();
+    return true;
+  }
+  // Marge d'un pixel de police tout autour : place pour le contour
+  const uint16_t pad = scale;
+  this->width_ = std::min<uint32_t>(glyphs.size() * GLYPH_ADVANCE * scale + scale, 0xFFFF);
+  this->height_ = (GLYPH_HEIGHT + 2) * scale;
+  this->mask_.assign((size_t) this->width_ * this->height_, OSD_INK_BACKGROUND);
+
+  for (size_t n = 0; n < glyphs.size(); n++) {
+    const uint8_t *glyph = FONT_5X7[glyphs[n] - 32];
+    for (uint8_t gy = 0; gy < GLYPH_HEIGHT; gy++) {
+      for (uint8_t gx = 0; gx < 5; gx++) {
+        if (!(glyph[gy] & (0x10 >> gx)))
+          continue;
+        uint32_t x = pad + (n * GLYPH_ADVANCE + gx) * scale;
+        if (x + scale > this->width_)
+          continue;
+        for (uint16_t y = pad + gy * scale; y < pad + (gy + 1) * scale; y++)
+          memset(&this->mask_[(size_t) y * this->width_ + x], OSD_INK_TEXT, scale);
+      }
+    }
+  }
+  // Contour d'un pixel autour du texte : dilatation 3x3 séparable, les
+  // voisins horizontaux d'abord puis les lignes au-dessus et en dessous
+  const uint16_t w = this->width_;
+  std::vector<uint8_t> near(this->mask_.size());
+  for (uint16_t y = 0; y < this->height_; y++) {
+    const uint8_t *m = this->row(y);
+    uint8_t *n = &near[(size_t) y * w];
+    for (uint16_t x = 0; x < w; x++) {
+      n[x] = m[x] == OSD_INK_TEXT || (x > 0 && m[x - 1] == OSD_INK_TEXT) || (x + 1 < w && m[x + 1] == OSD_INK_TEXT);
+    }
+  }
+  for (uint16_t y = 0; y < this->height_; y++) {
+    uint8_t *m = &this->mask_[(size_t) y * w];
+    const uint8_t *n = &near[(size_t) y * w];
+    for (uint16_t x = 0; x < w; x++) {
+      if (m[x] == OSD_INK_BACKGROUND && (n[x] || (y > 0 && n[x - w]) || (y + 1 < this->height_ && n[x + w])))
+        m[x] = OSD_INK_OUTLINE;
+    }
+  }
+  return true;
+}
+
+void OsdOverlay::set_line(uint8_t index, const std::string &text) {
+  if (index < MAX_LINES)
+    this->texts_[index] = text;
+}
+
+void OsdOverlay::set_boxes(const FrameRoi *boxes, uint8_t count) {
+  this->box_count_ = std::min(count, MAX_BOXES);
+  std::copy(boxes, boxes + this->box_count_, this->boxes_);
+}
+
+// Couleur + opacité (0..32) d'une encre, dans le format de la frame
+struct Ink {
+  uint8_t alpha;
+  uint32_t spread;  // RGB565 étalé, voir spread565()
+  uint8_t y, u, v;
+  uint8_t site[4];  // RAW8 : valeur par site de la mosaïque
+};
+
+// RGB565 -> 0b00000GGGGGG00000RRRRR000000BBBBB : un produit par 0..32 ne
+// déborde pas d'un champ sur l'autre, les trois canaux en une multiplication
+static inline uint32_t spread565(uint16_t p) { return (p | (uint32_t) p << 16) & 0x07E0F81F; }
+static inline uint16_t pack_spread(uint32_t x) {
+  x &= 0x07E0F81F;
+  return (uint16_t) (x | x >> 16);
+}
+
+static Ink make_ink(uint32_t rgb, uint8_t alpha, uint8_t bayer_pattern) {
+  uint8_t r = rgb >> 16, g = rgb >> 8, b = rgb;
+  Ink ink;
+  ink.alpha = alpha;
+  ink.spread = spread565(pack_rgb565(r, g, b));
+  ink.y = rgb_to_y(r, g, b);
+  ink.u = rgb_to_u(r, g, b);
+  ink.v = rgb_to_v(r, g, b);
+  for (uint8_t site = 0; site < 4; site++) {
+    ink.site[site] = site == bayer_red_site(bayer_pattern) ? r : (site == bayer_blue_site(bayer_pattern) ? b : g);
+  }
+  return ink;
+}
+
+static inline uint8_t lerp8(uint8_t from, uint8_t to, uint8_t alpha) {
+  return (from * (32 - alpha) + to * alpha + 16) >> 5;
+}
+
+// `count` pixels de la ligne y à partir de x, l'encre de chaque pixel lue
+// dans `mask` (nullptr : encre 0 partout). YUV422 : x et count pairs.
+static void blend_span(const FrameView &view, uint16_t y, uint16_t x, uint16_t count, const uint8_t *mask,
+                       const Ink *inks) {
+  uint8_t *row = view.row(y);
+  if (view.format == PIXEL_FORMAT_RGB565) {
+    uint16_t *p = (uint16_t *) row + x;
+    for (uint16_t i = 0; i < count; i++) {
+      const Ink &ink = inks[mask ? mask[i] : 0];
+      if (ink.alpha == 32) {
+        p[i] = pack_spread(ink.spread);
+      } else if (ink.alpha != 0) {
+        p[i] = pack_spread((spread565(p[i]) * (32 - ink.alpha) + ink.spread * ink.alpha) >> 5);
+      }
+    }
+  } else if (view.format == PIXEL_FORMAT_YUV422) {
+    // Y0 U Y1 V : luma par pixel, chroma de la paire avec les deux encres
+    uint8_t *p = row + x * 2;
+    for (uint16_t i = 0; i + 1 < count; i += 2, p += 4) {
+      const Ink &k0 = inks[mask ? mask[i] : 0];
+      const Ink &k1 = inks[mask ? mask[i + 1] : 0];
+      uint8_t a = k0.alpha + k1.alpha;
+      if (a == 0)
+        continue;
+      p[0] = lerp8(p[0], k0.y, k0.alpha);
+      p[2] = lerp8(p[2], k1.y, k1.alpha);
+      p[1] = (p[1] * (64 - a) + k0.u * k0.alpha + k1.u * k1.alpha + 32) >> 6;
+      p[3] = (p[3] * (64 - a) + k0.v * k0.alpha + k1.v * k1.alpha + 32) >> 6;
+    }
+  } else {
+    // Site de la mosaïque : (ligne & 1) * 2 + (colonne & 1), motif de la vue
+    uint8_t *p = row + x;
+    uint8_t row_site = (y & 1) << 1;
+    for (uint16_t i = 0; i < count; i++) {
+      const Ink &ink = inks[mask ? mask[i] : 0];
+      if (ink.alpha != 0)
+        p[i] = lerp8(p[i], ink.site[row_site | ((x + i) & 1)], ink.alpha);
+    }
+  }
+}
+
+void OsdOverlay::draw(const FrameView &view) {
+  if (!view.valid()) {
+    return;
+  }
+  uint8_t scale = this->config_.scale != 0 ? this->config_.scale : std::max(1, view.height / 240);
+  Ink inks[OSD_INK_COUNT] = {
+      make_ink(0x000000, (this->config_.background_opacity * 32 + 50) / 100, view.bayer_pattern),
+      make_ink(0x000000, 32, view.bayer_pattern),
+      make_ink(this->config_.color, 32, view.bayer_pattern),
+  };
+  const bool yuv = view.format == PIXEL_FORMAT_YUV422;
+
+  // Bloc de texte : hauteur totale pour les coins du bas
+  uint32_t block_height = 0;
+  for (uint8_t i = 0; i < MAX_LINES; i++) {
+    if (this->sprites_[i].set_text(this->texts_[i], scale))
+      this->rasterize_count_++;
+    block_height += this->sprites_[i].get_height();
+  }
+  const int32_t margin = 2 * scale;
+  const bool right = this->config_.position == OSD_TOP_RIGHT || this->config_.position == OSD_BOTTOM_RIGHT;
+  const bool bottom = this->config_.position == OSD_BOTTOM_LEFT || this->config_.position == OSD_BOTTOM_RIGHT;
+  int32_t top = bottom ? (int32_t) view.height - margin - (int32_t) block_height : margin;
+
+  for (uint8_t i = 0; i < MAX_LINES; i++) {
+    const OsdSprite &sprite = this->sprites_[i];
+    if (sprite.empty())
+      continue;
+    int32_t x = right ? (int32_t) view.width - margin - sprite.get_width() : margin;
+    if (yuv)
+      x &= ~1;
+    // Rogné à la frame (texte plus large que l'image)
+    int32_t skip = x < 0 ? -x : 0;
+    x += skip;
+    int32_t count = std::min<int32_t>(sprite.get_width() - skip, view.width - x);
+    if (yuv)
+      count &= ~1;
+    for (uint16_t sy = 0; sy < sprite.get_height() && count > 0; sy++) {
+      int32_t y = top + sy;
+      if (y >= 0 && y < view.height)
+        blend_span(view, y, x, count, sprite.row(sy) + skip, inks);
+    }
+    top += sprite.get_height();
+  }
+
+  // Boîtes : seulement les lignes et colonnes du contour
+  const Ink *box_ink = &inks[OSD_INK_TEXT];
+  for (uint8_t b = 0; b < this->box_count_; b++) {
+    FrameRoi box = this->boxes_[b];
+    uint32_t x0 = std::min<uint32_t>(box.x, view.width), y0 = std::min<uint32_t>(box.y, view.height);
+    uint32_t x1 = std::min<uint32_t>(x0 + box.width, view.width), y1 = std::min<uint32_t>(y0 + box.height, view.height);
+    if (yuv) {
+      x0 &= ~1;
+      x1 &= ~1;
+    }
+    if (x1 <= x0 || y1 <= y0)
+      continue;
+    uint32_t thickness = std::min<uint32_t>({(uint32_t) (yuv ? (scale + 1) & ~1 : scale), x1 - x0, y1 - y0});
+    for (uint32_t y = y0; y < y1; y++) {
+      if (y < y0 + thickness || y >= y1 - thickness) {
+        blend_span(view, y, x0, x1 - x0, nullptr, box_ink);
+      } else {
+        blend_span(view, y, x0, thickness, nullptr, box_ink);
+        blend_span(view, y, x1 - thickness, thickness, nullptr, box_ink);
+      }
+    }
+  }
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "frame_view.h"
+
+// Incrustation (horodatage, texte, boîtes de mouvement) dans la frame publiée.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+enum OsdPosition : uint8_t {
+  OSD_TOP_LEFT = 0,
+  OSD_TOP_RIGHT,
+  OSD_BOTTOM_LEFT,
+  OSD_BOTTOM_RIGHT,
+};
+
+struct OsdConfig {
+  OsdPosition position{OSD_TOP_LEFT};
+  uint8_t scale{0};                // pixels frame par pixel de police, 0 = hauteur / 240
+  uint8_t background_opacity{50};  // % de noir derrière le texte
+  uint32_t color{0xFFFFFF};        // texte et boîtes de mouvement, 0xRRGGBB
+};
+
+// Palette d'un masque OsdSprite
+enum OsdInk : uint8_t {
+  OSD_INK_BACKGROUND = 0,  // cadre derrière le texte (background_opacity)
+  OSD_INK_OUTLINE,         // noir opaque, texte lisible sur n'importe quelle scène
+  OSD_INK_TEXT,
+  OSD_INK_COUNT,
+};
+
+// Une ligne de texte dans la police 5x7 intégrée, rastérisée en masque
+// d'indices OsdInk. set_text() ne la refait que si le texte ou l'échelle
+// change : une ligne d'horloge est reconstruite une fois par seconde, pas à
+// chaque frame.
+class OsdSprite {
+ public:
+  // ASCII ; les lettres accentuées Latin-1 perdent leur accent, le reste devient '?'
+  bool set_text(const std::string &text, uint8_t scale);
+  const std::string &get_text() const { return this->text_; }
+  bool empty() const { return this->width_ == 0; }
+  uint16_t get_width() const { return this->width_; }
+  uint16_t get_height() const { return this->height_; }
+  const uint8_t *row(uint16_t y) const { return this->mask_.data() + (size_t) y * this->width_; }
+
+ protected:
+  std::string text_;
+  uint8_t scale_{0};
+  uint16_t width_{0};
+  uint16_t height_{0};
+  std::vector<uint8_t> mask_;
+};
+
+// Lignes de texte empilées dans un coin et contours des boîtes de mouvement,
+// composés sur place dans la frame (RGB565, YUV422 ou RAW8) : seules les
+// lignes sous le bloc de texte et les bords des boîtes sont lus et écrits,
+// sans copie de la frame.
+class OsdOverlay {
+ public:
+  static constexpr uint8_t MAX_LINES = 4;
+  static constexpr uint8_t MAX_BOXES = 8;
+
+  void set_config(const OsdConfig &config) { this->config_ = config; }
+  const OsdConfig &get_config() const { return this->config_; }
+  // Un texte vide masque la ligne
+  void set_line(uint8_t index, const std::string &text);
+  // En pixels frame, tracées avec un contour de `scale` pixels
+  void set_boxes(const FrameRoi *boxes, uint8_t count);
+
+  void draw(const FrameView &view);
+  // Reconstructions de sprites depuis le boot (sinon draw() ne fait que mélanger)
+  uint32_t get_rasterize_count() const { return this->rasterize_count_; }
+
+ protected:
+  OsdConfig config_{};
+  std::string texts_[MAX_LINES];
+  OsdSprite sprites_[MAX_LINES];
+  FrameRoi boxes_[MAX_BOXES]{};
+  uint8_t box_count_{0};
+  uint32_t rasterize_count_{0};
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,165 @@
+#include "pixel_convert.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+static inline void expand565(uint16_t px, uint8_t &r, uint8_t &g, uint8_t &b) {
+  uint8_t r5 = px >> 11;
+  uint8_t g6 = (px >> 5) & 0x3F;
+  uint8_t b5 = px & 0x1F;
+  r = (r5 << 3) | (r5 >> 2);
+  g = (g6 << 2) | (g6 >> 4);
+  b = (b5 << 3) | (b5 >> 2);
+}
+
+// Couleur du quad 2x2 dont le site en haut à gauche est `top` (x et y pairs)
+static inline void bayer_quad(const uint8_t *top, uint32_t stride, uint8_t pattern, uint8_t &r, uint8_t &g,
+                              uint8_t &b) {
+  const uint8_t quad[4] = {top[0], top[1], top[stride], top[stride + 1]};
+  const uint8_t r_site = bayer_red_site(pattern);
+  const uint8_t b_site = bayer_blue_site(pattern);
+  // Les deux verts sont sur la diagonale opposée à R/B
+  r = quad[r_site];
+  b = quad[b_site];
+  g = (quad[r_site ^ 1] + quad[b_site ^ 1] + 1) >> 1;
+}
+
+// sink(x, r, g, b) pour chaque pixel de la ligne `y` (RGB565 / YUV422 ; le
+// RAW8 passe par demosaic_rows())
+template<typename Sink> static inline void for_each_rgb(const FrameView &view, uint16_t y, Sink sink) {
+  const uint16_t w = view.width;
+  switch (view.format) {
+    case PIXEL_FORMAT_YUV422: {
+      const uint8_t *row = view.row(y);
+      for (uint16_t x = 0; x + 1 < w; x += 2, row += 4) {
+        uint8_t r, g, b;
+        yuv_to_rgb(row[0], row[1], row[3], r, g, b);
+        sink(x, r, g, b);
+        yuv_to_rgb(row[2], row[1], row[3], r, g, b);
+        sink(x + 1, r, g, b);
+      }
+      break;
+    }
+    default: {
+      const uint16_t *row = (const uint16_t *) view.row(y);
+      for (uint16_t x = 0; x < w; x++) {
+        uint8_t r, g, b;
+        expand565(row[x], r, g, b);
+        sink(x, r, g, b);
+      }
+      break;
+    }
+  }
+}
+
+void sample_row_rgb565(const FrameView &view, uint16_t y, uint8_t step, uint16_t first, uint16_t count,
+                       uint16_t *out) {
+  if (view.format == PIXEL_FORMAT_YUV422) {
+    const uint8_t *row = view.row(y);
+    for (uint16_t i = 0; i < count; i++) {
+      uint32_t x = (uint32_t) (first + i) * step;
+      const uint8_t *pair = row + (x & ~1u) * 2;
+      uint8_t r, g, b;
+      yuv_to_rgb(pair[(x & 1) * 2], pair[1], pair[3], r, g, b);
+      out[i] = pack_rgb565(r, g, b);
+    }
+  } else if (view.format == PIXEL_FORMAT_RAW8) {
+    uint16_t qy = y & ~1;
+    if (qy + 1 >= view.height)
+      qy = view.height >= 2 ? view.height - 2 : 0;
+    const uint8_t *top = view.row(qy);
+    for (uint16_t i = 0; i < count; i++) {
+      uint32_t x = ((uint32_t) (first + i) * step) & ~1u;
+      uint8_t r, g, b;
+      bayer_quad(top + x, view.stride, view.bayer_pattern, r, g, b);
+      out[i] = pack_rgb565(r, g, b);
+    }
+  } else {
+    const uint16_t *row = (const uint16_t *) view.row(y);
+    for (uint16_t i = 0; i < count; i++) {
+      out[i] = row[(uint32_t) (first + i) * step];
+    }
+  }
+}
+
+void convert_to_rgb565(const FrameView &view, uint16_t *out, DemosaicMethod demosaic) {
+  if (view.format == PIXEL_FORMAT_RAW8) {
+    demosaic_rows(view, demosaic, false, DEMOSAIC_OUTPUT_RGB565, 0, view.height, (uint8_t *) out,
+                  (uint32_t) view.width * 2);
+    return;
+  }
+  for (uint16_t y = 0; y < view.height; y++) {
+    uint16_t *dst = out + (size_t) y * view.width;
+    if (view.format == PIXEL_FORMAT_RGB565) {
+      memcpy(dst, view.row(y), view.row_bytes());
+      continue;
+    }
+    for_each_rgb(view, y, [dst](uint16_t x, uint8_t r, uint8_t g, uint8_t b) { dst[x] = pack_rgb565(r, g, b); });
+  }
+}
+
+void convert_to_rgb888(const FrameView &view, uint8_t *out, DemosaicMethod demosaic) {
+  if (view.format == PIXEL_FORMAT_RAW8) {
+    demosaic_rows(view, demosaic, false, DEMOSAIC_OUTPUT_RGB888, 0, view.height, out, (uint32_t) view.width * 3);
+    return;
+  }
+  for (uint16_t y = 0; y < view.height; y++) {
+    uint8_t *dst = out + (size_t) y * view.width * 3;
+    for_each_rgb(view, y, [dst](uint16_t x, uint8_t r, uint8_t g, uint8_t b) {
+      dst[x * 3 + 0] = r;
+      dst[x * 3 + 1] = g;
+      dst[x * 3 + 2] = b;
+    });
+  }
+}
+
+void convert_to_yuv422(const FrameView &view, uint8_t *out, DemosaicMethod demosaic) {
+  const uint16_t w = view.width & ~1;
+  if (view.format == PIXEL_FORMAT_RAW8) {
+    demosaic_rows(view, demosaic, false, DEMOSAIC_OUTPUT_YUV422, 0, view.height, out, (uint32_t) w * 2);
+    return;
+  }
+  for (uint16_t y = 0; y < view.height; y++) {
+    uint8_t *dst = out + (size_t) y * w * 2;
+    if (view.format == PIXEL_FORMAT_YUV422) {
+      memcpy(dst, view.row(y), (size_t) w * 2);
+      continue;
+    }
+    // Chroma moyennée sur la paire de pixels
+    uint8_t r0 = 0, g0 = 0, b0 = 0;
+    for_each_rgb(view, y, [&](uint16_t x, uint8_t r, uint8_t g, uint8_t b) {
+      if (x >= w)
+        return;
+      if ((x & 1) == 0) {
+        r0 = r;
+        g0 = g;
+        b0 = b;
+        return;
+      }
+      uint8_t ra = (r0 + r + 1) >> 1, ga = (g0 + g + 1) >> 1, ba = (b0 + b + 1) >> 1;
+      uint8_t *pair = dst + (x - 1) * 2;
+      pair[0] = rgb_to_y(r0, g0, b0);
+      pair[1] = rgb_to_u(ra, ga, ba);
+      pair[2] = rgb_to_y(r, g, b);
+      pair[3] = rgb_to_v(ra, ga, ba);
+    });
+  }
+}
+
+void rgb565_to_raw8(const uint16_t *rgb565, uint16_t width, uint16_t height, uint8_t bayer_pattern, uint8_t *out) {
+  const uint8_t r_site = bayer_red_site(bayer_pattern);
+  const uint8_t b_site = bayer_blue_site(bayer_pattern);
+  for (uint16_t y = 0; y < height; y++) {
+    for (uint16_t x = 0; x < width; x++) {
+      uint8_t r, g, b;
+      expand565(rgb565[(size_t) y * width + x], r, g, b);
+      uint8_t site = (y & 1) * 2 + (x & 1);
+      out[(size_t) y * width + x] = site == r_site ? r : (site == b_site ? b : g);
+    }
+  }
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "demosaic.h"
+#include "frame_view.h"
+
+// Conversions de format pour les consommateurs qui n'utilisent pas celui de la capture.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Chaque fonction prend une vue avec stride et écrit une image compacte
+// width x height.
+//
+// Conventions des buffers de frame (pixel_format:) :
+//   RGB565 : uint16_t natif (R dans les bits de poids fort)
+//   YUV422 : octets Y0 U Y1 V, BT.601 pleine échelle (réglage de l'ISP)
+//   RAW8   : mosaïque de Bayer, ordre dans FrameView::bayer_pattern
+//            (0=BGGR 1=GBRG 2=GRBG 3=RGGB, comme l'ISP), dématricée selon
+//            `demosaic` (demosaic.h).
+
+inline uint16_t pack_rgb565(uint8_t r, uint8_t g, uint8_t b) {
+  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+inline uint8_t clamp_u8(int32_t v) { return v < 0 ? 0 : (v > 255 ? 255 : v); }
+
+// BT.601 pleine échelle, virgule fixe 8 bits
+inline void yuv_to_rgb(uint8_t y, uint8_t u, uint8_t v, uint8_t &r, uint8_t &g, uint8_t &b) {
+  int32_t d = u - 128;
+  int32_t e = v - 128;
+  r = clamp_u8(y + ((359 * e + 128) >> 8));
+  g = clamp_u8(y - ((88 * d + 183 * e + 128) >> 8));
+  b = clamp_u8(y + ((454 * d + 128) >> 8));
+}
+
+inline uint8_t rgb_to_y(uint8_t r, uint8_t g, uint8_t b) { return (77 * r + 150 * g + 29 * b + 128) >> 8; }
+inline uint8_t rgb_to_u(uint8_t r, uint8_t g, uint8_t b) {
+  return clamp_u8(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128);
+}
+inline uint8_t rgb_to_v(uint8_t r, uint8_t g, uint8_t b) {
+  return clamp_u8(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128);
+}
+// Luminance BT.601 directement depuis les champs RGB565, blanc = 255
+inline uint32_t luma565(uint32_t r5, uint32_t g6, uint32_t b5) {
+  return (2518 * r5 + 2433 * g6 + 960 * b5 + 512) >> 10;
+}
+
+// Index du site rouge / bleu dans un quad de Bayer 2x2 (ligne * 2 + colonne)
+inline uint8_t bayer_red_site(uint8_t pattern) { return 3 - (pattern & 3); }
+inline uint8_t bayer_blue_site(uint8_t pattern) { return pattern & 3; }
+
+// RGB565 des échantillons first..first+count-1 de la ligne `y`, un tous les
+// `step` pixels (échantillonnage des stats).
+void sample_row_rgb565(const FrameView &view, uint16_t y, uint8_t step, uint16_t first, uint16_t count,
+                       uint16_t *out);
+
+void convert_to_rgb565(const FrameView &view, uint16_t *out, DemosaicMethod demosaic = DEMOSAIC_NEAREST);
+void convert_to_rgb888(const FrameView &view, uint8_t *out, DemosaicMethod demosaic = DEMOSAIC_NEAREST);
+void convert_to_yuv422(const FrameView &view, uint8_t *out, DemosaicMethod demosaic = DEMOSAIC_NEAREST);
+
+// Mosaïque d'une image RGB565 (CSI virtuel : ce que livrerait le capteur)
+void rgb565_to_raw8(const uint16_t *rgb565, uint16_t width, uint16_t height, uint8_t bayer_pattern, uint8_t *out);
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,81 @@
+#include "ppa_scaler.h"
+
+#ifdef USE_ESP32_VARIANT_ESP32P4
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+static const char *const TAG = "mipi_dsi_cam.ppa";
+
+PpaScaler::~PpaScaler() {
+  if (this->client_ != nullptr) {
+    ppa_unregister_client(this->client_);
+  }
+}
+
+bool PpaScaler::init() {
+  ppa_client_config_t config = {};
+  config.oper_type = PPA_OPERATION_SRM;
+  config.max_pending_trans_num = 1;
+  esp_err_t ret = ppa_register_client(&config, &this->client_);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "PPA client registration failed: %s", esp_err_to_name(ret));
+    this->client_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool PpaScaler::scale_transformed(const FrameView &src, const FrameView &dst, const FrameTransform &transform) {
+  if (this->client_ == nullptr || !src.valid() || !dst.valid() || src.format != PIXEL_FORMAT_RGB565 ||
+      dst.format != PIXEL_FORMAT_RGB565 || !dst.is_packed()) {
+    return false;
+  }
+
+  ppa_srm_oper_config_t op = {};
+  // Vue stridée : image = lignes entières de la frame, bloc = la vue
+  op.in.buffer = src.data;
+  op.in.pic_w = src.stride / 2;
+  op.in.pic_h = src.height;
+  op.in.block_w = src.width;
+  op.in.block_h = src.height;
+  op.in.block_offset_x = 0;
+  op.in.block_offset_y = 0;
+  op.in.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+
+  op.out.buffer = dst.data;
+  // Le driver veut une taille alignée sur la ligne de cache (buffer alloué ainsi)
+  op.out.buffer_size = (dst.row_bytes() * dst.height + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  op.out.pic_w = dst.width;
+  op.out.pic_h = dst.height;
+  op.out.block_offset_x = 0;
+  op.out.block_offset_y = 0;
+  op.out.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+
+  // Le PPA tourne dans le sens antihoraire, avant le miroir (comme FrameTransform)
+  static const ppa_srm_rotation_angle_t ANGLES[4] = {PPA_SRM_ROTATION_ANGLE_0, PPA_SRM_ROTATION_ANGLE_270,
+                                                     PPA_SRM_ROTATION_ANGLE_180, PPA_SRM_ROTATION_ANGLE_90};
+  op.rotation_angle = ANGLES[transform.rotation & 3];
+  op.mirror_x = transform.mirror_x;
+  op.mirror_y = transform.mirror_y;
+  // Facteurs sur les axes de l'entrée : un quart de tour échange la sortie
+  bool swap = transform.swaps_axes();
+  op.scale_x = (float) (swap ? dst.height : dst.width) / src.width;
+  op.scale_y = (float) (swap ? dst.width : dst.height) / src.height;
+  op.mode = PPA_TRANS_MODE_BLOCKING;
+
+  esp_err_t ret = ppa_do_scale_rotate_mirror(this->client_, &op);
+  if (ret != ESP_OK) {
+    ESP_LOGW(TAG, "PPA scale %ux%u -> %ux%u failed: %s", src.width, src.height, dst.width, dst.height,
+             esp_err_to_name(ret));
+    return false;
+  }
+  return true;
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
+
+#endif  // USE_ESP32_VARIANT_ESP32P4
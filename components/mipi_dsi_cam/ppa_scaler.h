@@ -0,0 +1,36 @@
+#pragma once
+
+#include "frame_scaler.h"
+
+#ifdef USE_ESP32_VARIANT_ESP32P4
+extern "C" {
+  #include "driver/ppa.h"
+}
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Pixel-Processing Accelerator de l'ESP32-P4 (moteur scale-rotate-mirror).
+// Les facteurs d'échelle sont tronqués au pas de 1/16 : les tailles données
+// par fit_scale_sixteenths() sortent exactement. Rotation et miroir sont
+// gratuits dans la même passe. dst doit être aligné sur une ligne de cache
+// (heap_caps_aligned_calloc(ALIGNMENT, ...)) et compact.
+class PpaScaler : public FrameScaler {
+ public:
+  static constexpr size_t ALIGNMENT = 64;
+
+  ~PpaScaler() override;
+  const char *get_name() const override { return "PPA (hardware)"; }
+  bool init();
+  bool scale(const FrameView &src, const FrameView &dst) override { return this->scale_transformed(src, dst, {}); }
+  bool supports_transform() const override { return true; }
+  bool scale_transformed(const FrameView &src, const FrameView &dst, const FrameTransform &transform) override;
+
+ protected:
+  ppa_client_handle_t client_{nullptr};
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
+
+#endif  // USE_ESP32_VARIANT_ESP32P4
@@ -0,0 +1,127 @@
+"""Helpers shared by the sensor_mipi_csi_*.py driver generators."""
+
+# Octets de données max par écriture I2C (SENSOR_MAX_BURST dans sensor_registers.h)
+MAX_BURST = 32
+# mode_select / software_reset (standard MIPI) : jamais fusionnés dans un burst
+ISOLATED_REGISTERS = (0x0100, 0x0103)
+
+
+def coalesce_init_sequence(sequence, isolated=ISOLATED_REGISTERS, delay_after=False):
+    """Regroupe les registres consécutifs d'une séquence d'init en écritures burst.
+
+    sequence: liste de (addr, value, delay_ms).
+    isolated: adresses toujours écrites seules (reset, stream, group hold...).
+    delay_after: le délai d'une entrée s'applique après son écriture (sinon avant),
+    une entrée avec délai termine (resp. commence) donc son burst.
+
+    Retourne (data, bursts) avec bursts = [(addr, offset, count, delay_ms)].
+    """
+    data = []
+    bursts = []
+    for addr, value, delay in sequence:
+        extend = False
+        if bursts and addr not in isolated:
+            b_addr, b_offset, b_count, b_delay = bursts[-1]
+            extend = (
+                addr == b_addr + b_count
+                and b_addr not in isolated
+                and b_count < MAX_BURST
+                and (b_delay == 0 if delay_after else delay == 0)
+            )
+        if extend:
+            b_addr, b_offset, b_count, b_delay = bursts[-1]
+            bursts[-1] = (b_addr, b_offset, b_count + 1, delay if delay_after else b_delay)
+        else:
+            bursts.append((addr, len(data), 1, delay))
+        data.append(value)
+    return data, bursts
+
+
+def generate_init_tables(name, sequence, isolated=ISOLATED_REGISTERS, delay_after=False):
+    """C++ de {name}_init_data[] et {name}_init_bursts[] (voir SensorInitBurst)."""
+    data, bursts = coalesce_init_sequence(sequence, isolated, delay_after)
+
+    code = f'// {len(sequence)} registres en {len(bursts)} écritures I2C (adresses consécutives regroupées)\n'
+    code += f'static constexpr uint8_t {name}_init_data[] = {{\n'
+    for i in range(0, len(data), 16):
+        code += '    ' + ', '.join(f'0x{v:02X}' for v in data[i:i + 16]) + ',\n'
+    code += '};\n\n'
+    code += f'static constexpr SensorInitBurst {name}_init_bursts[] = {{\n'
+    for addr, offset, count, delay in bursts:
+        code += f'    {{0x{addr:04X}, {offset}, {count}, {delay}}},\n'
+    code += '};\n'
+    return code
+
+
+def generate_mode_tables(name, modes, init_sequence):
+    """C++ de {name}_modes[] (SensorMode) et {name}_mode_registers[].
+
+    modes: liste de dicts (name, width, height, fps, lane_bitrate_mbps,
+    bayer_pattern, exposure_max, registers=[(addr, value)]), le mode 0 est
+    celui que laisse init_sequence.
+
+    Chaque mode écrit l'union des registres que les modes modifient : le
+    résultat ne dépend pas du mode précédent.
+    """
+    union = sorted({addr for mode in modes for addr, _ in mode['registers']})
+    init_values = {addr: value for addr, value, _ in init_sequence}
+    for addr, value in modes[0]['registers']:
+        if init_values.get(addr) != value:
+            raise ValueError(f"{name} mode {modes[0]['name']}: 0x{addr:04X} diffère de la séquence d'init")
+    code = ''
+    for index, mode in enumerate(modes):
+        values = dict(mode['registers'])
+        missing = [addr for addr in union if addr not in values]
+        if missing:
+            raise ValueError(f"{name} mode {mode['name']}: registres 0x{missing[0]:04X}... non définis")
+        code += generate_init_tables(f'{name}_mode{index}', [(addr, values[addr], 0) for addr in union])
+        code += '\n'
+
+    code += f'static constexpr SensorMode {name}_modes[] = {{\n'
+    for mode in modes:
+        code += (f'    {{"{mode["name"]}", {mode["width"]}, {mode["height"]}, {mode["fps"]}, '
+                 f'{mode["lane_bitrate_mbps"]}, {mode["bayer_pattern"]}, 0x{mode["exposure_max"]:X}}},\n')
+    code += '};\n\n'
+    code += f'static constexpr SensorModeRegisters {name}_mode_registers[] = {{\n'
+    for index in range(len(modes)):
+        table = f'{name}_mode{index}'
+        code += (f'    {{{table}_init_data, {table}_init_bursts, '
+                 f'sizeof({table}_init_bursts) / sizeof({table}_init_bursts[0])}},\n')
+    code += '};\n'
+    return code
+
+
+def generate_driver_factory(sensors):
+    """C++ de create_sensor_driver() pour les capteurs `sensors` (ceux de la config).
+
+    Un seul capteur, déjà validé à la compilation : pas de dispatch au boot.
+    """
+    code = '''
+namespace esphome {
+namespace mipi_dsi_cam {
+
+inline ISensorDriver* create_sensor_driver(const std::string& sensor_type, i2c::I2CDevice* i2c) {
+'''
+    if len(sensors) == 1:
+        code += f'''
+    return new {sensors[0].upper()}Adapter(i2c);
+}}
+'''
+    else:
+        for sensor_id in sensors:
+            code += f'''
+    if (sensor_type == "{sensor_id}") {{
+        return new {sensor_id.upper()}Adapter(i2c);
+    }}
+'''
+        code += '''
+    
+    ESP_LOGE("mipi_dsi_cam", "Unknown sensor type: %s", sensor_type.c_str());
+    return nullptr;
+}
+'''
+    code += '''
+}
+}
+'''
+    return code
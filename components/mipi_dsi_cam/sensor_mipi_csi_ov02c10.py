@@ -1,3 +1,5 @@
+from .sensor_codegen import ISOLATED_REGISTERS, generate_init_tables
+
 SENSOR_INFO = {
     'name': 'ov02c10',
     'manufacturer': 'OmniVision',
@@ -9,6 +11,14 @@ SENSOR_INFO = {
     'width': 1288,
     'height': 728,
     'fps': 30,
+    # Limites d'exposition pour l'AE (en lignes, write_controls_ décale de 4 bits ;
+    # max = (VTS 1164 - marge d'intégration 8) lignes)
+    'exposure_min': 0x10,
+    'exposure_max': 0x484,
+    # Frames encore exposées avec les anciens réglages après un commit exp/gain
+    'apply_delay_frames': 2,
+    # Borne du sondage de l'ID après relâchement du reset (power-up, SCCB prêt)
+    'power_up_ms': 20,
 }
 
 REGISTERS = {
@@ -414,20 +424,11 @@ namespace {SENSOR_INFO['name']}_regs {{
     cpp_code += f'''
 }}
 
-struct {SENSOR_INFO['name'].upper()}InitRegister {{
-    uint16_t addr;
-    uint8_t value;
-    uint16_t delay_ms;
-}};
-
-static const {SENSOR_INFO['name'].upper()}InitRegister {SENSOR_INFO['name']}_init_sequence[] = {{
 '''
     
-    for addr, value, delay in INIT_SEQUENCE:
-        cpp_code += f'    {{0x{addr:04X}, 0x{value:02X}, {delay}}},\n'
+    cpp_code += generate_init_tables(SENSOR_INFO['name'], INIT_SEQUENCE, isolated=ISOLATED_REGISTERS + (REGISTERS['group_hold'],))
     
     cpp_code += f'''
-}};
 
 struct {SENSOR_INFO['name'].upper()}GainRegisters {{
     uint8_t dgain_fine;
@@ -435,7 +436,7 @@ struct {SENSOR_INFO['name'].upper()}GainRegisters {{
     uint8_t analog_gain;
 }};
 
-static const {SENSOR_INFO['name'].upper()}GainRegisters {SENSOR_INFO['name']}_gain_map[] = {{
+static constexpr {SENSOR_INFO['name'].upper()}GainRegisters {SENSOR_INFO['name']}_gain_map[] = {{
 '''
     
     for fine, coarse, analog in GAIN_REGISTERS:
@@ -444,6 +445,16 @@ static const {SENSOR_INFO['name'].upper()}GainRegisters {SENSOR_INFO['name']}_ga
     cpp_code += f'''
 }};
 
+// Gain (x1000) de chaque index de {SENSOR_INFO['name']}_gain_map
+static constexpr uint32_t {SENSOR_INFO['name']}_gain_values[] = {{
+'''
+    
+    for value in GAIN_VALUES[:len(GAIN_REGISTERS)]:
+        cpp_code += f'    {value},\n'
+    
+    cpp_code += f'''
+}};
+
 class {SENSOR_INFO['name'].upper()}Driver {{
 public:
     {SENSOR_INFO['name'].upper()}Driver(esphome::i2c::I2CDevice* i2c) : i2c_(i2c) {{}}
@@ -451,16 +462,14 @@ public:
     esp_err_t init() {{
         ESP_LOGI(TAG, "Init {SENSOR_INFO['name'].upper()} - 1288x728 @ 30fps, 1 lane (ORIGINAL)");
         
-        for (size_t i = 0; i < sizeof({SENSOR_INFO['name']}_init_sequence) / sizeof({SENSOR_INFO['name'].upper()}InitRegister); i++) {{
-            const auto& reg = {SENSOR_INFO['name']}_init_sequence[i];
-            
-            if (reg.delay_ms > 0) {{
-                vTaskDelay(pdMS_TO_TICKS(reg.delay_ms));
-            }}
-            
-            esp_err_t ret = write_register(reg.addr, reg.value);
+        // Le reset logiciel remet tous les registres par défaut
+        shadow_.invalidate();
+        
+        for (const auto& burst : {SENSOR_INFO['name']}_init_bursts) {{
+            // Délai avant l'écriture, sauf reset logiciel : sondé après
+            esp_err_t ret = sensor_write_init_burst(i2c_, burst, {SENSOR_INFO['name']}_init_data, false);
             if (ret != ESP_OK) {{
-                ESP_LOGE(TAG, "Init failed at reg 0x%04X", reg.addr);
+                ESP_LOGE(TAG, "Init failed at reg 0x%04X (+%u)", burst.addr, burst.count);
                 return ret;
             }}
         }}
@@ -501,56 +510,16 @@ public:
     }}
     
     esp_err_t set_gain(uint32_t gain_index) {{
-        if (gain_index >= sizeof({SENSOR_INFO['name']}_gain_map) / sizeof({SENSOR_INFO['name'].upper()}GainRegisters)) {{
-            gain_index = (sizeof({SENSOR_INFO['name']}_gain_map) / sizeof({SENSOR_INFO['name'].upper()}GainRegisters)) - 1;
-        }}
-        
-        const auto& gain = {SENSOR_INFO['name']}_gain_map[gain_index];
-        
-        // Group hold start
-        esp_err_t ret = write_register({SENSOR_INFO['name']}_regs::GROUP_HOLD, 0x00);
-        if (ret != ESP_OK) return ret;
-        
-        // Write gain registers
-        ret = write_register({SENSOR_INFO['name']}_regs::GAIN_DIG_FINE_H, gain.dgain_fine >> 2);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::GAIN_DIG_FINE_L, (gain.dgain_fine & 0x03) << 6);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::GAIN_DIG_COARSE, gain.dgain_coarse);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::GAIN_ANALOG, gain.analog_gain);
-        if (ret != ESP_OK) return ret;
-        
-        // Group hold end
-        ret = write_register({SENSOR_INFO['name']}_regs::GROUP_HOLD, 0x10);
-        return ret;
+        return write_controls_(nullptr, &gain_index);
     }}
     
     esp_err_t set_exposure(uint32_t exposure) {{
-        // OV02C10 exposure format: 16-bit value in registers 0x3500-0x3502
-        uint8_t exp_h = (exposure >> 12) & 0x0F;
-        uint8_t exp_m = (exposure >> 4) & 0xFF;
-        uint8_t exp_l = (exposure & 0x0F) << 4;
-        
-        // Group hold start
-        esp_err_t ret = write_register({SENSOR_INFO['name']}_regs::GROUP_HOLD, 0x00);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::EXPOSURE_H, exp_h);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::EXPOSURE_M, exp_m);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::EXPOSURE_L, exp_l);
-        if (ret != ESP_OK) return ret;
-        
-        // Group hold end
-        ret = write_register({SENSOR_INFO['name']}_regs::GROUP_HOLD, 0x10);
-        return ret;
+        return write_controls_(&exposure, nullptr);
+    }}
+    
+    // Exposition + gain dans le même groupe : appliqués sur la même frame
+    esp_err_t set_exposure_gain(uint32_t exposure, uint32_t gain_index) {{
+        return write_controls_(&exposure, &gain_index);
     }}
     
     esp_err_t write_register(uint16_t reg, uint8_t value) {{
@@ -565,6 +534,7 @@ public:
             ESP_LOGE(TAG, "Failed to write reg 0x%04X, error: %d", reg, err);
             return ESP_FAIL;
         }}
+        shadow_.refresh(reg, value);
         return ESP_OK;
     }}
     
@@ -592,7 +562,67 @@ public:
     }}
     
 private:
+    esp_err_t write_controls_(const uint32_t* exposure, const uint32_t* gain_index) {{
+        // OV02C10 exposure format: 16-bit value in registers 0x3500-0x3502
+        uint8_t exp[3] = {{0, 0, 0}};
+        if (exposure != nullptr) {{
+            exp[0] = (*exposure >> 12) & 0x0F;
+            exp[1] = (*exposure >> 4) & 0xFF;
+            exp[2] = (*exposure & 0x0F) << 4;
+        }}
+        
+        const {SENSOR_INFO['name'].upper()}GainRegisters* gain = nullptr;
+        uint8_t fine[2] = {{0, 0}};
+        if (gain_index != nullptr) {{
+            const size_t count = sizeof({SENSOR_INFO['name']}_gain_map) / sizeof({SENSOR_INFO['name'].upper()}GainRegisters);
+            gain = &{SENSOR_INFO['name']}_gain_map[*gain_index < count ? *gain_index : count - 1];
+            fine[0] = gain->dgain_fine >> 2;
+            fine[1] = (gain->dgain_fine & 0x03) << 6;
+        }}
+        
+        // Rien à écrire : pas de group hold non plus
+        bool exp_same = exposure == nullptr || shadow_.matches({SENSOR_INFO['name']}_regs::EXPOSURE_H, exp, 3);
+        bool gain_same = gain == nullptr ||
+            (shadow_.matches({SENSOR_INFO['name']}_regs::GAIN_DIG_FINE_H, fine, 2) &&
+             shadow_.matches({SENSOR_INFO['name']}_regs::GAIN_DIG_COARSE, gain->dgain_coarse) &&
+             shadow_.matches({SENSOR_INFO['name']}_regs::GAIN_ANALOG, gain->analog_gain));
+        if (exp_same && gain_same) {{
+            return ESP_OK;
+        }}
+        
+        // Group hold start (groupe 0)
+        esp_err_t ret = write_register({SENSOR_INFO['name']}_regs::GROUP_HOLD, 0x00);
+        if (ret != ESP_OK) return ret;
+        
+        if (!exp_same) {{
+            ret = shadow_.write(i2c_, {SENSOR_INFO['name']}_regs::EXPOSURE_H, exp, 3);
+        }}
+        if (ret == ESP_OK && !gain_same) {{
+            ret = shadow_.write(i2c_, {SENSOR_INFO['name']}_regs::GAIN_DIG_FINE_H, fine, 2);
+            if (ret == ESP_OK) {{
+                ret = shadow_.write(i2c_, {SENSOR_INFO['name']}_regs::GAIN_DIG_COARSE, &gain->dgain_coarse, 1);
+            }}
+            if (ret == ESP_OK) {{
+                ret = shadow_.write(i2c_, {SENSOR_INFO['name']}_regs::GAIN_ANALOG, &gain->analog_gain, 1);
+            }}
+        }}
+        
+        // Group hold end, puis lancement : le groupe est appliqué au début de la frame suivante.
+        // Même après une erreur : un groupe resté ouvert garderait pour lui toutes les
+        // écritures suivantes (stop, tables de mode, AE). Le shadow ne retient que ce qui
+        // est passé, c'est bien ce que le lancement applique.
+        esp_err_t end = write_register({SENSOR_INFO['name']}_regs::GROUP_HOLD, 0x10);
+        if (end == ESP_OK) {{
+            end = write_register({SENSOR_INFO['name']}_regs::GROUP_HOLD, 0xA0);
+        }}
+        if (end != ESP_OK) {{
+            ESP_LOGE(TAG, "Group hold close failed");
+        }}
+        return ret != ESP_OK ? ret : end;
+    }}
+    
     esphome::i2c::I2CDevice* i2c_;
+    SensorRegisterShadow shadow_;
     static constexpr const char* TAG = "{SENSOR_INFO['name'].upper()}";
 }};
 
@@ -610,12 +640,23 @@ public:
     uint16_t get_height() const override {{ return {SENSOR_INFO['height']}; }}
     uint8_t get_fps() const override {{ return {SENSOR_INFO['fps']}; }}
     
+    size_t get_gain_count() const override {{ return sizeof({SENSOR_INFO['name']}_gain_values) / sizeof({SENSOR_INFO['name']}_gain_values[0]); }}
+    uint32_t get_gain_value(uint32_t gain_index) const override {{
+        return {SENSOR_INFO['name']}_gain_values[gain_index < get_gain_count() ? gain_index : get_gain_count() - 1];
+    }}
+    uint32_t get_exposure_min() const override {{ return {SENSOR_INFO['exposure_min']}; }}
+    uint32_t get_exposure_max() const override {{ return {SENSOR_INFO['exposure_max']}; }}
+    uint8_t get_apply_delay_frames() const override {{ return {SENSOR_INFO['apply_delay_frames']}; }}
+    uint16_t get_power_up_ms() const override {{ return {SENSOR_INFO['power_up_ms']}; }}
+    
     esp_err_t init() override {{ return driver_.init(); }}
     esp_err_t read_id(uint16_t* pid) override {{ return driver_.read_id(pid); }}
     esp_err_t start_stream() override {{ return driver_.start_stream(); }}
     esp_err_t stop_stream() override {{ return driver_.stop_stream(); }}
     esp_err_t set_gain(uint32_t gain_index) override {{ return driver_.set_gain(gain_index); }}
     esp_err_t set_exposure(uint32_t exposure) override {{ return driver_.set_exposure(exposure); }}
+    esp_err_t set_exposure_gain(uint32_t exposure, uint32_t gain_index) override {{ return driver_.set_exposure_gain(exposure, gain_index); }}
+    bool has_group_hold() const override {{ return true; }}
     esp_err_t write_register(uint16_t reg, uint8_t value) override {{ return driver_.write_register(reg, value); }}
     esp_err_t read_register(uint16_t reg, uint8_t* value) override {{ return driver_.read_register(reg, value); }}
     
@@ -1,3 +1,5 @@
+from .sensor_codegen import generate_init_tables, generate_mode_tables
+
 SENSOR_INFO = {
     'name': 'ov5647',
     'manufacturer': 'OmniVision',
@@ -9,6 +11,13 @@ SENSOR_INFO = {
     'width': 800,
     'height': 640,
     'fps': 50,
+    # Limites d'exposition pour l'AE (1/16 de ligne, max = (VTS 984 - 4) lignes)
+    'exposure_min': 0x10,
+    'exposure_max': 0x3D40,
+    # Frames encore exposées avec les anciens réglages après un commit exp/gain
+    'apply_delay_frames': 2,
+    # Borne du sondage de l'ID après relâchement du reset (power-up, SCCB prêt)
+    'power_up_ms': 20,
 }
 
 REGISTERS = {
@@ -148,6 +157,48 @@ INIT_SEQUENCE = [
     (0x4051, 0x8f, 0),
 ]
 
+# Modes sélectionnables à chaud (MipiDsiCam::set_mode), le mode 0 est celui de
+# INIT_SEQUENCE. Même PLL et même binning : seuls la fenêtre verticale, la
+# hauteur de sortie et le VTS changent.
+MODES = [
+    {
+        'name': f"{SENSOR_INFO['width']}x{SENSOR_INFO['height']}",
+        'width': SENSOR_INFO['width'],
+        'height': SENSOR_INFO['height'],
+        'fps': SENSOR_INFO['fps'],
+        'lane_bitrate_mbps': SENSOR_INFO['lane_bitrate_mbps'],
+        'bayer_pattern': SENSOR_INFO['bayer_pattern'],
+        'exposure_max': SENSOR_INFO['exposure_max'],
+        'registers': [
+            (0x3803, 0x00),  # Y start L: 0
+            (0x3806, 0x07),  # Y end: 1953
+            (0x3807, 0xa1),
+            (0x380a, 0x02),  # Height: 640
+            (0x380b, 0x80),
+            (0x380e, 0x03),  # VTS: 984 lines
+            (0x380f, 0xd8),
+        ],
+    },
+    {
+        'name': '800x480',
+        'width': 800,
+        'height': 480,
+        'fps': 60,
+        'lane_bitrate_mbps': 400,
+        'bayer_pattern': 1,
+        'exposure_max': 0x2DE0,
+        'registers': [
+            (0x3803, 0xb4),  # Y start L: 180
+            (0x3806, 0x06),  # Y end: 1613
+            (0x3807, 0x4d),
+            (0x380a, 0x01),  # Height: 480
+            (0x380b, 0xe0),
+            (0x380e, 0x02),  # VTS: 738 lines
+            (0x380f, 0xe2),
+        ],
+    },
+]
+
 # Tables de gain (identiques)
 GAIN_VALUES = [
     1000, 1062, 1125, 1187, 1250, 1312, 1375, 1437,
@@ -193,27 +244,20 @@ namespace {SENSOR_INFO['name']}_regs {{
     cpp_code += f'''
 }}
 
-struct {SENSOR_INFO['name'].upper()}InitRegister {{
-    uint16_t addr;
-    uint8_t value;
-    uint16_t delay_ms;
-}};
-
-static const {SENSOR_INFO['name'].upper()}InitRegister {SENSOR_INFO['name']}_init_sequence[] = {{
 '''
     
-    for addr, value, delay in INIT_SEQUENCE:
-        cpp_code += f'    {{0x{addr:04X}, 0x{value:02X}, {delay}}},\n'
+    cpp_code += generate_init_tables(SENSOR_INFO['name'], INIT_SEQUENCE)
+    cpp_code += '\n'
+    cpp_code += generate_mode_tables(SENSOR_INFO['name'], MODES, INIT_SEQUENCE)
     
     cpp_code += f'''
-}};
 
 struct {SENSOR_INFO['name'].upper()}GainRegisters {{
     uint8_t gain_h;
     uint8_t gain_l;
 }};
 
-static const {SENSOR_INFO['name'].upper()}GainRegisters {SENSOR_INFO['name']}_gain_map[] = {{
+static constexpr {SENSOR_INFO['name'].upper()}GainRegisters {SENSOR_INFO['name']}_gain_map[] = {{
 '''
     
     for gain_h, gain_l in GAIN_REGISTERS:
@@ -222,6 +266,16 @@ static const {SENSOR_INFO['name'].upper()}GainRegisters {SENSOR_INFO['name']}_ga
     cpp_code += f'''
 }};
 
+// Gain (x1000) de chaque index de {SENSOR_INFO['name']}_gain_map
+static constexpr uint32_t {SENSOR_INFO['name']}_gain_values[] = {{
+'''
+    
+    for value in GAIN_VALUES[:len(GAIN_REGISTERS)]:
+        cpp_code += f'    {value},\n'
+    
+    cpp_code += f'''
+}};
+
 class {SENSOR_INFO['name'].upper()}Driver {{
 public:
     {SENSOR_INFO['name'].upper()}Driver(esphome::i2c::I2CDevice* i2c) : i2c_(i2c) {{}}
@@ -229,16 +283,14 @@ public:
     esp_err_t init() {{
         ESP_LOGI(TAG, "Init {SENSOR_INFO['name'].upper()} - 800x640@50fps (from tab5_camera)");
         
-        for (size_t i = 0; i < sizeof({SENSOR_INFO['name']}_init_sequence) / sizeof({SENSOR_INFO['name'].upper()}InitRegister); i++) {{
-            const auto& reg = {SENSOR_INFO['name']}_init_sequence[i];
-            
-            if (reg.delay_ms > 0) {{
-                vTaskDelay(pdMS_TO_TICKS(reg.delay_ms));
-            }}
-            
-            esp_err_t ret = write_register(reg.addr, reg.value);
+        // Le reset logiciel remet tous les registres par défaut
+        shadow_.invalidate();
+        
+        for (const auto& burst : {SENSOR_INFO['name']}_init_bursts) {{
+            // Délai avant l'écriture, sauf reset logiciel : sondé après
+            esp_err_t ret = sensor_write_init_burst(i2c_, burst, {SENSOR_INFO['name']}_init_data, false);
             if (ret != ESP_OK) {{
-                ESP_LOGE(TAG, "Init failed at reg 0x%04X", reg.addr);
+                ESP_LOGE(TAG, "Init failed at reg 0x%04X (+%u)", burst.addr, burst.count);
                 return ret;
             }}
         }}
@@ -247,6 +299,15 @@ public:
         return ESP_OK;
     }}
     
+    // Flux arrêté : pris en compte au prochain start_stream()
+    esp_err_t set_mode(uint8_t index) {{
+        esp_err_t ret = sensor_write_mode(i2c_, {SENSOR_INFO['name']}_mode_registers[index]);
+        if (ret != ESP_OK) {{
+            ESP_LOGE(TAG, "Mode %s failed", {SENSOR_INFO['name']}_modes[index].name);
+        }}
+        return ret;
+    }}
+    
     esp_err_t read_id(uint16_t* pid) {{
         uint8_t pid_h, pid_l;
         
@@ -275,11 +336,8 @@ public:
         
         const auto& gain = {SENSOR_INFO['name']}_gain_map[gain_index];
         
-        esp_err_t ret = write_register({SENSOR_INFO['name']}_regs::GAIN_H, gain.gain_h);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::GAIN_L, gain.gain_l);
-        return ret;
+        const uint8_t values[2] = {{gain.gain_h, gain.gain_l}};
+        return shadow_.write(i2c_, {SENSOR_INFO['name']}_regs::GAIN_H, values, 2);
     }}
     
     esp_err_t set_exposure(uint32_t exposure) {{
@@ -287,14 +345,9 @@ public:
         uint8_t exp_m = (exposure >> 8) & 0xFF;
         uint8_t exp_l = exposure & 0xFF;
         
-        esp_err_t ret = write_register({SENSOR_INFO['name']}_regs::EXPOSURE_H, exp_h);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::EXPOSURE_M, exp_m);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::EXPOSURE_L, exp_l);
-        return ret;
+        // EXPOSURE_H/M/L consécutifs : un seul burst, limité aux octets qui changent
+        const uint8_t values[3] = {{exp_h, exp_m, exp_l}};
+        return shadow_.write(i2c_, {SENSOR_INFO['name']}_regs::EXPOSURE_H, values, 3);
     }}
     
     esp_err_t write_register(uint16_t reg, uint8_t value) {{
@@ -309,6 +362,7 @@ public:
             ESP_LOGE(TAG, "I2C write failed for reg 0x%04X", reg);
             return ESP_FAIL;
         }}
+        shadow_.refresh(reg, value);
         return ESP_OK;
     }}
     
@@ -331,6 +385,7 @@ public:
     
 private:
     esphome::i2c::I2CDevice* i2c_;
+    SensorRegisterShadow shadow_;
     static constexpr const char* TAG = "{SENSOR_INFO['name'].upper()}";
 }};
 
@@ -342,13 +397,36 @@ public:
     uint16_t get_pid() const override {{ return 0x{SENSOR_INFO['pid']:04X}; }}
     uint8_t get_i2c_address() const override {{ return 0x{SENSOR_INFO['i2c_address']:02X}; }}
     uint8_t get_lane_count() const override {{ return {SENSOR_INFO['lane_count']}; }}
-    uint8_t get_bayer_pattern() const override {{ return {SENSOR_INFO['bayer_pattern']}; }}
-    uint16_t get_lane_bitrate_mbps() const override {{ return {SENSOR_INFO['lane_bitrate_mbps']}; }}
-    uint16_t get_width() const override {{ return {SENSOR_INFO['width']}; }}
-    uint16_t get_height() const override {{ return {SENSOR_INFO['height']}; }}
-    uint8_t get_fps() const override {{ return {SENSOR_INFO['fps']}; }}
+    uint8_t get_bayer_pattern() const override {{ return mode_info_().bayer_pattern; }}
+    uint16_t get_lane_bitrate_mbps() const override {{ return mode_info_().lane_bitrate_mbps; }}
+    uint16_t get_width() const override {{ return mode_info_().width; }}
+    uint16_t get_height() const override {{ return mode_info_().height; }}
+    uint8_t get_fps() const override {{ return mode_info_().fps; }}
+    
+    size_t get_gain_count() const override {{ return sizeof({SENSOR_INFO['name']}_gain_values) / sizeof({SENSOR_INFO['name']}_gain_values[0]); }}
+    uint32_t get_gain_value(uint32_t gain_index) const override {{
+        return {SENSOR_INFO['name']}_gain_values[gain_index < get_gain_count() ? gain_index : get_gain_count() - 1];
+    }}
+    uint32_t get_exposure_min() const override {{ return {SENSOR_INFO['exposure_min']}; }}
+    uint32_t get_exposure_max() const override {{ return mode_info_().exposure_max; }}
+    uint8_t get_apply_delay_frames() const override {{ return {SENSOR_INFO['apply_delay_frames']}; }}
+    uint16_t get_power_up_ms() const override {{ return {SENSOR_INFO['power_up_ms']}; }}
+    
+    uint8_t get_mode_count() const override {{ return sizeof({SENSOR_INFO['name']}_modes) / sizeof({SENSOR_INFO['name']}_modes[0]); }}
+    SensorMode get_mode(uint8_t index) const override {{ return {SENSOR_INFO['name']}_modes[index < get_mode_count() ? index : 0]; }}
+    uint8_t get_current_mode() const override {{ return mode_; }}
+    esp_err_t set_mode(uint8_t index) override {{
+        if (index >= get_mode_count()) return ESP_ERR_INVALID_ARG;
+        esp_err_t ret = driver_.set_mode(index);
+        if (ret == ESP_OK) mode_ = index;
+        return ret;
+    }}
     
-    esp_err_t init() override {{ return driver_.init(); }}
+    esp_err_t init() override {{
+        // Le reset logiciel ramène le capteur au mode 0
+        mode_ = 0;
+        return driver_.init();
+    }}
     esp_err_t read_id(uint16_t* pid) override {{ return driver_.read_id(pid); }}
     esp_err_t start_stream() override {{ return driver_.start_stream(); }}
     esp_err_t stop_stream() override {{ return driver_.stop_stream(); }}
@@ -358,7 +436,10 @@ public:
     esp_err_t read_register(uint16_t reg, uint8_t* value) override {{ return driver_.read_register(reg, value); }}
     
 private:
+    const SensorMode& mode_info_() const {{ return {SENSOR_INFO['name']}_modes[mode_]; }}
+    
     {SENSOR_INFO['name'].upper()}Driver driver_;
+    uint8_t mode_{{0}};
 }};
 
 }}
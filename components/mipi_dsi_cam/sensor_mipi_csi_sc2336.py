@@ -1,3 +1,5 @@
+from .sensor_codegen import generate_init_tables
+
 SENSOR_INFO = {
     'name': 'sc2336',
     'manufacturer': 'SmartSens',
@@ -9,6 +11,13 @@ SENSOR_INFO = {
     'width': 1280,
     'height': 720,
     'fps': 30,
+    # Limites d'exposition pour l'AE (demi-lignes, max = 2 x VTS 1250 - 10)
+    'exposure_min': 0x8,
+    'exposure_max': 0x9BA,
+    # Frames encore exposées avec les anciens réglages après un commit exp/gain
+    'apply_delay_frames': 2,
+    # Borne du sondage de l'ID après relâchement du reset (power-up, SCCB prêt)
+    'power_up_ms': 20,
 }
 
 REGISTERS = {
@@ -249,20 +258,11 @@ namespace {SENSOR_INFO['name']}_regs {{
     cpp_code += f'''
 }}
 
-struct {SENSOR_INFO['name'].upper()}InitRegister {{
-    uint16_t addr;
-    uint8_t value;
-    uint16_t delay_ms;
-}};
-
-static const {SENSOR_INFO['name'].upper()}InitRegister {SENSOR_INFO['name']}_init_sequence[] = {{
 '''
     
-    for addr, value, delay in INIT_SEQUENCE:
-        cpp_code += f'    {{0x{addr:04X}, 0x{value:02X}, {delay}}},\n'
+    cpp_code += generate_init_tables(SENSOR_INFO['name'], INIT_SEQUENCE)
     
     cpp_code += f'''
-}};
 
 struct {SENSOR_INFO['name'].upper()}GainRegisters {{
     uint8_t dgain_fine;
@@ -270,7 +270,7 @@ struct {SENSOR_INFO['name'].upper()}GainRegisters {{
     uint8_t analog_gain;
 }};
 
-static const {SENSOR_INFO['name'].upper()}GainRegisters {SENSOR_INFO['name']}_gain_map[] = {{
+static constexpr {SENSOR_INFO['name'].upper()}GainRegisters {SENSOR_INFO['name']}_gain_map[] = {{
 '''
     
     for fine, coarse, analog in GAIN_REGISTERS:
@@ -279,6 +279,16 @@ static const {SENSOR_INFO['name'].upper()}GainRegisters {SENSOR_INFO['name']}_ga
     cpp_code += f'''
 }};
 
+// Gain (x1000) de chaque index de {SENSOR_INFO['name']}_gain_map
+static constexpr uint32_t {SENSOR_INFO['name']}_gain_values[] = {{
+'''
+    
+    for value in GAIN_VALUES[:len(GAIN_REGISTERS)]:
+        cpp_code += f'    {value},\n'
+    
+    cpp_code += f'''
+}};
+
 class {SENSOR_INFO['name'].upper()}Driver {{
 public:
     {SENSOR_INFO['name'].upper()}Driver(esphome::i2c::I2CDevice* i2c) : i2c_(i2c) {{}}
@@ -286,16 +296,14 @@ public:
     esp_err_t init() {{
         ESP_LOGI(TAG, "Init {SENSOR_INFO['name'].upper()}");
         
-        for (size_t i = 0; i < sizeof({SENSOR_INFO['name']}_init_sequence) / sizeof({SENSOR_INFO['name'].upper()}InitRegister); i++) {{
-            const auto& reg = {SENSOR_INFO['name']}_init_sequence[i];
-            
-            if (reg.delay_ms > 0) {{
-                vTaskDelay(pdMS_TO_TICKS(reg.delay_ms));
-            }}
-            
-            esp_err_t ret = write_register(reg.addr, reg.value);
+        // Le reset logiciel remet tous les registres par défaut
+        shadow_.invalidate();
+        
+        for (const auto& burst : {SENSOR_INFO['name']}_init_bursts) {{
+            // Délai avant l'écriture, sauf reset logiciel : sondé après
+            esp_err_t ret = sensor_write_init_burst(i2c_, burst, {SENSOR_INFO['name']}_init_data, false);
             if (ret != ESP_OK) {{
-                ESP_LOGE(TAG, "Init failed at reg 0x%04X", reg.addr);
+                ESP_LOGE(TAG, "Init failed at reg 0x%04X (+%u)", burst.addr, burst.count);
                 return ret;
             }}
         }}
@@ -332,14 +340,12 @@ public:
         
         const auto& gain = {SENSOR_INFO['name']}_gain_map[gain_index];
         
-        esp_err_t ret = write_register({SENSOR_INFO['name']}_regs::GAIN_FINE, gain.dgain_fine);
+        // GAIN_COARSE (0x3E06) puis GAIN_FINE (0x3E07) : consécutifs
+        const uint8_t digital[2] = {{gain.dgain_coarse, gain.dgain_fine}};
+        esp_err_t ret = shadow_.write(i2c_, {SENSOR_INFO['name']}_regs::GAIN_COARSE, digital, 2);
         if (ret != ESP_OK) return ret;
         
-        ret = write_register({SENSOR_INFO['name']}_regs::GAIN_COARSE, gain.dgain_coarse);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::GAIN_ANALOG, gain.analog_gain);
-        return ret;
+        return shadow_.write(i2c_, {SENSOR_INFO['name']}_regs::GAIN_ANALOG, &gain.analog_gain, 1);
     }}
     
     esp_err_t set_exposure(uint32_t exposure) {{
@@ -347,14 +353,9 @@ public:
         uint8_t exp_m = (exposure >> 4) & 0xFF;
         uint8_t exp_l = (exposure & 0x0F) << 4;
         
-        esp_err_t ret = write_register({SENSOR_INFO['name']}_regs::EXPOSURE_H, exp_h);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::EXPOSURE_M, exp_m);
-        if (ret != ESP_OK) return ret;
-        
-        ret = write_register({SENSOR_INFO['name']}_regs::EXPOSURE_L, exp_l);
-        return ret;
+        // EXPOSURE_H/M/L consécutifs : un seul burst, limité aux octets qui changent
+        const uint8_t values[3] = {{exp_h, exp_m, exp_l}};
+        return shadow_.write(i2c_, {SENSOR_INFO['name']}_regs::EXPOSURE_H, values, 3);
     }}
     
     esp_err_t write_register(uint16_t reg, uint8_t value) {{
@@ -369,6 +370,7 @@ public:
             ESP_LOGE(TAG, "I2C write failed for reg 0x%04X", reg);
             return ESP_FAIL;
         }}
+        shadow_.refresh(reg, value);
         return ESP_OK;
     }}
     
@@ -391,6 +393,7 @@ public:
     
 private:
     esphome::i2c::I2CDevice* i2c_;
+    SensorRegisterShadow shadow_;
     static constexpr const char* TAG = "{SENSOR_INFO['name'].upper()}";
 }};
 
@@ -408,6 +411,15 @@ public:
     uint16_t get_height() const override {{ return {SENSOR_INFO['height']}; }}
     uint8_t get_fps() const override {{ return {SENSOR_INFO['fps']}; }}
     
+    size_t get_gain_count() const override {{ return sizeof({SENSOR_INFO['name']}_gain_values) / sizeof({SENSOR_INFO['name']}_gain_values[0]); }}
+    uint32_t get_gain_value(uint32_t gain_index) const override {{
+        return {SENSOR_INFO['name']}_gain_values[gain_index < get_gain_count() ? gain_index : get_gain_count() - 1];
+    }}
+    uint32_t get_exposure_min() const override {{ return {SENSOR_INFO['exposure_min']}; }}
+    uint32_t get_exposure_max() const override {{ return {SENSOR_INFO['exposure_max']}; }}
+    uint8_t get_apply_delay_frames() const override {{ return {SENSOR_INFO['apply_delay_frames']}; }}
+    uint16_t get_power_up_ms() const override {{ return {SENSOR_INFO['power_up_ms']}; }}
+    
     esp_err_t init() override {{ return driver_.init(); }}
     esp_err_t read_id(uint16_t* pid) override {{ return driver_.read_id(pid); }}
     esp_err_t start_stream() override {{ return driver_.start_stream(); }}
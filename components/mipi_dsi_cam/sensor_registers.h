@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esphome/components/i2c/i2c.h"
+#include "capture_backend.h"
+
+// Partagé par les drivers capteur générés (mipi_dsi_cam_drivers_generated.h).
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Valeurs par rafale, à garder en phase avec sensor_codegen.MAX_BURST
+static constexpr uint8_t SENSOR_MAX_BURST = 32;
+
+// Suite de registres consécutifs d'une séquence d'init, regroupés par
+// sensor_codegen.py. Les valeurs sont dans le tableau plat d'init du capteur.
+struct SensorInitBurst {
+  uint16_t addr;
+  uint16_t offset;
+  uint8_t count;
+  uint16_t delay_ms;
+};
+
+// Registres qu'un mode capteur écrit par-dessus la séquence d'init
+// (sensor_codegen.generate_mode_tables).
+struct SensorModeRegisters {
+  const uint8_t *data;
+  const SensorInitBurst *bursts;
+  uint8_t burst_count;
+};
+
+// Une transaction I2C : adresse de départ sur 16 bits puis les valeurs, le
+// capteur incrémente l'adresse de registre après chaque octet.
+inline esp_err_t sensor_write_burst(i2c::I2CDevice *i2c, uint16_t reg, const uint8_t *values, uint8_t count) {
+  if (count == 0 || count > SENSOR_MAX_BURST) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  uint8_t data[2 + SENSOR_MAX_BURST];
+  data[0] = static_cast<uint8_t>((reg >> 8) & 0xFF);
+  data[1] = static_cast<uint8_t>(reg & 0xFF);
+  for (uint8_t i = 0; i < count; i++) {
+    data[2 + i] = values[i];
+  }
+  return i2c->write_read(data, 2 + count, nullptr, 0) == i2c::ERROR_OK ? ESP_OK : ESP_FAIL;
+}
+
+// software_reset MIPI, à garder en phase avec sensor_codegen.ISOLATED_REGISTERS
+static constexpr uint16_t SENSOR_SOFTWARE_RESET = 0x0103;
+
+// Le bit de reset logiciel retombe tout seul quand le capteur est revenu : on
+// le sonde plutôt que d'attendre le pire cas, `timeout_ms` borne l'attente.
+// Entre-temps le capteur peut ne pas répondre du tout (NACK), ce n'est pas une
+// erreur.
+inline bool sensor_wait_reset_done(i2c::I2CDevice *i2c, uint16_t timeout_ms) {
+  const uint8_t addr[2] = {static_cast<uint8_t>(SENSOR_SOFTWARE_RESET >> 8),
+                           static_cast<uint8_t>(SENSOR_SOFTWARE_RESET & 0xFF)};
+  for (uint16_t waited = 0;; waited++) {
+    // 1 ms minimum : le bit peut se relire à 0 avant le début du reset
+    vTaskDelay(pdMS_TO_TICKS(1));
+    uint8_t value;
+    if (i2c->write_read(addr, 2, &value, 1) == i2c::ERROR_OK && (value & 0x01) == 0) {
+      return true;
+    }
+    if (waited + 1 >= timeout_ms) {
+      return false;
+    }
+  }
+}
+
+// Une entrée d'une table d'init. Son délai est une attente avant l'écriture
+// (après avec delay_after), sauf sur le reset logiciel où il borne seulement
+// le sondage qui suit l'écriture.
+inline esp_err_t sensor_write_init_burst(i2c::I2CDevice *i2c, const SensorInitBurst &burst, const uint8_t *data,
+                                         bool delay_after) {
+  const bool reset = burst.addr == SENSOR_SOFTWARE_RESET && burst.count == 1 && (data[burst.offset] & 0x01);
+  if (burst.delay_ms > 0 && !delay_after && !reset) {
+    vTaskDelay(pdMS_TO_TICKS(burst.delay_ms));
+  }
+  esp_err_t ret = sensor_write_burst(i2c, burst.addr, &data[burst.offset], burst.count);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  if (reset) {
+    // Au-delà de la borne : on continue comme l'ancienne attente fixe
+    sensor_wait_reset_done(i2c, burst.delay_ms > 0 ? burst.delay_ms : 10);
+  } else if (burst.delay_ms > 0 && delay_after) {
+    vTaskDelay(pdMS_TO_TICKS(burst.delay_ms));
+  }
+  return ESP_OK;
+}
+
+inline esp_err_t sensor_write_mode(i2c::I2CDevice *i2c, const SensorModeRegisters &mode) {
+  for (uint8_t i = 0; i < mode.burst_count; i++) {
+    const SensorInitBurst &burst = mode.bursts[i];
+    esp_err_t ret = sensor_write_burst(i2c, burst.addr, &mode.data[burst.offset], burst.count);
+    if (ret != ESP_OK) {
+      return ret;
+    }
+  }
+  return ESP_OK;
+}
+
+// Dernière valeur écrite dans les registres de contrôle (exposition, gain...) :
+// un pas d'AE qui laisse un registre inchangé ne coûte aucune transaction I2C.
+// Oubliée à l'init(), le reset du capteur remet tous les registres par défaut.
+class SensorRegisterShadow {
+ public:
+  static constexpr uint8_t CAPACITY = 16;
+
+  bool matches(uint16_t reg, uint8_t value) const {
+    int8_t i = this->find_(reg);
+    return i >= 0 && this->values_[i] == value;
+  }
+  bool matches(uint16_t reg, const uint8_t *values, uint8_t count) const {
+    for (uint8_t i = 0; i < count; i++) {
+      if (!this->matches(reg + i, values[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Écrit en une rafale les registres consécutifs qui ont changé et les mémorise.
+  esp_err_t write(i2c::I2CDevice *i2c, uint16_t reg, const uint8_t *values, uint8_t count) {
+    uint8_t first = 0;
+    while (first < count && this->matches(reg + first, values[first])) {
+      first++;
+    }
+    if (first == count) {
+      return ESP_OK;
+    }
+    uint8_t last = count - 1;
+    while (this->matches(reg + last, values[last])) {
+      last--;
+    }
+    esp_err_t ret = sensor_write_burst(i2c, reg + first, values + first, last - first + 1);
+    if (ret != ESP_OK) {
+      // État du capteur inconnu : réécrire la prochaine fois
+      for (uint8_t i = first; i <= last; i++) {
+        this->forget_(reg + i);
+      }
+      return ret;
+    }
+    for (uint8_t i = first; i <= last; i++) {
+      this->store_(reg + i, values[i]);
+    }
+    return ESP_OK;
+  }
+
+  // Garde un registre suivi cohérent après un write_register() hors cache.
+  void refresh(uint16_t reg, uint8_t value) {
+    int8_t i = this->find_(reg);
+    if (i >= 0) {
+      this->values_[i] = value;
+    }
+  }
+
+  void invalidate() { this->count_ = 0; }
+
+ protected:
+  int8_t find_(uint16_t reg) const {
+    for (uint8_t i = 0; i < this->count_; i++) {
+      if (this->regs_[i] == reg) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  void store_(uint16_t reg, uint8_t value) {
+    int8_t i = this->find_(reg);
+    if (i < 0) {
+      i = this->count_ < CAPACITY ? this->count_++ : this->next_evict_++ % CAPACITY;
+      this->regs_[i] = reg;
+    }
+    this->values_[i] = value;
+  }
+
+  void forget_(uint16_t reg) {
+    int8_t i = this->find_(reg);
+    if (i >= 0) {
+      this->regs_[i] = this->regs_[--this->count_];
+      this->values_[i] = this->values_[this->count_];
+    }
+  }
+
+  uint16_t regs_[CAPACITY]{};
+  uint8_t values_[CAPACITY]{};
+  uint8_t count_{0};
+  uint8_t next_evict_{0};
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
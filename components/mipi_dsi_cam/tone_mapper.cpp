@@ -0,0 +1,100 @@
+#include "tone_mapper.h"
+
+#include <cmath>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// Les gains WB bougent un peu à chaque frame : reconstruire au-delà seulement
+static const float GAIN_EPSILON = 0.005f;
+static const float PARAM_EPSILON = 0.001f;
+
+static bool differs(float a, float b, float epsilon) { return std::fabs(a - b) > epsilon; }
+
+bool ToneParams::is_identity() const {
+  return !differs(this->gain_r, 1.0f, PARAM_EPSILON) && !differs(this->gain_g, 1.0f, PARAM_EPSILON) &&
+         !differs(this->gain_b, 1.0f, PARAM_EPSILON) && !differs(this->gamma, 1.0f, PARAM_EPSILON) &&
+         !differs(this->contrast, 1.0f, PARAM_EPSILON) && this->brightness == 0 &&
+         !differs(this->saturation, 1.0f, PARAM_EPSILON);
+}
+
+void ToneMapper::set_params(const ToneParams &params) {
+  const ToneParams &cur = this->params_;
+  if (differs(params.gain_r, cur.gain_r, GAIN_EPSILON) || differs(params.gain_g, cur.gain_g, GAIN_EPSILON) ||
+      differs(params.gain_b, cur.gain_b, GAIN_EPSILON) || differs(params.gamma, cur.gamma, PARAM_EPSILON) ||
+      differs(params.contrast, cur.contrast, PARAM_EPSILON) || params.brightness != cur.brightness ||
+      differs(params.saturation, cur.saturation, PARAM_EPSILON)) {
+    this->params_ = params;
+    this->dirty_ = true;
+  }
+}
+
+// Un canal : gain WB, puis gamma, contraste autour du gris moyen, luminosité.
+// Entrée sur 5/6 bits, sortie 0-255.
+static void build_channel(uint8_t *out, uint8_t levels, float gain, const ToneParams &p) {
+  float inv_gamma = p.gamma > 0.01f ? 1.0f / p.gamma : 1.0f;
+  float offset = p.brightness / 200.0f;
+  for (uint8_t v = 0; v < levels; v++) {
+    float x = v * gain / (levels - 1);
+    if (x > 1.0f)
+      x = 1.0f;
+    x = std::pow(x, inv_gamma);
+    x = (x - 0.5f) * p.contrast + 0.5f + offset;
+    int32_t y = (int32_t) (x * 255.0f + 0.5f);
+    out[v] = y < 0 ? 0 : (y > 255 ? 255 : y);
+  }
+}
+
+static inline uint32_t clamp8(int32_t v) { return v < 0 ? 0 : (v > 255 ? 255 : v); }
+
+bool ToneMapper::prepare() {
+  if (!this->dirty_ || this->lut_ == nullptr)
+    return false;
+
+  uint8_t tr[32], tg[64], tb[32];
+  build_channel(tr, 32, this->params_.gain_r, this->params_);
+  build_channel(tg, 64, this->params_.gain_g, this->params_);
+  build_channel(tb, 32, this->params_.gain_b, this->params_);
+  // La saturation mélange les canaux : c'est elle qui impose la table 16 bits complète
+  int32_t sat = (int32_t) (this->params_.saturation * 256.0f + 0.5f);
+
+  uint16_t *lut = this->lut_;
+  for (uint32_t p = 0; p < LUT_SIZE; p++) {
+    int32_t r = tr[p >> 11];
+    int32_t g = tg[(p >> 5) & 0x3F];
+    int32_t b = tb[p & 0x1F];
+    if (sat != 256) {
+      int32_t y = (77 * r + 150 * g + 29 * b) >> 8;
+      r = clamp8(y + (((r - y) * sat) >> 8));
+      g = clamp8(y + (((g - y) * sat) >> 8));
+      b = clamp8(y + (((b - y) * sat) >> 8));
+    }
+    lut[p] = (((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255);
+  }
+  this->dirty_ = false;
+  return true;
+}
+
+void ToneMapper::apply(uint8_t *frame, size_t begin_pixel, size_t end_pixel) const {
+  const uint16_t *lut = this->lut_;
+  uint16_t *pixels = (uint16_t *) frame;
+  size_t i = begin_pixel;
+  if ((i & 1) && i < end_pixel) {
+    pixels[i] = lut[pixels[i]];
+    i++;
+  }
+
+  // Deux pixels par accès 32 bits (buffers alignés sur 64 octets)
+  uint32_t *pairs = (uint32_t *) (pixels + i);
+  size_t pair_count = (end_pixel - i) / 2;
+  for (size_t k = 0; k < pair_count; k++) {
+    uint32_t pp = pairs[k];
+    pairs[k] = lut[pp & 0xFFFF] | ((uint32_t) lut[pp >> 16] << 16);
+  }
+  i += pair_count * 2;
+  if (i < end_pixel)
+    pixels[i] = lut[pixels[i]];
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
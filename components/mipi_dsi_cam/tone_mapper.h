@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// WB, gamma, contraste, luminosité et saturation en une LUT RGB565 de 128 Ko.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+struct ToneParams {
+  // Balance des blancs (de WhiteBalance, 1.0 = neutre)
+  float gain_r{1.0f};
+  float gain_g{1.0f};
+  float gain_b{1.0f};
+  float gamma{1.0f};       // > 1 éclaircit les tons moyens
+  float contrast{1.0f};    // autour du gris moyen
+  int8_t brightness{0};    // -100..100 % de la demi-échelle
+  float saturation{1.0f};  // 0 = niveaux de gris
+
+  bool is_identity() const;
+};
+
+// Toutes les opérations couleur du pipeline réunies dans une table
+// RGB565 -> RGB565 de 65536 entrées : la frame n'est lue et écrite qu'une fois,
+// quoi qu'il soit activé (la limite est la bande passante PSRAM, pas l'ALU).
+//
+// prepare() ne reconstruit la table que si les paramètres ont changé ; apply()
+// traite en place une plage de pixels, l'appelant peut répartir une frame sur
+// les deux cœurs.
+class ToneMapper {
+ public:
+  static constexpr size_t LUT_SIZE = 65536;
+
+  // Stockage de la table (LUT_SIZE entrées) fourni par l'appelant.
+  void set_lut_buffer(uint16_t *lut) {
+    this->lut_ = lut;
+    this->dirty_ = true;
+  }
+  bool has_lut() const { return this->lut_ != nullptr; }
+
+  void set_params(const ToneParams &params);
+  const ToneParams &get_params() const { return this->params_; }
+
+  // Reconstruit la table si besoin ; true si elle l'a été.
+  bool prepare();
+  void apply(uint8_t *frame, size_t begin_pixel, size_t end_pixel) const;
+
+ protected:
+  ToneParams params_{};
+  uint16_t *lut_{nullptr};
+  bool dirty_{true};
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,213 @@
+#include "virtual_csi_backend.h"
+#include "pixel_convert.h"
+
+#ifdef USE_HOST
+
+#include "esphome/core/log.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+static const char *const TAG = "mipi_dsi_cam.virtual";
+
+static const uint16_t BOX_SIZE = 64;
+
+static inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) { return pack_rgb565(r, g, b); }
+
+bool VirtualCsiBackend::init(const CaptureConfig &config, const Callbacks &callbacks) {
+  this->config_ = config;
+  this->callbacks_ = callbacks;
+  this->pixel_count_ = (size_t) config.width * config.height;
+  this->frame_bytes_ = this->pixel_count_ * bytes_per_pixel(config.format);
+  this->frames_.clear();
+  this->frame_count_ = 0;
+
+  if (!this->replay_path_.empty()) {
+    if (!this->load_replay_()) {
+      return false;
+    }
+    ESP_LOGI(TAG, "Replaying %u frame(s) from %s @ %u fps", (unsigned) this->frame_count_,
+             this->replay_path_.c_str(), this->get_effective_fps());
+  } else {
+    this->render_pattern_();
+    ESP_LOGI(TAG, "Synthetic pattern %u @ %u fps", this->pattern_, this->get_effective_fps());
+  }
+  return true;
+}
+
+bool VirtualCsiBackend::load_replay_() {
+  FILE *f = fopen(this->replay_path_.c_str(), "rb");
+  if (f == nullptr) {
+    ESP_LOGE(TAG, "Cannot open replay file %s", this->replay_path_.c_str());
+    return false;
+  }
+
+  const bool raw8 = this->replay_format_ == VIRTUAL_REPLAY_RAW8;
+  size_t file_frame_size = this->pixel_count_ * (raw8 ? 1 : 2);
+  std::vector<uint8_t> file_frame(file_frame_size);
+  std::vector<uint16_t> rgb(this->pixel_count_);
+
+  while (fread(file_frame.data(), 1, file_frame_size, f) == file_frame_size) {
+    if (raw8 && this->config_.format == PIXEL_FORMAT_RAW8) {
+      // Mosaïque livrée telle quelle, comme l'ISP en sortie RAW8
+      this->frames_.insert(this->frames_.end(), file_frame.begin(), file_frame.end());
+      this->frame_count_++;
+      continue;
+    }
+    if (raw8) {
+      convert_to_rgb565(FrameView::packed(file_frame.data(), this->config_.width, this->config_.height,
+                                          PIXEL_FORMAT_RAW8, this->config_.bayer_pattern),
+                        rgb.data(), DEMOSAIC_BILINEAR);
+    } else {
+      memcpy(rgb.data(), file_frame.data(), file_frame_size);
+    }
+    this->store_frame_(rgb.data());
+  }
+  fclose(f);
+
+  if (this->frame_count_ == 0) {
+    ESP_LOGE(TAG, "Replay file %s holds no complete %ux%u frame", this->replay_path_.c_str(),
+             this->config_.width, this->config_.height);
+    return false;
+  }
+  return true;
+}
+
+void VirtualCsiBackend::store_frame_(const uint16_t *rgb565) {
+  const uint16_t w = this->config_.width;
+  const uint16_t h = this->config_.height;
+  this->frames_.resize((this->frame_count_ + 1) * this->frame_bytes_);
+  uint8_t *out = &this->frames_[this->frame_count_ * this->frame_bytes_];
+  switch (this->config_.format) {
+    case PIXEL_FORMAT_YUV422:
+      convert_to_yuv422(FrameView::packed((uint8_t *) rgb565, w, h, PIXEL_FORMAT_RGB565), out);
+      break;
+    case PIXEL_FORMAT_RAW8:
+      rgb565_to_raw8(rgb565, w, h, this->config_.bayer_pattern, out);
+      break;
+    default:
+      memcpy(out, rgb565, this->frame_bytes_);
+      break;
+  }
+  this->frame_count_++;
+}
+
+void VirtualCsiBackend::render_pattern_() {
+  static const uint16_t BARS[8] = {
+    rgb565(255, 255, 255), rgb565(255, 255, 0), rgb565(0, 255, 255), rgb565(0, 255, 0),
+    rgb565(255, 0, 255), rgb565(255, 0, 0), rgb565(0, 0, 255), rgb565(0, 0, 0),
+  };
+  const uint16_t w = this->config_.width;
+  const uint16_t h = this->config_.height;
+
+  std::vector<uint16_t> frame(this->pixel_count_);
+  uint32_t seed = 0x12345678;
+
+  for (uint16_t y = 0; y < h; y++) {
+    for (uint16_t x = 0; x < w; x++) {
+      uint16_t px;
+      switch (this->pattern_) {
+        case VIRTUAL_PATTERN_GRADIENT:
+          px = rgb565(x * 255 / w, y * 255 / h, 128);
+          break;
+        case VIRTUAL_PATTERN_NOISE:
+          seed ^= seed << 13;
+          seed ^= seed >> 17;
+          seed ^= seed << 5;
+          px = (uint16_t) seed;
+          break;
+        default:
+          px = BARS[x * 8 / w];
+          break;
+      }
+      frame[(size_t) y * w + x] = px;
+    }
+  }
+  this->store_frame_(frame.data());
+}
+
+uint8_t *VirtualCsiBackend::allocate_frame_buffer(size_t size) {
+  // aligned_alloc veut une taille multiple de l'alignement
+  return (uint8_t*)aligned_alloc(64, (size + 63) & ~(size_t) 63);
+}
+
+void VirtualCsiBackend::produce_frame_(uint8_t *buffer, uint32_t index) {
+  // La copie tient lieu de transfert DMA
+  memcpy(buffer, &this->frames_[(index % this->frame_count_) * this->frame_bytes_], this->frame_bytes_);
+
+  if (!this->replay_path_.empty())
+    return;
+
+  // Boîte mobile (blanche) : chaque frame synthétique est différente
+  const uint16_t w = this->config_.width;
+  const uint16_t h = this->config_.height;
+  if (w <= BOX_SIZE || h <= BOX_SIZE)
+    return;
+  uint16_t bx = (index * 8) % (w - BOX_SIZE);
+  uint16_t by = (index * 4) % (h - BOX_SIZE);
+  const size_t bpp = bytes_per_pixel(this->config_.format);
+  for (uint16_t y = by; y < by + BOX_SIZE; y++) {
+    uint8_t *dst = buffer + ((size_t) y * w + bx) * bpp;
+    if (this->config_.format == PIXEL_FORMAT_YUV422) {
+      // bx pair : paires Y0 U Y1 V entières
+      for (uint16_t x = 0; x < BOX_SIZE; x += 2, dst += 4) {
+        dst[0] = 255;
+        dst[1] = 128;
+        dst[2] = 255;
+        dst[3] = 128;
+      }
+    } else {
+      memset(dst, 0xFF, BOX_SIZE * bpp);
+    }
+  }
+}
+
+bool VirtualCsiBackend::start() {
+  if (this->running_.load() || this->frame_count_ == 0) {
+    return false;
+  }
+  this->running_.store(true);
+  this->thread_ = std::thread(&VirtualCsiBackend::run_, this);
+  return true;
+}
+
+void VirtualCsiBackend::stop() {
+  this->running_.store(false);
+  if (this->thread_.joinable()) {
+    this->thread_.join();
+  }
+}
+
+bool VirtualCsiBackend::reconfigure(const CaptureConfig &config) {
+  // Le fichier de replay est relu : il doit contenir des frames à la nouvelle taille
+  return this->init(config, this->callbacks_);
+}
+
+void VirtualCsiBackend::run_() {
+  const uint8_t fps = this->get_effective_fps() != 0 ? this->get_effective_fps() : 30;
+  const auto period = std::chrono::microseconds(1000000 / fps);
+  auto next = std::chrono::steady_clock::now();
+  uint32_t index = 0;
+
+  while (this->running_.load(std::memory_order_relaxed)) {
+    next += period;
+
+    uint8_t *buffer = this->callbacks_.on_new_frame(this->callbacks_.arg);
+    if (buffer != nullptr) {
+      this->produce_frame_(buffer, index);
+      this->callbacks_.on_frame_done(this->callbacks_.arg, buffer, this->frame_bytes_);
+    }
+    index++;
+
+    std::this_thread::sleep_until(next);
+  }
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
+
+#endif  // USE_HOST
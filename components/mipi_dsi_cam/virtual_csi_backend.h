@@ -0,0 +1,85 @@
+#pragma once
+
+#include "capture_backend.h"
+
+#ifdef USE_HOST
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+enum VirtualPattern {
+  VIRTUAL_PATTERN_COLOR_BARS = 0,
+  VIRTUAL_PATTERN_GRADIENT = 1,
+  VIRTUAL_PATTERN_NOISE = 2,
+};
+
+enum VirtualReplayFormat {
+  VIRTUAL_REPLAY_RGB565 = 0,
+  VIRTUAL_REPLAY_RAW8 = 1,
+};
+
+// Remplaçant host du contrôleur CSI : un thread de capture déclenche les
+// mêmes callbacks new-frame / frame-done à cadence fixe, pour profiler le
+// pool de frames, l'AE et les consommateurs hors de la carte.
+//
+// Les frames sont soit une mire synthétique (avec un carré mobile pour que
+// chaque frame diffère), soit rejouées en boucle depuis un fichier brut de
+// frames RGB565 ou RAW8 (Bayer) consécutives à la résolution du capteur, et
+// livrées dans le format de pixel configuré comme le ferait l'ISP.
+class VirtualCsiBackend : public CaptureBackend {
+ public:
+  ~VirtualCsiBackend() override { this->stop(); }
+
+  // 0 = cadence du capteur
+  void set_fps(uint8_t fps) { this->fps_ = fps; }
+  void set_pattern(VirtualPattern pattern) { this->pattern_ = pattern; }
+  void set_replay_file(const std::string &path, VirtualReplayFormat format) {
+    this->replay_path_ = path;
+    this->replay_format_ = format;
+  }
+
+  const char *get_name() const override { return "Virtual CSI (host)"; }
+  bool init(const CaptureConfig &config, const Callbacks &callbacks) override;
+  uint8_t *allocate_frame_buffer(size_t size) override;
+  bool start() override;
+  void stop() override;
+  bool reconfigure(const CaptureConfig &config) override;
+
+  uint8_t get_effective_fps() const { return this->fps_ != 0 ? this->fps_ : this->config_.fps; }
+
+ protected:
+  bool load_replay_();
+  void render_pattern_();
+  // Ajoute une image RGB565, convertie au format de sortie
+  void store_frame_(const uint16_t *rgb565);
+  void produce_frame_(uint8_t *buffer, uint32_t index);
+  void run_();
+
+  CaptureConfig config_{};
+  Callbacks callbacks_{};
+  size_t pixel_count_{0};
+  size_t frame_bytes_{0};
+
+  uint8_t fps_{0};
+  VirtualPattern pattern_{VIRTUAL_PATTERN_COLOR_BARS};
+  std::string replay_path_;
+  VirtualReplayFormat replay_format_{VIRTUAL_REPLAY_RGB565};
+
+  // Contenu prérendu au format de sortie : une frame de mire ou toutes les
+  // frames du replay.
+  std::vector<uint8_t> frames_;
+  size_t frame_count_{0};
+
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
+
+#endif  // USE_HOST
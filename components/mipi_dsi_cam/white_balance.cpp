@@ -0,0 +1,61 @@
+#include "white_balance.h"
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+// En dessous, les moyennes par canal sont surtout du bruit
+static const uint8_t MIN_MEAN_LUMA = 16;
+// White-patch : assez d'échantillons clairs, sinon retour au gray-world
+static const uint32_t MIN_BRIGHT_SAMPLES = 64;
+
+static float clamp_gain(float gain) {
+  if (gain < WhiteBalance::MIN_GAIN)
+    return WhiteBalance::MIN_GAIN;
+  if (gain > WhiteBalance::MAX_GAIN)
+    return WhiteBalance::MAX_GAIN;
+  return gain;
+}
+
+void WhiteBalance::set_mode(AwbMode mode) {
+  this->mode_ = mode;
+  if (mode == AWB_GRAY_WORLD || mode == AWB_WHITE_PATCH) {
+    // Les gains auto sont normalisés sur le vert
+    this->gain_r_ /= this->gain_g_;
+    this->gain_b_ /= this->gain_g_;
+    this->gain_g_ = 1.0f;
+  }
+}
+
+void WhiteBalance::set_gains(float red, float green, float blue) {
+  this->mode_ = AWB_MANUAL;
+  this->gain_r_ = clamp_gain(red);
+  this->gain_g_ = clamp_gain(green);
+  this->gain_b_ = clamp_gain(blue);
+}
+
+void WhiteBalance::update(const FrameStats &stats) {
+  if (this->mode_ != AWB_GRAY_WORLD && this->mode_ != AWB_WHITE_PATCH)
+    return;
+  if (stats.mean_luma < MIN_MEAN_LUMA)
+    return;
+
+  uint8_t r = stats.mean_r;
+  uint8_t g = stats.mean_g;
+  uint8_t b = stats.mean_b;
+  if (this->mode_ == AWB_WHITE_PATCH && stats.bright_count >= MIN_BRIGHT_SAMPLES) {
+    r = stats.bright_r;
+    g = stats.bright_g;
+    b = stats.bright_b;
+  }
+  if (r == 0 || g == 0 || b == 0)
+    return;
+
+  // Mesurée sur la frame du capteur, avant la LUT : la dominante donne les gains
+  float target_r = clamp_gain((float) g / r);
+  float target_b = clamp_gain((float) g / b);
+  this->gain_r_ += this->alpha_ * (target_r - this->gain_r_);
+  this->gain_b_ += this->alpha_ * (target_b - this->gain_b_);
+}
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
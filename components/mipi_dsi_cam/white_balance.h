@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_stats.h"
+
+// Balance des blancs logicielle : estime les gains, le ToneMapper les applique.
+
+namespace esphome {
+namespace mipi_dsi_cam {
+
+enum AwbMode {
+  AWB_OFF = 0,
+  AWB_GRAY_WORLD = 1,
+  AWB_WHITE_PATCH = 2,
+  AWB_MANUAL = 3,
+};
+
+// Pour les capteurs dont l'AWB de l'ISP est inutilisable.
+//
+// Les gains viennent des FrameStats partagées (gray-world : moyennes par canal ;
+// white-patch : échantillons clairs non saturés), lissés dans le temps et
+// normalisés sur le vert. Le ToneMapper les applique, avec les autres
+// opérations couleur, en une seule passe sur la frame.
+//
+// L'estimation se fait sur la frame du capteur, avant la passe du ToneMapper :
+// la dominante mesurée donne directement les gains (pas de boucle à travers
+// gamma et contraste).
+class WhiteBalance {
+ public:
+  static constexpr float MIN_GAIN = 0.5f;
+  static constexpr float MAX_GAIN = 4.0f;
+
+  void set_mode(AwbMode mode);
+  AwbMode get_mode() const { return this->mode_; }
+  // 0..1, poids de chaque nouvelle estimation
+  void set_smoothing(float alpha) { this->alpha_ = alpha; }
+  // Gains manuels (passe en AWB_MANUAL)
+  void set_gains(float red, float green, float blue);
+
+  // Stats d'une frame (sans effet en manuel ou arrêté).
+  void update(const FrameStats &stats);
+
+  bool is_active() const { return this->mode_ != AWB_OFF; }
+  float get_red_gain() const { return this->gain_r_; }
+  float get_green_gain() const { return this->gain_g_; }
+  float get_blue_gain() const { return this->gain_b_; }
+
+ protected:
+  AwbMode mode_{AWB_OFF};
+  float alpha_{0.15f};
+  float gain_r_{1.0f};
+  float gain_g_{1.0f};
+  float gain_b_{1.0f};
+};
+
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
@@ -0,0 +1,262 @@
+// AutoExposure replayed in closed loop against recorded luma traces
+// (data/ae_*.csv), with each sensor's own gain table, exposure limits and
+// control delay, through a linear and a gamma 2.2 response.
+//
+// The camera loop is reproduced as MipiDsiCam::update_auto_exposure_() runs
+// it: new settings reach the sensor apply_delay frames later and frames
+// exposed with stale settings are not fed to the controller. After every
+// scene change the report gives the frames until the metered luma stays
+// within the controller's band, how far it went past the target (EV), the
+// lag while the scene was still moving and the writes made once converged.
+
+#include "esphome/core/log.h"
+#include "mipi_dsi_cam/auto_exposure.h"
+#include "mipi_dsi_cam/mipi_dsi_cam.h"
+#include "mipi_dsi_cam/sensor_registers.h"
+#include "sensor_drivers_generated.h"
+#include "test_support.h"
+
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace esphome;
+using namespace esphome::mipi_dsi_cam;
+
+namespace esphome {
+uint32_t millis() { return 0; }
+uint32_t micros() { return 0; }
+void delay(uint32_t ms) {}
+void delayMicroseconds(uint32_t us) {}
+}  // namespace esphome
+
+static const uint8_t TARGET = 128;
+static const uint8_t ZONES = 8;
+// The controller's hysteresis band (auto_exposure.cpp, LEAVE_BAND_EV)
+static const float BAND_EV = 0.20f;
+
+static const int MAX_CONVERGENCE_FRAMES = 20;
+static const float MAX_OVERSHOOT_EV = 0.25f;
+static const float MAX_RAMP_LAG_EV = 0.6f;
+
+struct SceneFrame {
+  float background;
+  float center;
+  bool moving;  // marked in the trace while the scene changes (step, pan)
+};
+
+struct Trace {
+  std::string name;
+  std::vector<SceneFrame> frames;
+};
+
+static bool load_trace(const std::string &name, Trace &trace) {
+  std::ifstream file("data/" + name + ".csv");
+  if (!file)
+    return false;
+  trace.name = name;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream fields(line);
+    std::string frame, background, center, moving;
+    std::getline(fields, frame, ',');
+    std::getline(fields, background, ',');
+    std::getline(fields, center, ',');
+    std::getline(fields, moving, ',');
+    trace.frames.push_back({std::stof(background), std::stof(center), moving == "1"});
+  }
+  return !trace.frames.empty();
+}
+
+enum Response { RESPONSE_LINEAR, RESPONSE_GAMMA };
+static const char *const RESPONSE_NAMES[] = {"linear", "gamma 2.2"};
+static const char *const METERING_NAMES[] = {"average", "center", "spot"};
+
+// Luma of a zone whose linear scene luma at the reference setting
+// (exposure_max / 4, gain x1) is `scene`
+static uint8_t sensor_luma(float scene, float exposure_ratio, Response response) {
+  float linear = scene * exposure_ratio;
+  if (response == RESPONSE_GAMMA)
+    linear = 255.0f * powf(std::min(linear / 255.0f, 1.0f), 1.0f / 2.2f);
+  return (uint8_t) std::min(linear + 0.5f, 255.0f);
+}
+
+static void fill_stats(const SceneFrame &scene, float exposure_ratio, Response response, FrameStats &stats) {
+  stats.zone_cols = ZONES;
+  stats.zone_rows = ZONES;
+  const uint8_t background = sensor_luma(scene.background, exposure_ratio, response);
+  const uint8_t center = sensor_luma(scene.center, exposure_ratio, response);
+  uint32_t sum = 0;
+  for (int r = 0; r < ZONES; r++) {
+    for (int c = 0; c < ZONES; c++) {
+      const bool central = (c == ZONES / 2 - 1 || c == ZONES / 2) && (r == ZONES / 2 - 1 || r == ZONES / 2);
+      stats.zone_mean[r * ZONES + c] = central ? center : background;
+      sum += stats.zone_mean[r * ZONES + c];
+    }
+  }
+  stats.mean_luma = sum / (ZONES * ZONES);
+}
+
+struct FrameRecord {
+  float error_ev;  // log2(target / metered)
+  bool at_limit;   // nothing left to move in the error's direction
+  bool wrote;
+  bool converged;  // the controller's own view, after this frame
+};
+
+static std::vector<FrameRecord> replay(const Trace &trace, ISensorDriver *sensor, Response response,
+                                       MeteringMode metering) {
+  std::vector<uint32_t> gains(sensor->get_gain_count());
+  for (size_t i = 0; i < gains.size(); i++)
+    gains[i] = sensor->get_gain_value(i);
+  AutoExposure ae;
+  ae.set_limits(sensor->get_exposure_min(), sensor->get_exposure_max(), gains);
+  ae.set_target(TARGET);
+  ae.set_metering_mode(metering);
+  ae.set_settle_frames(0);
+
+  const float reference = sensor->get_exposure_max() / 4.0f;
+  const uint8_t delay = sensor->get_apply_delay_frames();
+  uint32_t exposure = (uint32_t) reference, gain_index = 0;
+  uint32_t effective_exposure = exposure, effective_gain = gain_index;
+  size_t apply_at = SIZE_MAX;
+  ae.reset(exposure, gain_index);
+
+  std::vector<FrameRecord> records;
+  FrameStats stats;
+  for (size_t n = 0; n < trace.frames.size(); n++) {
+    if (n >= apply_at) {
+      effective_exposure = exposure;
+      effective_gain = gain_index;
+      apply_at = SIZE_MAX;
+    }
+    const float ratio = effective_exposure * (sensor->get_gain_value(effective_gain) / 1000.0f) / reference;
+    fill_stats(trace.frames[n], ratio, response, stats);
+
+    FrameRecord record;
+    const uint8_t metered = ae.metered_luma(stats);
+    record.error_ev = log2f((float) TARGET / (metered > 0 ? metered : 1));
+    record.at_limit = record.error_ev > 0 ? exposure >= ae.get_exposure_max() && gain_index >= ae.get_gain_index_max()
+                                          : exposure <= ae.get_exposure_min() && gain_index == 0;
+    record.wrote = false;
+    // Exposed with stale settings: skipped, as the camera does
+    if (effective_exposure == exposure && effective_gain == gain_index &&
+        ae.update(stats, &exposure, &gain_index)) {
+      apply_at = n + delay;
+      record.wrote = true;
+    }
+    record.converged = ae.is_converged();
+    records.push_back(record);
+  }
+  return records;
+}
+
+struct Measures {
+  int changes{0};
+  int convergence{0};     // worst, frames from the end of a scene change
+  float overshoot{0.0f};  // worst, EV past the target
+  float ramp_lag{0.0f};   // worst |error| while a multi-frame change goes on
+  int hunting_writes{0};  // sensor writes once the controller has converged
+  bool settled{true};
+};
+
+static Measures measure(const Trace &trace, const std::vector<FrameRecord> &records) {
+  const size_t count = trace.frames.size();
+  Measures m;
+  // Segments run from the last frame of a change (or the start) to the next change
+  size_t begin = 0;
+  while (begin < count) {
+    size_t end = begin + 1;
+    while (end < count && !trace.frames[end].moving)
+      end++;
+
+    auto in_band = [&](size_t n) { return std::fabs(records[n].error_ev) <= BAND_EV || records[n].at_limit; };
+    size_t settled = end;
+    while (settled > begin && in_band(settled - 1))
+      settled--;
+    if (settled == end) {
+      m.settled = false;
+    } else {
+      m.convergence = std::max(m.convergence, (int) (settled - begin));
+    }
+
+    // Past the target: the error changes sign against the first one seen
+    float first = 0.0f;
+    bool converged = false;
+    for (size_t n = begin; n < end; n++) {
+      const float error = records[n].error_ev;
+      if (first == 0.0f && std::fabs(error) > BAND_EV)
+        first = error;
+      if (first != 0.0f && error * first < 0.0f)
+        m.overshoot = std::max(m.overshoot, std::fabs(error));
+      if (converged && n >= settled && records[n].wrote)
+        m.hunting_writes++;
+      converged = converged || records[n].converged;
+    }
+
+    if (end == count)
+      break;
+    // The change itself: a step is one frame, a pan is followed frame by frame
+    size_t last = end;
+    while (last + 1 < count && trace.frames[last + 1].moving)
+      last++;
+    for (size_t n = end + 1; n <= last; n++)
+      m.ramp_lag = std::max(m.ramp_lag, std::fabs(records[n].error_ev));
+    m.changes++;
+    begin = last;
+  }
+  return m;
+}
+
+int main() {
+  const char *const TRACES[] = {"ae_lights_on_off", "ae_window_pan", "ae_flicker", "ae_backlit"};
+
+  for (const char *name : TRACES) {
+    Trace trace;
+    if (!load_trace(name, trace)) {
+      printf("data/%s.csv: missing or empty (run from tests/)\n", name);
+      test::failures()++;
+      continue;
+    }
+    for (int metering = METERING_AVERAGE; metering <= METERING_SPOT; metering++) {
+      // Metering only matters when the center differs from the rest
+      if (metering != METERING_CENTER_WEIGHTED && trace.name != "ae_backlit")
+        continue;
+      for (Response response : {RESPONSE_LINEAR, RESPONSE_GAMMA}) {
+        Measures worst;
+        const char *slowest = "";
+        for (const reference::SensorUnderTest &entry : reference::SENSORS) {
+          std::unique_ptr<ISensorDriver> sensor(entry.create(nullptr));
+          const Measures m = measure(trace, replay(trace, sensor.get(), response, (MeteringMode) metering));
+          if (!m.settled)
+            printf("%s: %s never settles (%s, %s)\n", trace.name.c_str(), entry.name, RESPONSE_NAMES[response],
+                   METERING_NAMES[metering]);
+          CHECK(m.settled);
+          if (m.convergence > worst.convergence || *slowest == '\0')
+            slowest = entry.name;
+          worst.changes = m.changes;
+          worst.convergence = std::max(worst.convergence, m.convergence);
+          worst.overshoot = std::max(worst.overshoot, m.overshoot);
+          worst.ramp_lag = std::max(worst.ramp_lag, m.ramp_lag);
+          worst.hunting_writes = std::max(worst.hunting_writes, m.hunting_writes);
+        }
+        printf("%-16s %-7s %-9s %d change(s): settles in %2d frames (%s), overshoot %.2f EV, ramp lag %.2f EV, "
+               "%d write(s) once converged\n",
+               trace.name.c_str(), METERING_NAMES[metering], RESPONSE_NAMES[response], worst.changes,
+               worst.convergence, slowest, worst.overshoot, worst.ramp_lag, worst.hunting_writes);
+        CHECK(worst.convergence <= MAX_CONVERGENCE_FRAMES);
+        CHECK(worst.overshoot <= MAX_OVERSHOOT_EV);
+        CHECK(worst.ramp_lag <= MAX_RAMP_LAG_EV);
+        // Noise inside the band must not make AE hunt
+        if (trace.name == "ae_flicker")
+          CHECK_EQ(worst.hunting_writes, 0);
+      }
+    }
+  }
+  return test::finish("auto_exposure_replay_test");
+}
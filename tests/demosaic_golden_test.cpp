@@ -0,0 +1,357 @@
+// Golden-image tests of the software demosaic (nearest, bilinear,
+// edge-aware) for the four Bayer orders, plus the properties the
+// pipeline relies on: row bands and column chunks don't change the
+// result, crops keep the Bayer phase, YUV422 pairs carry the chunk's RGB.
+//
+// The golden frames live in data/demosaic_golden_*.ppm (plain PPM, the four
+// orders stacked top to bottom). After an intended change of the kernels,
+// regenerate them from the tests/ directory and review the diff:
+//   build/tests/demosaic_golden_test --update
+
+#include "mipi_dsi_cam/demosaic.h"
+#include "mipi_dsi_cam/pixel_convert.h"
+#include "test_support.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static const uint16_t W = 16;
+static const uint16_t H = 12;
+static const char *const METHOD_NAMES[] = {"nearest", "bilinear", "edge_aware"};
+static const char *const PATTERN_NAMES[] = {"BGGR", "GBRG", "GRBG", "RGGB"};
+
+struct Image {
+  uint16_t width{0};
+  uint16_t height{0};
+  std::vector<uint8_t> rgb;  // RGB888
+
+  Image() = default;
+  Image(uint16_t w, uint16_t h) : width(w), height(h), rgb((size_t) w * h * 3) {}
+  uint8_t *at(int x, int y) { return &this->rgb[((size_t) y * this->width + x) * 3]; }
+  const uint8_t *at(int x, int y) const { return &this->rgb[((size_t) y * this->width + x) * 3]; }
+};
+
+// Ground truth: a ramp, a sharp diagonal edge and a saturated patch
+static Image make_scene(uint16_t w, uint16_t h) {
+  Image img(w, h);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint8_t *p = img.at(x, y);
+      if (x > y + w / 3) {
+        p[0] = 230, p[1] = 60, p[2] = 40;
+      } else if (x < 4 && y > h - 5) {
+        p[0] = 255, p[1] = 255, p[2] = 255;
+      } else {
+        p[0] = 20 + x * 120 / w, p[1] = 40 + y * 120 / h, p[2] = 200 - x * 60 / w - y * 40 / h;
+      }
+    }
+  }
+  return img;
+}
+
+static Image make_ramp(uint16_t w, uint16_t h) {
+  Image img(w, h);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint8_t *p = img.at(x, y);
+      p[0] = 10 + x * 2 + y, p[1] = 30 + x + y * 2, p[2] = 200 - x - y;
+    }
+  }
+  return img;
+}
+
+// What the sensor delivers: one channel per site
+// Luminance edges (channels move together, as in most real scenes): a
+// diagonal and a vertical one between a dark and a bright surface
+static Image make_edges(uint16_t w, uint16_t h) {
+  Image img(w, h);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint8_t *p = img.at(x, y);
+      const bool bright = (x > y / 2 + w / 4) != (x > 3 * w / 4);
+      p[0] = bright ? 210 : 50, p[1] = bright ? 220 : 60, p[2] = bright ? 180 : 40;
+    }
+  }
+  return img;
+}
+
+static std::vector<uint8_t> mosaic(const Image &img, uint8_t pattern) {
+  std::vector<uint8_t> raw((size_t) img.width * img.height);
+  const uint8_t r_site = bayer_red_site(pattern);
+  const uint8_t b_site = bayer_blue_site(pattern);
+  for (int y = 0; y < img.height; y++) {
+    for (int x = 0; x < img.width; x++) {
+      const uint8_t site = (y & 1) * 2 + (x & 1);
+      raw[(size_t) y * img.width + x] = img.at(x, y)[site == r_site ? 0 : (site == b_site ? 2 : 1)];
+    }
+  }
+  return raw;
+}
+
+static Image run(std::vector<uint8_t> &raw, uint16_t w, uint16_t h, uint8_t pattern, DemosaicMethod method) {
+  Image out(w, h);
+  demosaic(FrameView::packed(raw.data(), w, h, PIXEL_FORMAT_RAW8, pattern), method, false, DEMOSAIC_OUTPUT_RGB888,
+           out.rgb.data());
+  return out;
+}
+
+// --- Golden files ---
+
+static std::string golden_path(int method) { return std::string("data/demosaic_golden_") + METHOD_NAMES[method] + ".ppm"; }
+
+static Image golden_frame(int method) {
+  Image all(W, H * 4);
+  const Image scene = make_scene(W, H);
+  for (uint8_t pattern = 0; pattern < 4; pattern++) {
+    std::vector<uint8_t> raw = mosaic(scene, pattern);
+    Image out = run(raw, W, H, pattern, (DemosaicMethod) method);
+    memcpy(all.at(0, H * pattern), out.rgb.data(), out.rgb.size());
+  }
+  return all;
+}
+
+static bool write_ppm(const std::string &path, const Image &img, int method) {
+  FILE *f = fopen(path.c_str(), "w");
+  if (f == nullptr)
+    return false;
+  fprintf(f, "P3\n# demosaic %s of make_scene(%u, %u), BGGR GBRG GRBG RGGB stacked\n%u %u\n255\n",
+          METHOD_NAMES[method], W, H, img.width, img.height);
+  for (int y = 0; y < img.height; y++) {
+    for (int x = 0; x < img.width; x++) {
+      const uint8_t *p = img.at(x, y);
+      fprintf(f, "%3u %3u %3u%s", p[0], p[1], p[2], x + 1 < img.width ? "  " : "\n");
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+static bool read_ppm(const std::string &path, Image &img) {
+  FILE *f = fopen(path.c_str(), "r");
+  if (f == nullptr)
+    return false;
+  char line[256];
+  unsigned w = 0, h = 0, max = 0;
+  bool ok = fgets(line, sizeof(line), f) != nullptr && strncmp(line, "P3", 2) == 0;
+  while (ok && fgets(line, sizeof(line), f) != nullptr && line[0] == '#') {
+  }
+  ok = ok && sscanf(line, "%u %u", &w, &h) == 2 && fscanf(f, "%u", &max) == 1 && max == 255;
+  if (ok) {
+    img = Image(w, h);
+    for (uint8_t &v : img.rgb) {
+      unsigned value;
+      if (fscanf(f, "%u", &value) != 1) {
+        ok = false;
+        break;
+      }
+      v = value;
+    }
+  }
+  fclose(f);
+  return ok;
+}
+
+static void check_golden(bool update) {
+  for (int method = 0; method < 3; method++) {
+    const Image out = golden_frame(method);
+    const std::string path = golden_path(method);
+    if (update) {
+      CHECK(write_ppm(path, out, method));
+      printf("wrote %s\n", path.c_str());
+      continue;
+    }
+    Image golden;
+    if (!read_ppm(path, golden)) {
+      printf("%s: missing or unreadable (run from tests/, --update to create it)\n", path.c_str());
+      ::test::failures()++;
+      continue;
+    }
+    CHECK(golden.width == out.width && golden.height == out.height);
+    if (golden.rgb != out.rgb) {
+      for (size_t i = 0; i < out.rgb.size() && i < golden.rgb.size(); i++) {
+        if (out.rgb[i] != golden.rgb[i]) {
+          size_t px = i / 3;
+          printf("%s: %s differs first at %s x=%zu y=%zu\n", path.c_str(), METHOD_NAMES[method],
+                 PATTERN_NAMES[px / W / H], px % W, px / W % H);
+          break;
+        }
+      }
+      ::test::failures()++;
+    }
+  }
+}
+
+// --- Properties against the ground truth ---
+
+static int max_error(const Image &a, const Image &b, int margin) {
+  int worst = 0;
+  for (int y = margin; y < a.height - margin; y++) {
+    for (int x = margin; x < a.width - margin; x++) {
+      for (int c = 0; c < 3; c++)
+        worst = std::max(worst, abs(a.at(x, y)[c] - b.at(x, y)[c]));
+    }
+  }
+  return worst;
+}
+
+static long total_error(const Image &a, const Image &b) {
+  long sum = 0;
+  for (size_t i = 0; i < a.rgb.size(); i++)
+    sum += abs(a.rgb[i] - b.rgb[i]);
+  return sum;
+}
+
+static void check_flat_and_ramp() {
+  for (uint8_t pattern = 0; pattern < 4; pattern++) {
+    // Flat field: exact everywhere, borders included (mirroring keeps the phase)
+    Image flat(W, H);
+    for (size_t i = 0; i < flat.rgb.size(); i += 3)
+      flat.rgb[i] = 200, flat.rgb[i + 1] = 100, flat.rgb[i + 2] = 50;
+    std::vector<uint8_t> raw = mosaic(flat, pattern);
+    for (int method = 0; method < 3; method++)
+      CHECK_EQ(max_error(run(raw, W, H, pattern, (DemosaicMethod) method), flat, 0), 0);
+
+    // Linear ramp: interpolation is exact up to rounding away from the borders
+    const Image ramp = make_ramp(40, 24);
+    raw = mosaic(ramp, pattern);
+    CHECK(max_error(run(raw, 40, 24, pattern, DEMOSAIC_BILINEAR), ramp, 1) <= 1);
+    CHECK(max_error(run(raw, 40, 24, pattern, DEMOSAIC_EDGE_AWARE), ramp, 3) <= 1);
+    // Nearest: one quad per colour, off by at most one pixel step of the ramp
+    CHECK(max_error(run(raw, 40, 24, pattern, DEMOSAIC_NEAREST), ramp, 0) <= 4);
+
+    // Luminance edges: the edge-aware mode has to beat bilinear
+    const Image edges = make_edges(64, 48);
+    raw = mosaic(edges, pattern);
+    long bilinear = total_error(run(raw, 64, 48, pattern, DEMOSAIC_BILINEAR), edges);
+    long edge = total_error(run(raw, 64, 48, pattern, DEMOSAIC_EDGE_AWARE), edges);
+    CHECK(edge < bilinear);
+    if (pattern == 0)
+      printf("edge scene, total abs error: bilinear %ld, edge-aware %ld\n", bilinear, edge);
+  }
+}
+
+// --- Row bands, column chunks and crops ---
+
+static void check_bands_and_crops() {
+  // Wider than one column chunk (128) so the chunk seams are covered
+  const uint16_t w = 300, h = 20;
+  const Image scene = make_scene(w, h);
+  for (uint8_t pattern = 0; pattern < 4; pattern++) {
+    std::vector<uint8_t> raw = mosaic(scene, pattern);
+    const FrameView view = FrameView::packed(raw.data(), w, h, PIXEL_FORMAT_RAW8, pattern);
+    for (int method = 0; method < 3; method++) {
+      const Image whole = run(raw, w, h, pattern, (DemosaicMethod) method);
+
+      // Three bands of rows, as when split across cores
+      Image bands(w, h);
+      const uint16_t cuts[] = {0, 7, 13, h};
+      for (int i = 0; i < 3; i++)
+        demosaic_rows(view, (DemosaicMethod) method, false, DEMOSAIC_OUTPUT_RGB888, cuts[i], cuts[i + 1],
+                      bands.rgb.data(), w * 3);
+      CHECK(bands.rgb == whole.rgb);
+
+      // Odd crop origin: widened to the quad, same Bayer phase. Inside the
+      // crop, away from its mirrored borders, pixels match the full frame.
+      esphome::mipi_dsi_cam::FrameRoi roi{101, 3, 150, 15};
+      const FrameView crop = view.crop(roi);
+      CHECK_EQ(crop.data - view.data, 2 * w + 100);
+      CHECK_EQ(crop.bayer_pattern, pattern);
+      Image part(crop.width, crop.height);
+      demosaic(crop, (DemosaicMethod) method, false, DEMOSAIC_OUTPUT_RGB888, part.rgb.data());
+      // (nearest: 1, the last column of an odd width reuses the previous quad)
+      const int margin = method == DEMOSAIC_NEAREST ? 1 : 3;
+      bool same = true;
+      for (int y = margin; y < crop.height - margin; y++) {
+        for (int x = margin; x < crop.width - margin; x++)
+          same = same && memcmp(part.at(x, y), whole.at(x + 100, y + 2), 3) == 0;
+      }
+      if (!same)
+        printf("crop mismatch: %s %s\n", METHOD_NAMES[method], PATTERN_NAMES[pattern]);
+      CHECK(same);
+    }
+  }
+}
+
+// --- Output formats ---
+
+static void check_output_formats() {
+  const Image scene = make_scene(W, H);
+  for (uint8_t pattern = 0; pattern < 4; pattern++) {
+    std::vector<uint8_t> raw = mosaic(scene, pattern);
+    const FrameView view = FrameView::packed(raw.data(), W, H, PIXEL_FORMAT_RAW8, pattern);
+    for (int method = 0; method < 3; method++) {
+      const Image rgb = run(raw, W, H, pattern, (DemosaicMethod) method);
+      std::vector<uint8_t> yuv((size_t) W * H * 2);
+      std::vector<uint16_t> rgb565((size_t) W * H);
+      demosaic(view, (DemosaicMethod) method, false, DEMOSAIC_OUTPUT_YUV422, yuv.data());
+      demosaic(view, (DemosaicMethod) method, false, DEMOSAIC_OUTPUT_RGB565, (uint8_t *) rgb565.data());
+
+      bool yuv_ok = true, rgb565_ok = true;
+      for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x += 2) {
+          // Y0 U Y1 V: luma per pixel, chroma of the pair's average
+          const uint8_t *a = rgb.at(x, y), *b = rgb.at(x + 1, y);
+          const uint8_t ra = (a[0] + b[0] + 1) >> 1, ga = (a[1] + b[1] + 1) >> 1, ba = (a[2] + b[2] + 1) >> 1;
+          const uint8_t *pair = &yuv[((size_t) y * W + x) * 2];
+          yuv_ok = yuv_ok && pair[0] == rgb_to_y(a[0], a[1], a[2]) && pair[1] == rgb_to_u(ra, ga, ba) &&
+                   pair[2] == rgb_to_y(b[0], b[1], b[2]) && pair[3] == rgb_to_v(ra, ga, ba);
+        }
+        for (int x = 0; x < W; x++) {
+          const uint8_t *p = rgb.at(x, y);
+          rgb565_ok = rgb565_ok && rgb565[(size_t) y * W + x] == pack_rgb565(p[0], p[1], p[2]);
+        }
+      }
+      CHECK(yuv_ok);
+      CHECK(rgb565_ok);
+    }
+
+    // 2x2 binning: one pixel per quad, its own colour
+    Image binned(W / 2, H / 2);
+    demosaic(view, DEMOSAIC_BILINEAR, true, DEMOSAIC_OUTPUT_RGB888, binned.rgb.data());
+    const uint8_t r_site = bayer_red_site(pattern), b_site = bayer_blue_site(pattern);
+    bool binned_ok = true;
+    for (int y = 0; y < H / 2; y++) {
+      for (int x = 0; x < W / 2; x++) {
+        const uint8_t quad[4] = {raw[(2 * y) * W + 2 * x], raw[(2 * y) * W + 2 * x + 1],
+                                 raw[(2 * y + 1) * W + 2 * x], raw[(2 * y + 1) * W + 2 * x + 1]};
+        const uint8_t *p = binned.at(x, y);
+        binned_ok = binned_ok && p[0] == quad[r_site] && p[2] == quad[b_site] &&
+                    p[1] == ((quad[r_site ^ 1] + quad[b_site ^ 1] + 1) >> 1);
+      }
+    }
+    CHECK(binned_ok);
+  }
+
+  // RGB565 source to YUV422: odd width drops the last pixel, pairs keep Y0 U Y1 V
+  const uint16_t w = 7, h = 2;
+  std::vector<uint16_t> src(w * h);
+  for (int i = 0; i < w * h; i++)
+    src[i] = pack_rgb565(i * 30, 255 - i * 15, i * 10);
+  std::vector<uint8_t> yuv((size_t) (w & ~1) * h * 2 + 4, 0xAA);
+  convert_to_yuv422(FrameView::packed((uint8_t *) src.data(), w, h, PIXEL_FORMAT_RGB565), yuv.data());
+  CHECK_EQ(yuv[(w & ~1) * h * 2], 0xAA);
+  std::vector<uint8_t> rgb((size_t) w * h * 3);
+  convert_to_rgb888(FrameView::packed((uint8_t *) src.data(), w, h, PIXEL_FORMAT_RGB565), rgb.data());
+  const uint8_t *a = &rgb[(w + 2) * 3], *b = &rgb[(w + 3) * 3];
+  const uint8_t *pair = &yuv[((w & ~1) + 2) * 2];
+  CHECK_EQ(pair[0], rgb_to_y(a[0], a[1], a[2]));
+  CHECK_EQ(pair[2], rgb_to_y(b[0], b[1], b[2]));
+  CHECK_EQ(pair[1], rgb_to_u((a[0] + b[0] + 1) >> 1, (a[1] + b[1] + 1) >> 1, (a[2] + b[2] + 1) >> 1));
+  CHECK_EQ(pair[3], rgb_to_v((a[0] + b[0] + 1) >> 1, (a[1] + b[1] + 1) >> 1, (a[2] + b[2] + 1) >> 1));
+}
+
+int main(int argc, char **argv) {
+  const bool update = argc > 1 && strcmp(argv[1], "--update") == 0;
+  check_golden(update);
+  if (update)
+    return test::finish("demosaic_golden_test --update");
+  check_flat_and_ramp();
+  check_bands_and_crops();
+  check_output_formats();
+  return test::finish("demosaic_golden_test");
+}
@@ -0,0 +1,147 @@
+// FrameMetrics exposition text, checked line by line against the Prometheus
+// text format (one HELP / TYPE per family, cumulative buckets ending with
+// +Inf, _sum and _count per stage, counters with the _total suffix), plus
+// the bucket a latency lands in and the percentile estimate from the buckets.
+
+#include "mipi_dsi_cam/frame_metrics.h"
+#include "test_support.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static std::vector<std::string> lines_of(const std::string &text) {
+  std::vector<std::string> lines;
+  std::istringstream in(text);
+  std::string line;
+  while (std::getline(in, line))
+    lines.push_back(line);
+  return lines;
+}
+
+static bool has_line(const std::vector<std::string> &lines, const std::string &wanted) {
+  for (const std::string &line : lines) {
+    if (line == wanted)
+      return true;
+  }
+  return false;
+}
+
+// name{labels} value, name and value in the text format's alphabet
+static bool is_sample(const std::string &line) {
+  size_t i = 0;
+  if (line.empty() || !(isalpha((unsigned char) line[0]) || line[0] == '_'))
+    return false;
+  while (i < line.size() && (isalnum((unsigned char) line[i]) || line[i] == '_'))
+    i++;
+  if (i < line.size() && line[i] == '{') {
+    const size_t close = line.find('}', i);
+    if (close == std::string::npos)
+      return false;
+    i = close + 1;
+  }
+  if (i >= line.size() || line[i] != ' ')
+    return false;
+  const std::string value = line.substr(i + 1);
+  char *end = nullptr;
+  strtod(value.c_str(), &end);
+  return !value.empty() && *end == '\0';
+}
+
+static void test_exposition() {
+  FrameMetrics metrics;
+  for (uint32_t us : {300u, 500u, 700u, 1500u, 2000000u})
+    metrics.record(STAGE_CONVERT, us);
+  for (int i = 0; i < 3; i++)
+    metrics.increment(COUNTER_FRAMES_CAPTURED);
+  metrics.set(COUNTER_FRAMES_DROPPED, 42);
+
+  std::string text;
+  metrics.write_prometheus(text);
+  const std::vector<std::string> lines = lines_of(text);
+  CHECK(!text.empty() && text.back() == '\n');
+  CHECK_EQ(lines.size(), 2 + STAGE_COUNT * (LatencyHistogram::BUCKET_COUNT + 2) + COUNTER_COUNT * 3);
+
+  // 500 us is on the first bound: "le" is inclusive
+  CHECK(has_line(lines, "mipi_camera_stage_latency_seconds_bucket{stage=\"convert\",le=\"0.0005\"} 2"));
+  CHECK(has_line(lines, "mipi_camera_stage_latency_seconds_bucket{stage=\"convert\",le=\"0.001\"} 3"));
+  CHECK(has_line(lines, "mipi_camera_stage_latency_seconds_bucket{stage=\"convert\",le=\"0.002\"} 4"));
+  CHECK(has_line(lines, "mipi_camera_stage_latency_seconds_bucket{stage=\"convert\",le=\"1\"} 4"));
+  CHECK(has_line(lines, "mipi_camera_stage_latency_seconds_bucket{stage=\"convert\",le=\"+Inf\"} 5"));
+  CHECK(has_line(lines, "mipi_camera_stage_latency_seconds_sum{stage=\"convert\"} 2.003000"));
+  CHECK(has_line(lines, "mipi_camera_stage_latency_seconds_count{stage=\"convert\"} 5"));
+  CHECK(has_line(lines, "mipi_camera_stage_latency_seconds_count{stage=\"jpeg_encode\"} 0"));
+  CHECK(has_line(lines, "# TYPE mipi_camera_frames_captured_total counter"));
+  CHECK(has_line(lines, "mipi_camera_frames_captured_total 3"));
+  CHECK(has_line(lines, "mipi_camera_frames_dropped_total 42"));
+
+  std::map<std::string, int> types;
+  std::map<std::string, long> last_bucket;
+  for (const std::string &line : lines) {
+    if (line.compare(0, 7, "# HELP ") == 0)
+      continue;
+    if (line.compare(0, 7, "# TYPE ") == 0) {
+      types[line.substr(7, line.find(' ', 7) - 7)]++;
+      continue;
+    }
+    if (!is_sample(line))
+      printf("not a sample line: %s\n", line.c_str());
+    CHECK(is_sample(line));
+    // Buckets are cumulative within a stage
+    if (line.compare(0, 40, "mipi_camera_stage_latency_seconds_bucket") == 0) {
+      const std::string stage = line.substr(0, line.find(",le="));
+      const long value = atol(line.substr(line.rfind(' ') + 1).c_str());
+      if (last_bucket.count(stage))
+        CHECK(value >= last_bucket[stage]);
+      last_bucket[stage] = value;
+    }
+  }
+  CHECK_EQ(last_bucket.size(), STAGE_COUNT);
+  CHECK_EQ(types.size(), 1 + COUNTER_COUNT);
+  for (const auto &type : types)
+    CHECK_EQ(type.second, 1);
+}
+
+static void test_percentiles() {
+  LatencyHistogram histogram;
+  CHECK_EQ(histogram.snapshot().percentile_us(0.5f), 0);
+  // Ten samples in (1000, 2000]: estimates spread linearly over the bucket
+  for (int i = 0; i < 10; i++)
+    histogram.record(1500);
+  const LatencyHistogram::Snapshot first = histogram.snapshot();
+  CHECK_EQ(first.count, 10);
+  CHECK_EQ(first.sum_us, 15000);
+  CHECK_EQ(first.percentile_us(0.5f), 1500);
+  CHECK_EQ(first.percentile_us(1.0f), 2000);
+
+  // Past the last bound nothing better than the bound itself is known
+  for (int i = 0; i < 30; i++)
+    histogram.record(5000000);
+  const LatencyHistogram::Snapshot second = histogram.snapshot();
+  CHECK_EQ(second.percentile_us(0.99f), 1000000);
+  CHECK_EQ(second.percentile_us(0.1f), 1400);
+
+  // Window between two snapshots: only the late samples
+  const LatencyHistogram::Snapshot window = second.since(first);
+  CHECK_EQ(window.count, 30);
+  CHECK_EQ(window.buckets[LatencyHistogram::BUCKET_COUNT - 1], 30);
+  CHECK_EQ(window.sum_us, 150000000ull);
+}
+
+static void test_names() {
+  CHECK(std::string(metric_stage_name(STAGE_GLASS_TO_CLIENT)) == "glass_to_client");
+  CHECK(std::string(metric_stage_name(STAGE_OSD)) == "osd");
+  CHECK(std::string(metric_stage_name(STAGE_COUNT)) == "unknown");
+}
+
+int main() {
+  test_exposition();
+  test_percentiles();
+  test_names();
+  return test::finish("frame_metrics_test");
+}
@@ -0,0 +1,148 @@
+// FramePacer on simulated camera streams: the measured source cadence,
+// the decimation chosen for a known per-frame cost and CPU budget, evenly
+// spaced displayed frames, the 15% margin before stepping back up, the
+// min-interval cap with its 10% tolerance, MAX_DECIMATION, frames seen late,
+// pauses left out of the cadence, and reset().
+
+#include "mipi_dsi_cam/frame_pacer.h"
+#include "test_support.h"
+
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+// Camera stream at a fixed interval; every displayed frame costs `cost_us`
+struct Stream {
+  FramePacer pacer;
+  uint32_t sequence{0};
+  int64_t timestamp_us{1000000};
+  uint32_t interval_us;
+
+  explicit Stream(uint32_t interval) : interval_us(interval) {}
+
+  // Sequences of the displayed frames among the next `frames`
+  std::vector<uint32_t> run(uint32_t frames, uint32_t cost_us) {
+    std::vector<uint32_t> shown;
+    for (uint32_t i = 0; i < frames; i++) {
+      if (this->pacer.should_display(this->sequence, this->timestamp_us)) {
+        shown.push_back(this->sequence);
+        this->pacer.record_cost(cost_us);
+      }
+      this->sequence++;
+      this->timestamp_us += this->interval_us;
+    }
+    return shown;
+  }
+};
+
+static bool evenly_spaced(const std::vector<uint32_t> &shown, uint32_t step) {
+  for (size_t i = 1; i < shown.size(); i++) {
+    if (shown[i] - shown[i - 1] != step)
+      return false;
+  }
+  return !shown.empty();
+}
+
+static void test_cadence() {
+  // 30 fps, cheap frames: every frame shown
+  Stream stream(33333);
+  std::vector<uint32_t> shown = stream.run(60, 5000);
+  CHECK_EQ(shown.size(), 60);
+  CHECK_EQ(stream.pacer.get_source_interval_us(), 33333);
+  CHECK_EQ(stream.pacer.get_decimation(), 1);
+  CHECK_EQ(stream.pacer.get_cost_us(), 5000);
+}
+
+static void test_decimation() {
+  // 40 ms per frame at half the CPU: 80 ms between frames, one in three at 30 fps
+  Stream stream(33333);
+  stream.run(30, 40000);
+  CHECK_EQ(stream.pacer.get_decimation(), 3);
+  CHECK(evenly_spaced(stream.run(60, 40000), 3));
+
+  // Cheaper again (40 ms of budget): back to one in two, once the average follows
+  stream.run(200, 20000);
+  CHECK_EQ(stream.pacer.get_decimation(), 2);
+  CHECK(evenly_spaced(stream.run(60, 20000), 2));
+
+  // 31 ms needed: under one camera interval, not 15% under, so still one in two
+  stream.run(200, 15500);
+  CHECK_EQ(stream.pacer.get_decimation(), 2);
+  stream.run(200, 14000);
+  CHECK_EQ(stream.pacer.get_decimation(), 1);
+
+  // A larger budget takes the same cost at full rate
+  Stream generous(33333);
+  generous.pacer.set_cpu_budget(1.0f);
+  generous.run(60, 25000);
+  CHECK_EQ(generous.pacer.get_decimation(), 1);
+
+  // Far too slow: capped
+  Stream slow(33333);
+  slow.run(60, 2000000);
+  CHECK_EQ(slow.pacer.get_decimation(), FramePacer::MAX_DECIMATION);
+
+  slow.pacer.set_cpu_budget(0.0f);
+  CHECK(slow.pacer.get_cpu_budget() == 0.01f);
+}
+
+static void test_min_interval() {
+  // 60 fps cap on a 60 fps sensor ticking slightly fast: not halved
+  Stream fast(16000);
+  fast.pacer.set_min_interval_us(16667);
+  fast.run(60, 1000);
+  CHECK_EQ(fast.pacer.get_decimation(), 1);
+
+  // 30 fps cap on the same sensor: one in two
+  fast.pacer.set_min_interval_us(33333);
+  fast.run(10, 1000);
+  CHECK_EQ(fast.pacer.get_decimation(), 2);
+  CHECK(evenly_spaced(fast.run(40, 1000), 2));
+}
+
+static void test_late_frames() {
+  // Decimation counted in camera frames: a frame seen late is shown if the
+  // camera has moved far enough since the last one shown
+  Stream stream(33333);
+  stream.run(30, 40000);
+  CHECK_EQ(stream.pacer.get_decimation(), 3);
+  FramePacer &pacer = stream.pacer;
+  const uint32_t base = stream.sequence + 10;
+  const int64_t t = stream.timestamp_us;
+  CHECK(pacer.should_display(base, t));
+  CHECK(!pacer.should_display(base + 2, t + 66666));
+  CHECK(pacer.should_display(base + 4, t + 133332));
+  CHECK(!pacer.should_display(base + 5, t + 166665));
+  CHECK(pacer.should_display(base + 7, t + 233331));
+}
+
+static void test_pauses_and_reset() {
+  Stream stream(33333);
+  stream.run(30, 5000);
+  // A 2 s pause is not a cadence
+  stream.timestamp_us += 2000000;
+  stream.run(2, 5000);
+  CHECK_EQ(stream.pacer.get_source_interval_us(), 33333);
+  // Nor a sequence going backwards (mode switch)
+  stream.sequence = 0;
+  stream.run(2, 5000);
+  CHECK_EQ(stream.pacer.get_source_interval_us(), 33333);
+
+  stream.run(30, 40000);
+  CHECK(stream.pacer.get_decimation() > 1);
+  stream.pacer.reset();
+  CHECK_EQ(stream.pacer.get_decimation(), 1);
+  CHECK_EQ(stream.pacer.get_source_interval_us(), 0);
+  CHECK_EQ(stream.pacer.get_cost_us(), 0);
+  // No cadence yet: the next frame is shown whatever came before
+  CHECK(stream.pacer.should_display(stream.sequence, stream.timestamp_us));
+}
+
+int main() {
+  test_cadence();
+  test_decimation();
+  test_min_interval();
+  test_late_frames();
+  test_pauses_and_reset();
+  return test::finish("frame_pacer_test");
+}
@@ -0,0 +1,230 @@
+// FramePool under contention: one producer (the CSI ISR) against several
+// consumers taking and dropping references, both in auto-publish mode and
+// with a processing stage (take_pending / publish) in between.
+//
+// Every frame is filled with its own sequence number, so a consumer that
+// sees a mixed buffer caught the producer writing into a slot it holds.
+// Build with -DCAMERA_TESTS_SANITIZER=thread to also let TSan watch it.
+
+#include "mipi_dsi_cam/frame_pool.h"
+#include "test_support.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static const uint8_t SLOTS = 4;
+static const size_t WORDS = 256;
+// Per mode, whatever the build (TSan is ~20x slower)
+static const auto RUN_TIME = std::chrono::seconds(2);
+static const int CONSUMERS = 3;
+
+// Exposes the pool bookkeeping for the end-of-run leak check
+class PoolProbe : public FramePool {
+ public:
+  uint16_t refs(int8_t slot) const { return this->slots_[slot].refs.load(); }
+  uint8_t free_mask() const { return this->free_mask_.load(); }
+  uint8_t filled_mask() const { return this->filled_mask_.load(); }
+  uint8_t writing_mask() const { return this->writing_mask_.load(); }
+  int8_t latest() const { return this->latest_.load(); }
+};
+
+// References the consumers hold per slot, as seen by the test itself
+static std::atomic<int> g_held[SLOTS];
+
+struct ConsumerStats {
+  uint32_t frames{0};
+  uint32_t torn{0};
+  uint32_t backwards{0};
+  uint32_t bad_info{0};
+};
+
+static bool uniform(const uint32_t *words, uint32_t value) {
+  for (size_t i = 0; i < WORDS; i++) {
+    if (words[i] != value)
+      return false;
+  }
+  return true;
+}
+
+static void consume(PoolProbe &pool, std::atomic<bool> &running, ConsumerStats &stats, int id) {
+  uint32_t last = 0;
+  uint32_t iteration = 0;
+  while (running.load(std::memory_order_relaxed)) {
+    int8_t slot = pool.acquire();
+    if (slot < 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    g_held[slot]++;
+    const FrameInfo &info = pool.info(slot);
+    const uint32_t *words = (const uint32_t *) pool.data(slot);
+    uint32_t seq = info.sequence;
+    if (seq == 0 || pool.sequence(slot) != seq || info.received_size != WORDS * sizeof(uint32_t))
+      stats.bad_info++;
+    if ((int32_t) (seq - last) < 0)
+      stats.backwards++;
+    last = seq;
+
+    // Second reference on the same frame now and then (LVGL + web at once)
+    int8_t again = (iteration++ % 7 == (uint32_t) id) ? pool.acquire() : -1;
+    if (!uniform(words, seq))
+      stats.torn++;
+    // Hold it a little: the producer must go around this slot
+    if (iteration % 16 == 0)
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    if (!uniform(words, seq))
+      stats.torn++;
+    stats.frames++;
+    pool.release(again);
+    g_held[slot]--;
+    pool.release(slot);
+  }
+}
+
+static void produce(PoolProbe &pool, uint32_t *committed, uint32_t *overwrites) {
+  FrameInfo info;
+  info.received_size = WORDS * sizeof(uint32_t);
+  const auto end = std::chrono::steady_clock::now() + RUN_TIME;
+  for (uint32_t i = 0; std::chrono::steady_clock::now() < end; i++) {
+    int8_t slot = pool.begin_write();
+    if (slot < 0)
+      continue;
+    // Sequences are handed out in commit order, starting at 1
+    uint32_t seq = *committed + 1;
+    uint32_t *words = (uint32_t *) pool.data(slot);
+    for (size_t w = 0; w < WORDS; w++)
+      words[w] = seq;
+    // A consumer reading this slot while it was written
+    if (g_held[slot].load() != 0)
+      (*overwrites)++;
+    if (i % 97 == 0) {
+      // DMA error: frame abandoned, slot goes back to the free set
+      pool.cancel_write(slot);
+      continue;
+    }
+    pool.commit_write(slot, info);
+    (*committed)++;
+  }
+}
+
+static void check_no_leak(PoolProbe &pool) {
+  pool.flush();
+  for (int8_t i = 0; i < pool.slot_count(); i++)
+    CHECK_EQ(pool.refs(i), 0);
+  CHECK_EQ(pool.free_mask(), (1u << pool.slot_count()) - 1);
+  CHECK_EQ(pool.filled_mask(), 0);
+  CHECK_EQ(pool.writing_mask(), 0);
+  CHECK_EQ(pool.latest(), -1);
+}
+
+// Deterministic part: a held frame is never handed back to the DMA, however
+// far the producer runs ahead, and comes back once released
+static void check_held_frame_is_skipped() {
+  std::vector<std::vector<uint32_t>> storage(FramePool::MIN_SLOTS, std::vector<uint32_t>(WORDS));
+  uint8_t *buffers[FramePool::MIN_SLOTS];
+  for (uint8_t i = 0; i < FramePool::MIN_SLOTS; i++)
+    buffers[i] = (uint8_t *) storage[i].data();
+  PoolProbe pool;
+  CHECK(pool.init(buffers, FramePool::MIN_SLOTS, WORDS * sizeof(uint32_t)));
+
+  FrameInfo info;
+  pool.commit_write(pool.begin_write(), info);
+  int8_t held = pool.acquire();
+  CHECK(held >= 0);
+  for (int i = 0; i < 20; i++) {
+    int8_t slot = pool.begin_write();
+    CHECK(slot >= 0);
+    CHECK(slot != held);
+    pool.commit_write(slot, info);
+    pool.publish_pending();
+  }
+  CHECK_EQ(pool.refs(held), 1);
+  pool.release(held);
+
+  bool reused = false;
+  for (int i = 0; i < FramePool::MIN_SLOTS; i++) {
+    int8_t slot = pool.begin_write();
+    reused = reused || slot == held;
+    pool.commit_write(slot, info);
+    pool.publish_pending();
+  }
+  CHECK(reused);
+  check_no_leak(pool);
+}
+
+static void run(bool processing_stage) {
+  std::vector<std::vector<uint32_t>> storage(SLOTS, std::vector<uint32_t>(WORDS));
+  uint8_t *buffers[SLOTS];
+  for (uint8_t i = 0; i < SLOTS; i++)
+    buffers[i] = (uint8_t *) storage[i].data();
+
+  PoolProbe pool;
+  CHECK(pool.init(buffers, SLOTS, WORDS * sizeof(uint32_t)));
+  pool.set_auto_publish(!processing_stage);
+
+  std::atomic<bool> running{true};
+  std::vector<ConsumerStats> stats(CONSUMERS);
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < CONSUMERS; i++)
+    consumers.emplace_back(consume, std::ref(pool), std::ref(running), std::ref(stats[i]), i);
+
+  // MipiDsiCam::loop(): takes the newest frame exclusively, then publishes it
+  std::atomic<bool> producing{true};
+  uint32_t processed = 0;
+  std::thread stage;
+  if (processing_stage) {
+    stage = std::thread([&] {
+      while (producing.load(std::memory_order_relaxed)) {
+        int8_t slot = pool.take_pending();
+        if (slot < 0) {
+          std::this_thread::yield();
+          continue;
+        }
+        if (!uniform((const uint32_t *) pool.data(slot), pool.info(slot).sequence))
+          test::failures()++;
+        processed++;
+        pool.publish(slot);
+      }
+    });
+  }
+
+  uint32_t committed = 0;
+  uint32_t overwrites = 0;
+  std::thread producer(produce, std::ref(pool), &committed, &overwrites);
+  producer.join();
+  producing.store(false);
+  if (stage.joinable())
+    stage.join();
+  running.store(false);
+  for (std::thread &t : consumers)
+    t.join();
+
+  uint32_t seen = 0;
+  for (const ConsumerStats &s : stats) {
+    CHECK_EQ(s.torn, 0);
+    CHECK_EQ(s.backwards, 0);
+    CHECK_EQ(s.bad_info, 0);
+    seen += s.frames;
+  }
+  CHECK_EQ(overwrites, 0);
+  CHECK(committed > 1000);
+  CHECK(seen > 1000);
+  if (processing_stage)
+    CHECK(processed > 0);
+  printf("%s: %u frames committed, %u drops, %u consumer reads\n",
+         processing_stage ? "processing stage" : "auto publish", committed, pool.get_dropped_frames(), seen);
+
+  check_no_leak(pool);
+}
+
+int main() {
+  check_held_frame_is_skipped();
+  run(false);
+  run(true);
+  return test::finish("frame_pool_stress_test");
+}
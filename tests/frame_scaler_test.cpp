@@ -0,0 +1,144 @@
+// SoftwareScaler and fit_scale_sixteenths() on fixtures with exact
+// results: 1/16 fit factors, same-size copies, flat colours at odd ratios,
+// a 2:1 area average of a checkerboard, a monotonic bilinear ramp, strided
+// views in and out, and the inputs it must refuse.
+
+#include "mipi_dsi_cam/frame_scaler.h"
+#include "mipi_dsi_cam/pixel_convert.h"
+#include "test_support.h"
+
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static FrameView rgb565_view(std::vector<uint16_t> &pixels, uint16_t w, uint16_t h) {
+  return FrameView::packed((uint8_t *) pixels.data(), w, h, PIXEL_FORMAT_RGB565);
+}
+
+static void test_fit() {
+  CHECK_EQ(fit_scale_sixteenths(1280, 720, 800, 480), 10);
+  CHECK_EQ(fit_scale_sixteenths(640, 480, 320, 240), 8);
+  // Limited by the tighter axis
+  CHECK_EQ(fit_scale_sixteenths(100, 100, 50, 400), 8);
+  CHECK_EQ(fit_scale_sixteenths(160, 120, 800, 480), 64);
+  CHECK_EQ(fit_scale_sixteenths(1920, 1080, 100, 40), 0);
+  CHECK_EQ(fit_scale_sixteenths(0, 720, 800, 480), 0);
+}
+
+static void test_same_size() {
+  const uint16_t w = 13, h = 7;
+  std::vector<uint16_t> src((size_t) w * h);
+  for (size_t i = 0; i < src.size(); i++)
+    src[i] = (uint16_t) (i * 2654435761u >> 16);
+  for (ScaleFilter filter : {SCALE_FILTER_BILINEAR, SCALE_FILTER_AREA}) {
+    std::vector<uint16_t> dst((size_t) w * h);
+    SoftwareScaler scaler(filter);
+    CHECK(scaler.scale(rgb565_view(src, w, h), rgb565_view(dst, w, h)));
+    CHECK(dst == src);
+  }
+}
+
+static void test_flat_colour() {
+  const uint16_t colour = pack_rgb565(200, 60, 120);
+  std::vector<uint16_t> src(37 * 23, colour);
+  struct Size {
+    uint16_t w, h;
+  };
+  for (ScaleFilter filter : {SCALE_FILTER_BILINEAR, SCALE_FILTER_AREA}) {
+    SoftwareScaler scaler(filter);
+    for (Size size : {Size{64, 51}, Size{9, 7}, Size{37, 5}, Size{1, 1}}) {
+      std::vector<uint16_t> dst((size_t) size.w * size.h, 0);
+      CHECK(scaler.scale(rgb565_view(src, 37, 23), rgb565_view(dst, size.w, size.h)));
+      uint32_t wrong = 0;
+      for (uint16_t px : dst)
+        wrong += px != colour;
+      if (wrong != 0)
+        printf("%s 37x23 -> %ux%u: %u pixel(s) off the flat colour\n", scale_filter_name(filter), size.w, size.h,
+               wrong);
+      CHECK_EQ(wrong, 0);
+    }
+  }
+}
+
+static void test_area_average() {
+  // 2x2 black / white checkerboard halved: every output pixel is the mean
+  const uint16_t w = 16, h = 8;
+  std::vector<uint16_t> src((size_t) w * h);
+  for (uint16_t y = 0; y < h; y++) {
+    for (uint16_t x = 0; x < w; x++)
+      src[(size_t) y * w + x] = ((x ^ y) & 1) ? 0xFFFF : 0x0000;
+  }
+  std::vector<uint16_t> dst((size_t) (w / 2) * (h / 2));
+  SoftwareScaler scaler(SCALE_FILTER_AREA);
+  CHECK(scaler.scale(rgb565_view(src, w, h), rgb565_view(dst, w / 2, h / 2)));
+  for (uint16_t px : dst)
+    CHECK_EQ(px, 0x8410);
+}
+
+static void test_bilinear_ramp() {
+  // Horizontal red ramp enlarged 4x: non-decreasing, same ends
+  const uint16_t w = 8, h = 2;
+  std::vector<uint16_t> src((size_t) w * h);
+  for (uint16_t y = 0; y < h; y++) {
+    for (uint16_t x = 0; x < w; x++)
+      src[(size_t) y * w + x] = (uint16_t) ((x * 4) << 11);
+  }
+  std::vector<uint16_t> dst((size_t) w * 4 * h * 4);
+  SoftwareScaler scaler;
+  CHECK(scaler.scale(rgb565_view(src, w, h), rgb565_view(dst, w * 4, h * 4)));
+  for (uint16_t y = 0; y < h * 4; y++) {
+    const uint16_t *row = &dst[(size_t) y * w * 4];
+    CHECK_EQ(row[0], src[0]);
+    CHECK_EQ(row[w * 4 - 1], src[w - 1]);
+    for (uint16_t x = 1; x < w * 4; x++)
+      CHECK(row[x] >= row[x - 1]);
+  }
+  // Output pixel 15 is centred 3/8 of the way from source pixel 3 (12) to 4 (16)
+  CHECK_EQ(dst[15] >> 11, 13);
+}
+
+static void test_strided() {
+  // Scale a crop into a window of a bigger canvas: nothing else is written
+  const uint16_t w = 32, h = 16;
+  std::vector<uint16_t> src((size_t) w * h, 0x0000);
+  for (uint16_t y = 4; y < 12; y++) {
+    for (uint16_t x = 8; x < 24; x++)
+      src[(size_t) y * w + x] = 0xF800;
+  }
+  std::vector<uint16_t> canvas(40 * 30, 0x1234);
+  const FrameView from = rgb565_view(src, w, h).crop({8, 4, 16, 8});
+  const FrameView to = rgb565_view(canvas, 40, 30).crop({10, 5, 8, 4});
+  SoftwareScaler scaler(SCALE_FILTER_AREA);
+  CHECK(scaler.scale(from, to));
+  for (uint16_t y = 0; y < 30; y++) {
+    for (uint16_t x = 0; x < 40; x++) {
+      const bool inside = x >= 10 && x < 18 && y >= 5 && y < 9;
+      CHECK_EQ(canvas[(size_t) y * 40 + x], inside ? 0xF800 : 0x1234);
+    }
+  }
+}
+
+static void test_refused() {
+  std::vector<uint16_t> a(16 * 16), b(8 * 8);
+  SoftwareScaler scaler;
+  FrameView yuv = FrameView::packed((uint8_t *) a.data(), 16, 16, PIXEL_FORMAT_YUV422);
+  CHECK(!scaler.scale(yuv, rgb565_view(b, 8, 8)));
+  CHECK(!scaler.scale(rgb565_view(a, 16, 16), FrameView{}));
+  // Software backend: rotation goes through transform_frame(), identity still scales
+  CHECK(!scaler.supports_transform());
+  FrameTransform rotate;
+  rotate.rotation = ROTATION_90;
+  CHECK(!scaler.scale_transformed(rgb565_view(a, 16, 16), rgb565_view(b, 8, 8), rotate));
+  CHECK(scaler.scale_transformed(rgb565_view(a, 16, 16), rgb565_view(b, 8, 8), FrameTransform{}));
+}
+
+int main() {
+  test_fit();
+  test_same_size();
+  test_flat_colour();
+  test_area_average();
+  test_bilinear_ramp();
+  test_strided();
+  test_refused();
+  return test::finish("frame_scaler_test");
+}
@@ -0,0 +1,265 @@
+// Frame signatures on synthetic frames: exact block means on flat and
+// split frames, sensor-like noise staying under the skip threshold while a
+// single changed block goes over it, the three pixel formats agreeing, and
+// no match across geometries, formats or empty signatures.
+//
+// TileChangeTracker on YUV422 frames (the Y bytes are the tile means): the
+// rectangles for known changed tiles, partial edge tiles, the merge down to
+// MAX_RECTS, the full-redraw cases and slow drift of tiles not redrawn.
+
+#include "mipi_dsi_cam/frame_signature.h"
+#include "mipi_dsi_cam/pixel_convert.h"
+#include "test_support.h"
+
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+// 8x8 pixels per signature block
+static const uint16_t W = FrameSignature::COLS * 8;
+static const uint16_t H = FrameSignature::ROWS * 8;
+
+static std::vector<uint16_t> grey_frame(uint8_t level) {
+  return std::vector<uint16_t>((size_t) W * H, pack_rgb565(level, level, level));
+}
+
+static FrameView view_of(std::vector<uint16_t> &pixels) {
+  return FrameView::packed((uint8_t *) pixels.data(), W, H, PIXEL_FORMAT_RGB565);
+}
+
+static void test_block_means() {
+  std::vector<uint16_t> pixels = grey_frame(0);
+  // Right half white
+  for (uint16_t y = 0; y < H; y++) {
+    for (uint16_t x = W / 2; x < W; x++)
+      pixels[(size_t) y * W + x] = 0xFFFF;
+  }
+  FrameSignature signature;
+  compute_frame_signature(view_of(pixels), 5, signature);
+  CHECK(signature.valid());
+  CHECK_EQ(signature.sequence, 5);
+  CHECK_EQ(signature.width, W);
+  CHECK_EQ(signature.height, H);
+  for (uint8_t row = 0; row < FrameSignature::ROWS; row++) {
+    for (uint8_t col = 0; col < FrameSignature::COLS; col++)
+      CHECK_EQ(signature.blocks[row * FrameSignature::COLS + col], col < FrameSignature::COLS / 2 ? 0 : 255);
+  }
+}
+
+static void test_noise_and_change() {
+  std::vector<uint16_t> pixels = grey_frame(120);
+  FrameSignature reference, current;
+  compute_frame_signature(view_of(pixels), 1, reference);
+  CHECK_EQ(reference.distance(reference), 0);
+
+  // +-1 RGB565 step of noise on every pixel: a few luma levels at most
+  uint32_t noise = 12345;
+  std::vector<uint16_t> noisy = pixels;
+  for (uint16_t &px : noisy) {
+    noise = noise * 1103515245u + 12345u;
+    const int d = (int) ((noise >> 16) % 3) - 1;
+    px = pack_rgb565(120 + d * 8, 120 + d * 4, 120 + d * 8);
+  }
+  compute_frame_signature(view_of(noisy), 2, current);
+  CHECK(current.distance(reference) <= 4);
+  CHECK(!current.differs(reference, 4));
+
+  // One block turns white: that block alone sets the distance
+  std::vector<uint16_t> changed = pixels;
+  for (uint16_t y = 16; y < 24; y++) {
+    for (uint16_t x = 40; x < 48; x++)
+      changed[(size_t) y * W + x] = 0xFFFF;
+  }
+  compute_frame_signature(view_of(changed), 3, current);
+  CHECK_EQ(current.blocks[2 * FrameSignature::COLS + 5], 255);
+  CHECK_EQ(current.blocks[2 * FrameSignature::COLS + 4], reference.blocks[0]);
+  CHECK_EQ(current.distance(reference), 255 - reference.blocks[0]);
+  CHECK(current.differs(reference, 4));
+}
+
+static void test_formats() {
+  std::vector<uint16_t> pixels = grey_frame(160);
+  FrameSignature rgb, yuv, raw;
+  compute_frame_signature(view_of(pixels), 1, rgb);
+
+  std::vector<uint8_t> yuv_pixels((size_t) W * H * 2);
+  convert_to_yuv422(view_of(pixels), yuv_pixels.data());
+  compute_frame_signature(FrameView::packed(yuv_pixels.data(), W, H, PIXEL_FORMAT_YUV422), 1, yuv);
+  std::vector<uint8_t> raw_pixels((size_t) W * H);
+  rgb565_to_raw8(pixels.data(), W, H, 1, raw_pixels.data());
+  compute_frame_signature(FrameView::packed(raw_pixels.data(), W, H, PIXEL_FORMAT_RAW8, 1), 1, raw);
+
+  // Same grey, within the RGB565 rounding; never matched to each other
+  for (size_t i = 0; i < FrameSignature::COLS * FrameSignature::ROWS; i++) {
+    CHECK(yuv.blocks[i] >= rgb.blocks[i] - 2 && yuv.blocks[i] <= rgb.blocks[i] + 2);
+    CHECK(raw.blocks[i] >= rgb.blocks[i] - 2 && raw.blocks[i] <= rgb.blocks[i] + 2);
+  }
+  CHECK_EQ(yuv.distance(rgb), 255);
+  CHECK_EQ(raw.distance(yuv), 255);
+}
+
+static void test_mismatches() {
+  std::vector<uint16_t> pixels = grey_frame(100);
+  FrameSignature full, cropped, empty;
+  compute_frame_signature(view_of(pixels), 1, full);
+  compute_frame_signature(view_of(pixels).crop({0, 0, W / 2, H}), 2, cropped);
+  CHECK(cropped.valid());
+  CHECK_EQ(cropped.distance(full), 255);
+
+  CHECK(!empty.valid());
+  CHECK_EQ(full.distance(empty), 255);
+  CHECK_EQ(empty.distance(empty), 255);
+
+  // Nothing to read: an empty signature, whatever the sequence
+  compute_frame_signature(FrameView{}, 9, empty);
+  CHECK(!empty.valid());
+  CHECK_EQ(empty.sequence, 0);
+}
+
+// YUV422 frame whose luma is `level` everywhere
+struct LumaFrame {
+  uint16_t width;
+  uint16_t height;
+  std::vector<uint8_t> bytes;
+
+  LumaFrame(uint16_t w, uint16_t h, uint8_t level) : width(w), height(h), bytes((size_t) w * h * 2, 128) {
+    this->fill(0, 0, w, h, level);
+  }
+  void fill(uint16_t x0, uint16_t y0, uint16_t w, uint16_t h, uint8_t level) {
+    for (uint16_t y = y0; y < y0 + h; y++) {
+      for (uint16_t x = x0; x < x0 + w; x++)
+        this->bytes[((size_t) y * this->width + x) * 2] = level;
+    }
+  }
+  FrameView view() { return FrameView::packed(this->bytes.data(), this->width, this->height, PIXEL_FORMAT_YUV422); }
+};
+
+static bool same_rect(const FrameRoi &r, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  return r.x == x && r.y == y && r.width == w && r.height == h;
+}
+
+static void test_tile_rects() {
+  LumaFrame frame(128, 96, 80);  // 4 x 3 tiles of 32
+  TileChangeTracker tracker;
+  TileChanges changes;
+  tracker.compare(frame.view(), 4, changes);
+  CHECK(changes.full);
+  CHECK_EQ(changes.tile_count, 12);
+  CHECK(changes.coverage == 1.0f);
+
+  tracker.compare(frame.view(), 4, changes);
+  CHECK(!changes.full);
+  CHECK_EQ(changes.changed_tiles, 0);
+  CHECK_EQ(changes.rect_count, 0);
+
+  // One tile
+  frame.fill(32, 32, 32, 32, 200);
+  tracker.compare(frame.view(), 4, changes);
+  CHECK(!changes.full);
+  CHECK_EQ(changes.changed_tiles, 1);
+  CHECK_EQ(changes.rect_count, 1);
+  CHECK(same_rect(changes.rects[0], 32, 32, 32, 32));
+  CHECK(changes.coverage > 0.083f && changes.coverage < 0.084f);
+  // Redrawn: it is the reference now
+  tracker.compare(frame.view(), 4, changes);
+  CHECK_EQ(changes.changed_tiles, 0);
+
+  // Same run of tiles on two rows: one rectangle
+  frame.fill(64, 0, 64, 64, 10);
+  tracker.compare(frame.view(), 4, changes);
+  CHECK_EQ(changes.changed_tiles, 4);
+  CHECK_EQ(changes.rect_count, 1);
+  CHECK(same_rect(changes.rects[0], 64, 0, 64, 64));
+
+  // Most of the view: a full redraw instead of rectangles
+  frame.fill(0, 0, 128, 64, 250);
+  tracker.compare(frame.view(), 4, changes);
+  CHECK(changes.full);
+  CHECK_EQ(changes.rect_count, 0);
+  tracker.compare(frame.view(), 4, changes);
+  CHECK(!changes.full);
+  CHECK_EQ(changes.changed_tiles, 0);
+
+  tracker.reset();
+  tracker.compare(frame.view(), 4, changes);
+  CHECK(changes.full);
+}
+
+static void test_tile_edges() {
+  // 100 x 70 with 32-pixel tiles: the last column / row of tiles is partial
+  LumaFrame frame(100, 70, 50);
+  TileChangeTracker tracker;
+  TileChanges changes;
+  tracker.compare(frame.view(), 4, changes);
+  CHECK_EQ(changes.tile_count, 4 * 3);
+  frame.fill(96, 64, 4, 6, 220);
+  tracker.compare(frame.view(), 4, changes);
+  CHECK_EQ(changes.rect_count, 1);
+  CHECK(same_rect(changes.rects[0], 96, 64, 4, 6));
+
+  // Geometry change: full redraw
+  LumaFrame other(96, 64, 50);
+  tracker.compare(other.view(), 4, changes);
+  CHECK(changes.full);
+
+  tracker.set_tile_size(1);
+  CHECK_EQ(tracker.get_tile_size(), TileChangeTracker::MIN_TILE_SIZE);
+}
+
+static void test_tile_merge() {
+  // Checkerboard of 16-pixel tiles: far more runs than MAX_RECTS
+  LumaFrame frame(256, 128, 60);
+  TileChangeTracker tracker;
+  tracker.set_tile_size(16);
+  tracker.set_full_threshold(1.0f);
+  TileChanges changes;
+  tracker.compare(frame.view(), 4, changes);
+  for (uint16_t ty = 0; ty < 8; ty++) {
+    for (uint16_t tx = (ty & 1); tx < 16; tx += 2)
+      frame.fill(tx * 16, ty * 16, 16, 16, 180);
+  }
+  tracker.compare(frame.view(), 4, changes);
+  CHECK(!changes.full);
+  CHECK_EQ(changes.changed_tiles, 64);
+  CHECK(changes.rect_count >= 1 && changes.rect_count <= TileChanges::MAX_RECTS);
+  // Every changed tile lies in a rectangle
+  uint32_t uncovered = 0;
+  for (uint16_t ty = 0; ty < 8; ty++) {
+    for (uint16_t tx = (ty & 1); tx < 16; tx += 2) {
+      bool covered = false;
+      for (uint8_t i = 0; i < changes.rect_count; i++) {
+        const FrameRoi &r = changes.rects[i];
+        covered |= tx * 16 >= r.x && tx * 16 + 16 <= r.x + r.width && ty * 16 >= r.y && ty * 16 + 16 <= r.y + r.height;
+      }
+      uncovered += !covered;
+    }
+  }
+  CHECK_EQ(uncovered, 0);
+}
+
+static void test_tile_drift() {
+  LumaFrame frame(64, 64, 100);
+  TileChangeTracker tracker;
+  TileChanges changes;
+  tracker.compare(frame.view(), 4, changes);
+  // +3 then +3 again: below the threshold each time, not in total
+  frame.fill(0, 0, 32, 32, 103);
+  tracker.compare(frame.view(), 4, changes);
+  CHECK_EQ(changes.changed_tiles, 0);
+  frame.fill(0, 0, 32, 32, 106);
+  tracker.compare(frame.view(), 4, changes);
+  CHECK_EQ(changes.changed_tiles, 1);
+  CHECK(same_rect(changes.rects[0], 0, 0, 32, 32));
+}
+
+int main() {
+  test_block_means();
+  test_noise_and_change();
+  test_formats();
+  test_mismatches();
+  test_tile_rects();
+  test_tile_edges();
+  test_tile_merge();
+  test_tile_drift();
+  return test::finish("frame_signature_test");
+}
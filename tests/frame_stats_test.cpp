@@ -0,0 +1,146 @@
+// FrameStatsEngine on small fixtures whose statistics are known exactly:
+// half black / half white frames for the histogram, the zone grid and the
+// clip / crush shares, a uniform light grey for the bright-sample means, the
+// sample count after adapt() changes the step, and the cases where nothing
+// is sampled (other geometry, empty rows) leaving the stats untouched.
+
+#include "mipi_dsi_cam/frame_stats.h"
+#include "mipi_dsi_cam/pixel_convert.h"
+#include "test_support.h"
+
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static const uint16_t W = 64;
+static const uint16_t H = 32;
+
+static FrameView fill(std::vector<uint16_t> &pixels, bool (*is_white)(uint16_t x, uint16_t y)) {
+  pixels.assign((size_t) W * H, 0);
+  for (uint16_t y = 0; y < H; y++) {
+    for (uint16_t x = 0; x < W; x++) {
+      pixels[(size_t) y * W + x] = is_white(x, y) ? 0xFFFF : 0x0000;
+    }
+  }
+  return FrameView::packed((uint8_t *) pixels.data(), W, H, PIXEL_FORMAT_RGB565);
+}
+
+static void test_halves() {
+  std::vector<uint16_t> pixels;
+  const FrameView view = fill(pixels, [](uint16_t x, uint16_t) { return x >= W / 2; });
+  FrameStatsEngine engine;
+  engine.configure(W, H, 4, 2);
+  CHECK_EQ(engine.get_step(), 1);
+  FrameStats stats;
+  CHECK(engine.compute(view, 7, stats));
+  CHECK_EQ(stats.sequence, 7);
+  CHECK_EQ(stats.sample_count, W * H);
+  CHECK_EQ(stats.histogram[0], W * H / 2);
+  CHECK_EQ(stats.histogram[255], W * H / 2);
+  CHECK_EQ(stats.mean_luma, 127);
+  CHECK_EQ(stats.mean_r, 127);
+  CHECK_EQ(stats.mean_g, 127);
+  CHECK_EQ(stats.mean_b, 127);
+  CHECK(stats.clipped_percent == 50.0f);
+  CHECK(stats.crushed_percent == 50.0f);
+  CHECK_EQ(stats.bright_count, 0);
+  CHECK_EQ(stats.zone_cols, 4);
+  CHECK_EQ(stats.zone_rows, 2);
+  for (uint8_t row = 0; row < 2; row++) {
+    CHECK_EQ(stats.zone(0, row), 0);
+    CHECK_EQ(stats.zone(1, row), 0);
+    CHECK_EQ(stats.zone(2, row), 255);
+    CHECK_EQ(stats.zone(3, row), 255);
+  }
+
+  // Top / bottom split, through the row index of the zone grid
+  const FrameView bottom = fill(pixels, [](uint16_t, uint16_t y) { return y >= H / 2; });
+  CHECK(engine.compute(bottom, 8, stats));
+  for (uint8_t col = 0; col < 4; col++) {
+    CHECK_EQ(stats.zone(col, 0), 0);
+    CHECK_EQ(stats.zone(col, 1), 255);
+  }
+  // Scratch of the previous compute() must not leak into this one
+  CHECK_EQ(stats.histogram[0], W * H / 2);
+  CHECK_EQ(stats.histogram[255], W * H / 2);
+}
+
+static void test_bright_samples() {
+  // 224 grey: RGB565 fields 28 / 56 / 28, luma 228, inside [BRIGHT_LEVEL, CLIP_LEVEL)
+  std::vector<uint16_t> pixels((size_t) W * H, pack_rgb565(224, 224, 224));
+  FrameStatsEngine engine;
+  engine.configure(W, H, 8, 8);
+  FrameStats stats;
+  CHECK(engine.compute(FrameView::packed((uint8_t *) pixels.data(), W, H, PIXEL_FORMAT_RGB565), 1, stats));
+  CHECK_EQ(stats.mean_luma, 228);
+  CHECK_EQ(stats.histogram[228], W * H);
+  CHECK_EQ(stats.bright_count, W * H);
+  CHECK_EQ(stats.bright_r, 230);
+  CHECK_EQ(stats.bright_g, 226);
+  CHECK_EQ(stats.bright_b, 230);
+  CHECK(stats.clipped_percent == 0.0f);
+  CHECK(stats.crushed_percent == 0.0f);
+}
+
+static void test_step() {
+  std::vector<uint16_t> pixels;
+  const FrameView view = fill(pixels, [](uint16_t x, uint16_t) { return x >= W / 2; });
+  FrameStatsEngine engine;
+  engine.configure(W, H, 4, 2);
+  // Over budget: one more pixel skipped on both axes
+  engine.adapt(engine.get_budget_us() * 2);
+  CHECK_EQ(engine.get_step(), 2);
+  FrameStats stats;
+  CHECK(engine.compute(view, 1, stats));
+  CHECK_EQ(stats.sample_step, 2);
+  CHECK_EQ(stats.sample_count, (W / 2) * (H / 2));
+  CHECK_EQ(stats.mean_luma, 127);
+  CHECK_EQ(stats.zone(1, 0), 0);
+  CHECK_EQ(stats.zone(2, 0), 255);
+  // Well under budget: back to every pixel
+  engine.adapt(0);
+  CHECK_EQ(engine.get_step(), 1);
+}
+
+static void test_yuv422() {
+  // Mid grey in YUV422 goes through sample_row_rgb565(): the RGB565 rounding
+  // moves the luma by a couple of levels at most
+  std::vector<uint8_t> yuv((size_t) W * H * 2, 128);
+  FrameStatsEngine engine;
+  engine.configure(W, H, 2, 2);
+  FrameStats stats;
+  CHECK(engine.compute(FrameView::packed(yuv.data(), W, H, PIXEL_FORMAT_YUV422), 1, stats));
+  CHECK_EQ(stats.sample_count, W * H);
+  CHECK(stats.mean_luma >= 126 && stats.mean_luma <= 131);
+  CHECK_EQ(stats.zone(0, 0), stats.mean_luma);
+  CHECK_EQ(stats.zone(1, 1), stats.mean_luma);
+}
+
+static void test_nothing_sampled() {
+  std::vector<uint16_t> pixels((size_t) W * H, 0xFFFF);
+  FrameStatsEngine engine;
+  engine.configure(W, H, 4, 4);
+  FrameStats stats;
+  stats.sequence = 3;
+  stats.mean_luma = 42;
+  // Layout made for another size
+  CHECK(!engine.compute(FrameView::packed((uint8_t *) pixels.data(), W / 2, H, PIXEL_FORMAT_RGB565), 9, stats));
+  CHECK_EQ(stats.sequence, 3);
+  CHECK_EQ(stats.mean_luma, 42);
+
+  // Zero-width rows: no sample at all, no sequence stamp either
+  engine.configure(0, H, 4, 4);
+  FrameView empty = FrameView::packed((uint8_t *) pixels.data(), 0, H, PIXEL_FORMAT_RGB565);
+  CHECK(!engine.compute(empty, 10, stats));
+  CHECK_EQ(stats.sequence, 3);
+  CHECK_EQ(stats.sample_count, 0);
+}
+
+int main() {
+  test_halves();
+  test_bright_samples();
+  test_step();
+  test_yuv422();
+  test_nothing_sampled();
+  return test::finish("frame_stats_test");
+}
@@ -0,0 +1,219 @@
+// transform_frame() against a naive per-pixel reference (the loop it
+// replaced): every rotation and mirror combination, RGB565 / RAW8 / YUV422,
+// sizes around TRANSFORM_TILE and odd ones, packed and strided views on both
+// sides. Plus the sizes and Bayer order of transformed_view() and the
+// mismatches transform_frame() refuses.
+
+#include "mipi_dsi_cam/frame_transform.h"
+#include "mipi_dsi_cam/pixel_convert.h"
+#include "test_support.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+struct Size {
+  uint16_t w, h;
+};
+static const Size SIZES[] = {{70, 45}, {64, 32}, {33, 65}, {2, 7}, {1, 1}};
+
+static uint32_t hash(uint32_t x, uint32_t y) {
+  uint32_t h = x * 0x9E3779B1u ^ (y + 0x7F4A7C15u) * 0x85EBCA77u;
+  return h ^ (h >> 15);
+}
+
+static std::vector<FrameTransform> all_transforms() {
+  std::vector<FrameTransform> transforms;
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    for (uint8_t mirror = 0; mirror < 4; mirror++) {
+      FrameTransform t;
+      t.rotation = (FrameRotation) rotation;
+      t.mirror_x = mirror & 1;
+      t.mirror_y = mirror & 2;
+      transforms.push_back(t);
+    }
+  }
+  return transforms;
+}
+
+// Source pixel of output (x, y): mirror of the rotated image undone first,
+// then the clockwise rotation, one pixel at a time
+static void naive_source(const FrameView &src, uint16_t out_w, uint16_t out_h, const FrameTransform &t, uint16_t x,
+                         uint16_t y, uint16_t &sx, uint16_t &sy) {
+  const uint16_t ux = t.mirror_x ? out_w - 1 - x : x;
+  const uint16_t uy = t.mirror_y ? out_h - 1 - y : y;
+  switch (t.rotation) {
+    case ROTATION_90:
+      sx = uy, sy = src.height - 1 - ux;
+      break;
+    case ROTATION_180:
+      sx = src.width - 1 - ux, sy = src.height - 1 - uy;
+      break;
+    case ROTATION_270:
+      sx = src.width - 1 - uy, sy = ux;
+      break;
+    default:
+      sx = ux, sy = uy;
+      break;
+  }
+}
+
+// Canvas a bit larger than the view, with a margin the transform must not touch
+struct Canvas {
+  static const uint8_t FILL = 0xA5;
+  std::vector<uint8_t> bytes;
+  FrameView whole;
+  FrameView view;
+
+  Canvas(uint16_t w, uint16_t h, PixelFormat format, bool strided) {
+    const uint16_t margin = strided ? 2 : 0;
+    bytes.assign((size_t) (w + 2 * margin) * (h + 2 * margin) * bytes_per_pixel(format), FILL);
+    whole = FrameView::packed(bytes.data(), w + 2 * margin, h + 2 * margin, format);
+    // Odd byte offset for RGB565 (no aligned 32-bit words), whole Bayer quads for RAW8
+    const uint16_t x = margin + (format == PIXEL_FORMAT_RGB565 ? 1 : 0);
+    view = strided ? whole.crop({x, margin, w, h}) : whole;
+  }
+  // Bytes outside `view` still FILL
+  bool margin_untouched() const {
+    const uint8_t bpp = bytes_per_pixel(whole.format);
+    for (uint16_t y = 0; y < whole.height; y++) {
+      for (uint16_t x = 0; x < whole.width * bpp; x++) {
+        const uint8_t *p = whole.row(y) + x;
+        const bool inside = p >= view.data && (size_t) (p - view.data) / view.stride < view.height &&
+                            (size_t) (p - view.data) % view.stride < view.row_bytes();
+        if (!inside && *p != FILL)
+          return false;
+      }
+    }
+    return true;
+  }
+};
+
+static void test_pixels(PixelFormat format) {
+  const uint8_t bpp = bytes_per_pixel(format);
+  for (const Size &size : SIZES) {
+    for (bool strided : {false, true}) {
+      Canvas src(size.w, size.h, format, strided);
+      for (uint16_t y = 0; y < size.h; y++) {
+        for (uint16_t x = 0; x < size.w; x++) {
+          const uint32_t v = hash(x, y);
+          memcpy(src.view.row(y) + x * bpp, &v, bpp);
+        }
+      }
+      for (const FrameTransform &t : all_transforms()) {
+        const uint16_t out_w = t.swaps_axes() ? size.h : size.w;
+        const uint16_t out_h = t.swaps_axes() ? size.w : size.h;
+        Canvas dst(out_w, out_h, format, strided);
+        CHECK(transform_frame(src.view, dst.view, t));
+        uint32_t wrong = 0;
+        for (uint16_t y = 0; y < out_h; y++) {
+          for (uint16_t x = 0; x < out_w; x++) {
+            uint16_t sx, sy;
+            naive_source(src.view, out_w, out_h, t, x, y, sx, sy);
+            wrong += memcmp(dst.view.row(y) + x * bpp, src.view.row(sy) + sx * bpp, bpp) != 0;
+          }
+        }
+        if (wrong != 0)
+          printf("format %d %ux%u %s%s%s%s: %u pixel(s) differ\n", format, size.w, size.h, rotation_name(t.rotation),
+                 t.mirror_x ? " mirror_x" : "", t.mirror_y ? " mirror_y" : "", strided ? " strided" : "", wrong);
+        CHECK_EQ(wrong, 0);
+        CHECK(dst.margin_untouched());
+      }
+    }
+  }
+}
+
+static void test_yuv422() {
+  for (const Size &size : SIZES) {
+    if (size.w % 2 != 0)
+      continue;
+    for (bool strided : {false, true}) {
+      Canvas src(size.w, size.h, PIXEL_FORMAT_YUV422, strided);
+      for (uint16_t y = 0; y < size.h; y++) {
+        for (uint16_t x = 0; x < size.w; x++) {
+          // Y per pixel, U / V per pair
+          src.view.row(y)[x * 2] = (uint8_t) hash(x, y);
+          src.view.row(y)[x * 2 + 1] = (uint8_t) (hash(x / 2, y + 1000) >> (x & 1 ? 8 : 0));
+        }
+      }
+      for (const FrameTransform &t : all_transforms()) {
+        // A quarter turn of an odd height drops one source row
+        const uint16_t out_w = (t.swaps_axes() ? size.h : size.w) & ~1;
+        const uint16_t out_h = t.swaps_axes() ? size.w : size.h;
+        const FrameView expected = transformed_view(src.view, t, nullptr);
+        CHECK_EQ(expected.width, out_w);
+        CHECK_EQ(expected.height, out_h);
+        if (out_w == 0)
+          continue;
+        Canvas dst(out_w, out_h, PIXEL_FORMAT_YUV422, strided);
+        CHECK(transform_frame(src.view, dst.view, t));
+        uint32_t wrong = 0;
+        for (uint16_t y = 0; y < out_h; y++) {
+          for (uint16_t x = 0; x < out_w; x += 2) {
+            uint16_t sx0, sy0, sx1, sy1;
+            naive_source(src.view, out_w, out_h, t, x, y, sx0, sy0);
+            naive_source(src.view, out_w, out_h, t, x + 1, y, sx1, sy1);
+            const uint8_t *p0 = src.view.row(sy0) + (sx0 & ~1) * 2;
+            const uint8_t *p1 = src.view.row(sy1) + (sx1 & ~1) * 2;
+            const uint8_t *d = dst.view.row(y) + x * 2;
+            // Own luma, chroma averaged over the two source pairs
+            wrong += d[0] != p0[(sx0 & 1) * 2];
+            wrong += d[2] != p1[(sx1 & 1) * 2];
+            wrong += d[1] != ((p0[1] + p1[1] + 1) >> 1);
+            wrong += d[3] != ((p0[3] + p1[3] + 1) >> 1);
+          }
+        }
+        if (wrong != 0)
+          printf("YUV422 %ux%u %s%s%s%s: %u byte(s) differ\n", size.w, size.h, rotation_name(t.rotation),
+                 t.mirror_x ? " mirror_x" : "", t.mirror_y ? " mirror_y" : "", strided ? " strided" : "", wrong);
+        CHECK_EQ(wrong, 0);
+        CHECK(dst.margin_untouched());
+      }
+    }
+  }
+}
+
+static void test_bayer_order() {
+  // A flat colour mosaic, transformed, demosaics to the same colour with the
+  // order transformed_view() reports
+  const uint16_t w = 16, h = 12;
+  const uint16_t colour = pack_rgb565(232, 96, 24);
+  std::vector<uint16_t> flat((size_t) w * h, colour);
+  std::vector<uint8_t> raw((size_t) w * h), out_raw((size_t) w * h);
+  std::vector<uint16_t> rgb((size_t) w * h);
+  for (uint8_t pattern = 0; pattern < 4; pattern++) {
+    rgb565_to_raw8(flat.data(), w, h, pattern, raw.data());
+    const FrameView src = FrameView::packed(raw.data(), w, h, PIXEL_FORMAT_RAW8, pattern);
+    for (const FrameTransform &t : all_transforms()) {
+      const FrameView dst = transformed_view(src, t, out_raw.data());
+      CHECK(transform_frame(src, dst, t));
+      convert_to_rgb565(dst, rgb.data(), DEMOSAIC_NEAREST);
+      uint32_t wrong = 0;
+      for (size_t i = 0; i < (size_t) dst.width * dst.height; i++)
+        wrong += rgb[i] != colour;
+      CHECK_EQ(wrong, 0);
+    }
+  }
+}
+
+static void test_refused() {
+  std::vector<uint16_t> a(16 * 8), b(16 * 8);
+  const FrameView src = FrameView::packed((uint8_t *) a.data(), 16, 8, PIXEL_FORMAT_RGB565);
+  FrameTransform quarter;
+  quarter.rotation = ROTATION_90;
+  // Unrotated size for a quarter turn, another format, nothing to write to
+  CHECK(!transform_frame(src, FrameView::packed((uint8_t *) b.data(), 16, 8, PIXEL_FORMAT_RGB565), quarter));
+  CHECK(!transform_frame(src, FrameView::packed((uint8_t *) b.data(), 16, 8, PIXEL_FORMAT_YUV422), FrameTransform{}));
+  CHECK(!transform_frame(src, FrameView{}, FrameTransform{}));
+  CHECK(transform_frame(src, transformed_view(src, quarter, (uint8_t *) b.data()), quarter));
+}
+
+int main() {
+  test_pixels(PIXEL_FORMAT_RGB565);
+  test_pixels(PIXEL_FORMAT_RAW8);
+  test_yuv422();
+  test_bayer_order();
+  test_refused();
+  return test::finish("frame_transform_test");
+}
@@ -0,0 +1,123 @@
+// FrameView::crop() and zoom_window() bounds: crops inside the frame only
+// move the pointer, crops past an edge are clipped, YUV422 keeps whole
+// Y0UY1V pairs and RAW8 its Bayer phase, zoom windows stay inside the frame
+// whatever the centre, and FrameRoi survives pack() / unpack().
+
+#include "mipi_dsi_cam/frame_view.h"
+#include "test_support.h"
+
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static const uint16_t W = 64;
+static const uint16_t H = 48;
+
+static void check_view(const FrameView &view, const FrameView &frame, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  CHECK_EQ(view.data - frame.data, (long) y * frame.stride + x * bytes_per_pixel(frame.format));
+  CHECK_EQ(view.width, w);
+  CHECK_EQ(view.height, h);
+  CHECK_EQ(view.stride, frame.stride);
+  CHECK_EQ(view.format, frame.format);
+}
+
+static void test_crop_rgb565() {
+  std::vector<uint8_t> buffer((size_t) W * H * 2);
+  const FrameView frame = FrameView::packed(buffer.data(), W, H, PIXEL_FORMAT_RGB565);
+  CHECK(frame.is_packed());
+
+  const FrameView inside = frame.crop({10, 5, 20, 30});
+  check_view(inside, frame, 10, 5, 20, 30);
+  CHECK(!inside.is_packed());
+  CHECK_EQ(inside.row_bytes(), 40);
+
+  // Past the right / bottom edge: clipped to the frame
+  check_view(frame.crop({50, 40, 100, 100}), frame, 50, 40, W - 50, H - 40);
+  // Origin outside: pinned to the last row / column
+  check_view(frame.crop({200, 100, 10, 10}), frame, W - 1, H - 1, 1, 1);
+  // Zero size: the whole frame
+  check_view(frame.crop({10, 10, 0, 5}), frame, 0, 0, W, H);
+  // Crop of a crop stays in the parent's buffer
+  check_view(inside.crop({2, 3, 100, 4}), frame, 12, 8, 18, 4);
+
+  FrameView empty{};
+  const FrameView still_empty = empty.crop({1, 1, 2, 2});
+  CHECK(still_empty.data == nullptr);
+  CHECK(!still_empty.valid());
+}
+
+static void test_crop_yuv422() {
+  std::vector<uint8_t> buffer((size_t) W * H * 2);
+  const FrameView frame = FrameView::packed(buffer.data(), W, H, PIXEL_FORMAT_YUV422);
+  // Odd x drops to the start of its pair, odd width grows to a whole pair
+  check_view(frame.crop({11, 3, 9, 7}), frame, 10, 3, 10, 7);
+  check_view(frame.crop({10, 3, 8, 7}), frame, 10, 3, 8, 7);
+  // Up to the right edge: the widened pair still ends on it
+  check_view(frame.crop({61, 0, 3, 1}), frame, 60, 0, 4, 1);
+  const FrameView pair = frame.crop({W - 1, 0, 1, 1});
+  CHECK_EQ(pair.width % 2, 0);
+  CHECK((pair.data - frame.data) % 4 == 0);
+}
+
+static void test_crop_raw8() {
+  std::vector<uint8_t> buffer((size_t) W * H);
+  const FrameView frame = FrameView::packed(buffer.data(), W, H, PIXEL_FORMAT_RAW8, 3);
+  // Odd origin moves to the quad's corner, the size grows to keep the area
+  const FrameView crop = frame.crop({5, 7, 10, 10});
+  check_view(crop, frame, 4, 6, 11, 11);
+  CHECK_EQ(crop.bayer_pattern, 3);
+  check_view(frame.crop({4, 6, 10, 10}), frame, 4, 6, 10, 10);
+}
+
+static void test_zoom_window() {
+  // No zoom
+  CHECK(zoom_window(W, H, 1.0f, 0.5f, 0.5f).is_full());
+  CHECK(zoom_window(W, H, 0.5f, 0.5f, 0.5f).is_full());
+
+  const FrameRoi centred = zoom_window(W, H, 2.0f, 0.5f, 0.5f);
+  CHECK_EQ(centred.x, 16);
+  CHECK_EQ(centred.y, 12);
+  CHECK_EQ(centred.width, 32);
+  CHECK_EQ(centred.height, 24);
+
+  // Centre near a corner: the window slides back inside
+  const FrameRoi corner = zoom_window(W, H, 4.0f, 0.0f, 1.0f);
+  CHECK_EQ(corner.x, 0);
+  CHECK_EQ(corner.width, 16);
+  CHECK_EQ(corner.y + corner.height, H);
+  const FrameRoi far = zoom_window(W, H, 4.0f, 1.0f, 0.0f);
+  CHECK_EQ(far.x + far.width, W);
+  CHECK_EQ(far.y, 0);
+
+  // Even origin and sizes for every factor, never past the frame
+  for (float factor = 1.1f; factor < 40.0f; factor *= 1.3f) {
+    for (float c = 0.0f; c <= 1.0f; c += 0.125f) {
+      const FrameRoi roi = zoom_window(W - 2, H - 2, factor, c, 1.0f - c);
+      CHECK_EQ(roi.x % 2, 0);
+      CHECK_EQ(roi.width % 2, 0);
+      CHECK_EQ(roi.height % 2, 0);
+      CHECK(roi.width >= 2 && roi.height >= 2);
+      CHECK(roi.x + roi.width <= W - 2);
+      CHECK(roi.y + roi.height <= H - 2);
+    }
+  }
+}
+
+static void test_pack() {
+  const FrameRoi roi{0x1234, 0xFFFF, 1, 0x8000};
+  const FrameRoi back = FrameRoi::unpack(roi.pack());
+  CHECK_EQ(back.x, roi.x);
+  CHECK_EQ(back.y, roi.y);
+  CHECK_EQ(back.width, roi.width);
+  CHECK_EQ(back.height, roi.height);
+  CHECK_EQ(FrameRoi{}.pack(), 0);
+}
+
+int main() {
+  test_crop_rgb565();
+  test_crop_yuv422();
+  test_crop_raw8();
+  test_zoom_window();
+  test_pack();
+  return test::finish("frame_view_test");
+}
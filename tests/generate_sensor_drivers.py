@@ -0,0 +1,53 @@
+"""Generates the sensor drivers for the host tests, the way __init__.py::to_code does.
+
+usage: generate_sensor_drivers.py <output.h>
+
+Every sensor_mipi_csi_*.py driver is emitted, plus a table of the raw init
+sequences (before burst coalescing) for the tests to compare against.
+"""
+import importlib
+import os
+import sys
+import types
+
+COMPONENT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'components', 'mipi_dsi_cam')
+SENSORS = ['sc202cs', 'sc2336', 'ov5647', 'ov5647_480p', 'ov5647_vga', 'ov02c10']
+
+
+def load_sensor_modules():
+    # Imported as a package: the generators use relative imports (sensor_codegen)
+    package = types.ModuleType('mipi_dsi_cam_sensors')
+    package.__path__ = [COMPONENT_DIR]
+    sys.modules[package.__name__] = package
+    return {name: importlib.import_module(f'{package.__name__}.sensor_mipi_csi_{name}') for name in SENSORS}
+
+
+def main(output):
+    modules = load_sensor_modules()
+    code = '#pragma once\n\n// Generated by tests/generate_sensor_drivers.py, do not edit\n\n'
+    for name in SENSORS:
+        code += modules[name].get_driver_code() + '\n\n'
+
+    code += 'namespace esphome {\nnamespace mipi_dsi_cam {\nnamespace reference {\n\n'
+    code += 'struct RegisterWrite {\n  uint16_t addr;\n  uint8_t value;\n  uint16_t delay_ms;\n};\n\n'
+    for name in SENSORS:
+        sequence = modules[name].INIT_SEQUENCE
+        code += f'static const RegisterWrite {name}_reference_init[] = {{\n'
+        for addr, value, delay in sequence:
+            code += f'    {{0x{addr:04X}, 0x{value:02X}, {delay}}},\n'
+        code += '};\n\n'
+
+    code += 'struct SensorUnderTest {\n  const char *name;\n  ISensorDriver *(*create)(i2c::I2CDevice *i2c);\n'
+    code += '  const RegisterWrite *init;\n  size_t init_count;\n};\n\n'
+    code += 'static const SensorUnderTest SENSORS[] = {\n'
+    for name in SENSORS:
+        code += (f'    {{"{name}", [](i2c::I2CDevice *i2c) -> ISensorDriver * {{ return new {name.upper()}Adapter(i2c); }}, '
+                 f'{name}_reference_init, sizeof({name}_reference_init) / sizeof({name}_reference_init[0])}},\n')
+    code += '};\n\n}  // namespace reference\n}  // namespace mipi_dsi_cam\n}  // namespace esphome\n'
+
+    with open(output, 'w') as f:
+        f.write(code)
+
+
+if __name__ == '__main__':
+    main(sys.argv[1])
@@ -0,0 +1,361 @@
+// Host runtime behind the web server load test:
+//  - FreeRTOS mutexes, tasks and task notifications on std::thread
+//  - esp_http_server over POSIX sockets: one server thread accepting and
+//    dispatching like httpd, async handlers keeping their socket, a small
+//    send buffer (16 KB) so a slow client fills it as on lwIP
+//  - a JPEG "engine" standing in for the P4 encoder: one at a time, reads
+//    the input, takes the hardware's time (~40 Mpixel/s), returns 1/10 of
+//    the input size
+
+#include "driver/jpeg_encode.h"
+#include "esp_heap_caps.h"
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Read by the load test server for its report
+std::atomic<uint32_t> g_jpeg_encodes{0};
+
+const char *esp_err_to_name(esp_err_t err) { return err == ESP_OK ? "ESP_OK" : "ESP_FAIL"; }
+
+void *heap_caps_malloc(size_t size, uint32_t caps) { return malloc(size); }
+void heap_caps_free(void *ptr) { free(ptr); }
+
+// --- FreeRTOS ---
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::timed_mutex(); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+  auto *mutex = (std::timed_mutex *) semaphore;
+  if (ticks == portMAX_DELAY) {
+    mutex->lock();
+    return pdTRUE;
+  }
+  return mutex->try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  ((std::timed_mutex *) semaphore)->unlock();
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) { delete (std::timed_mutex *) semaphore; }
+
+void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }
+
+struct Task {
+  std::mutex mutex;
+  std::condition_variable notified;
+  uint32_t count{0};
+};
+// vTaskDelete(nullptr) unwinds the task's thread
+struct TaskExit {};
+static thread_local Task *t_current_task = nullptr;
+
+BaseType_t xTaskCreate(void (*function)(void *), const char *name, uint32_t stack_size, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+  Task *task = new Task();
+  if (handle != nullptr)
+    *handle = task;
+  std::thread([function, arg, task] {
+    t_current_task = task;
+    try {
+      function(arg);
+    } catch (TaskExit &) {
+    }
+  }).detach();
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) { throw TaskExit{}; }
+
+// Threads not started by xTaskCreate() (the httpd one) get theirs on demand
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (t_current_task == nullptr)
+    t_current_task = new Task();
+  return t_current_task;
+}
+
+void xTaskNotifyGive(TaskHandle_t handle) {
+  Task *task = (Task *) handle;
+  std::lock_guard<std::mutex> lock(task->mutex);
+  task->count++;
+  task->notified.notify_one();
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  Task *task = (Task *) xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->mutex);
+  auto ready = [task] { return task->count != 0; };
+  if (ticks == portMAX_DELAY) {
+    task->notified.wait(lock, ready);
+  } else {
+    task->notified.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+  }
+  uint32_t count = task->count;
+  if (count != 0)
+    task->count = clear_on_exit ? 0 : count - 1;
+  return count;
+}
+
+// --- JPEG engine ---
+
+static std::mutex g_engine;
+
+esp_err_t jpeg_new_encoder_engine(const jpeg_encode_engine_cfg_t *config, jpeg_encoder_handle_t *handle) {
+  *handle = (jpeg_encoder_handle_t) &g_engine;
+  return ESP_OK;
+}
+
+esp_err_t jpeg_del_encoder_engine(jpeg_encoder_handle_t handle) { return ESP_OK; }
+
+esp_err_t jpeg_encoder_process(jpeg_encoder_handle_t handle, const jpeg_encode_config_t *config, const uint8_t *in,
+                               uint32_t in_size, uint8_t *out, uint32_t out_capacity, uint32_t *out_size) {
+  std::lock_guard<std::mutex> lock(g_engine);
+  // DMA read of the input
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < in_size; i += 64)
+    sum += in[i];
+  std::this_thread::sleep_for(std::chrono::microseconds((int64_t) config->width * config->height / 40));
+  const uint32_t size = std::min<uint32_t>(in_size / 10, out_capacity);
+  if (size < 4)
+    return ESP_FAIL;
+  memset(out, sum & 0x7F, size);
+  out[0] = 0xFF, out[1] = 0xD8, out[size - 2] = 0xFF, out[size - 1] = 0xD9;
+  *out_size = size;
+  g_jpeg_encodes++;
+  return ESP_OK;
+}
+
+// --- esp_http_server ---
+
+struct Request {
+  int fd{-1};
+  std::string uri;
+  std::string query;
+  std::map<std::string, std::string> headers;
+  std::string status{"200 OK"};
+  std::string type{"text/html"};
+  std::vector<std::pair<std::string, std::string>> extra_headers;
+  bool headers_sent{false};
+  bool detached{false};  // async handler owns the socket now
+};
+
+struct Server {
+  int listen_fd{-1};
+  std::vector<httpd_uri_t> uris;
+};
+
+static Request *request_of(httpd_req_t *req) { return (Request *) req->aux; }
+
+static bool write_all(int fd, const char *data, size_t size) {
+  while (size != 0) {
+    ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (written <= 0)
+      return false;
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+// length < 0: chunked
+static bool send_headers(Request *request, long length) {
+  std::string head = "HTTP/1.1 " + request->status + "\r\nContent-Type: " + request->type + "\r\n";
+  for (auto &field : request->extra_headers)
+    head += field.first + ": " + field.second + "\r\n";
+  head += length >= 0 ? "Content-Length: " + std::to_string(length) + "\r\n" : "Transfer-Encoding: chunked\r\n";
+  head += "Connection: close\r\n\r\n";
+  request->headers_sent = true;
+  return write_all(request->fd, head.data(), head.size());
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type) {
+  request_of(req)->type = type;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value) {
+  request_of(req)->extra_headers.emplace_back(field, value);
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status) {
+  request_of(req)->status = status;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t len) {
+  if (len < 0)
+    len = buf != nullptr ? strlen(buf) : 0;
+  Request *request = request_of(req);
+  return send_headers(request, len) && write_all(request->fd, buf, len) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t len) {
+  Request *request = request_of(req);
+  if (!request->headers_sent && !send_headers(request, -1))
+    return ESP_FAIL;
+  if (len < 0)
+    len = buf != nullptr ? strlen(buf) : 0;
+  char size[16];
+  snprintf(size, sizeof(size), "%zx\r\n", (size_t) len);
+  if (!write_all(request->fd, size, strlen(size)))
+    return ESP_FAIL;
+  if (len != 0 && !write_all(request->fd, buf, len))
+    return ESP_FAIL;
+  return write_all(request->fd, "\r\n", 2) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *message) {
+  static const char *const STATUS[] = {"400 Bad Request", "404 Not Found", "500 Internal Server Error",
+                                       "503 Service Unavailable"};
+  request_of(req)->status = STATUS[error];
+  request_of(req)->type = "text/plain";
+  return httpd_resp_send(req, message, HTTPD_RESP_USE_STRLEN);
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t *req) { return request_of(req)->query.size(); }
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *req, char *buf, size_t len) {
+  const std::string &query = request_of(req)->query;
+  if (query.empty() || len == 0)
+    return ESP_ERR_NOT_FOUND;
+  snprintf(buf, len, "%s", query.c_str());
+  return ESP_OK;
+}
+
+esp_err_t httpd_query_key_value(const char *query, const char *key, char *value, size_t len) {
+  const std::string all = std::string("&") + query;
+  const std::string prefix = std::string("&") + key + "=";
+  size_t pos = all.find(prefix);
+  if (pos == std::string::npos)
+    return ESP_ERR_NOT_FOUND;
+  pos += prefix.size();
+  snprintf(value, len, "%s", all.substr(pos, all.find('&', pos) - pos).c_str());
+  return ESP_OK;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *value, size_t len) {
+  auto it = request_of(req)->headers.find(field);
+  if (it == request_of(req)->headers.end())
+    return ESP_ERR_NOT_FOUND;
+  snprintf(value, len, "%s", it->second.c_str());
+  return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *req, httpd_req_t **copy) {
+  *copy = new httpd_req_t(*req);
+  (*copy)->aux = new Request(*request_of(req));
+  request_of(req)->detached = true;
+  return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *req) {
+  close(request_of(req)->fd);
+  delete request_of(req);
+  delete req;
+  return ESP_OK;
+}
+
+static void parse_request(const std::string &head, Request &request) {
+  const size_t method_end = head.find(' ');
+  const size_t target_end = head.find(' ', method_end + 1);
+  const std::string target =
+      method_end == std::string::npos ? "/" : head.substr(method_end + 1, target_end - method_end - 1);
+  const size_t query = target.find('?');
+  request.uri = target.substr(0, query);
+  if (query != std::string::npos)
+    request.query = target.substr(query + 1);
+  // "Field: value" lines
+  size_t line = head.find("\r\n");
+  while (line != std::string::npos && line + 2 < head.size()) {
+    const size_t next = head.find("\r\n", line + 2);
+    const std::string field = head.substr(line + 2, next - line - 2);
+    const size_t colon = field.find(':');
+    if (colon != std::string::npos)
+      request.headers[field.substr(0, colon)] = field.substr(field.find_first_not_of(' ', colon + 1));
+    line = next;
+  }
+}
+
+static void serve(Server *server) {
+  for (;;) {
+    int fd = accept(server->listen_fd, nullptr, nullptr);
+    if (fd < 0)
+      continue;
+    timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int send_buffer = 16384;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &send_buffer, sizeof(send_buffer));
+
+    std::string head;
+    char buf[2048];
+    while (head.find("\r\n\r\n") == std::string::npos) {
+      ssize_t received = recv(fd, buf, sizeof(buf), 0);
+      if (received <= 0)
+        break;
+      head.append(buf, received);
+    }
+    Request *request = new Request();
+    request->fd = fd;
+    parse_request(head.substr(0, head.find("\r\n\r\n") + 2), *request);
+
+    httpd_req_t req{};
+    req.aux = request;
+    bool found = false;
+    for (const httpd_uri_t &uri : server->uris) {
+      if (request->uri == uri.uri) {
+        req.user_ctx = uri.user_ctx;
+        uri.handler(&req);
+        found = true;
+        break;
+      }
+    }
+    if (!found)
+      httpd_resp_send_err(&req, HTTPD_404_NOT_FOUND, "Not found");
+    if (!request->detached)
+      close(fd);
+    delete request;
+  }
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config) {
+  Server *server = new Server();
+  server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  int reuse = 1;
+  setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(config->server_port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(server->listen_fd, (sockaddr *) &address, sizeof(address)) != 0 || listen(server->listen_fd, 16) != 0) {
+    perror("httpd_start");
+    return ESP_FAIL;
+  }
+  *handle = server;
+  std::thread(serve, server).detach();
+  return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri) {
+  ((Server *) handle)->uris.push_back(*uri);
+  return ESP_OK;
+}
@@ -0,0 +1,76 @@
+#!/bin/bash
+# N curl clients on /stream of the host web server for T seconds; reports
+# each client's parts and fps, then the server's camera fps, encodes/s and
+# CPU.
+#
+#   tests/loadtest/run_load_test.sh BUILD_DIR N [query]
+#
+# Environment: T (measure, 8 s), PORT (8088), SLOW (curl --limit-rate of
+# client 1, e.g. 50k), SNAPSHOTS=1 (one /snapshot after another next to the
+# streams, alternating with ?roi=0: a third JPEG profile on the two allowed),
+# and for the server STATIC, MAX_STREAMS, MAX_FPS and MODE_SWITCH=ms (every
+# client must then get parts of both modes).
+# Exits non-zero when a client got nothing, lost its stream or a snapshot
+# failed.
+set -u
+
+BUILD_DIR=$1
+N=${2:-4}
+QUERY=${3:-}
+T=${T:-8}
+PORT=${PORT:-8088}
+export PORT
+
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+"$BUILD_DIR/web_loadtest_server" "$T" >"$OUT/server.log" 2>"$OUT/server.err" &
+SERVER=$!
+for _ in $(seq 100); do
+  grep -q READY "$OUT/server.err" 2>/dev/null && break
+  sleep 0.05
+done
+# Clients start with the measure window, after the server's warm-up
+sleep 1
+
+CLIENTS=()
+for i in $(seq "$N"); do
+  RATE=()
+  [ -n "${SLOW:-}" ] && [ "$i" = 1 ] && RATE=(--limit-rate "$SLOW")
+  curl -s -N "${RATE[@]}" --max-time "$T" "http://127.0.0.1:$PORT/stream$QUERY" -o "$OUT/out$i" -D "$OUT/hdr$i" &
+  CLIENTS+=($!)
+done
+if [ -n "${SNAPSHOTS:-}" ]; then
+  (
+    END=$((SECONDS + T))
+    while [ "$SECONDS" -lt "$END" ]; do
+      for Q in "" "?roi=0"; do
+        curl -s --max-time 2 -o /dev/null -w '%{http_code}\n' "http://127.0.0.1:$PORT/snapshot$Q"
+      done
+    done >"$OUT/snapshots"
+  ) &
+  CLIENTS+=($!)
+fi
+wait "${CLIENTS[@]}" 2>/dev/null
+
+STATUS=0
+for i in $(seq "$N"); do
+  PARTS=$(grep -c -a -- '--mipi-camera-frame' "$OUT/out$i")
+  SIZES=$(grep -a '^Content-Length:' "$OUT/out$i" | sort -u | wc -l)
+  echo "client $i: $(head -1 "$OUT/hdr$i" | tr -d '\r'), $PARTS parts, $(awk "BEGIN { printf \"%.1f\", $PARTS / $T }") fps"
+  [ "$PARTS" -gt 0 ] || STATUS=1
+  # Both modes seen: the stream went through the switch
+  if [ -n "${MODE_SWITCH:-}" ] && [ "$SIZES" -lt 2 ]; then
+    echo "client $i: stream lost at the mode switch"
+    STATUS=1
+  fi
+done
+if [ -n "${SNAPSHOTS:-}" ]; then
+  TOTAL=$(wc -l <"$OUT/snapshots")
+  OK=$(grep -c '^200$' "$OUT/snapshots")
+  echo "snapshots: $OK/$TOTAL OK"
+  [ "$TOTAL" -gt 0 ] && [ "$OK" = "$TOTAL" ] || STATUS=1
+fi
+wait "$SERVER"
+grep -a "^server:" "$OUT/server.log"
+exit $STATUS
@@ -0,0 +1,125 @@
+// The camera web server on host, for run_load_test.sh: mock sensor at
+// 640x480 30 fps behind VirtualCsiBackend, the real MipiDsiCam and
+// MipiCameraWebServer, httpd and the JPEG engine from host_runtime.cpp.
+//
+//   web_loadtest_server SECONDS
+//
+// Environment: PORT (8088), MAX_STREAMS (4), MAX_FPS, STATIC (color bars
+// instead of a moving gradient, for the unchanged-frame paths) and
+// MODE_SWITCH=ms (switch to mode 1 halfway through the measure, the stream
+// stopped for that long: on the board the sensor's mode table over I2C and
+// the CSI/ISP reconfigure take that time, the mock sensor none).
+//
+// Prints READY on stderr once serving, then after a 1 s warm-up measures
+// for SECONDS and reports on stdout: camera fps, encodes/s, process CPU
+// and the web counters.
+
+#include "mipi_camera_web_server/mipi_camera_web_server.h"
+#include "mipi_dsi_cam/virtual_csi_backend.h"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace esphome;
+
+namespace esphome {
+namespace setup_priority {
+const float HARDWARE = 800.0f;
+const float DATA = 600.0f;
+const float WIFI = 250.0f;
+const float LATE = -100.0f;
+}  // namespace setup_priority
+
+static const auto START = std::chrono::steady_clock::now();
+uint32_t millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - START).count();
+}
+uint32_t micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START).count();
+}
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+}  // namespace esphome
+
+extern std::atomic<uint32_t> g_jpeg_encodes;
+
+static int env_int(const char *name, int fallback) {
+  const char *value = getenv(name);
+  return value != nullptr ? atoi(value) : fallback;
+}
+
+static double cpu_seconds() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// The ESPHome main loop
+static void loop_for(mipi_dsi_cam::MipiDsiCam &camera, uint32_t ms) {
+  const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+  while (std::chrono::steady_clock::now() < end) {
+    camera.loop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+int main(int argc, char **argv) {
+  const int seconds = argc > 1 ? atoi(argv[1]) : 10;
+
+  mipi_dsi_cam::MipiDsiCam camera;
+  camera.set_sensor_type("mock");
+  camera.set_resolution(640, 480);
+  camera.set_framerate(30);
+  auto *backend = new mipi_dsi_cam::VirtualCsiBackend();
+  backend->set_pattern(getenv("STATIC") != nullptr ? mipi_dsi_cam::VIRTUAL_PATTERN_COLOR_BARS
+                                                   : mipi_dsi_cam::VIRTUAL_PATTERN_GRADIENT);
+  camera.set_capture_backend(backend);
+  camera.setup();
+  camera.start_streaming();
+
+  mipi_camera_web_server::MipiCameraWebServer web;
+  web.set_camera(&camera);
+  web.set_port(env_int("PORT", 8088));
+  web.set_max_streams(env_int("MAX_STREAMS", 4));
+  if (getenv("MAX_FPS") != nullptr)
+    web.set_max_stream_fps(env_int("MAX_FPS", 0));
+  web.setup();
+  fprintf(stderr, "READY\n");
+
+  loop_for(camera, 1000);
+  const auto &metrics = camera.get_metrics();
+  const double cpu_start = cpu_seconds();
+  const uint32_t encodes_start = g_jpeg_encodes;
+  const uint32_t captured_start = metrics.counter(mipi_dsi_cam::COUNTER_FRAMES_CAPTURED);
+  const int switch_ms = env_int("MODE_SWITCH", -1);
+  if (switch_ms >= 0) {
+    loop_for(camera, seconds * 500);
+    // set_mode() blocks the main loop the same way
+    camera.stop_streaming();
+    delay(switch_ms);
+    const bool switched = camera.set_mode(1) && camera.start_streaming();
+    printf("server: mode switch %s, stream stopped %d ms\n", switched ? "done" : "FAILED", switch_ms);
+    loop_for(camera, seconds * 500 - switch_ms);
+  } else {
+    loop_for(camera, seconds * 1000);
+  }
+  const double cpu = cpu_seconds() - cpu_start;
+  const uint32_t encodes = g_jpeg_encodes - encodes_start;
+  const uint32_t captured = metrics.counter(mipi_dsi_cam::COUNTER_FRAMES_CAPTURED) - captured_start;
+
+  printf("server: camera %.1f fps, encodes %.1f/s, CPU %.1f%% of one core, encoder busy %u, jpeg reused %u, "
+         "not modified %u, send failures %u\n",
+         captured / (double) seconds, encodes / (double) seconds, 100.0 * cpu / seconds,
+         metrics.counter(mipi_dsi_cam::COUNTER_ENCODER_BUSY), metrics.counter(mipi_dsi_cam::COUNTER_JPEG_REUSED),
+         metrics.counter(mipi_dsi_cam::COUNTER_NOT_MODIFIED), metrics.counter(mipi_dsi_cam::COUNTER_SEND_FAILURES));
+  fflush(stdout);
+  // Clients still connected see the end of their stream, not a reset
+  loop_for(camera, 1500);
+  _exit(0);
+}
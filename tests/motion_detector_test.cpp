@@ -0,0 +1,135 @@
+// MotionDetector on a synthetic clip: a textured static scene with sensor
+// noise (uniform +-7 luma levels), an object crossing frames 30-69 and a
+// lighting step at frame 90. Checks that the object is reported with a box
+// around it, that noise alone never is, that the lighting step is a global
+// change rather than motion, and that a mask over the object's path hides it.
+
+#include "mipi_dsi_cam/motion_detector.h"
+#include "mipi_dsi_cam/pixel_convert.h"
+#include "test_support.h"
+
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static const uint16_t W = 320;
+static const uint16_t H = 180;
+static const uint32_t CLIP_FRAMES = 120;
+static const uint32_t OBJECT_FIRST = 30;
+static const uint32_t OBJECT_LAST = 69;
+static const uint32_t LIGHTING_STEP = 90;
+static const uint16_t OBJECT_SIZE = H / 4;
+static const uint16_t OBJECT_Y = H / 3;
+
+static int object_x(uint32_t n) {
+  if (n < OBJECT_FIRST || n > OBJECT_LAST)
+    return -1;
+  return (int) ((n - OBJECT_FIRST) * (W - OBJECT_SIZE) / (OBJECT_LAST - OBJECT_FIRST));
+}
+
+class Clip {
+ public:
+  Clip() : scene_((size_t) W * H), frame_((size_t) W * H) {
+    // Blocky texture over a diagonal gradient, so the downsampled plane sees structure
+    for (uint32_t y = 0; y < H; y++) {
+      for (uint32_t x = 0; x < W; x++) {
+        uint32_t cell = (x / 8) * 2654435761u ^ (y / 8) * 40503u;
+        cell ^= cell >> 13;
+        this->scene_[(size_t) y * W + x] = 60 + (x + y) * 80 / (W + H) + (cell & 31);
+      }
+    }
+  }
+
+  FrameView render(uint32_t n) {
+    const int ox = object_x(n);
+    for (uint32_t y = 0; y < H; y++) {
+      for (uint32_t x = 0; x < W; x++) {
+        int luma = this->scene_[(size_t) y * W + x];
+        if (ox >= 0 && (int) x >= ox && x < ox + OBJECT_SIZE && y >= OBJECT_Y && y < OBJECT_Y + OBJECT_SIZE)
+          luma = 20 + (luma & 15);
+        if (n >= LIGHTING_STEP)
+          luma = luma * 8 / 5;
+        this->noise_ ^= this->noise_ << 13;
+        this->noise_ ^= this->noise_ >> 17;
+        this->noise_ ^= this->noise_ << 5;
+        luma += (int) (this->noise_ % 15) - 7;
+        const uint8_t v = clamp_u8(luma);
+        this->frame_[(size_t) y * W + x] = pack_rgb565(clamp_u8(v + 12), v, clamp_u8(v - 10));
+      }
+    }
+    return FrameView::packed((uint8_t *) this->frame_.data(), W, H, PIXEL_FORMAT_RGB565);
+  }
+
+ protected:
+  std::vector<uint8_t> scene_;
+  std::vector<uint16_t> frame_;
+  uint32_t noise_{2463534242u};
+};
+
+static bool overlaps(const FrameRoi &box, int x, int y, int w, int h) {
+  return box.x < x + w && x < box.x + box.width && box.y < y + h && y < box.y + box.height;
+}
+
+static void test_clip() {
+  Clip clip;
+  MotionDetector detector;
+  MotionResult result;
+  uint32_t detected = 0, boxed = 0, global_changes = 0;
+  for (uint32_t n = 0; n < CLIP_FRAMES; n++) {
+    detector.process(clip.render(n), n + 1, result);
+    CHECK_EQ(result.sequence, n + 1);
+    const bool moving = object_x(n) >= 0;
+    if (n == LIGHTING_STEP) {
+      CHECK(result.global_change);
+      CHECK(!result.motion);
+    } else if (!moving) {
+      // Noise, the empty scene once the object left, the new lighting
+      if (result.motion)
+        printf("frame %u: motion on a static frame\n", n);
+      CHECK(!result.motion);
+    }
+    global_changes += result.global_change;
+    if (!moving || !result.motion)
+      continue;
+    detected++;
+    CHECK(result.box_count >= 1);
+    boxed += result.box_count >= 1 && overlaps(result.boxes[0], object_x(n), OBJECT_Y, OBJECT_SIZE, OBJECT_SIZE);
+  }
+  CHECK_EQ(detected, OBJECT_LAST - OBJECT_FIRST + 1);
+  CHECK_EQ(boxed, detected);
+  CHECK_EQ(global_changes, 1);
+}
+
+static void test_mask() {
+  Clip clip;
+  MotionDetector detector;
+  // The band the object crosses, a little taller than it
+  CHECK(detector.add_mask(FrameRoi{0, (uint16_t) (OBJECT_Y - 8), W, (uint16_t) (OBJECT_SIZE + 16)}));
+  MotionResult result;
+  for (uint32_t n = 0; n < LIGHTING_STEP; n++) {
+    detector.process(clip.render(n), n + 1, result);
+    CHECK(!result.motion);
+  }
+}
+
+static void test_geometry_change() {
+  Clip clip;
+  MotionDetector detector;
+  MotionResult result;
+  detector.process(clip.render(0), 1, result);
+  // New size: the background restarts from this frame, nothing to report
+  std::vector<uint16_t> small((size_t) (W / 2) * (H / 2), pack_rgb565(200, 200, 200));
+  detector.process(FrameView::packed((uint8_t *) small.data(), W / 2, H / 2, PIXEL_FORMAT_RGB565), 2, result);
+  CHECK(!result.motion);
+  CHECK(!result.global_change);
+  detector.process(FrameView::packed((uint8_t *) small.data(), W / 2, H / 2, PIXEL_FORMAT_RGB565), 3, result);
+  CHECK(!result.motion);
+  CHECK_EQ(result.active_cells, 0);
+}
+
+int main() {
+  test_clip();
+  test_mask();
+  test_geometry_change();
+  return test::finish("motion_detector_test");
+}
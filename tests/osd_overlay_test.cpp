@@ -0,0 +1,282 @@
+// OSD compositing on flat frames, pixel by pixel: the 5x7 glyph mask and
+// its outline, sprite reuse, text blended in each corner with the
+// background opacity, stacked lines, clipping to a strided view without
+// touching its neighbours, motion box outlines, and the YUV422 / RAW8 paths.
+
+#include "mipi_dsi_cam/osd_overlay.h"
+#include "mipi_dsi_cam/pixel_convert.h"
+#include "test_support.h"
+
+#include <string>
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static const uint16_t W = 96;
+static const uint16_t H = 64;
+static const uint16_t GREY = 0x8410;   // rgb565(128, 128, 128)
+static const uint16_t HALF = 0x4208;   // GREY under 50% black
+static const uint16_t WHITE = 0xFFFF;
+
+static FrameView rgb565_view(std::vector<uint16_t> &pixels, uint16_t w, uint16_t h) {
+  return FrameView::packed((uint8_t *) pixels.data(), w, h, PIXEL_FORMAT_RGB565);
+}
+
+// RGB565 a sprite pixel of each ink gives over GREY (50% background)
+static uint16_t expected_ink(uint8_t ink) {
+  return ink == OSD_INK_TEXT ? WHITE : (ink == OSD_INK_OUTLINE ? 0x0000 : HALF);
+}
+
+// Every pixel of `frame` is the sprite blended at (x0, y0), GREY elsewhere
+static uint32_t sprite_mismatches(const std::vector<uint16_t> &frame, const OsdSprite &sprite, int x0, int y0) {
+  uint32_t wrong = 0;
+  for (int y = 0; y < H; y++) {
+    for (int x = 0; x < W; x++) {
+      const bool inside = x >= x0 && x < x0 + sprite.get_width() && y >= y0 && y < y0 + sprite.get_height();
+      const uint16_t want = inside ? expected_ink(sprite.row(y - y0)[x - x0]) : GREY;
+      wrong += frame[(size_t) y * W + x] != want;
+    }
+  }
+  return wrong;
+}
+
+static void test_sprite() {
+  OsdSprite sprite;
+  CHECK(sprite.set_text("A", 1));
+  // 5 columns + 1 of spacing, a font pixel of margin all around
+  CHECK_EQ(sprite.get_width(), 7);
+  CHECK_EQ(sprite.get_height(), 9);
+  // 'A' top row 0x0E: columns 1..3 of the glyph, shifted by the margin
+  const uint8_t *top = sprite.row(1);
+  CHECK_EQ(top[1], OSD_INK_OUTLINE);
+  CHECK_EQ(top[2], OSD_INK_TEXT);
+  CHECK_EQ(top[4], OSD_INK_TEXT);
+  CHECK_EQ(top[5], OSD_INK_OUTLINE);
+  // Row above the glyph: outline over the text, background in the corners
+  CHECK_EQ(sprite.row(0)[3], OSD_INK_OUTLINE);
+  CHECK_EQ(sprite.row(0)[0], OSD_INK_BACKGROUND);
+  // Inside the 'A' (row 2: 0x11) between its legs
+  CHECK_EQ(sprite.row(3)[1], OSD_INK_TEXT);
+  CHECK_EQ(sprite.row(3)[3], OSD_INK_OUTLINE);
+
+  // Same text and scale: nothing rebuilt
+  CHECK(!sprite.set_text("A", 1));
+  CHECK(sprite.set_text("A", 3));
+  CHECK_EQ(sprite.get_width(), 21);
+  CHECK_EQ(sprite.get_height(), 27);
+  CHECK_EQ(sprite.row(3)[6], OSD_INK_TEXT);
+  CHECK_EQ(sprite.row(5)[8], OSD_INK_TEXT);
+
+  // Latin-1 accents fall back to the base letter, anything else to '?'
+  OsdSprite plain, other;
+  plain.set_text("eE?", 1);
+  sprite.set_text("\xC3\xA9\xC3\x89\xE2\x82\xAC", 1);
+  other.set_text("eE\t", 1);
+  CHECK_EQ(sprite.get_width(), plain.get_width());
+  for (uint16_t y = 0; y < plain.get_height(); y++) {
+    for (uint16_t x = 0; x < plain.get_width(); x++) {
+      CHECK_EQ(sprite.row(y)[x], plain.row(y)[x]);
+      CHECK_EQ(other.row(y)[x], plain.row(y)[x]);
+    }
+  }
+  CHECK(sprite.set_text("", 1));
+  CHECK(sprite.empty());
+}
+
+static void test_corners() {
+  OsdSprite sprite;
+  sprite.set_text("12:34", 1);
+  const int right = W - 2 - sprite.get_width();
+  const int bottom = H - 2 - sprite.get_height();
+  struct Case {
+    OsdPosition position;
+    int x, y;
+  };
+  for (const Case &c : {Case{OSD_TOP_LEFT, 2, 2}, Case{OSD_TOP_RIGHT, right, 2}, Case{OSD_BOTTOM_LEFT, 2, bottom},
+                        Case{OSD_BOTTOM_RIGHT, right, bottom}}) {
+    std::vector<uint16_t> frame((size_t) W * H, GREY);
+    OsdOverlay osd;
+    OsdConfig config;
+    config.position = c.position;
+    config.scale = 1;
+    osd.set_config(config);
+    osd.set_line(0, "12:34");
+    osd.draw(rgb565_view(frame, W, H));
+    const uint32_t wrong = sprite_mismatches(frame, sprite, c.x, c.y);
+    if (wrong != 0)
+      printf("position %d: %u pixel(s) off\n", c.position, wrong);
+    CHECK_EQ(wrong, 0);
+  }
+}
+
+static void test_lines_and_reuse() {
+  std::vector<uint16_t> frame((size_t) W * H, GREY);
+  OsdOverlay osd;
+  OsdConfig config;
+  config.scale = 1;
+  config.background_opacity = 0;
+  osd.set_config(config);
+  // Lines 0 and 2; the empty line 1 takes no room
+  osd.set_line(0, "AB");
+  osd.set_line(2, "C");
+  osd.draw(rgb565_view(frame, W, H));
+  // First frame: every slot is built for the scale, empty ones included
+  CHECK_EQ(osd.get_rasterize_count(), OsdOverlay::MAX_LINES);
+  OsdSprite second;
+  second.set_text("C", 1);
+  // Transparent background: only outline and text leave a mark
+  uint32_t wrong = 0;
+  for (uint16_t y = 0; y < second.get_height(); y++) {
+    for (uint16_t x = 0; x < second.get_width(); x++) {
+      const uint8_t ink = second.row(y)[x];
+      const uint16_t want = ink == OSD_INK_BACKGROUND ? GREY : expected_ink(ink);
+      wrong += frame[(size_t) (2 + 9 + y) * W + 2 + x] != want;
+    }
+  }
+  CHECK_EQ(wrong, 0);
+
+  // Same texts next frame: blended again, not rasterised again
+  osd.draw(rgb565_view(frame, W, H));
+  CHECK_EQ(osd.get_rasterize_count(), OsdOverlay::MAX_LINES);
+  osd.set_line(2, "D");
+  osd.draw(rgb565_view(frame, W, H));
+  CHECK_EQ(osd.get_rasterize_count(), OsdOverlay::MAX_LINES + 1);
+
+  // Automatic scale: one font pixel per 240 lines
+  std::vector<uint16_t> tall(64 * 480, GREY);
+  OsdOverlay automatic;
+  automatic.set_line(0, "A");
+  automatic.draw(rgb565_view(tall, 64, 480));
+  // After a 4-pixel margin: 2 pixels of padding, the outline one pixel
+  // thick above the 'A', then its top bar 2 pixels high
+  CHECK_EQ(tall[4 * 64 + 4 + 6], HALF);
+  CHECK_EQ(tall[5 * 64 + 4 + 6], 0x0000);
+  CHECK_EQ(tall[6 * 64 + 4 + 4], WHITE);
+  CHECK_EQ(tall[7 * 64 + 4 + 9], WHITE);
+}
+
+static void test_clipping() {
+  // Text wider than a 40x20 view cropped from a bigger canvas: the canvas
+  // around the view stays untouched
+  std::vector<uint16_t> canvas((size_t) W * H, GREY);
+  const FrameView view = rgb565_view(canvas, W, H).crop({20, 10, 40, 20});
+  OsdOverlay osd;
+  OsdConfig config;
+  config.scale = 2;
+  osd.set_config(config);
+  osd.set_line(0, "far too long for the view");
+  osd.set_line(1, "second line");
+  osd.set_line(2, "third line");
+  const FrameRoi boxes[] = {{30, 15, 100, 100}};
+  osd.set_boxes(boxes, 1);
+  osd.draw(view);
+  uint32_t outside = 0, inside_changed = 0;
+  for (uint16_t y = 0; y < H; y++) {
+    for (uint16_t x = 0; x < W; x++) {
+      const bool inside = x >= 20 && x < 60 && y >= 10 && y < 30;
+      const bool changed = canvas[(size_t) y * W + x] != GREY;
+      outside += !inside && changed;
+      inside_changed += inside && changed;
+    }
+  }
+  CHECK_EQ(outside, 0);
+  CHECK(inside_changed > 0);
+}
+
+static void test_boxes() {
+  std::vector<uint16_t> frame((size_t) W * H, GREY);
+  OsdOverlay osd;
+  OsdConfig config;
+  config.scale = 2;
+  config.color = 0xFF0000;
+  osd.set_config(config);
+  const FrameRoi boxes[] = {{10, 20, 30, 16}, {80, 50, 40, 40}, {200, 200, 5, 5}};
+  osd.set_boxes(boxes, 3);
+  osd.draw(rgb565_view(frame, W, H));
+  uint32_t wrong = 0;
+  for (uint16_t y = 0; y < H; y++) {
+    for (uint16_t x = 0; x < W; x++) {
+      // 2-pixel outlines; the second box is clipped to the frame, the third is off it
+      const bool in_first = x >= 10 && x < 40 && y >= 20 && y < 36;
+      const bool first_edge = in_first && (x < 12 || x >= 38 || y < 22 || y >= 34);
+      const bool in_second = x >= 80 && y >= 50;
+      const bool second_edge = in_second && (x < 82 || x >= W - 2 || y < 52 || y >= H - 2);
+      wrong += frame[(size_t) y * W + x] != (first_edge || second_edge ? 0xF800 : GREY);
+    }
+  }
+  CHECK_EQ(wrong, 0);
+}
+
+static void test_yuv422() {
+  std::vector<uint8_t> frame((size_t) W * H * 2);
+  for (size_t i = 0; i < frame.size(); i += 2) {
+    frame[i] = 128;
+    frame[i + 1] = 128;
+  }
+  OsdOverlay osd;
+  OsdConfig config;
+  config.scale = 1;
+  config.position = OSD_TOP_RIGHT;
+  config.color = 0xFFFF00;
+  osd.set_config(config);
+  osd.set_line(0, "Hi");
+  osd.draw(FrameView::packed(frame.data(), W, H, PIXEL_FORMAT_YUV422));
+  OsdSprite sprite;
+  sprite.set_text("Hi", 1);
+  // 13 pixels wide: starts on the pair boundary left of W - 2 - 13, and
+  // only whole pairs are drawn
+  const uint16_t x0 = (W - 2 - sprite.get_width()) & ~1;
+  const uint16_t count = sprite.get_width() & ~1;
+  const uint8_t yellow_y = rgb_to_y(255, 255, 0), yellow_u = rgb_to_u(255, 255, 0);
+  uint32_t wrong = 0;
+  for (uint16_t y = 0; y < H; y++) {
+    for (uint16_t x = 0; x < W; x++) {
+      const bool inside = x >= x0 && x < x0 + count && y >= 2 && y < 2 + sprite.get_height();
+      const uint8_t ink = inside ? sprite.row(y - 2)[x - x0] : 0xFF;
+      const uint8_t want = ink == OSD_INK_TEXT ? yellow_y : ink == OSD_INK_OUTLINE ? 0 : ink == 0xFF ? 128 : 64;
+      wrong += frame[((size_t) y * W + x) * 2] != want;
+    }
+  }
+  CHECK_EQ(wrong, 0);
+  // A pair of two text pixels takes the ink's chroma ('i' stem, row 4)
+  bool found = false;
+  for (uint16_t x = 0; x + 1 < count && !found; x += 2) {
+    if (sprite.row(4)[x] == OSD_INK_TEXT && sprite.row(4)[x + 1] == OSD_INK_TEXT) {
+      CHECK_EQ(frame[((size_t) 6 * W + x0 + x) * 2 + 1], yellow_u);
+      found = true;
+    }
+  }
+  CHECK(found);
+}
+
+static void test_raw8() {
+  // Each site of the mosaic gets its own channel of the ink
+  for (uint8_t pattern = 0; pattern < 4; pattern++) {
+    std::vector<uint8_t> frame((size_t) W * H, 100);
+    OsdOverlay osd;
+    OsdConfig config;
+    config.scale = 2;
+    config.color = 0xFF4010;
+    osd.set_config(config);
+    const FrameRoi boxes[] = {{0, 0, W, H}};
+    osd.set_boxes(boxes, 1);
+    osd.draw(FrameView::packed(frame.data(), W, H, PIXEL_FORMAT_RAW8, pattern));
+    for (uint8_t site = 0; site < 4; site++) {
+      const uint8_t want = site == bayer_red_site(pattern) ? 0xFF : site == bayer_blue_site(pattern) ? 0x10 : 0x40;
+      CHECK_EQ(frame[(site >> 1) * W + (site & 1)], want);
+    }
+    // Inside the 2-pixel outline: untouched
+    CHECK_EQ(frame[10 * W + 10], 100);
+  }
+}
+
+int main() {
+  test_sprite();
+  test_corners();
+  test_lines_and_reuse();
+  test_clipping();
+  test_boxes();
+  test_yuv422();
+  test_raw8();
+  return test::finish("osd_overlay_test");
+}
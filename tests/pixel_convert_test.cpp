@@ -0,0 +1,159 @@
+// Format conversions of pixel_convert.h on small fixtures with exact
+// results: YUV422 and RAW8 to RGB565 for grey and saturated colours, every
+// Bayer order, strided crops, the stats sampler agreeing with the full
+// conversion, and RGB565 -> YUV422 -> RGB565 staying within rounding.
+
+#include "mipi_dsi_cam/pixel_convert.h"
+#include "test_support.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static const uint16_t W = 8;
+static const uint16_t H = 6;
+
+static std::vector<uint8_t> yuv_frame(uint8_t y, uint8_t u, uint8_t v) {
+  std::vector<uint8_t> frame((size_t) W * H * 2);
+  for (size_t i = 0; i < frame.size(); i += 4) {
+    frame[i] = y;
+    frame[i + 1] = u;
+    frame[i + 2] = y;
+    frame[i + 3] = v;
+  }
+  return frame;
+}
+
+static void test_yuv422_to_rgb565() {
+  std::vector<uint16_t> out((size_t) W * H);
+  std::vector<uint8_t> grey = yuv_frame(128, 128, 128);
+  convert_to_rgb565(FrameView::packed(grey.data(), W, H, PIXEL_FORMAT_YUV422), out.data());
+  for (uint16_t px : out)
+    CHECK_EQ(px, pack_rgb565(128, 128, 128));
+
+  // BT.601 full-range red, green and blue
+  struct Case {
+    uint8_t y, u, v;
+    uint16_t rgb565;
+  };
+  const Case cases[] = {{76, 85, 255, 0xF800}, {150, 44, 21, 0x07E0}, {29, 255, 107, 0x001F}};
+  for (const Case &c : cases) {
+    std::vector<uint8_t> frame = yuv_frame(c.y, c.u, c.v);
+    convert_to_rgb565(FrameView::packed(frame.data(), W, H, PIXEL_FORMAT_YUV422), out.data());
+    CHECK_EQ(out[0], c.rgb565);
+    CHECK_EQ(out[W * H - 1], c.rgb565);
+  }
+
+  // Y0 and Y1 of a pair share the chroma but keep their own luma
+  std::vector<uint8_t> pair = yuv_frame(128, 128, 128);
+  pair[0] = 0;
+  pair[2] = 255;
+  convert_to_rgb565(FrameView::packed(pair.data(), W, H, PIXEL_FORMAT_YUV422), out.data());
+  CHECK_EQ(out[0], 0x0000);
+  CHECK_EQ(out[1], 0xFFFF);
+}
+
+static void test_raw8_to_rgb565() {
+  const uint16_t colours[] = {pack_rgb565(200, 100, 40), pack_rgb565(16, 240, 120), 0xFFFF, 0x0000};
+  std::vector<uint8_t> raw((size_t) W * H);
+  std::vector<uint16_t> out((size_t) W * H);
+  for (uint8_t pattern = 0; pattern < 4; pattern++) {
+    for (uint16_t colour : colours) {
+      std::vector<uint16_t> flat((size_t) W * H, colour);
+      rgb565_to_raw8(flat.data(), W, H, pattern, raw.data());
+      // A flat colour comes back unchanged whatever the method
+      for (DemosaicMethod method : {DEMOSAIC_NEAREST, DEMOSAIC_BILINEAR, DEMOSAIC_EDGE_AWARE}) {
+        convert_to_rgb565(FrameView::packed(raw.data(), W, H, PIXEL_FORMAT_RAW8, pattern), out.data(), method);
+        uint32_t wrong = 0;
+        for (uint16_t px : out)
+          wrong += px != colour;
+        if (wrong != 0)
+          printf("pattern %u method %d colour %04X: %u pixel(s) differ\n", pattern, method, colour, wrong);
+        CHECK_EQ(wrong, 0);
+      }
+    }
+  }
+
+  // Mosaic layout: RGGB puts red top-left and blue bottom-right of each quad
+  std::vector<uint16_t> flat((size_t) W * H, pack_rgb565(248, 128, 8));
+  rgb565_to_raw8(flat.data(), W, H, 3, raw.data());
+  CHECK_EQ(raw[0], 255);  // 5-bit 31 expanded
+  CHECK_EQ(raw[1], 130);  // 6-bit 32 expanded
+  CHECK_EQ(raw[W], 130);
+  CHECK_EQ(raw[W + 1], 8);
+  // BGGR: the other diagonal
+  rgb565_to_raw8(flat.data(), W, H, 0, raw.data());
+  CHECK_EQ(raw[0], 8);
+  CHECK_EQ(raw[W + 1], 255);
+}
+
+static void test_strided_crop() {
+  // Left half black, right half white: a crop of the right half is all white
+  std::vector<uint8_t> frame = yuv_frame(0, 128, 128);
+  for (uint16_t y = 0; y < H; y++) {
+    for (uint16_t x = W / 2; x < W; x++)
+      frame[(size_t) y * W * 2 + x * 2] = 255;
+  }
+  const FrameView view = FrameView::packed(frame.data(), W, H, PIXEL_FORMAT_YUV422).crop({W / 2, 1, W / 2, 3});
+  CHECK(!view.is_packed());
+  std::vector<uint16_t> out((size_t) view.width * view.height, 0x1234);
+  convert_to_rgb565(view, out.data());
+  for (uint16_t px : out)
+    CHECK_EQ(px, 0xFFFF);
+}
+
+static void test_sampler_matches_conversion() {
+  // A ramp, so every sampled position has its own colour
+  std::vector<uint16_t> ramp((size_t) W * H);
+  for (uint16_t y = 0; y < H; y++) {
+    for (uint16_t x = 0; x < W; x++)
+      ramp[(size_t) y * W + x] = pack_rgb565(x * 32, y * 40, 255 - x * 16);
+  }
+  std::vector<uint8_t> yuv((size_t) W * H * 2);
+  convert_to_yuv422(FrameView::packed((uint8_t *) ramp.data(), W, H, PIXEL_FORMAT_RGB565), yuv.data());
+  std::vector<uint8_t> raw((size_t) W * H);
+  rgb565_to_raw8(ramp.data(), W, H, 2, raw.data());
+
+  const FrameView views[] = {FrameView::packed(yuv.data(), W, H, PIXEL_FORMAT_YUV422),
+                             FrameView::packed(raw.data(), W, H, PIXEL_FORMAT_RAW8, 2),
+                             FrameView::packed((uint8_t *) ramp.data(), W, H, PIXEL_FORMAT_RGB565)};
+  for (const FrameView &view : views) {
+    std::vector<uint16_t> full((size_t) W * H);
+    convert_to_rgb565(view, full.data(), DEMOSAIC_NEAREST);
+    for (uint16_t y = 0; y < H; y++) {
+      uint16_t samples[W];
+      sample_row_rgb565(view, y, 3, 0, (W + 2) / 3, samples);
+      for (uint16_t i = 0; i < (W + 2) / 3; i++)
+        CHECK_EQ(samples[i], full[(size_t) y * W + i * 3]);
+    }
+  }
+}
+
+static void test_yuv422_round_trip() {
+  std::vector<uint16_t> src((size_t) W * H);
+  for (size_t i = 0; i < src.size(); i++)
+    src[i] = pack_rgb565(i * 5, 255 - i * 5, 128);
+  // Same colour over each pair, so the shared chroma loses nothing
+  for (size_t i = 1; i < src.size(); i += 2)
+    src[i] = src[i - 1];
+  std::vector<uint8_t> yuv((size_t) W * H * 2);
+  convert_to_yuv422(FrameView::packed((uint8_t *) src.data(), W, H, PIXEL_FORMAT_RGB565), yuv.data());
+  std::vector<uint16_t> back((size_t) W * H);
+  convert_to_rgb565(FrameView::packed(yuv.data(), W, H, PIXEL_FORMAT_YUV422), back.data());
+  for (size_t i = 0; i < src.size(); i++) {
+    // One RGB565 step per channel at most
+    CHECK(abs((src[i] >> 11) - (back[i] >> 11)) <= 1);
+    CHECK(abs(((src[i] >> 5) & 0x3F) - ((back[i] >> 5) & 0x3F)) <= 1);
+    CHECK(abs((src[i] & 0x1F) - (back[i] & 0x1F)) <= 1);
+  }
+}
+
+int main() {
+  test_yuv422_to_rgb565();
+  test_raw8_to_rgb565();
+  test_strided_crop();
+  test_sampler_matches_conversion();
+  test_yuv422_round_trip();
+  return test::finish("pixel_convert_test");
+}
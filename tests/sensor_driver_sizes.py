@@ -0,0 +1,83 @@
+"""Code size of each sensor driver, as __init__.py::to_code would generate it.
+
+usage: sensor_driver_sizes.py <c++ compiler> <work dir> [compiler flags...]
+
+For no sensor (the mock-only build), each sensor alone and all of them, the
+generated header (drivers + create_sensor_driver()) is compiled in a small
+translation unit with -Os against the test stubs. The table gives .text and
+.rodata per configuration and the delta over the mock-only build. Vtables and
+string tables the host toolchain puts in .data.rel.ro are counted as .rodata:
+on the ESP32 they land in flash with the rest.
+
+Host x86 code is not Xtensa / RISC-V code: compare the rows with each other.
+Run by hand, or through the sensor_driver_sizes target of tests/CMakeLists.txt.
+"""
+import os
+import subprocess
+import sys
+
+from generate_sensor_drivers import SENSORS, load_sensor_modules
+
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+COMPONENTS_DIR = os.path.join(TESTS_DIR, '..', 'components')
+
+# Only the factory is referenced, as in mipi_dsi_cam.cpp
+PROBE = '''#include "esphome/core/log.h"
+#include "mipi_dsi_cam/mipi_dsi_cam.h"
+#include "mipi_dsi_cam/sensor_registers.h"
+#include "mipi_dsi_cam_drivers_generated.h"
+
+namespace esphome {
+namespace mipi_dsi_cam {
+ISensorDriver *size_probe(const std::string &type, i2c::I2CDevice *i2c) { return create_sensor_driver(type, i2c); }
+}  // namespace mipi_dsi_cam
+}  // namespace esphome
+'''
+
+
+def section_sizes(obj):
+    text = rodata = 0
+    output = subprocess.run(['size', '-A', obj], check=True, capture_output=True, text=True).stdout
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) < 2 or not fields[1].isdigit():
+            continue
+        name, size = fields[0], int(fields[1])
+        if name.startswith('.text'):
+            text += size
+        elif name.startswith('.rodata') or name.startswith('.data.rel.ro'):
+            rodata += size
+    return text, rodata
+
+
+def build(cxx, work_dir, flags, name, sensors, modules, codegen):
+    directory = os.path.join(work_dir, name)
+    os.makedirs(directory, exist_ok=True)
+    with open(os.path.join(directory, 'mipi_dsi_cam_drivers_generated.h'), 'w') as f:
+        f.write('#pragma once\n\n')
+        f.write(''.join(modules[sensor].get_driver_code() + '\n\n' for sensor in sensors))
+        f.write(codegen.generate_driver_factory(sensors))
+    source = os.path.join(directory, 'probe.cpp')
+    with open(source, 'w') as f:
+        f.write(PROBE)
+    obj = os.path.join(directory, 'probe.o')
+    subprocess.run([cxx, '-std=c++17', '-Os', '-c', source, '-o', obj, '-I', directory, '-I', COMPONENTS_DIR,
+                    '-I', os.path.join(TESTS_DIR, 'stubs')] + flags, check=True)
+    return section_sizes(obj)
+
+
+def main(cxx, work_dir, flags):
+    modules = load_sensor_modules()
+    codegen = sys.modules['mipi_dsi_cam_sensors.sensor_codegen']
+    configs = [('none', [])] + [(sensor, [sensor]) for sensor in SENSORS] + [('all', SENSORS)]
+    sizes = [build(cxx, work_dir, flags, name, sensors, modules, codegen) for name, sensors in configs]
+    base_text, base_rodata = sizes[0]
+    print(f'{"sensors":<14}{".text":>9}{".rodata":>9}{"Δ .text":>10}{"Δ .rodata":>11}')
+    for (name, _), (text, rodata) in zip(configs, sizes):
+        print(f'{name:<14}{text:>9}{rodata:>9}{text - base_text:>+10}{rodata - base_rodata:>+11}')
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+    main(sys.argv[1], sys.argv[2], sys.argv[3:])
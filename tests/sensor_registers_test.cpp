@@ -0,0 +1,229 @@
+// Sensor drivers against a fake I2C bus: init tables coalesced into bursts
+// must leave the sensor exactly as the raw register sequence would, and
+// SensorRegisterShadow must skip the AE writes that change nothing.
+//
+// The bus emulates an auto-incrementing 16-bit register map and counts
+// transactions and bytes; the report shows, per sensor, what init and an
+// AE step cost before (one 3-byte write per register) and now.
+
+#include "esphome/core/log.h"
+#include "mipi_dsi_cam/mipi_dsi_cam.h"
+#include "mipi_dsi_cam/sensor_registers.h"
+#include "sensor_drivers_generated.h"
+#include "test_support.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace esphome;
+using namespace esphome::mipi_dsi_cam;
+
+// Simulated clock: driver delays cost nothing but are accounted for
+static uint32_t g_now_ms = 0;
+namespace esphome {
+uint32_t millis() { return g_now_ms; }
+uint32_t micros() { return g_now_ms * 1000; }
+void delay(uint32_t ms) { g_now_ms += ms; }
+void delayMicroseconds(uint32_t us) { g_now_ms += us / 1000; }
+}  // namespace esphome
+
+class FakeSensorBus : public i2c::I2CBus {
+ public:
+  i2c::ErrorCode write_readv(uint8_t address, const uint8_t *write_buffer, size_t write_count, uint8_t *read_buffer,
+                             size_t read_count) override {
+    this->transactions++;
+    this->bytes += write_count + read_count;
+    if (read_count != 0)
+      this->reads++;
+    if (this->fail_next || (this->fail_in != 0 && --this->fail_in == 0)) {
+      this->fail_next = false;
+      return i2c::ERROR_NOT_ACKNOWLEDGED;
+    }
+    if (write_count == 0) {
+      // Address probe
+      return i2c::ERROR_OK;
+    }
+    if (write_count < 2)
+      return i2c::ERROR_INVALID_ARGUMENT;
+    uint16_t reg = (uint16_t) (write_buffer[0] << 8 | write_buffer[1]);
+    for (size_t i = 2; i < write_count; i++, reg++) {
+      this->registers[reg] = write_buffer[i];
+      this->writes.emplace_back(reg, write_buffer[i]);
+      this->register_writes++;
+    }
+    for (size_t i = 0; i < read_count; i++, reg++) {
+      read_buffer[i] = this->registers[reg];
+      // Software reset: done as soon as it is polled
+      if (reg == SENSOR_SOFTWARE_RESET)
+        this->registers[reg] &= ~0x01;
+    }
+    return i2c::ERROR_OK;
+  }
+
+  void reset_counters() {
+    this->transactions = 0;
+    this->reads = 0;
+    this->bytes = 0;
+    this->register_writes = 0;
+    this->writes.clear();
+  }
+
+  // 400 kHz, 9 clocks per byte plus the address byte
+  float bus_ms(uint32_t transactions, uint32_t bytes) const { return (transactions + bytes) * 9 / 400.0f; }
+
+  uint8_t registers[65536]{};
+  std::vector<std::pair<uint16_t, uint8_t>> writes;
+  uint32_t transactions{0};
+  uint32_t reads{0};
+  uint32_t bytes{0};
+  uint32_t register_writes{0};
+  bool fail_next{false};
+  uint32_t fail_in{0};  // fails the n-th transaction from now
+};
+
+struct Device : public i2c::I2CDevice {
+  explicit Device(i2c::I2CBus *bus) {
+    this->set_i2c_address(0x36);
+    this->set_i2c_bus(bus);
+  }
+};
+
+static void check_shadow() {
+  FakeSensorBus bus;
+  Device device(&bus);
+  SensorRegisterShadow shadow;
+
+  const uint8_t first[3] = {0x01, 0x02, 0x03};
+  CHECK_EQ(shadow.write(&device, 0x3500, first, 3), ESP_OK);
+  CHECK_EQ(bus.transactions, 1);
+  CHECK_EQ(bus.register_writes, 3);
+
+  // Same values: no transaction at all
+  bus.reset_counters();
+  CHECK_EQ(shadow.write(&device, 0x3500, first, 3), ESP_OK);
+  CHECK_EQ(bus.transactions, 0);
+
+  // Only the middle register changed: one write of one byte, at its address
+  bus.reset_counters();
+  const uint8_t middle[3] = {0x01, 0x22, 0x03};
+  CHECK_EQ(shadow.write(&device, 0x3500, middle, 3), ESP_OK);
+  CHECK_EQ(bus.transactions, 1);
+  CHECK_EQ(bus.register_writes, 1);
+  CHECK(bus.writes.size() == 1 && bus.writes[0].first == 0x3501 && bus.writes[0].second == 0x22);
+
+  // First and last changed: one burst spanning both
+  bus.reset_counters();
+  const uint8_t ends[3] = {0x11, 0x22, 0x33};
+  CHECK_EQ(shadow.write(&device, 0x3500, ends, 3), ESP_OK);
+  CHECK_EQ(bus.transactions, 1);
+  CHECK_EQ(bus.register_writes, 3);
+
+  // A failed write is forgotten: the same values go out again next time
+  bus.reset_counters();
+  const uint8_t lost[3] = {0x11, 0x44, 0x33};
+  bus.fail_next = true;
+  CHECK(shadow.write(&device, 0x3500, lost, 3) != ESP_OK);
+  CHECK_EQ(shadow.write(&device, 0x3500, lost, 3), ESP_OK);
+  CHECK_EQ(bus.transactions, 2);
+  CHECK_EQ(bus.registers[0x3501], 0x44);
+
+  // Uncached write_register() keeps the shadow coherent
+  shadow.refresh(0x3501, 0x55);
+  bus.reset_counters();
+  const uint8_t refreshed[3] = {0x11, 0x55, 0x33};
+  CHECK_EQ(shadow.write(&device, 0x3500, refreshed, 3), ESP_OK);
+  CHECK_EQ(bus.transactions, 0);
+
+  // Forgotten on invalidate() (sensor reset)
+  shadow.invalidate();
+  CHECK_EQ(shadow.write(&device, 0x3500, refreshed, 3), ESP_OK);
+  CHECK_EQ(bus.transactions, 1);
+}
+
+static void check_sensor(const reference::SensorUnderTest &sensor) {
+  std::unique_ptr<FakeSensorBus> bus(new FakeSensorBus());
+  Device device(bus.get());
+  std::unique_ptr<ISensorDriver> driver(sensor.create(&device));
+
+  // --- Init: coalesced bursts replay the raw sequence, in order ---
+  g_now_ms = 0;
+  CHECK_EQ(driver->init(), ESP_OK);
+  uint32_t init_transactions = bus->transactions - bus->reads;
+  uint32_t init_bytes = bus->bytes;
+  uint32_t init_delay_ms = g_now_ms;
+
+  bool same_writes = bus->writes.size() >= sensor.init_count;
+  uint32_t raw_delay_ms = 0;
+  for (size_t i = 0; i < sensor.init_count; i++) {
+    const reference::RegisterWrite &ref = sensor.init[i];
+    raw_delay_ms += ref.delay_ms;
+    if (same_writes && (bus->writes[i].first != ref.addr || bus->writes[i].second != ref.value)) {
+      printf("%s: init write %zu is 0x%04X=0x%02X, expected 0x%04X=0x%02X\n", sensor.name, i, bus->writes[i].first,
+             bus->writes[i].second, ref.addr, ref.value);
+      same_writes = false;
+    }
+  }
+  CHECK(same_writes);
+  // Reset polling aside, never more write transactions than registers
+  CHECK(init_transactions <= sensor.init_count);
+  // The software reset is polled, not slept through: never longer than the table says
+  CHECK(init_delay_ms <= raw_delay_ms);
+
+  // --- AE steps through the register shadow ---
+  bus->reset_counters();
+  CHECK_EQ(driver->set_exposure_gain(0x400, 10), ESP_OK);
+  uint32_t first_step = bus->transactions;
+  uint32_t control_registers = bus->register_writes;
+  CHECK(first_step > 0);
+
+  bus->reset_counters();
+  CHECK_EQ(driver->set_exposure_gain(0x400, 10), ESP_OK);
+  uint32_t repeat_step = bus->transactions;
+  // Group hold drivers still frame the (empty) update
+  CHECK(driver->has_group_hold() ? bus->register_writes <= 2 : repeat_step == 0);
+
+  bus->reset_counters();
+  CHECK_EQ(driver->set_exposure_gain(0x401, 10), ESP_OK);
+  uint32_t small_step = bus->transactions;
+  uint32_t small_step_bytes = bus->bytes;
+  CHECK(small_step <= first_step);
+
+  // A failed AE write is retried in full next time, not assumed applied
+  bus->fail_next = true;
+  driver->set_exposure_gain(0x500, 12);
+  bus->reset_counters();
+  CHECK_EQ(driver->set_exposure_gain(0x500, 12), ESP_OK);
+  CHECK(bus->transactions > 0);
+
+  // Failing inside a group hold: the group is still closed and launched,
+  // otherwise the sensor would keep every later write to itself
+  if (driver->has_group_hold()) {
+    bus->reset_counters();
+    bus->fail_in = 2;
+    CHECK(driver->set_exposure_gain(0x600, 14) != ESP_OK);
+    const size_t n = bus->writes.size();
+    CHECK(n >= 3);
+    if (n >= 3) {
+      const uint16_t group_hold = bus->writes[0].first;
+      CHECK(bus->writes[n - 2].first == group_hold && bus->writes[n - 2].second == 0x10);
+      CHECK(bus->writes[n - 1].first == group_hold && bus->writes[n - 1].second == 0xA0);
+    }
+    bus->fail_in = 0;
+  }
+
+  uint32_t before_bytes = sensor.init_count * 3;
+  printf("%-12s init %3zu regs: %3zu -> %3u transactions, %4u -> %4u bytes (%5.1f -> %5.1f ms I2C, delays %u -> %u ms)\n",
+         sensor.name, sensor.init_count, sensor.init_count, init_transactions, before_bytes, init_bytes,
+         bus->bus_ms(sensor.init_count, before_bytes), bus->bus_ms(init_transactions, init_bytes), raw_delay_ms,
+         init_delay_ms);
+  printf("%-12s AE step %u regs: %u transactions before, now %u first, %u unchanged, %u for exp+1 (%u bytes)\n", "",
+         control_registers, control_registers, first_step, repeat_step, small_step, small_step_bytes);
+}
+
+int main() {
+  check_shadow();
+  for (const reference::SensorUnderTest &sensor : reference::SENSORS)
+    check_sensor(sensor);
+  return test::finish("sensor_registers_test");
+}
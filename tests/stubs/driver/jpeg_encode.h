@@ -0,0 +1,42 @@
+#pragma once
+
+// Host stand-in for the ESP32-P4 JPEG encoder driver. The load test engine
+// (tests/loadtest/host_runtime.cpp) takes the hardware's time, not its output.
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef struct jpeg_encoder_t *jpeg_encoder_handle_t;
+
+typedef enum {
+  JPEG_ENCODE_IN_FORMAT_RGB888,
+  JPEG_ENCODE_IN_FORMAT_RGB565,
+  JPEG_ENCODE_IN_FORMAT_GRAY,
+  JPEG_ENCODE_IN_FORMAT_YUV422,
+} jpeg_enc_input_format_t;
+
+typedef enum {
+  JPEG_DOWN_SAMPLING_YUV444,
+  JPEG_DOWN_SAMPLING_YUV422,
+  JPEG_DOWN_SAMPLING_YUV420,
+  JPEG_DOWN_SAMPLING_GRAY,
+} jpeg_down_sampling_type_t;
+
+typedef struct {
+  jpeg_enc_input_format_t src_type;
+  jpeg_down_sampling_type_t sub_sample;
+  int image_quality;
+  int width;
+  int height;
+} jpeg_encode_config_t;
+
+typedef struct {
+  int timeout_ms;
+  int intr_priority;
+} jpeg_encode_engine_cfg_t;
+
+esp_err_t jpeg_new_encoder_engine(const jpeg_encode_engine_cfg_t *config, jpeg_encoder_handle_t *handle);
+esp_err_t jpeg_del_encoder_engine(jpeg_encoder_handle_t handle);
+esp_err_t jpeg_encoder_process(jpeg_encoder_handle_t handle, const jpeg_encode_config_t *config, const uint8_t *in,
+                               uint32_t in_size, uint8_t *out, uint32_t out_capacity, uint32_t *out_size);
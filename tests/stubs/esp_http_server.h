@@ -0,0 +1,75 @@
+#pragma once
+
+// Host stand-in for the subset of esp_http_server the camera web server
+// uses, served over POSIX sockets by tests/loadtest/host_runtime.cpp: one
+// server thread like httpd, async handlers, chunked responses.
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "esp_err.h"
+
+typedef void *httpd_handle_t;
+
+typedef enum {
+  HTTP_GET,
+  HTTP_POST,
+} httpd_method_t;
+
+typedef struct httpd_req {
+  httpd_handle_t handle;
+  int method;
+  const char uri[512];
+  size_t content_len;
+  void *aux;
+  void *user_ctx;
+} httpd_req_t;
+
+typedef struct {
+  const char *uri;
+  httpd_method_t method;
+  esp_err_t (*handler)(httpd_req_t *req);
+  void *user_ctx;
+} httpd_uri_t;
+
+typedef struct {
+  unsigned task_priority;
+  size_t stack_size;
+  int core_id;
+  uint16_t server_port;
+  uint16_t ctrl_port;
+  uint16_t max_open_sockets;
+  uint16_t max_uri_handlers;
+  bool lru_purge_enable;
+  uint16_t send_wait_timeout;
+  uint16_t recv_wait_timeout;
+} httpd_config_t;
+
+#define HTTPD_DEFAULT_CONFIG() \
+  httpd_config_t { 5, 4096, 0x7FFFFFFF, 80, 32768, 7, 8, false, 5, 5 }
+#define HTTPD_RESP_USE_STRLEN -1
+
+typedef enum {
+  HTTPD_400_BAD_REQUEST,
+  HTTPD_404_NOT_FOUND,
+  HTTPD_500_INTERNAL_SERVER_ERROR,
+  HTTPD_503_SERVICE_UNAVAILABLE,
+} httpd_err_code_t;
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri);
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type);
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value);
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status);
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t len);
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t len);
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *message);
+
+size_t httpd_req_get_url_query_len(httpd_req_t *req);
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *req, char *buf, size_t len);
+esp_err_t httpd_query_key_value(const char *query, const char *key, char *value, size_t len);
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *value, size_t len);
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *req, httpd_req_t **copy);
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *req);
@@ -0,0 +1,51 @@
+#pragma once
+
+// Host stand-in for ESPHome's I2C API: I2CDevice forwards every transaction
+// to an I2CBus, which a test implements to record or emulate a sensor.
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace i2c {
+
+enum ErrorCode {
+  ERROR_OK = 0,
+  ERROR_INVALID_ARGUMENT,
+  ERROR_NOT_ACKNOWLEDGED,
+  ERROR_TIMEOUT,
+  ERROR_NOT_INITIALIZED,
+  ERROR_TOO_LARGE,
+  ERROR_UNKNOWN,
+  ERROR_CRC,
+};
+
+class I2CBus {
+ public:
+  virtual ~I2CBus() = default;
+  // One transaction: write `write_count` bytes, then (repeated start) read `read_count`.
+  virtual ErrorCode write_readv(uint8_t address, const uint8_t *write_buffer, size_t write_count, uint8_t *read_buffer,
+                                size_t read_count) = 0;
+};
+
+class I2CDevice {
+ public:
+  void set_i2c_address(uint8_t address) { this->address_ = address; }
+  void set_i2c_bus(I2CBus *bus) { this->bus_ = bus; }
+
+  ErrorCode write_read(const uint8_t *write_buffer, size_t write_count, uint8_t *read_buffer, size_t read_count) const {
+    return this->bus_ != nullptr ? this->bus_->write_readv(this->address_, write_buffer, write_count, read_buffer,
+                                                           read_count)
+                                 : ERROR_NOT_INITIALIZED;
+  }
+  ErrorCode write(const uint8_t *data, size_t len, bool stop = true) const {
+    return this->write_read(data, len, nullptr, 0);
+  }
+  ErrorCode read(uint8_t *data, size_t len) const { return this->write_read(nullptr, 0, data, len); }
+
+ protected:
+  uint8_t address_{0};
+  I2CBus *bus_{nullptr};
+};
+
+}  // namespace i2c
+}  // namespace esphome
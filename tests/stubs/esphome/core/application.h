@@ -0,0 +1,4 @@
+#pragma once
+
+// Host stand-in: nothing of App is used by the components built on host.
+#include "esphome/core/component.h"
@@ -0,0 +1,39 @@
+#pragma once
+
+// Host stand-in for esphome::Component: lifecycle hooks only, no scheduler.
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float HARDWARE;
+extern const float DATA;
+extern const float WIFI;
+extern const float LATE;
+}  // namespace setup_priority
+
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+  void status_set_warning() {}
+  void set_timeout(uint32_t timeout, std::function<void()> &&f) {}
+  void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {}
+  void set_interval(uint32_t interval, std::function<void()> &&f) {}
+  void defer(std::function<void()> &&f) { f(); }
+  void enable_loop() {}
+  void disable_loop() {}
+
+ protected:
+  bool failed_{false};
+};
+
+}  // namespace esphome
@@ -0,0 +1,33 @@
+#pragma once
+
+// Host stand-in for ESPHome's HAL. The tests define millis/micros/delay
+// themselves, usually on a simulated clock.
+#include <cstddef>
+#include <cstdint>
+
+#ifdef USE_ESP32_VARIANT_ESP32P4
+// Web server load test: what the IDF build makes visible to the component on
+// the board, implemented by tests/loadtest/host_runtime.cpp
+#include "driver/jpeg_encode.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#endif
+
+namespace esphome {
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+class GPIOPin {
+ public:
+  virtual void setup() {}
+  virtual void digital_write(bool value) {}
+  virtual bool digital_read() { return false; }
+};
+
+}  // namespace esphome
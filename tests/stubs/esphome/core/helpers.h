@@ -0,0 +1,35 @@
+#pragma once
+
+// Host stand-in for the ESPHome helpers the components use.
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace esphome {
+
+template<typename... Ts> class CallbackManager;
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) {
+    for (auto &callback : this->callbacks_)
+      callback(args...);
+  }
+  size_t size() const { return this->callbacks_.size(); }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+class HighFrequencyLoopRequester {
+ public:
+  void start() { this->started_ = true; }
+  void stop() { this->started_ = false; }
+  static bool is_high_frequency() { return false; }
+
+ protected:
+  bool started_{false};
+};
+
+}  // namespace esphome
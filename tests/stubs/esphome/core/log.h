@@ -0,0 +1,12 @@
+#pragma once
+
+// Host stand-in for ESPHome's logger: messages go to stdout, tags are dropped.
+#include <cstdio>
+
+#define ESP_LOGE(tag, ...) (printf(__VA_ARGS__), printf("\n"))
+#define ESP_LOGW(tag, ...) (printf(__VA_ARGS__), printf("\n"))
+#define ESP_LOGI(tag, ...) (printf(__VA_ARGS__), printf("\n"))
+#define ESP_LOGD(tag, ...) ((void) 0)
+#define ESP_LOGV(tag, ...) ((void) 0)
+#define ESP_LOGVV(tag, ...) ((void) 0)
+#define ESP_LOGCONFIG(tag, ...) (printf(__VA_ARGS__), printf("\n"))
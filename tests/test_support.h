@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal check helpers for the host tests: no framework, a failed CHECK
+// prints where it happened and the test binary exits non-zero at the end.
+
+namespace test {
+
+inline int &failures() {
+  static int count = 0;
+  return count;
+}
+
+inline int finish(const char *name) {
+  if (failures() != 0) {
+    printf("%s: %d check(s) FAILED\n", name, failures());
+    return EXIT_FAILURE;
+  }
+  printf("%s: OK\n", name);
+  return EXIT_SUCCESS;
+}
+
+}  // namespace test
+
+#define CHECK(cond)                                                \
+  do {                                                             \
+    if (!(cond)) {                                                 \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      ::test::failures()++;                                        \
+    }                                                              \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                                              \
+  do {                                                                                              \
+    long long va_ = (long long) (a), vb_ = (long long) (b);                                         \
+    if (va_ != vb_) {                                                                               \
+      printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, va_, vb_); \
+      ::test::failures()++;                                                                         \
+    }                                                                                               \
+  } while (0)
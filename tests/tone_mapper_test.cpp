@@ -0,0 +1,140 @@
+// ToneMapper LUT entries for parameters with a known result (identity,
+// WB gain, brightness, contrast, full desaturation), when prepare() rebuilds
+// the table, and apply() on pixel ranges that don't start or end on a
+// 32-bit pair: only [begin, end) is touched.
+
+#include "mipi_dsi_cam/tone_mapper.h"
+#include "test_support.h"
+
+#include <vector>
+
+using namespace esphome::mipi_dsi_cam;
+
+static uint16_t rgb565(uint8_t r5, uint8_t g6, uint8_t b5) { return r5 << 11 | g6 << 5 | b5; }
+
+static void test_identity() {
+  std::vector<uint16_t> lut(ToneMapper::LUT_SIZE);
+  ToneMapper mapper;
+  CHECK(!mapper.prepare());  // no storage yet
+  mapper.set_lut_buffer(lut.data());
+  CHECK(ToneParams{}.is_identity());
+  CHECK(mapper.prepare());
+  uint32_t mismatches = 0;
+  for (uint32_t p = 0; p < ToneMapper::LUT_SIZE; p++)
+    mismatches += lut[p] != p;
+  CHECK_EQ(mismatches, 0);
+  // Nothing changed since: no rebuild
+  CHECK(!mapper.prepare());
+}
+
+static void test_channel_curves() {
+  std::vector<uint16_t> lut(ToneMapper::LUT_SIZE);
+  ToneMapper mapper;
+  mapper.set_lut_buffer(lut.data());
+
+  ToneParams gain;
+  gain.gain_r = 2.0f;
+  mapper.set_params(gain);
+  CHECK(mapper.prepare());
+  CHECK_EQ(lut[rgb565(8, 0, 0)], rgb565(16, 0, 0));
+  CHECK_EQ(lut[rgb565(20, 10, 5)], rgb565(31, 10, 5));  // red saturates, G and B untouched
+  CHECK_EQ(lut[rgb565(0, 63, 31)], rgb565(0, 63, 31));
+
+  // +100 %: half of full scale added, black becomes mid grey
+  ToneParams bright;
+  bright.brightness = 100;
+  mapper.set_params(bright);
+  CHECK(mapper.prepare());
+  CHECK_EQ(lut[0], rgb565(16, 32, 16));
+  CHECK_EQ(lut[0xFFFF], 0xFFFF);
+
+  // Contrast around mid grey: the ends go further out, the middle barely moves
+  ToneParams contrast;
+  contrast.contrast = 2.0f;
+  mapper.set_params(contrast);
+  CHECK(mapper.prepare());
+  CHECK_EQ(lut[rgb565(4, 8, 4)], 0);
+  CHECK_EQ(lut[rgb565(28, 56, 28)], 0xFFFF);
+  CHECK_EQ(lut[rgb565(16, 32, 16)], rgb565(17, 33, 17));
+
+  // Gamma > 1 lifts the mid tones only
+  ToneParams gamma;
+  gamma.gamma = 2.0f;
+  mapper.set_params(gamma);
+  CHECK(mapper.prepare());
+  CHECK_EQ(lut[0], 0);
+  CHECK_EQ(lut[0xFFFF], 0xFFFF);
+  CHECK_EQ(lut[rgb565(8, 16, 8)] >> 11, 16);  // sqrt(8/31) * 31 = 15.7
+}
+
+static void test_saturation() {
+  std::vector<uint16_t> lut(ToneMapper::LUT_SIZE);
+  ToneMapper mapper;
+  mapper.set_lut_buffer(lut.data());
+  ToneParams grey;
+  grey.saturation = 0.0f;
+  mapper.set_params(grey);
+  CHECK(mapper.prepare());
+  // Pure red: its BT.601 luma (76) on all three channels
+  CHECK_EQ(lut[rgb565(31, 0, 0)], rgb565(9, 19, 9));
+  CHECK_EQ(lut[rgb565(0, 0, 31)], rgb565(3, 7, 3));  // luma 28
+  CHECK_EQ(lut[0xFFFF], 0xFFFF);
+  CHECK_EQ(lut[0], 0);
+}
+
+static void test_rebuild_threshold() {
+  std::vector<uint16_t> lut(ToneMapper::LUT_SIZE);
+  ToneMapper mapper;
+  mapper.set_lut_buffer(lut.data());
+  ToneParams params;
+  params.gain_b = 1.2f;
+  mapper.set_params(params);
+  CHECK(mapper.prepare());
+  // AWB jitter below the gain epsilon keeps the table
+  params.gain_b = 1.203f;
+  mapper.set_params(params);
+  CHECK(!mapper.prepare());
+  CHECK(mapper.get_params().gain_b == 1.2f);
+  params.gain_b = 1.21f;
+  mapper.set_params(params);
+  CHECK(mapper.prepare());
+  // A new buffer always needs filling
+  std::vector<uint16_t> other(ToneMapper::LUT_SIZE);
+  mapper.set_lut_buffer(other.data());
+  CHECK(mapper.prepare());
+  CHECK(other == lut);
+}
+
+static void test_apply_ranges() {
+  std::vector<uint16_t> lut(ToneMapper::LUT_SIZE);
+  ToneMapper mapper;
+  mapper.set_lut_buffer(lut.data());
+  ToneParams no_red;
+  no_red.gain_r = 0.0f;
+  mapper.set_params(no_red);
+  mapper.prepare();
+
+  const uint16_t red = rgb565(31, 10, 3);
+  const uint16_t mapped = rgb565(0, 10, 3);
+  for (size_t begin = 0; begin < 4; begin++) {
+    for (size_t end = begin; end < 12; end++) {
+      std::vector<uint16_t> frame(12, red);
+      mapper.apply((uint8_t *) frame.data(), begin, end);
+      for (size_t i = 0; i < frame.size(); i++) {
+        const bool inside = i >= begin && i < end;
+        if (frame[i] != (inside ? mapped : red))
+          printf("apply(%zu, %zu): pixel %zu wrong\n", begin, end, i);
+        CHECK_EQ(frame[i], inside ? mapped : red);
+      }
+    }
+  }
+}
+
+int main() {
+  test_identity();
+  test_channel_curves();
+  test_saturation();
+  test_rebuild_threshold();
+  test_apply_ranges();
+  return test::finish("tone_mapper_test");
+}
@@ -0,0 +1,113 @@
+// WhiteBalance gains from FrameStats with known channel means: gray-world
+// and white-patch targets, the fallback when too few bright samples, the
+// gain bounds, temporal smoothing, frames too dark to trust, manual gains
+// and the renormalisation on green when going back to an automatic mode.
+
+#include "mipi_dsi_cam/white_balance.h"
+#include "test_support.h"
+
+#include <cmath>
+
+using namespace esphome::mipi_dsi_cam;
+
+static bool near(float a, float b) { return std::fabs(a - b) < 1e-4f; }
+
+static FrameStats tinted(uint8_t r, uint8_t g, uint8_t b) {
+  FrameStats stats;
+  stats.sequence = 1;
+  stats.mean_luma = 128;
+  stats.mean_r = r;
+  stats.mean_g = g;
+  stats.mean_b = b;
+  return stats;
+}
+
+static void test_gray_world() {
+  WhiteBalance awb;
+  awb.set_mode(AWB_GRAY_WORLD);
+  awb.set_smoothing(1.0f);
+  awb.update(tinted(100, 150, 200));
+  CHECK(near(awb.get_red_gain(), 1.5f));
+  CHECK(near(awb.get_green_gain(), 1.0f));
+  CHECK(near(awb.get_blue_gain(), 0.75f));
+
+  // Half way toward each new estimate
+  awb.set_smoothing(0.5f);
+  awb.update(tinted(150, 150, 150));
+  CHECK(near(awb.get_red_gain(), 1.25f));
+  CHECK(near(awb.get_blue_gain(), 0.875f));
+  awb.update(tinted(150, 150, 150));
+  CHECK(near(awb.get_red_gain(), 1.125f));
+}
+
+static void test_white_patch() {
+  WhiteBalance awb;
+  awb.set_mode(AWB_WHITE_PATCH);
+  awb.set_smoothing(1.0f);
+  FrameStats stats = tinted(100, 150, 200);
+  stats.bright_count = 64;
+  stats.bright_r = 200;
+  stats.bright_g = 220;
+  stats.bright_b = 240;
+  awb.update(stats);
+  CHECK(near(awb.get_red_gain(), 1.1f));
+  CHECK(near(awb.get_blue_gain(), 220.0f / 240.0f));
+
+  // Too few bright samples: gray-world on the means instead
+  stats.bright_count = 63;
+  awb.update(stats);
+  CHECK(near(awb.get_red_gain(), 1.5f));
+  CHECK(near(awb.get_blue_gain(), 0.75f));
+}
+
+static void test_bounds_and_dark_frames() {
+  WhiteBalance awb;
+  awb.set_mode(AWB_GRAY_WORLD);
+  awb.set_smoothing(1.0f);
+  awb.update(tinted(20, 200, 250));
+  CHECK(near(awb.get_red_gain(), WhiteBalance::MAX_GAIN));
+  CHECK(near(awb.get_blue_gain(), 0.8f));
+  awb.update(tinted(250, 100, 100));
+  CHECK(near(awb.get_red_gain(), WhiteBalance::MIN_GAIN));
+
+  // Too dark to trust, or a channel with nothing in it: gains kept
+  FrameStats dark = tinted(10, 30, 60);
+  dark.mean_luma = 15;
+  awb.update(dark);
+  CHECK(near(awb.get_red_gain(), WhiteBalance::MIN_GAIN));
+  awb.update(tinted(0, 100, 100));
+  CHECK(near(awb.get_red_gain(), WhiteBalance::MIN_GAIN));
+  CHECK(near(awb.get_blue_gain(), 1.0f));
+}
+
+static void test_manual() {
+  WhiteBalance awb;
+  CHECK(!awb.is_active());
+  awb.update(tinted(100, 150, 200));
+  CHECK(near(awb.get_red_gain(), 1.0f));
+
+  awb.set_gains(0.1f, 2.0f, 9.0f);
+  CHECK_EQ(awb.get_mode(), AWB_MANUAL);
+  CHECK(awb.is_active());
+  CHECK(near(awb.get_red_gain(), WhiteBalance::MIN_GAIN));
+  CHECK(near(awb.get_green_gain(), 2.0f));
+  CHECK(near(awb.get_blue_gain(), WhiteBalance::MAX_GAIN));
+  // Manual gains are not touched by the stats
+  awb.update(tinted(100, 150, 200));
+  CHECK(near(awb.get_red_gain(), WhiteBalance::MIN_GAIN));
+
+  // Back to automatic: same colour balance, green at 1
+  awb.set_gains(1.0f, 2.0f, 3.0f);
+  awb.set_mode(AWB_GRAY_WORLD);
+  CHECK(near(awb.get_red_gain(), 0.5f));
+  CHECK(near(awb.get_green_gain(), 1.0f));
+  CHECK(near(awb.get_blue_gain(), 1.5f));
+}
+
+int main() {
+  test_gray_world();
+  test_white_patch();
+  test_bounds_and_dark_frames();
+  test_manual();
+  return test::finish("white_balance_test");
+}